@@ -94,6 +94,7 @@
 #cmakedefine HAVE_SYS_TIME_H 1
 #cmakedefine HAVE_SYS_TYPES_H 1
 #cmakedefine HAVE_SYS_UN_H 1
+#cmakedefine HAVE_SYS_UIO_H 1
 #cmakedefine HAVE_SYS_VADVISE_H 1
 #cmakedefine HAVE_SYS_STATVFS_H 1
 #cmakedefine HAVE_UCONTEXT_H 1
@@ -257,6 +258,7 @@
 #cmakedefine HAVE_RENAME 1
 #cmakedefine HAVE_RINT 1
 #cmakedefine HAVE_RWLOCK_INIT 1
+#cmakedefine HAVE_SCHED_GETCPU 1
 #cmakedefine HAVE_SCHED_YIELD 1
 #cmakedefine HAVE_SELECT 1
 #cmakedefine HAVE_SETFD 1
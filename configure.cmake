@@ -247,6 +247,7 @@ CHECK_INCLUDE_FILES (sys/vadvise.h HAVE_SYS_VADVISE_H)
 CHECK_INCLUDE_FILES (fnmatch.h HAVE_FNMATCH_H)
 CHECK_INCLUDE_FILES (stdarg.h  HAVE_STDARG_H)
 CHECK_INCLUDE_FILES ("stdlib.h;sys/un.h" HAVE_SYS_UN_H)
+CHECK_INCLUDE_FILES (sys/uio.h HAVE_SYS_UIO_H)
 CHECK_INCLUDE_FILES (vis.h HAVE_VIS_H)
 CHECK_INCLUDE_FILES (wchar.h HAVE_WCHAR_H)
 CHECK_INCLUDE_FILES (wctype.h HAVE_WCTYPE_H)
@@ -414,6 +415,7 @@ CHECK_FUNCTION_EXISTS (regcomp HAVE_REGCOMP)
 CHECK_FUNCTION_EXISTS (realpath HAVE_REALPATH)
 CHECK_FUNCTION_EXISTS (rename HAVE_RENAME)
 CHECK_FUNCTION_EXISTS (rwlock_init HAVE_RWLOCK_INIT)
+CHECK_FUNCTION_EXISTS (sched_getcpu HAVE_SCHED_GETCPU)
 CHECK_FUNCTION_EXISTS (sched_yield HAVE_SCHED_YIELD)
 CHECK_FUNCTION_EXISTS (setenv HAVE_SETENV)
 CHECK_FUNCTION_EXISTS (setlocale HAVE_SETLOCALE)
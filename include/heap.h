@@ -109,14 +109,70 @@ typedef struct st_heap_block
 
 struct st_heap_info;			/* For referense */
 
+	/* Types of columns stored in the overflow chunks */
+
+#define HP_COLUMN_FIXED		0
+#define HP_COLUMN_VARCHAR	1
+#define HP_COLUMN_BLOB		2
+
+/*
+  Tables with variable-length records keep the first head_length bytes of
+  each record, which include all key columns, in the record block. The
+  columns after them and all BLOB columns are packed into a chain of
+  fixed-size chunks of the overflow block. See hp_dynrec.c
+*/
+
+typedef struct st_hp_columndef		/* Column stored in the chunks */
+{
+  uint offset;				/* Offset of the column in record */
+  uint length;				/* pack_length() of the column */
+  uint null_pos;			/* Position of the null byte */
+  uint8 null_bit;			/* 0 if the column can't be null */
+  uint8 type;				/* HP_COLUMN_FIXED/VARCHAR/BLOB */
+  uint8 length_bytes;			/* Length prefix of VARCHAR or BLOB */
+} HP_COLUMNDEF;
+
+	/* Layouts of HASH indexes */
+
+#define HP_HASH_CHAINED		0	/* Linear hashing in block */
+#define HP_HASH_OPEN		1	/* Open addressing, see hp_ohash.c */
+
+struct st_hp_hash_bucket;
+
+typedef struct st_hp_hash_table		/* Buckets of an open hash index */
+{
+  struct st_hp_hash_bucket *bucket;	/* size buckets, cache line aligned */
+  uchar *alloc;				/* Allocated memory of bucket */
+  ulong size;				/* Number of buckets, 2^n */
+  ulong max_probe;			/* Longest probe from a home bucket */
+  ulong entries;			/* Used slots */
+  ulong deleted;			/* Slots of deleted keys */
+} HP_HASH_TABLE;
+
+typedef struct st_hp_hash_pos		/* Position in an open hash index */
+{
+  ulong home;				/* Bucket where the search started */
+  ulong probe;				/* Buckets after home */
+  int slot;
+  uint table;				/* 0 or 1, see HP_KEYDEF::hash */
+} HP_HASH_POS;
+
 typedef struct st_hp_keydef		/* Key definition with open */
 {
   uint flag;				/* HA_NOSAME | HA_NULL_PART_KEY */
   uint keysegs;				/* Number of key-segment */
   uint length;				/* Length of key (automatic) */
   uint8 algorithm;			/* HASH / BTREE */
+  uint8 hash_layout;			/* HP_HASH_CHAINED / HP_HASH_OPEN */
   HA_KEYSEG *seg;
   HP_BLOCK block;			/* Where keys are saved */
+  /*
+    Open hash index: hash[0] gets all new keys, hash[1] are the buckets
+    of the previous size while they are moved to hash[0], see hp_ohash.c
+  */
+  HP_HASH_TABLE hash[2];
+  ulong hash_moved;			/* Buckets of hash[1] moved */
+  uint hash_version;			/* Changed when keys are moved */
   /*
     Number of buckets used in hash table. Used only to provide
     #records estimates for heap key scans.
@@ -133,7 +189,9 @@ typedef struct st_hp_keydef		/* Key definition with open */
 typedef struct st_heap_share
 {
   HP_BLOCK block;
+  HP_BLOCK overflow;			/* Chunks of variable-length records */
   HP_KEYDEF  *keydef;
+  HP_COLUMNDEF *columndef;		/* Columns stored in the chunks */
   ulonglong data_length,index_length,max_table_size;
   ulonglong auto_increment;
   ulong min_records,max_records;	/* Params to open */
@@ -144,15 +202,25 @@ typedef struct st_heap_share
   uint key_version;                     /* Updated on key change */
   uint file_version;                    /* Update on clear */
   uint reclength;			/* Length of one record */
+  uint columns;				/* Columns in chunks, 0 if fixed */
+  uint head_length;			/* Record bytes kept in the block */
+  uint visible;				/* Offset of the deleted flag */
+  uint chunk_length;			/* Data bytes in one chunk */
+  ulong chunks, deleted_chunks;		/* Used and free chunks */
   uint changed;
   uint keys,max_key_length;
   uint currently_disabled_keys;    /* saved value from "keys" when disabled */
   uint open_count;
   uchar *del_link;			/* Link to next block with del. rec */
+  uchar *chunk_del_link;		/* Link to the first free chunk */
   char * name;			/* Name of "memory-file" */
   time_t create_time;
   THR_LOCK lock;
   mysql_mutex_t intern_lock;            /* Locking for use with _locking */
+  uint lock_stripes;			/* 0 if only table locks are used */
+  uint read_stripes;			/* Number of stripe_lock */
+  mysql_rwlock_t *stripe_lock;		/* Readers take one, writers all */
+  mysql_mutex_t *row_lock;		/* Row locks, striped by position */
   my_bool delete_on_close;
   my_bool internal;                     /* Internal temporary table */
   LIST open_list;
@@ -173,12 +241,21 @@ typedef struct st_heap_info
   uint opt_flag,update;
   uchar *lastkey;			/* Last used key with rkey */
   uchar *recbuf;                         /* Record buffer for rb-tree keys */
+  uchar *rec_buff;			/* Unpacked chunks of the last row */
+  size_t rec_buff_length;
   enum ha_rkey_function last_find_flag;
   TREE_ELEMENT *parents[MAX_TREE_HEIGHT+1];
   TREE_ELEMENT **last_pos;
   uint key_version;                     /* Version at last read */
   uint file_version;                    /* Version at scan */
   uint lastkey_len;
+  uint lock_stripe;			/* Stripe of stripe_lock for reading */
+  mysql_mutex_t *locked_row;		/* Row lock held by the handler */
+  uchar **found;			/* Rows found by the last hash rkey */
+  uint found_count, found_next, found_alloc;
+  HP_KEYDEF *hash_keydef;		/* Open hash index of hash_pos */
+  HP_HASH_POS hash_pos;			/* Where current_ptr was found */
+  uint hash_version;			/* hash_keydef->hash_version then */
   my_bool implicit_emptied;
   THR_LOCK_DATA lock;
   LIST open_list;
@@ -188,10 +265,14 @@ typedef struct st_heap_info
 typedef struct st_heap_create_info
 {
   HP_KEYDEF *keydef;
+  HP_COLUMNDEF *columndef;		/* Columns stored in the chunks */
+  uint columns;				/* 0 for fixed-length records */
+  uint head_length;			/* Record bytes kept in the block */
   uint auto_key;                        /* keynr [1 - maxkey] for auto key */
   uint auto_key_type;
   uint keys;
   uint reclength;
+  uint lock_stripes;			/* 0 for table-level locking only */
   ulong max_records;
   ulong min_records;
   ulonglong max_table_size;
@@ -247,6 +328,12 @@ int heap_rkey(HP_INFO *info, uchar *record, int inx, const uchar *key,
 extern uchar * heap_find(HP_INFO *info,int inx,const uchar *key);
 extern int heap_check_heap(HP_INFO *info, my_bool print_status);
 extern uchar *heap_position(HP_INFO *info);
+extern void heap_read_lock(HP_INFO *info);
+extern void heap_read_unlock(HP_INFO *info);
+extern void heap_write_lock(HP_INFO *info);
+extern void heap_write_unlock(HP_INFO *info);
+extern int heap_lock_row(HP_INFO *info, uchar *record);
+extern void heap_unlock_row(HP_INFO *info);
 
 /* The following is for programs that uses the old HEAP interface where
    pointer to rows where a long instead of a (uchar*).
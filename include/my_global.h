@@ -200,6 +200,16 @@
 #define likely(x)	__builtin_expect(((x) != 0),1)
 #define unlikely(x)	__builtin_expect(((x) != 0),0)
 
+/*
+  Hint the processor to fetch the memory at addr into the cache, as it
+  is going to be read soon.
+*/
+#if defined(__GNUC__) && !(__GNUC__ == 2 && __GNUC_MINOR__ < 96)
+#define prefetch_for_read(addr) __builtin_prefetch((addr), 0, 3)
+#else
+#define prefetch_for_read(addr) do { } while (0)
+#endif
+
 /* Fix problem with S_ISLNK() on Linux */
 #if defined(TARGET_OS_LINUX) || defined(__GLIBC__)
 #undef  _GNU_SOURCE
@@ -901,6 +901,15 @@ extern void *my_az_allocator(void *dummy, unsigned int items, unsigned int size)
 extern void my_az_free(void *dummy, void *address);
 extern int my_compress_buffer(uchar *dest, size_t *destLen,
                               const uchar *source, size_t sourceLen);
+typedef struct st_compress_stream COMPRESS_STREAM;
+extern COMPRESS_STREAM *my_compress_stream_init(myf flags);
+extern void my_compress_stream_end(COMPRESS_STREAM *stream);
+extern size_t my_compress_stream_bound(size_t len);
+extern my_bool my_compress_stream(COMPRESS_STREAM *stream, uchar *dest,
+                                  size_t *dest_len, const uchar *packet,
+                                  size_t len);
+extern my_bool my_uncompress_stream(COMPRESS_STREAM *stream, uchar *packet,
+                                    size_t len, size_t *complen);
 extern int packfrm(const uchar *, size_t, uchar **, size_t *);
 extern int unpackfrm(uchar **, size_t *, const uchar *);
 
@@ -32,6 +32,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
   #include <MSWSock.h>
   #define SOCKBUF_T char
 #else
+  #include <sys/socket.h>
   #include <netinet/in.h>
   #define SOCKBUF_T void
 #endif
@@ -380,6 +381,25 @@ inline_mysql_socket_set_state(MYSQL_SOCKET socket, enum PSI_socket_state state)
     inline_mysql_socket_send(FD, B, N, FL)
 #endif
 
+/**
+  @def mysql_socket_sendmsg(FD, M, FL)
+  Send data from the buffers described by the message header, M, to a
+  connected socket.
+  @c mysql_socket_sendmsg is a replacement for @c sendmsg.
+  @param FD Instrumented socket descriptor returned by socket() or accept()
+  @param M  Message header
+  @param FL Control flags
+*/
+#ifndef __WIN__
+#ifdef HAVE_PSI_SOCKET_INTERFACE
+  #define mysql_socket_sendmsg(FD, M, FL) \
+    inline_mysql_socket_sendmsg(__FILE__, __LINE__, FD, M, FL)
+#else
+  #define mysql_socket_sendmsg(FD, M, FL) \
+    inline_mysql_socket_sendmsg(FD, M, FL)
+#endif
+#endif /* __WIN__ */
+
 /**
   @def mysql_socket_recv(FD, B, N, FL)
   Receive data from a connected socket.
@@ -761,6 +781,54 @@ inline_mysql_socket_send
   return result;
 }
 
+#ifndef __WIN__
+/** mysql_socket_sendmsg */
+
+static inline ssize_t
+inline_mysql_socket_sendmsg
+(
+#ifdef HAVE_PSI_SOCKET_INTERFACE
+  const char *src_file, uint src_line,
+#endif
+ MYSQL_SOCKET mysql_socket, const struct msghdr *msg, int flags)
+{
+  ssize_t result;
+
+#ifdef HAVE_PSI_SOCKET_INTERFACE
+  if (mysql_socket.m_psi != NULL)
+  {
+    /* Instrumentation start */
+    PSI_socket_locker *locker;
+    PSI_socket_locker_state state;
+    size_t n= 0;
+    size_t i;
+    for (i= 0; i < (size_t) msg->msg_iovlen; i++)
+      n+= msg->msg_iov[i].iov_len;
+    locker= PSI_SOCKET_CALL(start_socket_wait)
+      (&state, mysql_socket.m_psi, PSI_SOCKET_SEND, n, src_file, src_line);
+
+    /* Instrumented code */
+    result= sendmsg(mysql_socket.fd, msg, flags);
+
+    /* Instrumentation end */
+    if (locker != NULL)
+    {
+      size_t bytes_written;
+      bytes_written= (result > -1) ? result : 0;
+      PSI_SOCKET_CALL(end_socket_wait)(locker, bytes_written);
+    }
+
+    return result;
+  }
+#endif
+
+  /* Non instrumented code */
+  result= sendmsg(mysql_socket.fd, msg, flags);
+
+  return result;
+}
+#endif /* __WIN__ */
+
 /** mysql_socket_recv */
 
 static inline ssize_t
@@ -215,6 +215,8 @@ enum enum_server_command
 #define CLIENT_PLUGIN_AUTH_LENENC_CLIENT_DATA (1UL << 21)
 /* Don't close the connection for a connection with expired password. */
 #define CLIENT_CAN_HANDLE_EXPIRED_PASSWORDS (1UL << 22)
+/* With CLIENT_COMPRESS: compression context is kept between packets */
+#define CLIENT_COMPRESS_STREAM (1UL << 28)
 
 #define CLIENT_PROGRESS  (1UL << 29)   /* Client support progress indicator */
 #define CLIENT_SSL_VERIFY_SERVER_CERT (1UL << 30)
@@ -230,7 +232,7 @@ enum enum_server_command
 #define CLIENT_REMEMBER_OPTIONS (1UL << 31)
 
 #ifdef HAVE_COMPRESS
-#define CAN_CLIENT_COMPRESS CLIENT_COMPRESS
+#define CAN_CLIENT_COMPRESS (CLIENT_COMPRESS | CLIENT_COMPRESS_STREAM)
 #else
 #define CAN_CLIENT_COMPRESS 0
 #endif
@@ -242,6 +244,7 @@ enum enum_server_command
                            CLIENT_CONNECT_WITH_DB | \
                            CLIENT_NO_SCHEMA | \
                            CLIENT_COMPRESS | \
+                           CLIENT_COMPRESS_STREAM | \
                            CLIENT_ODBC | \
                            CLIENT_LOCAL_FILES | \
                            CLIENT_IGNORE_SPACE | \
@@ -272,8 +275,9 @@ enum enum_server_command
   If any of the optional flags is supported by the build it will be switched
   on before sending to the client during the connection handshake.
 */
-#define CLIENT_BASIC_FLAGS (((CLIENT_ALL_FLAGS & ~CLIENT_SSL) \
+#define CLIENT_BASIC_FLAGS ((((CLIENT_ALL_FLAGS & ~CLIENT_SSL) \
                                                & ~CLIENT_COMPRESS) \
+                                               & ~CLIENT_COMPRESS_STREAM) \
                                                & ~CLIENT_SSL_VERIFY_SERVER_CERT)
 
 /**
@@ -579,6 +583,7 @@ typedef struct st_udf_init
   /* Constants when using compression */
 #define NET_HEADER_SIZE 4		/* standard header size */
 #define COMP_HEADER_SIZE 3		/* compression header extra size */
+#define NET_COMPRESS_STREAM 3		/* NET::compress for CLIENT_COMPRESS_STREAM */
 
   /* Prototypes to password functions */
 
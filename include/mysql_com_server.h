@@ -34,8 +34,14 @@ struct st_net_server
   before_header_callback_fn m_before_header;
   after_header_callback_fn m_after_header;
   void *m_user_data;
+  /* Compression context with NET_COMPRESS_STREAM, see net_serv.cc */
+  struct st_compress_stream *m_compress_stream;
 };
 
 typedef struct st_net_server NET_SERVER;
 
+struct iovec;
+my_bool my_net_writev(struct st_net *net, struct iovec *iov,
+                      unsigned int iovcnt);
+
 #endif
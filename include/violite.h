@@ -24,6 +24,15 @@
 
 #include "my_net.h"   /* needed because of struct in_addr */
 #include <mysql/psi/mysql_socket.h>
+#ifdef HAVE_SYS_UIO_H
+#include <sys/uio.h>
+#else
+struct iovec
+{
+  void *iov_base;
+  size_t iov_len;
+};
+#endif
 
 /* Simple vio interface in C;  The functions are implemented in violite.c */
 
@@ -78,6 +87,7 @@ my_bool vio_reset(Vio* vio, enum enum_vio_type type,
 size_t	vio_read(Vio *vio, uchar *	buf, size_t size);
 size_t  vio_read_buff(Vio *vio, uchar * buf, size_t size);
 size_t	vio_write(Vio *vio, const uchar * buf, size_t size);
+size_t	vio_writev(Vio *vio, const struct iovec *iov, int iovcnt);
 int	vio_blocking(Vio *vio, my_bool onoff, my_bool *old_mode);
 my_bool	vio_is_blocking(Vio *vio);
 /* setsockopt TCP_NODELAY at IPPROTO_TCP level, when possible */
@@ -190,6 +200,7 @@ void vio_end(void);
 #define vio_errno(vio)	 			(vio)->vioerrno(vio)
 #define vio_read(vio, buf, size)                ((vio)->read)(vio,buf,size)
 #define vio_write(vio, buf, size)               ((vio)->write)(vio, buf, size)
+#define vio_writev(vio, iov, iovcnt)            ((vio)->writev)(vio, iov, iovcnt)
 #define vio_blocking(vio, set_blocking_mode, old_mode)\
  	(vio)->vioblocking(vio, set_blocking_mode, old_mode)
 #define vio_is_blocking(vio) 			(vio)->is_blocking(vio)
@@ -256,6 +267,7 @@ struct st_vio
   int     (*vioerrno)(Vio*);
   size_t  (*read)(Vio*, uchar *, size_t);
   size_t  (*write)(Vio*, const uchar *, size_t);
+  size_t  (*writev)(Vio*, const struct iovec *, int);
   int     (*timeout)(Vio*, uint, my_bool);
   int     (*vioblocking)(Vio*, my_bool, my_bool *);
   my_bool (*is_blocking)(Vio*);
@@ -203,4 +203,199 @@ my_bool my_uncompress(uchar *packet, size_t len, size_t *complen)
   DBUG_RETURN(0);
 }
 
+/*
+  Streaming compression, used by the compressed protocol when both sides
+  support CLIENT_COMPRESS_STREAM.
+
+  One deflate and one inflate stream are kept for the whole connection, so
+  that the dictionary built from earlier packets is used for the following
+  ones. Small packets, like the rows of most result sets, compress much
+  better this way than one by one. Every packet is terminated with
+  Z_SYNC_FLUSH so that it can be decompressed as soon as it is received.
+  The empty stored block that ends such a flush is always
+  00 00 ff ff; it is not sent and is added back by the reader.
+
+  Raw deflate at the fastest level is used: the stream itself replaces the
+  zlib header and checksum, and the packets are too small for the higher
+  levels to pay off.
+*/
+
+#define COMPRESS_STREAM_LEVEL Z_BEST_SPEED
+#define COMPRESS_STREAM_WINDOW_BITS (-MAX_WBITS)
+
+static const uchar sync_flush_trailer[4]= { 0x00, 0x00, 0xff, 0xff };
+
+struct st_compress_stream
+{
+  z_stream deflate;
+  z_stream inflate;
+  uchar *buff;                                  /* Input of inflate() */
+  size_t buff_length;
+  myf flags;
+};
+
+
+/*
+  Create a compression context for both directions of a connection
+
+  SYNOPSIS
+    my_compress_stream_init()
+    flags	Flags for my_malloc()
+
+  RETURN
+    0   Out of memory
+    #   Context, to be freed with my_compress_stream_end()
+*/
+
+COMPRESS_STREAM *my_compress_stream_init(myf flags)
+{
+  COMPRESS_STREAM *stream;
+  DBUG_ENTER("my_compress_stream_init");
+
+  if (!(stream= (COMPRESS_STREAM*) my_malloc(sizeof(*stream),
+                                             MYF(flags | MY_ZEROFILL))))
+    DBUG_RETURN(0);
+  stream->flags= flags;
+  stream->deflate.zalloc= stream->inflate.zalloc= (alloc_func)my_az_allocator;
+  stream->deflate.zfree= stream->inflate.zfree= (free_func)my_az_free;
+  if (deflateInit2(&stream->deflate, COMPRESS_STREAM_LEVEL, Z_DEFLATED,
+                   COMPRESS_STREAM_WINDOW_BITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+  {
+    my_free(stream);
+    DBUG_RETURN(0);
+  }
+  if (inflateInit2(&stream->inflate, COMPRESS_STREAM_WINDOW_BITS) != Z_OK)
+  {
+    deflateEnd(&stream->deflate);
+    my_free(stream);
+    DBUG_RETURN(0);
+  }
+  DBUG_RETURN(stream);
+}
+
+
+void my_compress_stream_end(COMPRESS_STREAM *stream)
+{
+  DBUG_ENTER("my_compress_stream_end");
+  deflateEnd(&stream->deflate);
+  inflateEnd(&stream->inflate);
+  my_free(stream->buff);
+  my_free(stream);
+  DBUG_VOID_RETURN;
+}
+
+
+/*
+  Size of the buffer needed by my_compress_stream() for 'len' bytes.
+  Incompressible data is sent in stored blocks of at most 64K, each with
+  a 5 byte header, plus a few bytes for the pending bits of the last block.
+*/
+
+size_t my_compress_stream_bound(size_t len)
+{
+  return len + (len >> 10) + 64;
+}
+
+
+/*
+  Compress a packet with the connection's deflate stream
+
+  SYNOPSIS
+    my_compress_stream()
+    stream	Context from my_compress_stream_init()
+    dest	Buffer for the compressed data, at least
+                my_compress_stream_bound(len) bytes
+    dest_len	out: Length of the compressed data
+    packet	Data to compress
+    len		Length of data to compress
+
+  NOTES
+    Unlike my_compress() the data is compressed even when it does not get
+    shorter: the reader has to see everything that went through the stream.
+
+  RETURN
+    1   error. The stream can't be used anymore.
+    0   ok
+*/
+
+my_bool my_compress_stream(COMPRESS_STREAM *stream, uchar *dest,
+                           size_t *dest_len, const uchar *packet, size_t len)
+{
+  z_stream *zs= &stream->deflate;
+  size_t bound= my_compress_stream_bound(len);
+  DBUG_ENTER("my_compress_stream");
+
+  zs->next_in= (Bytef*) packet;
+  zs->avail_in= (uInt) len;
+  zs->next_out= (Bytef*) dest;
+  zs->avail_out= (uInt) bound;
+  if (deflate(zs, Z_SYNC_FLUSH) != Z_OK || zs->avail_in || !zs->avail_out)
+  {
+    DBUG_PRINT("error",("Can't compress packet of %lu bytes", (ulong) len));
+    DBUG_RETURN(1);
+  }
+  *dest_len= bound - zs->avail_out;
+  DBUG_ASSERT(*dest_len >= sizeof(sync_flush_trailer));
+  DBUG_ASSERT(!memcmp(dest + *dest_len - sizeof(sync_flush_trailer),
+                      sync_flush_trailer, sizeof(sync_flush_trailer)));
+  *dest_len-= sizeof(sync_flush_trailer);
+  DBUG_RETURN(0);
+}
+
+
+/*
+  Uncompress a packet with the connection's inflate stream
+
+  SYNOPSIS
+    my_uncompress_stream()
+    stream	Context from my_compress_stream_init()
+    packet	Compressed data. This is is replaced with the original data.
+    len		Length of compressed data
+    complen	Length of the original data, 0 if the packet was not
+                compressed. The packet buffer must be big enough for it.
+                out: Length of the data in 'packet'
+
+  RETURN
+    1   error. The stream can't be used anymore.
+    0   ok
+*/
+
+my_bool my_uncompress_stream(COMPRESS_STREAM *stream, uchar *packet,
+                             size_t len, size_t *complen)
+{
+  z_stream *zs= &stream->inflate;
+  size_t need= len + sizeof(sync_flush_trailer);
+  int error;
+  DBUG_ENTER("my_uncompress_stream");
+
+  if (!*complen)                                /* Sent as is */
+  {
+    *complen= len;
+    DBUG_RETURN(0);
+  }
+  if (need > stream->buff_length)
+  {
+    uchar *buff;
+    if (!(buff= (uchar*) my_realloc(stream->buff, need,
+                                    MYF(stream->flags | MY_ALLOW_ZERO_PTR))))
+      DBUG_RETURN(1);
+    stream->buff= buff;
+    stream->buff_length= need;
+  }
+  memcpy(stream->buff, packet, len);
+  memcpy(stream->buff + len, sync_flush_trailer, sizeof(sync_flush_trailer));
+
+  zs->next_in= (Bytef*) stream->buff;
+  zs->avail_in= (uInt) need;
+  zs->next_out= (Bytef*) packet;
+  zs->avail_out= (uInt) *complen;
+  error= inflate(zs, Z_SYNC_FLUSH);
+  if (error != Z_OK || zs->avail_in || zs->avail_out)
+  {                                             /* Probably wrong packet */
+    DBUG_PRINT("error",("Can't uncompress packet, error: %d", error));
+    DBUG_RETURN(1);
+  }
+  DBUG_RETURN(0);
+}
+
 #endif /* HAVE_COMPRESS */
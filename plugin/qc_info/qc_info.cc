@@ -109,19 +109,14 @@ static ST_FIELD_INFO qc_info_fields[]=
 
 static const char unknown[]= "#UNKNOWN#";
 
-static int qc_info_fill_table(THD *thd, TABLE_LIST *tables,
-                                              COND *cond)
+static int qc_info_fill_partition(THD *thd, TABLE *table,
+                                  Accessible_Query_Cache *partition)
 {
   int status= 1;
   CHARSET_INFO *scs= system_charset_info;
-  TABLE *table= tables->table;
-  HASH *queries = qc->get_queries();
+  HASH *queries = partition->get_queries();
 
-  /* one must have PROCESS privilege to see others' queries */
-  if (check_global_access(thd, PROCESS_ACL, true))
-    return 0;
-
-  if (qc->try_lock(thd))
+  if (partition->try_lock(thd))
     return 0; // QC is or is being disabled
 
   /* loop through all queries in the query cache */
@@ -264,10 +259,28 @@ static int qc_info_fill_table(THD *thd, TABLE_LIST *tables,
   status = 0;
 
 cleanup:
-  qc->unlock();
+  partition->unlock();
   return status;
 }
 
+static int qc_info_fill_table(THD *thd, TABLE_LIST *tables,
+                                              COND *cond)
+{
+  /* one must have PROCESS privilege to see others' queries */
+  if (check_global_access(thd, PROCESS_ACL, true))
+    return 0;
+
+  /* a partitioned cache has its queries in the partitions */
+  for (uint i= 0; i < qc->get_partition_count(); i++)
+  {
+    if (qc_info_fill_partition(thd, tables->table,
+                               (Accessible_Query_Cache *)
+                               qc->get_partition(i)))
+      return 1;
+  }
+  return 0;
+}
+
 static int qc_info_plugin_init(void *p)
 {
   ST_SCHEMA_TABLE *schema= (ST_SCHEMA_TABLE *)p;
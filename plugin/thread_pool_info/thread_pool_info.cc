@@ -0,0 +1,123 @@
+/* Copyright (C) 2017 MariaDB Corporation
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02111-1301 USA */
+
+/*
+  INFORMATION_SCHEMA.THREAD_POOL_QUEUES
+
+  One row per work queue of every active thread group of the Unix
+  thread pool, with the current queue length and the time events
+  spent waiting in the queue.
+*/
+
+#ifndef MYSQL_SERVER
+#define MYSQL_SERVER
+#endif
+
+#include <my_global.h>
+#include <sql_class.h>          // THD
+#include <table.h>              // ST_SCHEMA_TABLE
+#include <threadpool.h>
+#include <mysql/plugin.h>
+
+bool schema_table_store_record(THD *thd, TABLE *table);
+
+#define COLUMN_GROUP_ID 0
+#define COLUMN_PRIORITY 1
+#define COLUMN_QUEUE_LENGTH 2
+#define COLUMN_EVENTS 3
+#define COLUMN_TOTAL_WAIT_MICROSECONDS 4
+#define COLUMN_AVG_WAIT_MICROSECONDS 5
+
+static ST_FIELD_INFO queues_fields[]=
+{
+  {"GROUP_ID", MY_INT32_NUM_DECIMAL_DIGITS, MYSQL_TYPE_LONG, 0, 0, 0, 0},
+  {"PRIORITY", 4, MYSQL_TYPE_STRING, 0, 0, 0, 0},
+  {"QUEUE_LENGTH", MY_INT32_NUM_DECIMAL_DIGITS, MYSQL_TYPE_LONG, 0, 0, 0, 0},
+  {"EVENTS", MY_INT64_NUM_DECIMAL_DIGITS, MYSQL_TYPE_LONGLONG, 0, 0, 0, 0},
+  {"TOTAL_WAIT_MICROSECONDS", MY_INT64_NUM_DECIMAL_DIGITS, MYSQL_TYPE_LONGLONG,
+   0, 0, 0, 0},
+  {"AVG_WAIT_MICROSECONDS", MY_INT64_NUM_DECIMAL_DIGITS, MYSQL_TYPE_LONGLONG,
+   0, 0, 0, 0},
+  {0, 0, MYSQL_TYPE_STRING, 0, 0, 0, 0}
+};
+
+static const char *priority_names[TP_PRIORITY_COUNT]= { "HIGH", "LOW" };
+
+
+static int queues_fill_table(THD *thd, TABLE_LIST *tables, COND *cond)
+{
+  TABLE *table= tables->table;
+  uint count= tp_get_group_count();
+
+  for (uint group= 0; group < count; group++)
+  {
+    for (int prio= 0; prio < TP_PRIORITY_COUNT; prio++)
+    {
+      TP_QUEUE_STATS stats;
+      tp_get_queue_stats(group, prio, &stats);
+
+      table->field[COLUMN_GROUP_ID]->store(group, true);
+      table->field[COLUMN_PRIORITY]->store(priority_names[prio],
+                                           strlen(priority_names[prio]),
+                                           system_charset_info);
+      table->field[COLUMN_QUEUE_LENGTH]->store(stats.length, true);
+      table->field[COLUMN_EVENTS]->store(stats.events, true);
+      table->field[COLUMN_TOTAL_WAIT_MICROSECONDS]->store(stats.wait_time,
+                                                          true);
+      table->field[COLUMN_AVG_WAIT_MICROSECONDS]->
+        store(stats.events ? stats.wait_time / stats.events : 0, true);
+
+      if (schema_table_store_record(thd, table))
+        return 1;
+    }
+  }
+  return 0;
+}
+
+
+static int queues_plugin_init(void *p)
+{
+  ST_SCHEMA_TABLE *schema= (ST_SCHEMA_TABLE *)p;
+
+  schema->fields_info= queues_fields;
+  schema->fill_table= queues_fill_table;
+  return 0;
+}
+
+
+static struct st_mysql_information_schema queues_plugin=
+{ MYSQL_INFORMATION_SCHEMA_INTERFACE_VERSION };
+
+/*
+  Plugin library descriptor
+*/
+
+maria_declare_plugin(thread_pool_info)
+{
+  MYSQL_INFORMATION_SCHEMA_PLUGIN,
+  &queues_plugin,
+  "THREAD_POOL_QUEUES",
+  "MariaDB Corporation",
+  "Work queues of the thread pool groups.",
+  PLUGIN_LICENSE_GPL,
+  queues_plugin_init,         /* Plugin Init          */
+  0,                          /* Plugin Deinit        */
+  0x0100,                     /* version, hex         */
+  NULL,                       /* status variables     */
+  NULL,                       /* system variables     */
+  "1.0",                      /* version as a string  */
+  MariaDB_PLUGIN_MATURITY_EXPERIMENTAL
+}
+maria_declare_plugin_end;
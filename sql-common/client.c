@@ -2517,14 +2517,21 @@ static int send_client_reply_packet(MCPVIO_EXT *mpvio,
   if (mpvio->db)
     mysql->client_flag|= CLIENT_CONNECT_WITH_DB;
 
+  /* Keep the compression context between packets if the server can */
+  if (mysql->client_flag & CLIENT_COMPRESS)
+    mysql->client_flag|= CLIENT_COMPRESS_STREAM;
+
   /* Remove options that server doesn't support */
   mysql->client_flag= mysql->client_flag &
-                       (~(CLIENT_COMPRESS | CLIENT_SSL | CLIENT_PROTOCOL_41) 
+                       (~(CLIENT_COMPRESS | CLIENT_COMPRESS_STREAM |
+                          CLIENT_SSL | CLIENT_PROTOCOL_41)
                        | mysql->server_capabilities);
 
 #ifndef HAVE_COMPRESS
-  mysql->client_flag&= ~CLIENT_COMPRESS;
+  mysql->client_flag&= ~(CLIENT_COMPRESS | CLIENT_COMPRESS_STREAM);
 #endif
+  if (!(mysql->client_flag & CLIENT_COMPRESS))
+    mysql->client_flag&= ~CLIENT_COMPRESS_STREAM;
 
   if (mysql->client_flag & CLIENT_PROTOCOL_41)
   {
@@ -3583,7 +3590,8 @@ CLI_MYSQL_REAL_CONNECT(MYSQL *mysql,const char *host, const char *user,
   */
 
   if (mysql->client_flag & CLIENT_COMPRESS)      /* We will use compression */
-    net->compress=1;
+    net->compress= (mysql->client_flag & CLIENT_COMPRESS_STREAM ?
+                    NET_COMPRESS_STREAM : 1);
 
   if (db && !mysql->db && mysql_select_db(mysql, db))
   {
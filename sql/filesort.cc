@@ -45,6 +45,8 @@
 if (my_b_write((file),(uchar*) (from),param->ref_length)) \
   DBUG_RETURN(1);
 
+class Filesort_parallel;
+
 	/* functions defined in this file */
 
 static uchar *read_buffpek_from_file(IO_CACHE *buffer_file, uint count,
@@ -54,6 +56,7 @@ static ha_rows find_all_keys(THD *thd, Sort_param *param, SQL_SELECT *select,
                              IO_CACHE *buffer_file,
                              IO_CACHE *tempfile,
                              Bounded_queue<uchar, uchar> *pq,
+                             Filesort_parallel *parallel,
                              ha_rows *found_rows);
 static bool write_keys(Sort_param *param, Filesort_info *fs_info,
                       uint count, IO_CACHE *buffer_file, IO_CACHE *tempfile);
@@ -106,6 +109,70 @@ void Sort_param::init_for_filesort(uint sortlen, TABLE *table,
 }
 
 
+/**
+  Sorts a full buffer of keys in a worker thread and writes it to its
+  place in the temporary file.
+*/
+
+class Sort_buffer_job :public Sort_job
+{
+public:
+  Sort_param *param;
+  Filesort_buffer *buffer;
+  uint count;                                   // Keys in the buffer
+  uint write_count;                             // Keys to write
+  File file;
+  my_off_t file_pos;
+
+  bool run(uint worker);
+};
+
+
+/**
+  State of a filesort that sorts and merges its buffers in worker threads.
+
+  The rows are still read and the sort keys made by the thread of the
+  query, as handlers and items can only be used by this thread. When a
+  buffer is full, it is given to a worker that sorts it and writes it to
+  the temporary file, and the query thread goes on with the next free
+  buffer. The place of each run in the file is known when the buffer is
+  given to the worker, so the workers don't have to wait for each other.
+  The runs are then merged by the workers, see merge_many_buff_parallel()
+  and merge_index_parallel().
+
+  The workers are started when the first buffer is full, so sorts that
+  fit in memory are not affected.
+*/
+
+class Filesort_parallel
+{
+public:
+  Filesort_parallel()
+    :buffers(0), own_buffers(0), jobs(0), sort_buffers(0), buffer_count(0),
+     own_buffer_count(0), current(0), end_of_runs(0)
+  {}
+  ~Filesort_parallel() { end(); }
+
+  bool is_started() const { return buffers != 0; }
+  bool start(THD *thd, Sort_param *param, Filesort_info *fs_info);
+  Filesort_buffer *write_keys(THD *thd, Sort_param *param, uint count,
+                              IO_CACHE *buffpek_pointers,
+                              IO_CACHE *tempfile);
+  bool end_of_keys(THD *thd, IO_CACHE *tempfile);
+  void end();
+
+  Sort_workers workers;
+  Filesort_buffer **buffers;                    // buffers[0] is table->sort's
+  Filesort_buffer *own_buffers;
+  Sort_buffer_job *jobs;                        // One for every buffer
+  uchar **sort_buffers;                         // Merge buffer of each worker
+private:
+  uint buffer_count, own_buffer_count;
+  uint current;                                 // Buffer that is filled
+  my_off_t end_of_runs;
+};
+
+
 /**
   Sort a table.
   Creates a set of pointers that can be used to read the rows
@@ -156,6 +223,7 @@ ha_rows filesort(THD *thd, TABLE *table, SORT_FIELD *sortorder, uint s_length,
   Sort_param param;
   bool multi_byte_charset;
   Bounded_queue<uchar, uchar> pq;
+  Filesort_parallel parallel;
 
   DBUG_ENTER("filesort");
   DBUG_EXECUTE("info",TEST_filesort(sortorder,s_length););
@@ -298,9 +366,14 @@ ha_rows filesort(THD *thd, TABLE *table, SORT_FIELD *sortorder, uint s_length,
                           &buffpek_pointers,
                           &tempfile, 
                           pq.is_initialized() ? &pq : NULL,
+                          (thd->variables.max_sort_threads &&
+                           !pq.is_initialized() && !encrypt_tmp_files) ?
+                          &parallel : NULL,
                           found_rows);
   if (num_rows == HA_POS_ERROR)
     goto err;
+  if (parallel.is_started())
+    tracker->report_sort_threads(parallel.workers.threads());
 
   maxbuffer= (uint) (my_b_tell(&buffpek_pointers)/sizeof(*buffpek));
   tracker->report_merge_passes_at_start(thd->query_plan_fsort_passes);
@@ -344,20 +417,34 @@ ha_rows filesort(THD *thd, TABLE *table, SORT_FIELD *sortorder, uint s_length,
                                 (param.rec_length + sizeof(char*))) /
                                param.rec_length - 1);
     maxbuffer--;				// Offset from 0
-    if (merge_many_buff(&param,
-                        (uchar*) table_sort.get_sort_keys(),
-                        buffpek,&maxbuffer,
-			&tempfile))
+    if (parallel.is_started())
+    {
+      if (merge_many_buff_parallel(&param, &parallel.workers,
+                                   parallel.sort_buffers,
+                                   buffpek, &maxbuffer, &tempfile))
+        goto err;
+    }
+    else if (merge_many_buff(&param,
+                             (uchar*) table_sort.get_sort_keys(),
+                             buffpek,&maxbuffer,
+                             &tempfile))
       goto err;
     if (flush_io_cache(&tempfile) ||
 	reinit_io_cache(&tempfile,READ_CACHE,0L,0,0))
       goto err;
-    if (merge_index(&param,
-                    (uchar*) table_sort.get_sort_keys(),
-                    buffpek,
-                    maxbuffer,
-                    &tempfile,
-		    outfile))
+    if (parallel.is_started())
+    {
+      if (merge_index_parallel(&param, &parallel.workers,
+                               parallel.sort_buffers,
+                               buffpek, maxbuffer, &tempfile, outfile))
+        goto err;
+    }
+    else if (merge_index(&param,
+                         (uchar*) table_sort.get_sort_keys(),
+                         buffpek,
+                         maxbuffer,
+                         &tempfile,
+                         outfile))
       goto err;
   }
 
@@ -369,6 +456,8 @@ ha_rows filesort(THD *thd, TABLE *table, SORT_FIELD *sortorder, uint s_length,
   error= 0;
 
   err:
+  /* The workers must be gone before the buffers are freed */
+  parallel.end();
   my_free(param.tmp_buffer);
   if (!subselect || !subselect->is_uncacheable())
   {
@@ -637,6 +726,8 @@ static void dbug_print_record(TABLE *table, bool print_rowid)
                            in tempfile.
   @param tempfile          File to write sorted sequences of sortkeys to.
   @param pq                If !NULL, use it for keeping top N elements
+  @param parallel          If !NULL, full buffers may be sorted and written
+                           by worker threads
   @param [out] found_rows  The number of FOUND_ROWS().
                            For a query with LIMIT, this value will typically
                            be larger than the function return value.
@@ -676,6 +767,7 @@ static ha_rows find_all_keys(THD *thd, Sort_param *param, SQL_SELECT *select,
 			     IO_CACHE *buffpek_pointers,
                              IO_CACHE *tempfile,
                              Bounded_queue<uchar, uchar> *pq,
+                             Filesort_parallel *parallel,
                              ha_rows *found_rows)
 {
   int error,flag,quick_select;
@@ -685,6 +777,7 @@ static ha_rows find_all_keys(THD *thd, Sort_param *param, SQL_SELECT *select,
   TABLE *sort_form;
   handler *file;
   MY_BITMAP *save_read_set, *save_write_set, *save_vcol_set;
+  Filesort_buffer *keys_buffer= fs_info->get_filesort_buffer();
   
   DBUG_ENTER("find_all_keys");
   DBUG_PRINT("info",("using: %s",
@@ -832,12 +925,22 @@ static ha_rows find_all_keys(THD *thd, Sort_param *param, SQL_SELECT *select,
       {
         if (idx == param->max_keys_per_buffer)
         {
-          if (write_keys(param, fs_info, idx, buffpek_pointers, tempfile))
+          if (parallel && !parallel->is_started() &&
+              parallel->start(thd, param, fs_info))
+            parallel= NULL;                     // Sort in this thread
+          if (parallel)
+          {
+            if (!(keys_buffer= parallel->write_keys(thd, param, idx,
+                                                    buffpek_pointers,
+                                                    tempfile)))
+              DBUG_RETURN(HA_POS_ERROR);
+          }
+          else if (write_keys(param, fs_info, idx, buffpek_pointers, tempfile))
              DBUG_RETURN(HA_POS_ERROR);
 	  idx= 0;
 	  indexpos++;
         }
-        make_sortkey(param, fs_info->get_record_buffer(idx++), ref_pos);
+        make_sortkey(param, keys_buffer->get_record_buffer(idx++), ref_pos);
       }
     }
 
@@ -871,8 +974,16 @@ static ha_rows find_all_keys(THD *thd, Sort_param *param, SQL_SELECT *select,
     file->print_error(error,MYF(ME_ERROR | ME_WAITTANG)); // purecov: inspected
     DBUG_RETURN(HA_POS_ERROR);			/* purecov: inspected */
   }
-  if (indexpos && idx &&
-      write_keys(param, fs_info, idx, buffpek_pointers, tempfile))
+  if (parallel)
+  {
+    if (indexpos && idx &&
+        !parallel->write_keys(thd, param, idx, buffpek_pointers, tempfile))
+      DBUG_RETURN(HA_POS_ERROR);
+    if (parallel->end_of_keys(thd, tempfile))
+      DBUG_RETURN(HA_POS_ERROR);
+  }
+  else if (indexpos && idx &&
+           write_keys(param, fs_info, idx, buffpek_pointers, tempfile))
     DBUG_RETURN(HA_POS_ERROR);			/* purecov: inspected */
   const ha_rows retval=
     my_b_inited(tempfile) ?
@@ -941,6 +1052,365 @@ write_keys(Sort_param *param,  Filesort_info *fs_info, uint count,
 } /* write_keys */
 
 
+/**
+  Write function of an IO_CACHE that writes with pwrite() to the position
+  of the cache, see init_sort_write_cache().
+*/
+
+static int sort_cache_pwrite(IO_CACHE *info, const uchar *buffer,
+                             size_t count)
+{
+  if (buffer != info->write_buffer)
+  {
+    count&= ~((size_t) IO_SIZE - 1);
+    if (!count)
+      return 0;
+  }
+  if (mysql_file_pwrite(info->file, buffer, count, info->pos_in_file,
+                        info->myflags | MY_NABP))
+    return info->error= -1;
+  info->pos_in_file+= count;
+  return 0;
+}
+
+
+/**
+  Init a cache to write to a part of a temporary file that is shared
+  between the threads of a parallel sort. The cache does not use or move
+  the position of the file.
+*/
+
+static bool init_sort_write_cache(IO_CACHE *cache, File file, my_off_t pos)
+{
+  if (init_io_cache(cache, file, DISK_BUFFER_SIZE, WRITE_CACHE, pos, 0,
+                    MYF(MY_WME)))
+    return true;
+  cache->write_function= sort_cache_pwrite;
+  return false;
+}
+
+
+Sort_workers::Sort_workers()
+  :abort(false), worker_list(0), thread_count(0), jobs_busy(0),
+   first_job(0), last_job(&first_job), job_failed(false), shutdown(false)
+{}
+
+
+Sort_workers::~Sort_workers()
+{
+  stop();
+}
+
+
+pthread_handler_t sort_worker_thread(void *arg)
+{
+  Sort_workers::Worker *worker= (Sort_workers::Worker*) arg;
+  my_thread_init();
+  worker->workers->work(worker->number);
+  my_thread_end();
+  return 0;
+}
+
+
+/**
+  Start the worker threads.
+
+  @return Number of threads that could be started
+*/
+
+uint Sort_workers::start(uint count)
+{
+  DBUG_ENTER("Sort_workers::start");
+  DBUG_ASSERT(!worker_list);
+
+  if (!(worker_list= (Worker*) my_malloc(count * sizeof(Worker),
+                                         MYF(MY_THREAD_SPECIFIC))))
+    DBUG_RETURN(0);
+  mysql_mutex_init(key_LOCK_sort_workers, &LOCK_sort_workers,
+                   MY_MUTEX_INIT_FAST);
+  mysql_cond_init(key_COND_sort_job, &COND_sort_job, NULL);
+  mysql_cond_init(key_COND_sort_job_done, &COND_sort_job_done, NULL);
+  abort= job_failed= shutdown= false;
+  jobs_busy= 0;
+  first_job= 0;
+  last_job= &first_job;
+
+  for (thread_count= 0; thread_count < count; thread_count++)
+  {
+    Worker *worker= worker_list + thread_count;
+    worker->workers= this;
+    worker->number= thread_count;
+    if (mysql_thread_create(key_thread_sort_worker, &worker->thread_id, NULL,
+                            sort_worker_thread, worker))
+      break;
+  }
+  if (!thread_count)
+    stop();
+  DBUG_PRINT("info", ("started %u sort workers", thread_count));
+  DBUG_RETURN(thread_count);
+}
+
+
+/**
+  Stop the worker threads. Jobs that are queued are not run.
+*/
+
+void Sort_workers::stop()
+{
+  if (!worker_list)
+    return;
+  DBUG_ENTER("Sort_workers::stop");
+  mysql_mutex_lock(&LOCK_sort_workers);
+  abort= shutdown= true;
+  mysql_cond_broadcast(&COND_sort_job);
+  mysql_mutex_unlock(&LOCK_sort_workers);
+  for (uint i= 0; i < thread_count; i++)
+    pthread_join(worker_list[i].thread_id, NULL);
+  DBUG_ASSERT(!jobs_busy);
+  mysql_cond_destroy(&COND_sort_job_done);
+  mysql_cond_destroy(&COND_sort_job);
+  mysql_mutex_destroy(&LOCK_sort_workers);
+  my_free(worker_list);
+  worker_list= 0;
+  thread_count= 0;
+  DBUG_VOID_RETURN;
+}
+
+
+/** Give a job to the next free worker thread */
+
+void Sort_workers::add(Sort_job *job)
+{
+  DBUG_ASSERT(!job->busy);
+  mysql_mutex_lock(&LOCK_sort_workers);
+  job->next= 0;
+  job->busy= true;
+  *last_job= job;
+  last_job= &job->next;
+  jobs_busy++;
+  mysql_cond_signal(&COND_sort_job);
+  mysql_mutex_unlock(&LOCK_sort_workers);
+}
+
+
+/**
+  Wait until a job, or all jobs if job is NULL, are done.
+
+  If the query is killed, the jobs are told to stop and we still wait for
+  them, so that the caller can free the memory that they use.
+
+  @retval false  ok
+  @retval true   A job failed or the query was killed. The error is set.
+*/
+
+bool Sort_workers::wait(THD *thd, Sort_job *job)
+{
+  bool failed;
+  mysql_mutex_lock(&LOCK_sort_workers);
+  if (thd)
+    thd->ENTER_COND(&COND_sort_job_done, &LOCK_sort_workers, NULL, NULL);
+  while (job ? job->busy : jobs_busy != 0)
+  {
+    if (thd && thd->killed)
+      abort= true;
+    mysql_cond_wait(&COND_sort_job_done, &LOCK_sort_workers);
+  }
+  if (thd && thd->killed)
+    abort= true;
+  failed= job_failed;
+  if (thd)
+    thd->EXIT_COND(NULL);
+  else
+    mysql_mutex_unlock(&LOCK_sort_workers);
+
+  if (failed && (!thd || (!thd->is_error() && !thd->killed)))
+    my_error(ER_TEMP_FILE_WRITE_FAILURE, MYF(0));
+  return failed || abort;
+}
+
+
+/** Run jobs until the workers are stopped, in a worker thread */
+
+void Sort_workers::work(uint worker)
+{
+  mysql_mutex_lock(&LOCK_sort_workers);
+  for (;;)
+  {
+    Sort_job *job;
+    while (!(job= first_job) && !shutdown)
+      mysql_cond_wait(&COND_sort_job, &LOCK_sort_workers);
+    if (!job)
+      break;
+    if (!(first_job= job->next))
+      last_job= &first_job;
+    if (!abort)
+    {
+      mysql_mutex_unlock(&LOCK_sort_workers);
+      bool error= job->run(worker);
+      mysql_mutex_lock(&LOCK_sort_workers);
+      if (error)
+      {
+        job_failed= true;
+        abort= true;
+      }
+    }
+    job->busy= false;
+    jobs_busy--;
+    mysql_cond_broadcast(&COND_sort_job_done);
+  }
+  mysql_mutex_unlock(&LOCK_sort_workers);
+}
+
+
+bool Sort_buffer_job::run(uint worker)
+{
+  IO_CACHE cache;
+  uchar **keys= buffer->get_sort_keys(), **end= keys + write_count;
+  bool error;
+
+  buffer->sort_buffer(param, count, MYF(0));
+  if (init_sort_write_cache(&cache, file, file_pos))
+    return true;
+  for (; keys != end; keys++)
+  {
+    if (my_b_write(&cache, *keys, param->rec_length))
+      break;
+  }
+  error= keys != end;
+  if (end_io_cache(&cache))
+    error= true;
+  return error;
+}
+
+
+/**
+  Start the worker threads and allocate a buffer for every worker.
+
+  @retval false  ok
+  @retval true   The sort has to be done by the thread of the query
+*/
+
+bool Filesort_parallel::start(THD *thd, Sort_param *param,
+                              Filesort_info *fs_info)
+{
+  uint count= (uint) thd->variables.max_sort_threads, threads, i;
+  DBUG_ENTER("Filesort_parallel::start");
+
+  if (!my_multi_malloc(MYF(MY_THREAD_SPECIFIC),
+                       &buffers, (count + 1) * sizeof(*buffers),
+                       &own_buffers, count * sizeof(*own_buffers),
+                       &jobs, (count + 1) * sizeof(*jobs),
+                       &sort_buffers, count * sizeof(*sort_buffers),
+                       NullS))
+    DBUG_RETURN(true);
+  buffers[0]= fs_info->get_filesort_buffer();
+  for (i= 0; i < count; i++)
+    new (own_buffers + i) Filesort_buffer;
+  own_buffer_count= count;
+  for (buffer_count= 1; buffer_count <= count; buffer_count++)
+  {
+    Filesort_buffer *buffer= own_buffers + buffer_count - 1;
+    if (!buffer->alloc_sort_buffer(param->max_keys_per_buffer,
+                                   param->rec_length))
+      break;
+    buffers[buffer_count]= buffer;
+  }
+  /* We need a buffer for the query thread and one for every worker */
+  if (buffer_count < 2 || !(threads= workers.start(buffer_count - 1)))
+  {
+    end();
+    DBUG_RETURN(true);
+  }
+  buffer_count= threads + 1;
+  for (i= 0; i < buffer_count; i++)
+  {
+    new (jobs + i) Sort_buffer_job;
+    jobs[i].buffer= buffers[i];
+  }
+  for (i= 0; i < threads; i++)
+    sort_buffers[i]= (uchar*) buffers[i]->get_sort_keys();
+  param->workers_abort= &workers.abort;
+  current= 0;
+  end_of_runs= 0;
+  DBUG_RETURN(false);
+}
+
+
+/**
+  Give the full buffer to a worker that sorts and writes it, see
+  write_keys().
+
+  @return The next buffer to fill, NULL on error
+*/
+
+Filesort_buffer *Filesort_parallel::write_keys(THD *thd, Sort_param *param,
+                                               uint count,
+                                               IO_CACHE *buffpek_pointers,
+                                               IO_CACHE *tempfile)
+{
+  Sort_buffer_job *job= jobs + current;
+  BUFFPEK buffpek;
+  DBUG_ENTER("Filesort_parallel::write_keys");
+
+  if (!my_b_inited(tempfile) &&
+      open_cached_file(tempfile, mysql_tmpdir, TEMP_PREFIX, DISK_BUFFER_SIZE,
+                       MYF(MY_WME)))
+    DBUG_RETURN(NULL);
+  /* The workers write with pwrite(), so the file must exist */
+  if (tempfile->file < 0 && real_open_cached_file(tempfile))
+    DBUG_RETURN(NULL);
+  if (my_b_tell(buffpek_pointers) + sizeof(BUFFPEK) > (ulonglong)UINT_MAX)
+    DBUG_RETURN(NULL);
+
+  job->param= param;
+  job->count= count;
+  job->write_count= (uint) MY_MIN((ha_rows) count, param->max_rows);
+  job->file= tempfile->file;
+  job->file_pos= end_of_runs;
+  buffpek.file_pos= end_of_runs;
+  buffpek.count= job->write_count;
+  if (my_b_write(buffpek_pointers, (uchar*) &buffpek, sizeof(buffpek)))
+    DBUG_RETURN(NULL);
+  end_of_runs+= (my_off_t) job->write_count * param->rec_length;
+  workers.add(job);
+
+  current= (current + 1) % buffer_count;
+  if (workers.wait(thd, jobs + current))
+    DBUG_RETURN(NULL);
+  DBUG_RETURN(buffers[current]);
+}
+
+
+/**
+  Wait until all buffers are written and set the end of the temporary
+  file as if the runs were written through it.
+*/
+
+bool Filesort_parallel::end_of_keys(THD *thd, IO_CACHE *tempfile)
+{
+  if (!is_started())
+    return false;
+  return (workers.wait(thd) ||
+          reinit_io_cache(tempfile, WRITE_CACHE, end_of_runs, 0, 1));
+}
+
+
+/** Stop the workers and free the buffers */
+
+void Filesort_parallel::end()
+{
+  workers.stop();
+  if (buffers)
+  {
+    for (uint i= 0; i < own_buffer_count; i++)
+      own_buffers[i].free_sort_buffer();
+    my_free(buffers);
+    buffers= 0;
+    own_buffer_count= 0;
+  }
+}
+
+
 /**
   Store length as suffix in high-byte-first order.
 */
@@ -1571,11 +2041,16 @@ int merge_buffers(Sort_param *param, IO_CACHE *from_file,
   uchar *src;
   uchar *unique_buff= param->unique_buff;
   const bool killable= !param->not_killable;
+  /* NULL in the worker threads of a parallel sort */
   THD* const thd=current_thd;
   DBUG_ENTER("merge_buffers");
+  DBUG_ASSERT(thd || param->workers_abort || !killable);
 
-  thd->inc_status_sort_merge_passes();
-  thd->query_plan_fsort_passes++;
+  if (thd)
+  {
+    thd->inc_status_sort_merge_passes();
+    thd->query_plan_fsort_passes++;
+  }
 
   error=0;
   rec_length= param->rec_length;
@@ -1652,7 +2127,8 @@ int merge_buffers(Sort_param *param, IO_CACHE *from_file,
 
   while (queue.elements > 1)
   {
-    if (killable && thd->check_killed())
+    if (killable &&
+        (thd ? thd->check_killed() : *param->workers_abort))
     {
       error= 1; goto err;                        /* purecov: inspected */
     }
@@ -1830,6 +2306,322 @@ int merge_index(Sort_param *param, uchar *sort_buffer,
 } /* merge_index */
 
 
+/**
+  Merge of a group of buffers, or of a part of the final merge, done by a
+  worker thread. The result is written to its place in to_file, that is
+  known before the merge.
+*/
+
+class Sort_merge_job :public Sort_job
+{
+public:
+  Sort_param param;
+  IO_CACHE *from_file;
+  File to_file;
+  my_off_t to_pos;
+  my_off_t written;                      // Length of the result in to_file
+  uchar **sort_buffers;
+  BUFFPEK result, *first, *last;
+  int flag;
+
+  bool run(uint worker)
+  {
+    IO_CACHE cache;
+    bool error;
+    /* A merge that removes duplicates keeps the last key after the buffer */
+    if (param.unique_buff)
+      param.unique_buff= (sort_buffers[worker] +
+                          param.max_keys_per_buffer * param.rec_length);
+    if (init_sort_write_cache(&cache, to_file, to_pos))
+      return true;
+    error= merge_buffers(&param, from_file, &cache, sort_buffers[worker],
+                         &result, first, last, flag) != 0;
+    written= my_b_tell(&cache) - to_pos;
+    if (end_io_cache(&cache))
+      error= true;
+    return error;
+  }
+};
+
+
+/**
+  Merge buffers to make < MERGEBUFF2 buffers, like merge_many_buff(), with
+  the groups of MERGEBUFF buffers of every pass merged by worker threads.
+
+  The result of each group is written to its own part of the same file,
+  of the size of the group. If duplicates are removed (the runs of a
+  Unique), the result may be shorter and leave a gap before the next part,
+  the runs are still found by their BUFFPEK.
+
+  @param sort_buffers  Merge buffer of every worker, of
+                       param->max_keys_per_buffer keys
+
+  @retval false  ok
+  @retval true   error
+*/
+
+bool merge_many_buff_parallel(Sort_param *param, Sort_workers *workers,
+                              uchar **sort_buffers, BUFFPEK *buffpek,
+                              uint *maxbuffer, IO_CACHE *t_file)
+{
+  IO_CACHE t_file2, *from_file, *to_file, *temp;
+  Sort_merge_job *jobs;
+  uint i, groups, last;
+  my_off_t pos= 0;
+  bool error= true;
+  THD *thd= current_thd;
+  DBUG_ENTER("merge_many_buff_parallel");
+
+  if (*maxbuffer < MERGEBUFF2)
+    DBUG_RETURN(false);
+  if (flush_io_cache(t_file) ||
+      open_cached_file(&t_file2, mysql_tmpdir, TEMP_PREFIX, DISK_BUFFER_SIZE,
+                       MYF(MY_WME)))
+    DBUG_RETURN(true);
+  /* The first pass has the most groups */
+  groups= (*maxbuffer - MERGEBUFF*3/2) / MERGEBUFF + 2;
+  if (real_open_cached_file(&t_file2) ||
+      !(jobs= (Sort_merge_job*) my_malloc(groups * sizeof(*jobs),
+                                          MYF(MY_WME | MY_THREAD_SPECIFIC))))
+  {
+    close_cached_file(&t_file2);
+    DBUG_RETURN(true);
+  }
+
+  from_file= t_file; to_file= &t_file2;
+  while (*maxbuffer >= MERGEBUFF2)
+  {
+    pos= 0;
+    /* Same groups as in merge_many_buff() */
+    for (i= 0, groups= 0; i <= *maxbuffer; i= last + 1, groups++)
+    {
+      Sort_merge_job *job= new (jobs + groups) Sort_merge_job;
+      ha_rows rows= 0;
+      last= (i + MERGEBUFF*3/2 <= *maxbuffer) ? i + MERGEBUFF - 1 : *maxbuffer;
+      job->param= *param;
+      job->from_file= from_file;
+      job->to_file= to_file->file;
+      job->to_pos= pos;
+      job->sort_buffers= sort_buffers;
+      job->first= buffpek + i;
+      job->last= buffpek + last;
+      job->flag= 0;
+      for (BUFFPEK *run= job->first; run <= job->last; run++)
+        rows+= run->count;
+      set_if_smaller(rows, param->max_rows);
+      pos+= rows * param->rec_length;
+      workers->add(job);
+    }
+    if (workers->wait(thd))
+      goto cleanup;
+    for (i= 0; i < groups; i++)
+    {
+      buffpek[i]= jobs[i].result;
+      if (thd)
+      {
+        thd->inc_status_sort_merge_passes();
+        thd->query_plan_fsort_passes++;
+      }
+    }
+    temp=from_file; from_file=to_file; to_file=temp;
+    *maxbuffer= groups - 1;
+  }
+  /* Set the end of the result as if it was written through the cache */
+  error= reinit_io_cache(from_file, WRITE_CACHE, pos, 0, 1);
+
+cleanup:
+  my_free(jobs);
+  close_cached_file(to_file);                   // This holds old result
+  if (to_file == t_file)
+  {
+    *t_file=t_file2;                            // Copy result file
+    setup_io_cache(t_file);
+  }
+  DBUG_RETURN(error);
+} /* merge_many_buff_parallel */
+
+
+/**
+  Find the first key of a sorted run that is not smaller than key.
+  The keys of a Unique are compared with its compare function.
+*/
+
+static bool find_run_bound(Sort_param *param, IO_CACHE *file, BUFFPEK *run,
+                           uchar *key, uchar *buff, ha_rows low,
+                           ha_rows *bound)
+{
+  ha_rows high= run->count;
+  while (low < high)
+  {
+    ha_rows middle= low + (high - low) / 2;
+    if (my_b_pread(file, buff, param->sort_length,
+                   run->file_pos + middle * param->rec_length))
+      return true;
+    if ((param->unique_buff ?
+         param->cmp_context.key_compare(param->cmp_context.key_compare_arg,
+                                        buff, key) :
+         memcmp(buff, key, param->sort_length)) < 0)
+      low= middle + 1;
+    else
+      high= middle;
+  }
+  *bound= low;
+  return false;
+}
+
+
+/**
+  Do the final merge to the output file, like merge_index(), in worker
+  threads.
+
+  The key range is split into one part for every worker with keys of the
+  longest run as splitters, and the position of every splitter in every
+  run is found with a binary search. The parts are then merged
+  independently, each to its place in the output file.
+
+  The runs of a Unique (param->unique_buff is set) hold no duplicates, and
+  all copies of a key go to the same part, so the parts can remove the
+  duplicates on their own. The length of their results is then not known
+  before the merge: each part is written to the place it would have
+  without duplicates, and the place and number of keys of the result of
+  every part is returned in part_results.
+
+  @param flag          As for merge_buffers()
+  @param part_results  NULL, or room for workers->threads() parts, which
+                       is required if duplicates are removed
+  @param part_count    Number of parts in part_results
+
+  @retval false  ok
+  @retval true   error
+*/
+
+bool merge_index_parallel(Sort_param *param, Sort_workers *workers,
+                          uchar **sort_buffers, BUFFPEK *buffpek,
+                          uint maxbuffer, IO_CACHE *tempfile,
+                          IO_CACHE *outfile, int flag,
+                          BUFFPEK *part_results, uint *part_count)
+{
+  uint runs= maxbuffer + 1, parts= workers->threads(), part, run;
+  uint sort_length= param->sort_length, jobs_added= 0;
+  uint length= flag ? param->res_length : param->rec_length;
+  BUFFPEK *longest= buffpek, *part_runs;
+  Sort_merge_job *jobs;
+  uchar *splitters, *key;
+  ha_rows *bounds, rows_before= 0;
+  my_off_t start;
+  bool error= true;
+  THD *thd= current_thd;
+  DBUG_ENTER("merge_index_parallel");
+  DBUG_ASSERT(part_results || (!param->unique_buff && !param->min_dupl_count));
+
+  for (run= 1; run < runs; run++)
+  {
+    if (buffpek[run].count > longest->count)
+      longest= buffpek + run;
+  }
+  set_if_smaller(parts, longest->count);
+  if (parts < 2 && !part_results)
+    DBUG_RETURN(merge_index(param, sort_buffers[0], buffpek, maxbuffer,
+                            tempfile, outfile) != 0);
+
+  if (!my_multi_malloc(MYF(MY_WME | MY_THREAD_SPECIFIC),
+                       &splitters, (parts - 1) * sort_length,
+                       &key, sort_length,
+                       &bounds, runs * (parts + 1) * sizeof(*bounds),
+                       &part_runs, runs * parts * sizeof(*part_runs),
+                       &jobs, parts * sizeof(*jobs),
+                       NullS))
+    DBUG_RETURN(true);
+  if ((outfile->file < 0 && real_open_cached_file(outfile)) ||
+      flush_io_cache(outfile))
+    goto end;
+  start= my_b_tell(outfile);
+
+  for (part= 1; part < parts; part++)
+  {
+    if (my_b_pread(tempfile, splitters + (part - 1) * sort_length,
+                   sort_length,
+                   longest->file_pos +
+                   longest->count * part / parts * param->rec_length))
+      goto end;
+  }
+  /* bounds[run * (parts + 1) + part] is the first key of part in run */
+  for (run= 0; run < runs; run++)
+  {
+    ha_rows *run_bounds= bounds + run * (parts + 1);
+    run_bounds[0]= 0;
+    run_bounds[parts]= buffpek[run].count;
+    for (part= 1; part < parts; part++)
+    {
+      if (find_run_bound(param, tempfile, buffpek + run,
+                         splitters + (part - 1) * sort_length, key,
+                         run_bounds[part - 1], run_bounds + part))
+        goto end;
+    }
+  }
+
+  for (part= 0; part < parts && rows_before < param->max_rows; part++)
+  {
+    Sort_merge_job *job= jobs + jobs_added;
+    BUFFPEK *first= part_runs + part * runs, *last= first;
+    ha_rows rows= 0;
+    for (run= 0; run < runs; run++)
+    {
+      ha_rows *run_bounds= bounds + run * (parts + 1);
+      if (run_bounds[part + 1] == run_bounds[part])
+        continue;
+      last->file_pos= (buffpek[run].file_pos +
+                       run_bounds[part] * param->rec_length);
+      last->count= run_bounds[part + 1] - run_bounds[part];
+      rows+= last->count;
+      last++;
+    }
+    if (!rows)
+      continue;
+    new (job) Sort_merge_job;
+    job->param= *param;
+    job->param.max_rows= MY_MIN(rows, param->max_rows - rows_before);
+    job->from_file= tempfile;
+    job->to_file= outfile->file;
+    job->to_pos= start + rows_before * length;
+    job->sort_buffers= sort_buffers;
+    job->first= first;
+    job->last= last - 1;
+    job->flag= flag;
+    rows_before+= job->param.max_rows;
+    jobs_added++;
+    workers->add(job);
+  }
+  if (workers->wait(thd))
+    goto end;
+  if (thd)
+  {
+    thd->inc_status_sort_merge_passes();
+    thd->query_plan_fsort_passes++;
+  }
+  if (part_results)
+  {
+    for (part= 0; part < jobs_added; part++)
+    {
+      part_results[part].file_pos= jobs[part].to_pos;
+      part_results[part].count= jobs[part].written / length;
+    }
+    *part_count= jobs_added;
+    error= false;
+  }
+  else
+  {
+    /* Set the end of the output as if it was written through the cache */
+    error= reinit_io_cache(outfile, WRITE_CACHE,
+                           start + rows_before * length, 0, 1);
+  }
+
+end:
+  my_free(splitters);
+  DBUG_RETURN(error);
+} /* merge_index_parallel */
+
+
 static uint suffix_length(ulong string_length)
 {
   if (string_length < 256)
@@ -123,7 +123,8 @@ void Filesort_buffer::free_sort_buffer()
 }
 
 
-void Filesort_buffer::sort_buffer(const Sort_param *param, uint count)
+void Filesort_buffer::sort_buffer(const Sort_param *param, uint count,
+                                  myf flags)
 {
   size_t size= param->sort_length;
   if (count <= 1 || size == 0)
@@ -131,8 +132,7 @@ void Filesort_buffer::sort_buffer(const Sort_param *param, uint count)
   uchar **keys= get_sort_keys();
   uchar **buffer= NULL;
   if (radixsort_is_appliccable(count, param->sort_length) &&
-      (buffer= (uchar**) my_malloc(count*sizeof(char*),
-                                   MYF(MY_THREAD_SPECIFIC))))
+      (buffer= (uchar**) my_malloc(count*sizeof(char*), flags)))
   {
     radixsort_for_str_ptr(keys, count, param->sort_length, buffer);
     my_free(buffer);
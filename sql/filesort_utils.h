@@ -64,8 +64,12 @@ class Filesort_buffer
     m_idx_array(), m_record_length(0), m_start_of_data(NULL)
   {}
 
-  /** Sort me... */
-  void sort_buffer(const Sort_param *param, uint count);
+  /**
+    Sort me...
+    @param flags  Flags for temporary memory, MYF(0) in threads without THD
+  */
+  void sort_buffer(const Sort_param *param, uint count,
+                   myf flags= MYF(MY_THREAD_SPECIFIC));
 
   /// Initializes a record pointer.
   uchar *get_record_buffer(uint idx)
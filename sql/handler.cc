@@ -25,6 +25,7 @@
 #include "unireg.h"
 #include "rpl_handler.h"
 #include "sql_cache.h"                   // query_cache, query_cache_*
+#include "sql_expression_cache.h"        // publish_table_versions
 #include "sql_connect.h"                 // global_table_stats
 #include "key.h"     // key_copy, key_unpack, key_cmp_if_same, key_cmp
 #include "sql_table.h"                   // build_table_filename
@@ -1348,7 +1349,10 @@ int ha_commit_trans(THD *thd, bool all)
       Free resources and perform other cleanup even for 'empty' transactions.
     */
     if (is_real_trans)
+    {
       thd->transaction.cleanup();
+      publish_table_versions(thd, TRUE);
+    }
     DBUG_RETURN(0);
   }
 
@@ -1578,6 +1582,7 @@ commit_one_phase_2(THD *thd, bool all, THD_TRANS *trans, bool is_real_trans)
   {
     thd->has_waiter= false;
     thd->transaction.cleanup();
+    publish_table_versions(thd, TRUE);
   }
 
   DBUG_RETURN(error);
@@ -1682,6 +1687,7 @@ int ha_rollback_trans(THD *thd, bool all)
   {
     thd->has_waiter= false;
     thd->transaction.cleanup();
+    publish_table_versions(thd, TRUE);
   }
   if (all)
     thd->transaction_rollback_request= FALSE;
@@ -3967,6 +3973,19 @@ handler::mark_trx_read_write()
 }
 
 
+/**
+  Mark the table changed for the persistent subquery caches, see
+  publish_table_versions().
+*/
+
+inline void
+handler::mark_table_version_changed()
+{
+  if (table_share && table_share->tmp_table == NO_TMP_TABLE)
+    ha_thd()->mark_table_version_changed(table_share->version_slot);
+}
+
+
 /**
   Repair table: public interface.
 
@@ -4002,6 +4021,7 @@ handler::ha_bulk_update_row(const uchar *old_data, uchar *new_data,
   DBUG_ASSERT(table_share->tmp_table != NO_TMP_TABLE ||
               m_lock_type == F_WRLCK);
   mark_trx_read_write();
+  mark_table_version_changed();
 
   return bulk_update_row(old_data, new_data, dup_key_found);
 }
@@ -4019,6 +4039,7 @@ handler::ha_delete_all_rows()
   DBUG_ASSERT(table_share->tmp_table != NO_TMP_TABLE ||
               m_lock_type == F_WRLCK);
   mark_trx_read_write();
+  mark_table_version_changed();
 
   return delete_all_rows();
 }
@@ -4036,6 +4057,7 @@ handler::ha_truncate()
   DBUG_ASSERT(table_share->tmp_table != NO_TMP_TABLE ||
               m_lock_type == F_WRLCK);
   mark_trx_read_write();
+  mark_table_version_changed();
 
   return truncate();
 }
@@ -5921,6 +5943,7 @@ int handler::ha_write_row(uchar *buf)
 
   MYSQL_INSERT_ROW_START(table_share->db.str, table_share->table_name.str);
   mark_trx_read_write();
+  mark_table_version_changed();
   increment_statistics(&SSV::ha_write_count);
 
   TABLE_IO_WAIT(tracker, m_psi, PSI_TABLE_WRITE_ROW, MAX_KEY, 0,
@@ -5954,6 +5977,7 @@ int handler::ha_update_row(const uchar *old_data, uchar *new_data)
 
   MYSQL_UPDATE_ROW_START(table_share->db.str, table_share->table_name.str);
   mark_trx_read_write();
+  mark_table_version_changed();
   increment_statistics(&SSV::ha_update_count);
 
   TABLE_IO_WAIT(tracker, m_psi, PSI_TABLE_UPDATE_ROW, active_index, 0,
@@ -5982,6 +6006,7 @@ int handler::ha_delete_row(const uchar *buf)
 
   MYSQL_DELETE_ROW_START(table_share->db.str, table_share->table_name.str);
   mark_trx_read_write();
+  mark_table_version_changed();
   increment_statistics(&SSV::ha_delete_count);
 
   TABLE_IO_WAIT(tracker, m_psi, PSI_TABLE_DELETE_ROW, active_index, 0,
@@ -3896,6 +3896,7 @@ class handler :public Sql_alloc
 private:
   /* Private helpers */
   inline void mark_trx_read_write();
+  inline void mark_table_version_changed();
 private:
   inline void increment_statistics(ulong SSV::*offset) const;
   inline void decrement_statistics(ulong SSV::*offset) const;
@@ -3724,10 +3724,76 @@ void in_row::set(uint pos, Item *item)
   DBUG_VOID_RETURN;
 }
 
+/*
+  Lists with fewer values than this are searched with the binary search,
+  for them it is as fast as a hash lookup and needs no extra memory
+*/
+#define IN_LIST_HASH_MIN_ELEMENTS 16
+
 in_longlong::in_longlong(uint elements)
-  :in_vector(elements,sizeof(packed_longlong),(qsort2_cmp) cmp_longlong, 0)
+  :in_vector(elements,sizeof(packed_longlong),(qsort2_cmp) cmp_longlong, 0),
+   hash(0)
 {}
 
+
+/*
+  Sort the values and build the hash set of a long list
+
+  NOTES
+    The sorted array is kept, the range optimizer reads the values from
+    it. If there is no memory for the hash set, find() uses the binary
+    search.
+*/
+
+void in_longlong::sort()
+{
+  uint slots, bits;
+  in_vector::sort();
+  hash= 0;
+  if (used_count < IN_LIST_HASH_MIN_ELEMENTS)
+    return;
+
+  /* At least two slots per value keeps the probe sequences short */
+  for (bits= 1, slots= 2; slots < used_count * 2; bits++, slots*= 2) ;
+  if (!(hash= (packed_longlong*) sql_alloc(slots * sizeof(packed_longlong))))
+    return;
+  hash_shift= 64 - bits;
+  hash_mask= slots - 1;
+  for (uint i= 0; i < slots; i++)
+    hash[i].unsigned_flag= -1;
+
+  for (uint i= 0; i < used_count; i++)
+  {
+    packed_longlong *value= (packed_longlong*) base + i;
+    longlong flag= value->unsigned_flag && value->val < 0;
+    uint slot= hash_slot(value->val);
+    while (hash[slot].unsigned_flag >= 0 &&
+           !(hash[slot].val == value->val && hash[slot].unsigned_flag == flag))
+      slot= (slot + 1) & hash_mask;
+    hash[slot].val= value->val;
+    hash[slot].unsigned_flag= flag;
+  }
+}
+
+
+bool in_longlong::find(Item *item)
+{
+  packed_longlong *value;
+  if (!hash)
+    return in_vector::find(item);
+  if (!(value= (packed_longlong*) get_value(item)))
+    return false;				// Null value
+
+  longlong flag= value->unsigned_flag && value->val < 0;
+  for (uint slot= hash_slot(value->val); ; slot= (slot + 1) & hash_mask)
+  {
+    if (hash[slot].unsigned_flag < 0)
+      return false;
+    if (hash[slot].val == value->val && hash[slot].unsigned_flag == flag)
+      return true;
+  }
+}
+
 void in_longlong::set(uint pos,Item *item)
 {
   struct packed_longlong *buff= &((packed_longlong*) base)[pos];
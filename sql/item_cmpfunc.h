@@ -1089,11 +1089,11 @@ class in_vector :public Sql_alloc
   virtual ~in_vector() {}
   virtual void set(uint pos,Item *item)=0;
   virtual uchar *get_value(Item *item)=0;
-  void sort()
+  virtual void sort()
   {
     my_qsort2(base,used_count,size,compare,(void*)collation);
   }
-  bool find(Item *item);
+  virtual bool find(Item *item);
   
   /* 
     Create an instance of Item_{type} (e.g. Item_decimal) constant object
@@ -1167,10 +1167,26 @@ class in_longlong :public in_vector
     longlong val;
     longlong unsigned_flag;  // Use longlong, not bool, to preserve alignment
   } tmp;
+  /*
+    Open addressing hash set of the values of a long list, find() probes
+    it instead of doing a binary search in base. The values are stored
+    with unsigned_flag set only for the unsigned values above LONGLONG_MAX,
+    so that the values cmp_longlong() considers equal are stored equal.
+    An empty slot has unsigned_flag == -1.
+  */
+  packed_longlong *hash;
+  uint hash_shift;
+  uint hash_mask;
+  uint hash_slot(longlong val)
+  {
+    return (uint) (((ulonglong) val * 0x9E3779B97F4A7C15ULL) >> hash_shift);
+  }
 public:
   in_longlong(uint elements);
   void set(uint pos,Item *item);
   uchar *get_value(Item *item);
+  void sort();
+  bool find(Item *item);
   Item* create_item(THD *thd);
   void value_to_item(uint pos, Item *item)
   {
@@ -2210,6 +2210,138 @@ bool Item_sum_and::add()
   return 0;
 }
 
+
+/* approx_count_distinct */
+
+/**
+  Hash of the value of an argument. Values that are equal for
+  COUNT(DISTINCT) have the same hash.
+*/
+
+ulonglong Item_sum_approx_count_distinct::hash_arg(Item *arg)
+{
+  switch (arg->cmp_type()) {
+  case INT_RESULT:
+    return Hll_sketch::hash_int((ulonglong) arg->val_int());
+  case REAL_RESULT:
+  {
+    uchar buff[8];
+    double nr= arg->val_real();
+    if (nr == 0.0)
+      nr= 0.0;                                  // -0.0 is 0
+    float8store(buff, nr);
+    return Hll_sketch::hash_int(uint8korr(buff));
+  }
+  case DECIMAL_RESULT:
+  {
+    my_decimal value, *dec= arg->val_decimal(&value);
+    uchar buff[DECIMAL_MAX_FIELD_SIZE];
+    uint precision= arg->decimal_precision();
+    uint scale= MY_MIN(arg->decimals, DECIMAL_MAX_SCALE);
+    if (arg->null_value)
+      return 0;
+    /* Same binary form as in the field of COUNT(DISTINCT) */
+    my_decimal2binary(E_DEC_FATAL_ERROR & ~E_DEC_OVERFLOW, dec, buff,
+                      precision, scale);
+    return Hll_sketch::hash_bytes(buff, my_decimal_get_binary_size(precision,
+                                                                   scale));
+  }
+  case TIME_RESULT:
+  {
+    MYSQL_TIME ltime;
+    if (arg->get_date(&ltime, TIME_FUZZY_DATES | TIME_INVALID_DATES))
+      return 0;
+    return Hll_sketch::hash_int((ulonglong) pack_time(&ltime));
+  }
+  case STRING_RESULT:
+  {
+    String *res= arg->val_str(&tmp_value);
+    CHARSET_INFO *cs;
+    const uchar *ptr;
+    size_t length;
+    if (!res)
+      return 0;
+    cs= res->charset();
+    ptr= (const uchar*) res->ptr();
+    length= res->length();
+    if (cs == &my_charset_bin)
+      return Hll_sketch::hash_bytes(ptr, length);
+    /* Trailing spaces are not significant in comparisons */
+    length= cs->cset->lengthsp(cs, (const char*) ptr, length);
+    if (!(cs->state & MY_CS_BINSORT))
+    {
+      uint nweights= (uint) cs->cset->numchars(cs, (const char*) ptr,
+                                               (const char*) ptr + length);
+      size_t weights_length= cs->coll->strnxfrmlen(cs, nweights *
+                                                       cs->mbmaxlen);
+      if (weights.alloc(weights_length))
+        return 0;
+      length= cs->coll->strnxfrm(cs, (uchar*) weights.ptr(), weights_length,
+                                 nweights, ptr, length, 0);
+      ptr= (const uchar*) weights.ptr();
+    }
+    return Hll_sketch::hash_bytes(ptr, length);
+  }
+  case ROW_RESULT:
+    DBUG_ASSERT(0);
+  }
+  return 0;
+}
+
+
+bool Item_sum_approx_count_distinct::setup(THD *thd)
+{
+  uchar *registers;
+  if (sketch.is_inited())
+    return FALSE;
+  if (!(registers= (uchar*) thd->alloc(HLL_REGISTERS)))
+    return TRUE;
+  sketch.init(registers);
+  return FALSE;
+}
+
+
+void Item_sum_approx_count_distinct::clear()
+{
+  if (sketch.is_inited())
+    sketch.clear();
+}
+
+
+bool Item_sum_approx_count_distinct::add()
+{
+  ulonglong hash= 0;
+  for (uint i= 0; i < arg_count; i++)
+  {
+    ulonglong value= hash_arg(args[i]);
+    if (args[i]->null_value)
+      return 0;
+    hash= i ? Hll_sketch::hash_combine(hash, value) : value;
+  }
+  sketch.add(hash);
+  return 0;
+}
+
+
+longlong Item_sum_approx_count_distinct::val_int()
+{
+  DBUG_ASSERT(fixed == 1);
+  return sketch.is_inited() ? (longlong) sketch.estimate() : 0;
+}
+
+
+void Item_sum_approx_count_distinct::cleanup()
+{
+  sketch.reset();
+  Item_sum_int::cleanup();
+}
+
+
+Item *Item_sum_approx_count_distinct::copy_or_same(THD* thd)
+{
+  return new (thd->mem_root) Item_sum_approx_count_distinct(thd, this);
+}
+
 /************************************************************************
 ** reset result of a Item_sum with is saved in a tmp_table
 *************************************************************************/
@@ -2932,17 +3064,19 @@ int group_concat_key_cmp_with_distinct(void* arg, const void* key1,
 
 
 /**
-  function of sort for syntax: GROUP_CONCAT(expr,... ORDER BY col,... )
+  Compares the values of the ORDER BY expressions of GROUP_CONCAT.
+
+  @retval -1 : key1 < key2 in the requested order
+  @retval  0 : the ORDER BY values are equal
+  @retval  1 : key1 > key2 in the requested order
 */
 
-extern "C"
-int group_concat_key_cmp_with_order(void* arg, const void* key1, 
-                                    const void* key2)
+int Item_func_group_concat::cmp_order_keys(const uchar *key1,
+                                           const uchar *key2)
 {
-  Item_func_group_concat* grp_item= (Item_func_group_concat*) arg;
   ORDER **order_item, **end;
 
-  for (order_item= grp_item->order, end=order_item+ grp_item->arg_count_order;
+  for (order_item= order, end=order_item + arg_count_order;
        order_item < end;
        order_item++)
   {
@@ -2965,7 +3099,7 @@ int group_concat_key_cmp_with_order(void* arg, const void* key1,
       the temporary table, not the original field
 
       Note that for the case of ROLLUP, field may point to another table
-      tham grp_item->table. This is however ok as the table definitions are
+      than this->table. This is however ok as the table definitions are
       the same.
     */
     Field *field= item->get_tmp_table_field();
@@ -2978,12 +3112,57 @@ int group_concat_key_cmp_with_order(void* arg, const void* key1,
     if (res)
       return (*order_item)->asc ? res : -res;
   }
+  return 0;
+}
+
+
+/**
+  function of sort for syntax: GROUP_CONCAT(expr,... ORDER BY col,... )
+*/
+
+extern "C"
+int group_concat_key_cmp_with_order(void* arg, const void* key1, 
+                                    const void* key2)
+{
+  Item_func_group_concat* grp_item= (Item_func_group_concat*) arg;
+  int res= grp_item->cmp_order_keys((const uchar*) key1, (const uchar*) key2);
   /*
     We can't return 0 because in that case the tree class would remove this
     item as double value. This would cause problems for case-changes and
     if the returned values are not the same we do the sort on.
   */
-  return 1;
+  return res ? res : 1;
+}
+
+
+/**
+  function of sort for syntax:
+  GROUP_CONCAT(DISTINCT expr,... ORDER BY col,... ) when all ORDER BY
+  columns are in the expr list. Rows with equal expr values are then
+  neighbours in the sort order.
+*/
+
+extern "C"
+int group_concat_key_cmp_with_distinct_and_order(void* arg, const void* key1,
+                                                 const void* key2)
+{
+  Item_func_group_concat* grp_item= (Item_func_group_concat*) arg;
+  int res= grp_item->cmp_order_keys((const uchar*) key1, (const uchar*) key2);
+  return res ? res : group_concat_key_cmp_with_distinct(arg, key1, key2);
+}
+
+
+/**
+  Add a distinct value from unique_filter to unique_order.
+*/
+
+extern "C"
+int group_concat_add_to_order(void* key_arg,
+                              element_count count __attribute__((unused)),
+                              void* item_arg)
+{
+  Item_func_group_concat *item= (Item_func_group_concat *) item_arg;
+  return item->unique_order->unique_add(key_arg);
 }
 
 
@@ -3095,14 +3274,14 @@ Item_func_group_concat(THD *thd, Name_resolution_context *context_arg,
                        const SQL_I_List<ORDER> &order_list,
                        String *separator_arg)
   :Item_sum(thd), tmp_table_param(0), separator(separator_arg), tree(0),
-   unique_filter(NULL), table(0),
+   unique_filter(NULL), unique_order(NULL), table(0),
    order(0), context(context_arg),
    arg_count_order(order_list.elements),
    arg_count_field(select_list->elements),
    row_count(0),
    distinct(distinct_arg),
    warning_for_row(FALSE),
-   force_copy_fields(0), original(0)
+   force_copy_fields(0), spill(FALSE), original(0)
 {
   Item *item_select;
   Item **arg_ptr;
@@ -3154,6 +3333,7 @@ Item_func_group_concat::Item_func_group_concat(THD *thd,
   separator(item->separator),
   tree(item->tree),
   unique_filter(item->unique_filter),
+  unique_order(item->unique_order),
   table(item->table),
   context(item->context),
   arg_count_order(item->arg_count_order),
@@ -3163,6 +3343,7 @@ Item_func_group_concat::Item_func_group_concat(THD *thd,
   warning_for_row(item->warning_for_row),
   always_null(item->always_null),
   force_copy_fields(item->force_copy_fields),
+  spill(item->spill),
   original(item)
 {
   quick_group= item->quick_group;
@@ -3225,6 +3406,11 @@ void Item_func_group_concat::cleanup()
         delete unique_filter;
         unique_filter= NULL;
       }
+      if (unique_order)
+      {
+        delete unique_order;
+        unique_order= NULL;
+      }
     }
     DBUG_ASSERT(tree == 0);
   }
@@ -3280,6 +3466,8 @@ void Item_func_group_concat::clear()
     reset_tree(tree);
   if (unique_filter)
     unique_filter->reset();
+  if (unique_order)
+    unique_order->reset();
   if (table && table->blob_storage)
     table->blob_storage->reset();
   /* No need to reset the table as we never call write_row */
@@ -3306,6 +3494,12 @@ bool Item_func_group_concat::add()
   }
 
   null_value= FALSE;
+  if (spill)
+  {
+    Unique *unique= unique_filter ? unique_filter : unique_order;
+    return unique->unique_add(table->record[0] + table->s->null_bytes);
+  }
+
   bool row_eligible= TRUE;
 
   if (distinct) 
@@ -3509,6 +3703,33 @@ bool Item_func_group_concat::setup(THD *thd)
   */
   uint tree_key_length= table->s->reclength - table->s->null_bytes;
 
+  spill= order_or_distinct && thd->variables.group_concat_spill;
+  if (spill)
+  {
+    /*
+      If every ORDER BY column is in the expr list, one Unique both sorts
+      the values and removes the duplicates. Otherwise the duplicates are
+      removed first and the distinct values are sorted by a second one.
+    */
+    bool order_in_fields= TRUE;
+    for (uint i= 0; i < arg_count_order; i++)
+      order_in_fields&= order[i]->in_field_list;
+
+    if (distinct &&
+        !(unique_filter= new Unique(arg_count_order && order_in_fields ?
+                                    group_concat_key_cmp_with_distinct_and_order :
+                                    group_concat_key_cmp_with_distinct,
+                                    (void*) this, tree_key_length,
+                                    ram_limitation(thd))))
+      DBUG_RETURN(TRUE);
+    if (arg_count_order && !(distinct && order_in_fields) &&
+        !(unique_order= new Unique(group_concat_key_cmp_with_order,
+                                   (void*) this, tree_key_length,
+                                   ram_limitation(thd))))
+      DBUG_RETURN(TRUE);
+    DBUG_RETURN(FALSE);
+  }
+
   if (arg_count_order)
   {
     tree= &tree_base;
@@ -3543,6 +3764,8 @@ void Item_func_group_concat::make_unique()
   original= 0;
   force_copy_fields= 1;
   tree= 0;
+  unique_filter= 0;
+  unique_order= 0;
 }
 
 
@@ -3554,6 +3777,19 @@ String* Item_func_group_concat::val_str(String* str)
   if (no_appended && tree)
     /* Tree is used for sorting as in ORDER BY */
     tree_walk(tree, &dump_leaf_key, this, left_root_right);
+  else if (no_appended && spill)
+  {
+    /* Unique::walk() returns non-zero also if the result was truncated */
+    if (unique_filter && unique_order)
+    {
+      if (!unique_filter->walk(table, &group_concat_add_to_order, this))
+        unique_order->walk(table, &dump_leaf_key, this);
+    }
+    else if (unique_filter)
+      unique_filter->walk(table, &dump_leaf_key, this);
+    else
+      unique_order->walk(table, &dump_leaf_key, this);
+  }
 
   if (table && table->blob_storage && 
       table->blob_storage->is_truncated_value())
@@ -3603,4 +3839,6 @@ Item_func_group_concat::~Item_func_group_concat()
 {
   if (!original && unique_filter)
     delete unique_filter;    
+  if (!original && unique_order)
+    delete unique_order;
 }
@@ -25,6 +25,7 @@
 
 #include <my_tree.h>
 #include "sql_udf.h"                            /* udf_handler */
+#include "sql_hll.h"                            /* Hll_sketch */
 
 class Item_sum;
 class Aggregator_distinct;
@@ -347,7 +348,8 @@ class Item_sum :public Item_func_or_sum
   enum Sumfunctype
   { COUNT_FUNC, COUNT_DISTINCT_FUNC, SUM_FUNC, SUM_DISTINCT_FUNC, AVG_FUNC,
     AVG_DISTINCT_FUNC, MIN_FUNC, MAX_FUNC, STD_FUNC,
-    VARIANCE_FUNC, SUM_BIT_FUNC, UDF_SUM_FUNC, GROUP_CONCAT_FUNC
+    VARIANCE_FUNC, SUM_BIT_FUNC, UDF_SUM_FUNC, GROUP_CONCAT_FUNC,
+    APPROX_COUNT_DISTINCT_FUNC
   };
 
   Item **ref_by; /* pointer to a ref to the object used to register it */
@@ -1066,6 +1068,47 @@ class Item_sum_xor :public Item_sum_bit
 };
 
 
+/**
+  APPROX_COUNT_DISTINCT(expr, ...): the number of distinct rows of the
+  arguments without NULLs, estimated from a HyperLogLog sketch of the
+  hashes of the rows. Unlike COUNT(DISTINCT) it uses a fixed amount of
+  memory per group and does not sort or spill the values.
+
+  Values that are equal for COUNT(DISTINCT) have the same hash: strings
+  are hashed by their collation weights without trailing spaces, numbers
+  and temporal values by their value. The sketch is not stored in the
+  temporary table, so groups are made by sorting (quick_group= 0).
+*/
+
+class Item_sum_approx_count_distinct :public Item_sum_int
+{
+  Hll_sketch sketch;
+  String tmp_value, weights;
+
+  ulonglong hash_arg(Item *arg);
+
+public:
+  Item_sum_approx_count_distinct(THD *thd, List<Item> &list)
+    :Item_sum_int(thd, list)
+  { quick_group= 0; }
+  Item_sum_approx_count_distinct(THD *thd,
+                                 Item_sum_approx_count_distinct *item)
+    :Item_sum_int(thd, item)
+  { quick_group= 0; }
+  enum Sumfunctype sum_func() const { return APPROX_COUNT_DISTINCT_FUNC; }
+  bool setup(THD *thd);
+  void clear();
+  bool add();
+  longlong val_int();
+  void reset_field() { DBUG_ASSERT(0); }        // not used
+  void update_field() { DBUG_ASSERT(0); }       // not used
+  void no_rows_in_result() { clear(); }
+  void cleanup();
+  const char *func_name() const { return "approx_count_distinct("; }
+  Item *copy_or_same(THD* thd);
+};
+
+
 /* Items to get the value of a stored sum function */
 
 class Item_sum_field :public Item
@@ -1418,6 +1461,11 @@ int group_concat_key_cmp_with_distinct(void* arg, const void* key1,
                                        const void* key2);
 int group_concat_key_cmp_with_order(void* arg, const void* key1,
                                     const void* key2);
+int group_concat_key_cmp_with_distinct_and_order(void* arg, const void* key1,
+                                                 const void* key2);
+int group_concat_add_to_order(void* key_arg,
+                              element_count count __attribute__((unused)),
+                              void* item_arg);
 int dump_leaf_key(void* key_arg,
                   element_count count __attribute__((unused)),
                   void* item_arg);
@@ -1440,6 +1488,16 @@ class Item_func_group_concat : public Item_sum
      @see Item_func_group_concat::clear
    */
   Unique *unique_filter;
+  /**
+     With group_concat_spill the values are not kept in the tree, they are
+     added to Unique objects, which write sorted runs to a temporary file
+     when their buffer is full and merge them in val_str():
+     - unique_filter removes the duplicates of DISTINCT, and sorts the
+       values if all ORDER BY expressions are in the expr list,
+     - unique_order sorts the values by the ORDER BY expressions. With
+       DISTINCT it is filled from unique_filter in val_str().
+  */
+  Unique *unique_order;
   TABLE *table;
   ORDER **order;
   Name_resolution_context *context;
@@ -1453,6 +1511,7 @@ class Item_func_group_concat : public Item_sum
   bool always_null;
   bool force_copy_fields;
   bool no_appended;
+  bool spill;
   /*
     Following is 0 normal object and pointer to original one for copy
     (to correctly free resources)
@@ -1463,10 +1522,19 @@ class Item_func_group_concat : public Item_sum
                                                 const void* key2);
   friend int group_concat_key_cmp_with_order(void* arg, const void* key1,
 					     const void* key2);
+  friend int group_concat_key_cmp_with_distinct_and_order(void* arg,
+                                                          const void* key1,
+                                                          const void* key2);
+  friend int group_concat_add_to_order(void* key_arg,
+                                       element_count count
+                                       __attribute__((unused)),
+                                       void* item_arg);
   friend int dump_leaf_key(void* key_arg,
                            element_count count __attribute__((unused)),
 			   void* item_arg);
 
+  int cmp_order_keys(const uchar *key1, const uchar *key2);
+
 public:
   Item_func_group_concat(THD *thd, Name_resolution_context *context_arg,
                          bool is_distinct, List<Item> *is_select,
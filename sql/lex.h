@@ -673,6 +673,7 @@ static SYMBOL symbols[] = {
 
 static SYMBOL sql_functions[] = {
   { "ADDDATE",		SYM(ADDDATE_SYM)},
+  { "APPROX_COUNT_DISTINCT", SYM(APPROX_COUNT_DISTINCT_SYM)},
   { "BIT_AND",		SYM(BIT_AND)},
   { "BIT_OR",		SYM(BIT_OR)},
   { "BIT_XOR",		SYM(BIT_XOR)},
@@ -96,6 +96,7 @@ ulong opt_binlog_dbug_fsync_sleep= 0;
 
 mysql_mutex_t LOCK_prepare_ordered;
 mysql_cond_t COND_prepare_ordered;
+mysql_mutex_t LOCK_binlog_sync;
 mysql_mutex_t LOCK_after_binlog_sync;
 mysql_mutex_t LOCK_commit_ordered;
 
@@ -107,6 +108,46 @@ static ulonglong binlog_status_group_commit_trigger_timeout;
 static char binlog_snapshot_file[FN_REFLEN];
 static ulonglong binlog_snapshot_position;
 
+/*
+  Time spent in the stages of binlog group commit, in total and as a
+  histogram of the time taken by each group commit.
+*/
+enum binlog_stage
+{
+  BINLOG_STAGE_WRITE, BINLOG_STAGE_SYNC, BINLOG_STAGE_COMMIT,
+  BINLOG_STAGE_COUNT
+};
+#define BINLOG_STAGE_BUCKETS 5
+static ulonglong binlog_stage_usecs[BINLOG_STAGE_COUNT];
+static ulonglong binlog_stage_hist[BINLOG_STAGE_COUNT][BINLOG_STAGE_BUCKETS];
+
+static void
+binlog_stage_done(binlog_stage stage, ulonglong start)
+{
+  ulonglong usecs= microsecond_interval_timer() - start;
+  uint bucket;
+  if (usecs <= 100)
+    bucket= 0;
+  else if (usecs <= 1000)
+    bucket= 1;
+  else if (usecs <= 10000)
+    bucket= 2;
+  else if (usecs <= 100000)
+    bucket= 3;
+  else
+    bucket= 4;
+  my_atomic_add64((volatile int64 *)&binlog_stage_usecs[stage], usecs);
+  my_atomic_add64((volatile int64 *)&binlog_stage_hist[stage][bucket], 1);
+}
+
+#define BINLOG_STAGE_VARS(name, stage) \
+  {name "_usecs", (char *)&binlog_stage_usecs[stage], SHOW_LONGLONG}, \
+  {name "_le_100us", (char *)&binlog_stage_hist[stage][0], SHOW_LONGLONG}, \
+  {name "_le_1ms", (char *)&binlog_stage_hist[stage][1], SHOW_LONGLONG}, \
+  {name "_le_10ms", (char *)&binlog_stage_hist[stage][2], SHOW_LONGLONG}, \
+  {name "_le_100ms", (char *)&binlog_stage_hist[stage][3], SHOW_LONGLONG}, \
+  {name "_gt_100ms", (char *)&binlog_stage_hist[stage][4], SHOW_LONGLONG}
+
 static SHOW_VAR binlog_status_vars_detail[]=
 {
   {"commits",
@@ -123,6 +164,9 @@ static SHOW_VAR binlog_status_vars_detail[]=
     (char *)&binlog_snapshot_file, SHOW_CHAR},
   {"snapshot_position",
    (char *)&binlog_snapshot_position, SHOW_LONGLONG},
+  BINLOG_STAGE_VARS("stage_write", BINLOG_STAGE_WRITE),
+  BINLOG_STAGE_VARS("stage_sync", BINLOG_STAGE_SYNC),
+  BINLOG_STAGE_VARS("stage_commit", BINLOG_STAGE_COMMIT),
   {NullS, NullS, SHOW_LONG}
 };
 
@@ -4075,8 +4119,8 @@ bool MYSQL_BIN_LOG::reset_logs(THD *thd, bool create_new_log,
       Without binlog, we cannot XA recover prepared-but-not-committed
       transactions in engines. So force a commit checkpoint first.
 
-      Note that we take and immediately
-      release LOCK_after_binlog_sync/LOCK_commit_ordered. This has
+      Note that we take and immediately release
+      LOCK_binlog_sync/LOCK_after_binlog_sync/LOCK_commit_ordered. This has
       the effect to ensure that any on-going group commit (in
       trx_group_commit_leader()) has completed before we request the checkpoint,
       due to the chaining of LOCK_log and LOCK_commit_ordered in that function.
@@ -4088,7 +4132,9 @@ bool MYSQL_BIN_LOG::reset_logs(THD *thd, bool create_new_log,
       later would leave such transaction not recoverable.
     */
 
+    mysql_mutex_lock(&LOCK_binlog_sync);
     mysql_mutex_lock(&LOCK_after_binlog_sync);
+    mysql_mutex_unlock(&LOCK_binlog_sync);
     mysql_mutex_lock(&LOCK_commit_ordered);
     mysql_mutex_unlock(&LOCK_after_binlog_sync);
     mysql_mutex_unlock(&LOCK_commit_ordered);
@@ -5049,6 +5095,9 @@ int MYSQL_BIN_LOG::new_file_impl(bool need_lock)
     DBUG_RETURN(error);
   }
 
+  /* The old file must be synced before we rotate away from it. */
+  wait_for_binlog_sync_stage();
+
   mysql_mutex_lock(&LOCK_index);
 
   /* Reuse old name if not binlog and not update log */
@@ -5304,23 +5353,59 @@ bool MYSQL_BIN_LOG::flush_and_sync(bool *synced)
   if (synced)
     *synced= 0;
   mysql_mutex_assert_owner(&LOCK_log);
+  wait_for_binlog_sync_stage();
   if (flush_io_cache(&log_file))
     return 1;
+  if (sync_needed())
+  {
+    err= sync_binlog_file(fd);
+    if (synced)
+      *synced= 1;
+  }
+  return err;
+}
+
+
+/* Count a flush of the log, return true if sync_binlog says to sync now. */
+bool MYSQL_BIN_LOG::sync_needed()
+{
   uint sync_period= get_sync_period();
   if (sync_period && ++sync_counter >= sync_period)
   {
     sync_counter= 0;
-    err= mysql_file_sync(fd, MYF(MY_WME|MY_SYNC_FILESIZE));
-    if (synced)
-      *synced= 1;
+    return true;
+  }
+  return false;
+}
+
+
+int MYSQL_BIN_LOG::sync_binlog_file(File fd)
+{
+  int err= mysql_file_sync(fd, MYF(MY_WME|MY_SYNC_FILESIZE));
 #ifndef DBUG_OFF
-    if (opt_binlog_dbug_fsync_sleep > 0)
-      my_sleep(opt_binlog_dbug_fsync_sleep);
+  if (opt_binlog_dbug_fsync_sleep > 0)
+    my_sleep(opt_binlog_dbug_fsync_sleep);
 #endif
-  }
   return err;
 }
 
+
+/*
+  Wait for a group commit that syncs the binlog outside of LOCK_log to
+  finish its sync stage (see trx_group_commit_leader()). This must be done
+  before anything else syncs, rotates or closes the binlog, or moves the
+  binlog end position for dump threads.
+*/
+void MYSQL_BIN_LOG::wait_for_binlog_sync_stage()
+{
+  mysql_mutex_assert_owner(&LOCK_log);
+  if (!is_relay_log)
+  {
+    mysql_mutex_lock(&LOCK_binlog_sync);
+    mysql_mutex_unlock(&LOCK_binlog_sync);
+  }
+}
+
 void MYSQL_BIN_LOG::start_union_events(THD *thd, query_id_t query_id_param)
 {
   DBUG_ASSERT(!thd->binlog_evt_union.do_union);
@@ -7492,6 +7577,80 @@ MYSQL_BIN_LOG::write_transaction_to_binlog_events(group_commit_entry *entry)
   return 1;
 }
 
+/*
+  The sync stage of binlog group commit: sync the binlog if sync_binlog asks
+  for it, run the after_flush hooks and make the new events visible to dump
+  threads.
+
+  This runs under LOCK_log, or under LOCK_binlog_sync when
+  trx_group_commit_leader() lets the next group commit write to the binlog
+  while we sync.
+*/
+void
+MYSQL_BIN_LOG::group_commit_sync(group_commit_entry *queue, bool need_sync,
+                                 my_off_t end_offset)
+{
+  group_commit_entry *current;
+  bool any_error= false;
+  bool all_error= true;
+  bool first= true, last;
+
+  if (need_sync)
+  {
+    ulonglong start= microsecond_interval_timer();
+    if (sync_binlog_file(log_file.file))
+    {
+      for (current= queue; current != NULL; current= current->next)
+      {
+        if (!current->error)
+        {
+          current->error= ER_ERROR_ON_WRITE;
+          current->commit_errno= errno;
+          current->error_cache= NULL;
+        }
+      }
+      return;
+    }
+    binlog_stage_done(BINLOG_STAGE_SYNC, start);
+  }
+
+  mysql_mutex_assert_not_owner(&LOCK_prepare_ordered);
+  mysql_mutex_assert_not_owner(&LOCK_after_binlog_sync);
+  mysql_mutex_assert_not_owner(&LOCK_commit_ordered);
+  for (current= queue; current != NULL; current= current->next)
+  {
+    last= current->next == NULL;
+    if (!current->error &&
+        RUN_HOOK(binlog_storage, after_flush,
+            (current->thd,
+             current->cache_mngr->last_commit_pos_file,
+             current->cache_mngr->last_commit_pos_offset, need_sync,
+             first, last)))
+    {
+      current->error= ER_ERROR_ON_WRITE;
+      current->commit_errno= -1;
+      current->error_cache= NULL;
+      any_error= true;
+    }
+    else
+      all_error= false;
+    first= false;
+  }
+
+  /* update binlog_end_pos so it can be read by dump thread
+   *
+   * note: must be _after_ the RUN_HOOK(after_flush) or else
+   * semi-sync-plugin might not have put the transaction into
+   * it's list before dump-thread tries to send it
+   */
+  update_binlog_end_pos(end_offset);
+
+  if (any_error)
+    sql_print_error("Failed to run 'after_flush' hooks");
+  if (!all_error)
+    signal_update();
+}
+
 /*
   Do binlog group commit as the lead thread.
 
@@ -7510,8 +7669,10 @@ MYSQL_BIN_LOG::trx_group_commit_leader(group_commit_entry *leader)
   group_commit_entry *current, *last_in_queue;
   group_commit_entry *queue= NULL;
   bool check_purge= false;
+  bool need_sync= false, pipelined= false;
   ulong UNINIT_VAR(binlog_id);
   uint64 commit_id;
+  ulonglong stage_start;
   DBUG_ENTER("MYSQL_BIN_LOG::trx_group_commit_leader");
 
   {
@@ -7538,6 +7699,7 @@ MYSQL_BIN_LOG::trx_group_commit_leader(group_commit_entry *leader)
     group_commit_queue= NULL;
     mysql_mutex_unlock(&LOCK_prepare_ordered);
     binlog_id= current_binlog_id;
+    stage_start= microsecond_interval_timer();
 
     /* As the queue is in reverse order of entering, reverse it. */
     last_in_queue= current;
@@ -7619,8 +7781,7 @@ MYSQL_BIN_LOG::trx_group_commit_leader(group_commit_entry *leader)
       }
     }
 
-    bool synced= 0;
-    if (flush_and_sync(&synced))
+    if (flush_io_cache(&log_file))
     {
       for (current= queue; current != NULL; current= current->next)
       {
@@ -7634,46 +7795,20 @@ MYSQL_BIN_LOG::trx_group_commit_leader(group_commit_entry *leader)
     }
     else
     {
-      bool any_error= false;
-      bool all_error= true;
-
-      mysql_mutex_assert_not_owner(&LOCK_prepare_ordered);
-      mysql_mutex_assert_owner(&LOCK_log);
-      mysql_mutex_assert_not_owner(&LOCK_after_binlog_sync);
-      mysql_mutex_assert_not_owner(&LOCK_commit_ordered);
-      bool first= true, last;
-      for (current= queue; current != NULL; current= current->next)
+      binlog_stage_done(BINLOG_STAGE_WRITE, stage_start);
+      need_sync= sync_needed();
+      /*
+        With sync_binlog, the next group commit can write to the binlog while
+        we wait for the sync, see below. Except when we are about to rotate
+        the binlog, which must not happen before we are synced.
+      */
+      pipelined= get_sync_period() &&
+                 my_b_tell(&log_file) < (my_off_t) max_size;
+      if (!pipelined)
       {
-        last= current->next == NULL;
-        if (!current->error &&
-            RUN_HOOK(binlog_storage, after_flush,
-                (current->thd,
-                 current->cache_mngr->last_commit_pos_file,
-                 current->cache_mngr->last_commit_pos_offset, synced,
-                 first, last)))
-        {
-          current->error= ER_ERROR_ON_WRITE;
-          current->commit_errno= -1;
-          current->error_cache= NULL;
-          any_error= true;
-        }
-        else
-          all_error= false;
-        first= false;
+        wait_for_binlog_sync_stage();
+        group_commit_sync(queue, need_sync, commit_offset);
       }
-
-      /* update binlog_end_pos so it can be read by dump thread
-       *
-       * note: must be _after_ the RUN_HOOK(after_flush) or else
-       * semi-sync-plugin might not have put the transaction into
-       * it's list before dump-thread tries to send it
-       */
-      update_binlog_end_pos(commit_offset);
-
-      if (any_error)
-        sql_print_error("Failed to run 'after_flush' hooks");
-      if (!all_error)
-        signal_update();
     }
 
     /*
@@ -7710,15 +7845,31 @@ MYSQL_BIN_LOG::trx_group_commit_leader(group_commit_entry *leader)
     commit_offset= my_b_write_tell(&log_file);
   }
 
+  if (pipelined)
+  {
+    /*
+      Sync the binlog in a separate stage, so that the next group commit can
+      write to the binlog under LOCK_log in the meantime. As for the stages
+      below, we must lock LOCK_binlog_sync before we unlock LOCK_log, to keep
+      the group commits in order.
+    */
+    DEBUG_SYNC(leader->thd, "commit_before_get_LOCK_binlog_sync");
+    mysql_mutex_lock(&LOCK_binlog_sync);
+    mysql_mutex_unlock(&LOCK_log);
+    DEBUG_SYNC(leader->thd, "commit_after_get_LOCK_binlog_sync");
+    group_commit_sync(queue, need_sync, commit_offset);
+  }
+
   DEBUG_SYNC(leader->thd, "commit_before_get_LOCK_after_binlog_sync");
   mysql_mutex_lock(&LOCK_after_binlog_sync);
   /*
-    We cannot unlock LOCK_log until we have locked LOCK_after_binlog_sync;
-    otherwise scheduling could allow the next group commit to run ahead of us,
-    messing up the order of commit_ordered() calls. But as soon as
-    LOCK_after_binlog_sync is obtained, we can let the next group commit start.
+    We cannot unlock LOCK_log (or LOCK_binlog_sync) until we have locked
+    LOCK_after_binlog_sync; otherwise scheduling could allow the next group
+    commit to run ahead of us, messing up the order of commit_ordered() calls.
+    But as soon as LOCK_after_binlog_sync is obtained, we can let the next
+    group commit start.
   */
-  mysql_mutex_unlock(&LOCK_log);
+  mysql_mutex_unlock(pipelined ? &LOCK_binlog_sync : &LOCK_log);
 
   DEBUG_SYNC(leader->thd, "commit_after_release_LOCK_log");
 
@@ -7791,6 +7942,7 @@ MYSQL_BIN_LOG::trx_group_commit_leader(group_commit_entry *leader)
     Wakeup each participant waiting for our group commit, first calling the
     commit_ordered() methods for any transactions doing 2-phase commit.
   */
+  stage_start= microsecond_interval_timer();
   current= queue;
   while (current != NULL)
   {
@@ -7817,6 +7969,7 @@ MYSQL_BIN_LOG::trx_group_commit_leader(group_commit_entry *leader)
     }
     current= next;
   }
+  binlog_stage_done(BINLOG_STAGE_COMMIT, stage_start);
   DEBUG_SYNC(leader->thd, "commit_after_group_run_commit_ordered");
   mysql_mutex_unlock(&LOCK_commit_ordered);
   DEBUG_SYNC(leader->thd, "commit_after_group_release_commit_ordered");
@@ -8138,6 +8291,7 @@ void MYSQL_BIN_LOG::close(uint exiting)
 
   if (log_state == LOG_OPENED)
   {
+    wait_for_binlog_sync_stage();
 #ifdef HAVE_REPLICATION
     if (log_type == LOG_BIN &&
 	(exiting & LOG_CLOSE_STOP_EVENT))
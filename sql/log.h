@@ -88,11 +88,12 @@ class TC_LOG
 */
 extern mysql_mutex_t LOCK_prepare_ordered;
 extern mysql_cond_t COND_prepare_ordered;
+extern mysql_mutex_t LOCK_binlog_sync;
 extern mysql_mutex_t LOCK_after_binlog_sync;
 extern mysql_mutex_t LOCK_commit_ordered;
 #ifdef HAVE_PSI_INTERFACE
 extern PSI_mutex_key key_LOCK_prepare_ordered, key_LOCK_commit_ordered;
-extern PSI_mutex_key key_LOCK_after_binlog_sync;
+extern PSI_mutex_key key_LOCK_binlog_sync, key_LOCK_after_binlog_sync;
 extern PSI_cond_key key_COND_prepare_ordered;
 #endif
 
@@ -558,6 +559,11 @@ class MYSQL_BIN_LOG: public TC_LOG, private MYSQL_LOG
   int queue_for_group_commit(group_commit_entry *entry);
   bool write_transaction_to_binlog_events(group_commit_entry *entry);
   void trx_group_commit_leader(group_commit_entry *leader);
+  void group_commit_sync(group_commit_entry *queue, bool need_sync,
+                         my_off_t end_offset);
+  void wait_for_binlog_sync_stage();
+  bool sync_needed();
+  int sync_binlog_file(File fd);
   bool is_xidlist_idle_nolock();
 
 public:
@@ -828,9 +834,12 @@ class MYSQL_BIN_LOG: public TC_LOG, private MYSQL_LOG
                                   uint64 seq_no);
 
 
+  /*
+    Called under LOCK_log, or under LOCK_binlog_sync from the sync stage of
+    binlog group commit.
+  */
   void update_binlog_end_pos(my_off_t pos)
   {
-    mysql_mutex_assert_owner(&LOCK_log);
     mysql_mutex_assert_not_owner(&LOCK_binlog_end_pos);
     lock_binlog_end_pos();
     /**
@@ -9991,6 +9991,10 @@ int Rows_log_event::do_apply_event(rpl_group_info *rgi)
   {
     master_had_triggers= table->master_had_triggers;
     bool transactional_table= table->file->has_transactions();
+
+    if (rgi->is_parallel_exec &&
+        rgi->rli->mi->parallel_mode == SLAVE_PARALLEL_DEPENDENCY)
+      rgi->rli->parallel.record_row_keys(table);
     /*
       table == NULL means that this table should not be replicated
       (this was set up by Table_map_log_event::do_apply_event()
@@ -11064,6 +11068,12 @@ check_table_map(rpl_group_info *rgi, RPL_TABLE_LIST *table_list)
   DBUG_RETURN(res);
 }
 
+table_def *Table_map_log_event::create_table_def()
+{
+  return new table_def(m_coltype, m_colcnt, m_field_metadata,
+                       m_field_metadata_size, m_null_bits, m_flags);
+}
+
 int Table_map_log_event::do_apply_event(rpl_group_info *rgi)
 {
   RPL_TABLE_LIST *table_list;
@@ -718,6 +718,7 @@ class THD;
 
 class Format_description_log_event;
 class Relay_log_info;
+class table_def;
 
 #ifdef MYSQL_CLIENT
 enum enum_base64_output_mode {
@@ -4129,6 +4130,9 @@ class Table_map_log_event : public Log_event
   }
   int rewrite_db(const char* new_name, size_t new_name_len,
                  const Format_description_log_event*);
+#endif
+#if defined(MYSQL_SERVER) && defined(HAVE_REPLICATION)
+  table_def *create_table_def();
 #endif
   ulong get_table_id() const        { return m_table_id; }
   const char *get_table_name() const { return m_tblnam; }
@@ -4290,6 +4294,8 @@ class Rows_log_event : public Log_event
   MY_BITMAP const *get_cols_ai() const { return &m_cols_ai; }
   size_t get_width() const          { return m_width; }
   ulong get_table_id() const        { return m_table_id; }
+  const uchar *get_rows_buf() const { return m_rows_buf; }
+  const uchar *get_rows_end() const { return m_rows_cur; }
 
 #if defined(MYSQL_SERVER)
   /*
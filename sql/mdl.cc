@@ -25,13 +25,18 @@
 #include <mysql/psi/mysql_stage.h>
 #include "wsrep_mysqld.h"
 #include "wsrep_thd.h"
+#ifdef HAVE_SCHED_GETCPU
+#include <sched.h>
+#endif
 
 #ifdef HAVE_PSI_INTERFACE
 static PSI_mutex_key key_MDL_wait_LOCK_wait_status;
+static PSI_mutex_key key_MDL_lock_fast_path_mutex;
 
 static PSI_mutex_info all_mdl_mutexes[]=
 {
-  { &key_MDL_wait_LOCK_wait_status, "MDL_wait::LOCK_wait_status", 0}
+  { &key_MDL_wait_LOCK_wait_status, "MDL_wait::LOCK_wait_status", 0},
+  { &key_MDL_lock_fast_path_mutex, "MDL_lock::fast_path_mutex", 0}
 };
 
 static PSI_rwlock_key key_MDL_lock_rwlock;
@@ -109,6 +114,11 @@ void MDL_key::init_psi_keys()
 
 static bool mdl_initialized= 0;
 
+/**
+  Size of unused MDL_lock objects cache, see MDL_map::purge_unused().
+*/
+ulong mdl_locks_cache_size;
+
 
 /**
   A collection of all MDL locks. A singleton,
@@ -121,11 +131,32 @@ class MDL_map
   void init();
   void destroy();
   MDL_lock *find_or_insert(LF_PINS *pins, const MDL_key *key);
+  bool fast_path_acquire(LF_PINS *pins, const MDL_key *key,
+                         MDL_ticket *ticket, uint shard);
   unsigned long get_lock_owner(LF_PINS *pins, const MDL_key *key);
   void remove(LF_PINS *pins, MDL_lock *lock);
   LF_PINS *get_pins() { return lf_hash_get_pins(&m_locks); }
+
+  /**
+    Purge unused MDL_lock objects if there are too many of them.
+
+    Objects for locks which were acquired through the fast path are left
+    in the hash when the last fast path ticket is released, since it is
+    not known which ticket is the last one.
+  */
+  void purge_unused(LF_PINS *pins)
+  {
+    if (my_atomic_load32(&m_locks.count) >
+        my_atomic_load32(&m_purge_threshold))
+      purge_unused_impl(pins);
+  }
 private:
+  void purge_unused_impl(LF_PINS *pins);
+  bool remove_unused(LF_PINS *pins);
+
   LF_HASH m_locks; /**< All acquired locks in the server. */
+  /** Size of m_locks which triggers purge of unused MDL_lock objects. */
+  int32 volatile m_purge_threshold;
   /** Pre-allocated MDL_lock object for GLOBAL namespace. */
   MDL_lock *m_global_lock;
   /** Pre-allocated MDL_lock object for COMMIT namespace. */
@@ -279,6 +310,16 @@ Deadlock_detection_visitor::opt_change_victim_to(MDL_context *new_victim)
 
 #define MDL_BIT(A) static_cast<MDL_lock::bitmap_t>(1U << A)
 
+/**
+  Number of fast path shards in MDL_lock. A thread uses the shard of
+  the CPU it is running on, so that unobtrusive locks on the same table
+  taken on different CPUs don't touch the same cache lines.
+*/
+#define MDL_FAST_PATH_SHARDS 16
+
+/** Padding which keeps fast path shards in different cache lines. */
+#define MDL_CACHE_LINE_SIZE 64
+
 /**
   The lock context. Created internally for an acquired lock.
   For a given name, there exists only one MDL_lock instance,
@@ -324,6 +365,38 @@ class MDL_lock
   typedef Ticket_list::List::Iterator Ticket_iterator;
 
 
+  /**
+    Per-CPU part of the lock.
+
+    Unobtrusive locks (SHARED_READ and SHARED_WRITE locks on tables) are
+    granted by adding the ticket to a shard, without taking m_rwlock,
+    as long as there are no granted or pending obtrusive locks, which
+    are the only ones conflicting with them (see fast_path_state).
+    Threads acquiring obtrusive locks have to look through all shards.
+  */
+  struct Fast_path_shard
+  {
+    /** Protects m_tickets and m_count. */
+    mysql_mutex_t m_mutex;
+    /** Tickets granted through the fast path. */
+    Ticket_list::List m_tickets;
+    /** Number of SHARED_READ and SHARED_WRITE tickets in m_tickets. */
+    uint m_count[2];
+    char m_pad[MDL_CACHE_LINE_SIZE];
+  };
+
+  /** Values of m_fast_path_state. */
+  enum enum_fast_path_state
+  {
+    /** Fast path is available. */
+    FAST_PATH_ENABLED= 0,
+    /** There are granted or pending obtrusive locks. */
+    FAST_PATH_OBTRUSIVE,
+    /** The object is being removed from MDL_map. */
+    FAST_PATH_DESTROYED
+  };
+
+
   /**
     Helper struct which defines how different types of locks are handled
     for a specific MDL_lock. In practice we use only two strategies: "scoped"
@@ -464,6 +537,59 @@ class MDL_lock
     return (m_granted.is_empty() && m_waiting.is_empty());
   }
 
+  /** Check if lock of this type on this key can use the fast path. */
+  static bool is_fast_path_type(const MDL_key *key_arg,
+                                enum_mdl_type type_arg)
+  {
+#ifdef WITH_WSREP
+    /* Brute force aborts have to see all conflicting tickets. */
+    if (WSREP_ON)
+      return false;
+#endif
+    return key_arg->mdl_namespace() == MDL_key::TABLE &&
+           (type_arg == MDL_SHARED_READ || type_arg == MDL_SHARED_WRITE);
+  }
+
+  /** Lock types which may conflict with fast path lock types. */
+  static bitmap_t obtrusive_types()
+  {
+    return MDL_BIT(MDL_SHARED_NO_WRITE) | MDL_BIT(MDL_SHARED_NO_READ_WRITE) |
+           MDL_BIT(MDL_EXCLUSIVE);
+  }
+
+  bool fast_path_acquire(MDL_ticket *ticket, uint shard);
+  void remove_fast_path_ticket(LF_PINS *pins, MDL_ticket *ticket);
+  void materialize_fast_path_ticket(MDL_ticket *ticket);
+  bitmap_t fast_path_granted_bitmap() const;
+  bool fast_path_try_destroy();
+
+  /**
+    Disable the fast path before an obtrusive lock is checked against
+    granted fast path tickets.
+
+    @pre m_rwlock must be write-locked.
+  */
+  void set_fast_path_obtrusive()
+  {
+    if (m_fast_path_state != FAST_PATH_OBTRUSIVE)
+      my_atomic_store32(&m_fast_path_state, FAST_PATH_OBTRUSIVE);
+  }
+
+  /**
+    Re-enable the fast path when there are no more granted or pending
+    obtrusive locks.
+
+    @pre m_rwlock must be write-locked.
+  */
+  void update_fast_path_state()
+  {
+    int32 state= ((m_granted.bitmap() | m_waiting.bitmap()) &
+                  obtrusive_types()) ? FAST_PATH_OBTRUSIVE :
+                                       FAST_PATH_ENABLED;
+    if (m_fast_path_state != state)
+      my_atomic_store32(&m_fast_path_state, state);
+  }
+
   const bitmap_t *incompatible_granted_types_bitmap() const
   { return m_strategy->incompatible_granted_types_bitmap(); }
   const bitmap_t *incompatible_waiting_types_bitmap() const
@@ -491,16 +617,30 @@ class MDL_lock
     Ticket_iterator it(m_granted);
     MDL_ticket *conflicting_ticket;
     while ((conflicting_ticket= it++))
+      notify_conflicting_lock(ctx, conflicting_ticket);
+
+    if (key.mdl_namespace() != MDL_key::TABLE)
+      return;
+    for (uint i= 0; i < MDL_FAST_PATH_SHARDS; i++)
     {
-      if (conflicting_ticket->get_ctx() != ctx &&
-          m_strategy->conflicting_locks(conflicting_ticket))
-      {
-        MDL_context *conflicting_ctx= conflicting_ticket->get_ctx();
+      mysql_mutex_lock(&m_fast_path[i].m_mutex);
+      Ticket_iterator fast_path_it(m_fast_path[i].m_tickets);
+      while ((conflicting_ticket= fast_path_it++))
+        notify_conflicting_lock(ctx, conflicting_ticket);
+      mysql_mutex_unlock(&m_fast_path[i].m_mutex);
+    }
+  }
+  void notify_conflicting_lock(MDL_context *ctx,
+                               MDL_ticket *conflicting_ticket)
+  {
+    if (conflicting_ticket->get_ctx() != ctx &&
+        m_strategy->conflicting_locks(conflicting_ticket))
+    {
+      MDL_context *conflicting_ctx= conflicting_ticket->get_ctx();
 
-        ctx->get_owner()->
-          notify_shared_lock(conflicting_ctx->get_owner(),
-                             conflicting_ctx->get_needs_thr_lock_abort());
-      }
+      ctx->get_owner()->
+        notify_shared_lock(conflicting_ctx->get_owner(),
+                           conflicting_ctx->get_needs_thr_lock_abort());
     }
   }
 
@@ -522,25 +662,56 @@ class MDL_lock
   */
   ulong m_hog_lock_count;
 
+  /**
+    One of enum_fast_path_state values. Changed under write-locked
+    m_rwlock, read by the fast path under Fast_path_shard::m_mutex.
+  */
+  int32 volatile m_fast_path_state;
+
+  mutable Fast_path_shard m_fast_path[MDL_FAST_PATH_SHARDS];
+
 public:
 
   MDL_lock()
     : m_hog_lock_count(0),
+      m_fast_path_state(FAST_PATH_ENABLED),
       m_strategy(0)
-  { mysql_prlock_init(key_MDL_lock_rwlock, &m_rwlock); }
+  {
+    mysql_prlock_init(key_MDL_lock_rwlock, &m_rwlock);
+    init_fast_path();
+  }
 
   MDL_lock(const MDL_key *key_arg)
   : key(key_arg),
     m_hog_lock_count(0),
+    m_fast_path_state(FAST_PATH_ENABLED),
     m_strategy(&m_scoped_lock_strategy)
   {
     DBUG_ASSERT(key_arg->mdl_namespace() == MDL_key::GLOBAL ||
                 key_arg->mdl_namespace() == MDL_key::COMMIT);
     mysql_prlock_init(key_MDL_lock_rwlock, &m_rwlock);
+    init_fast_path();
   }
 
   ~MDL_lock()
-  { mysql_prlock_destroy(&m_rwlock); }
+  {
+    for (uint i= 0; i < MDL_FAST_PATH_SHARDS; i++)
+    {
+      DBUG_ASSERT(m_fast_path[i].m_tickets.is_empty());
+      mysql_mutex_destroy(&m_fast_path[i].m_mutex);
+    }
+    mysql_prlock_destroy(&m_rwlock);
+  }
+
+  void init_fast_path()
+  {
+    for (uint i= 0; i < MDL_FAST_PATH_SHARDS; i++)
+    {
+      mysql_mutex_init(key_MDL_lock_fast_path_mutex,
+                       &m_fast_path[i].m_mutex, MY_MUTEX_INIT_FAST);
+      m_fast_path[i].m_count[0]= m_fast_path[i].m_count[1]= 0;
+    }
+  }
 
   static void lf_alloc_constructor(uchar *arg)
   { new (arg + LF_HASH_OVERHEAD) MDL_lock(); }
@@ -554,6 +725,7 @@ class MDL_lock
     DBUG_ASSERT(key_arg->mdl_namespace() != MDL_key::GLOBAL &&
                 key_arg->mdl_namespace() != MDL_key::COMMIT);
     new (&lock->key) MDL_key(key_arg);
+    lock->m_fast_path_state= FAST_PATH_ENABLED;
     if (key_arg->mdl_namespace() == MDL_key::SCHEMA)
       lock->m_strategy= &m_scoped_lock_strategy;
     else
@@ -647,6 +819,15 @@ static my_bool mdl_iterate_lock(MDL_lock *lock, mdl_iterate_arg *arg)
   MDL_ticket *ticket;
   while ((ticket= ticket_it++) && !(res= arg->callback(ticket, arg->argument)))
     /* no-op */;
+  for (uint i= 0; !res && i < MDL_FAST_PATH_SHARDS; i++)
+  {
+    mysql_mutex_lock(&lock->m_fast_path[i].m_mutex);
+    MDL_lock::Ticket_iterator fast_path_it(lock->m_fast_path[i].m_tickets);
+    while ((ticket= fast_path_it++) &&
+           !(res= arg->callback(ticket, arg->argument)))
+      /* no-op */;
+    mysql_mutex_unlock(&lock->m_fast_path[i].m_mutex);
+  }
   mysql_prlock_unlock(&lock->m_rwlock);
   return MY_TEST(res);
 }
@@ -695,6 +876,7 @@ void MDL_map::init()
   m_locks.alloc.destructor= MDL_lock::lf_alloc_destructor;
   m_locks.initializer= (lf_hash_initializer) MDL_lock::lf_hash_initializer;
   m_locks.hash_function= mdl_hash_function;
+  m_purge_threshold= (int32) mdl_locks_cache_size;
 }
 
 
@@ -708,6 +890,13 @@ void MDL_map::destroy()
   delete m_global_lock;
   delete m_commit_lock;
 
+  /* Unused objects left by the fast path. */
+  if (LF_PINS *pins= get_pins())
+  {
+    remove_unused(pins);
+    lf_hash_put_pins(pins);
+  }
+
   DBUG_ASSERT(!my_atomic_load32(&m_locks.count));
   lf_hash_destroy(&m_locks);
 }
@@ -767,6 +956,102 @@ MDL_lock* MDL_map::find_or_insert(LF_PINS *pins, const MDL_key *mdl_key)
 }
 
 
+/**
+  Find MDL_lock object corresponding to the key, create it if it does
+  not exist, and try to acquire unobtrusive lock through the fast path.
+
+  @retval true   Lock was granted, ticket is linked to the fast path
+                 shard and points to the MDL_lock object.
+  @retval false  Fast path is not available (or OOM), the slow path
+                 must be used.
+*/
+
+bool MDL_map::fast_path_acquire(LF_PINS *pins, const MDL_key *mdl_key,
+                                MDL_ticket *ticket, uint shard)
+{
+  MDL_lock *lock;
+  bool res;
+
+  while (!(lock= (MDL_lock*) lf_hash_search(&m_locks, pins, mdl_key->ptr(),
+                                            mdl_key->length())))
+    if (lf_hash_insert(&m_locks, pins, (uchar*) mdl_key) == -1)
+      return false;
+
+  /*
+    The object cannot be freed while it is pinned, and cannot be
+    removed from the hash while the ticket is in the fast path shard.
+  */
+  res= lock->fast_path_acquire(ticket, shard);
+  lf_hash_search_unpin(pins);
+  return res;
+}
+
+
+/**
+  Remove unused MDL_lock object from the hash. Callback for
+  lf_hash_iterate().
+*/
+
+static my_bool mdl_remove_unused_lock(MDL_lock *lock, LF_PINS *pins)
+{
+  mysql_prlock_wrlock(&lock->m_rwlock);
+  if (lock->m_strategy && lock->is_empty())
+    mdl_locks.remove(pins, lock);
+  else
+    mysql_prlock_unlock(&lock->m_rwlock);
+  return FALSE;
+}
+
+
+/**
+  Remove all unused MDL_lock objects.
+
+  @param pins  Pins to be used for removal, separate pins are used
+               for traversal.
+
+  @retval true  OOM
+*/
+
+bool MDL_map::remove_unused(LF_PINS *pins)
+{
+  LF_PINS *iterate_pins;
+
+  if (!(iterate_pins= get_pins()))
+    return true;
+  lf_hash_iterate(&m_locks, iterate_pins,
+                  (my_hash_walk_action) mdl_remove_unused_lock, pins);
+  lf_hash_put_pins(iterate_pins);
+  return false;
+}
+
+
+/**
+  Remove unused MDL_lock objects once the hash has grown beyond
+  metadata_locks_cache_size and twice the number of objects that
+  survived the previous purge. Only one thread purges at a time.
+*/
+
+void MDL_map::purge_unused_impl(LF_PINS *pins)
+{
+  int32 threshold= my_atomic_load32(&m_purge_threshold);
+  int32 count;
+
+  if (my_atomic_load32(&m_locks.count) <= threshold ||
+      !my_atomic_cas32(&m_purge_threshold, &threshold, INT_MAX32))
+    return;
+
+  if (remove_unused(pins))
+  {
+    my_atomic_store32(&m_purge_threshold, threshold);
+    return;
+  }
+  count= my_atomic_load32(&m_locks.count);
+  my_atomic_store32(&m_purge_threshold,
+                    MY_MAX((int32) mdl_locks_cache_size,
+                           MY_MIN(count, INT_MAX32 / 2) * 2));
+}
+
+
 /**
  * Return thread id of the owner of the lock, if it is owned.
  */
@@ -825,6 +1110,16 @@ void MDL_map::remove(LF_PINS *pins, MDL_lock *lock)
     return;
   }
 
+  /*
+    Tickets granted through the fast path are not in the lists, the
+    object stays in the hash until they are gone, see purge_unused().
+  */
+  if (!lock->fast_path_try_destroy())
+  {
+    mysql_prlock_unlock(&lock->m_rwlock);
+    return;
+  }
+
   lock->m_strategy= 0;
   mysql_prlock_unlock(&lock->m_rwlock);
   lf_hash_delete(&m_locks, pins, lock->key.ptr(), lock->key.length());
@@ -842,7 +1137,8 @@ MDL_context::MDL_context()
   m_owner(NULL),
   m_needs_thr_lock_abort(FALSE),
   m_waiting_for(NULL),
-  m_pins(NULL)
+  m_pins(NULL),
+  m_fast_path_locks(0)
 {
   mysql_prlock_init(key_MDL_context_LOCK_waiting_for, &m_LOCK_waiting_for);
 }
@@ -878,6 +1174,58 @@ bool MDL_context::fix_pins()
 }
 
 
+/**
+  Choose fast path shard for this context. Contexts running on the same
+  CPU share a shard, so that its mutex stays in the local cache.
+*/
+
+uint MDL_context::fast_path_shard() const
+{
+#ifdef HAVE_SCHED_GETCPU
+  int cpu= sched_getcpu();
+  if (cpu >= 0)
+    return (uint) cpu % MDL_FAST_PATH_SHARDS;
+#endif
+  return (uint) (((size_t) this / sizeof(MDL_context)) %
+                 MDL_FAST_PATH_SHARDS);
+}
+
+
+/**
+  Move tickets granted through the fast path to MDL_lock::m_granted.
+
+  @param lock  If NULL, all tickets of this context are moved, otherwise
+               only tickets for this lock, m_rwlock of which must be
+               write-locked by the caller.
+*/
+
+void MDL_context::materialize_fast_path_locks(MDL_lock *lock)
+{
+  for (int i= 0; i < MDL_DURATION_END && m_fast_path_locks; i++)
+  {
+    Ticket_iterator it(m_tickets[i]);
+    MDL_ticket *ticket;
+
+    while ((ticket= it++))
+    {
+      if (ticket->m_fast_path_shard < 0)
+        continue;
+      if (!lock)
+      {
+        mysql_prlock_wrlock(&ticket->m_lock->m_rwlock);
+        ticket->m_lock->materialize_fast_path_ticket(ticket);
+        mysql_prlock_unlock(&ticket->m_lock->m_rwlock);
+      }
+      else if (ticket->m_lock == lock)
+        lock->materialize_fast_path_ticket(ticket);
+      else
+        continue;
+      m_fast_path_locks--;
+    }
+  }
+}
+
+
 /**
   Initialize a lock request.
 
@@ -1545,6 +1893,16 @@ MDL_lock::can_grant_lock(enum_mdl_type type_arg,
   bitmap_t granted_incompat_map= incompatible_granted_types_bitmap()[type_arg];
   bool  wsrep_can_grant= TRUE;
 
+  /*
+    Tickets granted through the fast path are not in m_granted. Our own
+    ones were materialized by the caller, any other ones conflict.
+  */
+  if (key.mdl_namespace() == MDL_key::TABLE &&
+      (granted_incompat_map & (MDL_BIT(MDL_SHARED_READ) |
+                               MDL_BIT(MDL_SHARED_WRITE))) &&
+      (fast_path_granted_bitmap() & granted_incompat_map))
+    return FALSE;
+
   /*
     New lock request can be satisfied iff:
     - There are no incompatible types of satisfied requests
@@ -1639,6 +1997,7 @@ void MDL_lock::remove_ticket(LF_PINS *pins, Ticket_list MDL_lock::*list,
 {
   mysql_prlock_wrlock(&m_rwlock);
   (this->*list).remove_ticket(ticket);
+  update_fast_path_state();
   if (is_empty())
     mdl_locks.remove(pins, this);
   else
@@ -1663,6 +2022,157 @@ void MDL_lock::remove_ticket(LF_PINS *pins, Ticket_list MDL_lock::*list,
 }
 
 
+/**
+  Try to grant unobtrusive lock without taking m_rwlock.
+
+  @param ticket  Ticket for SHARED_READ or SHARED_WRITE lock on a table.
+  @param shard   Fast path shard to use.
+
+  @retval true   Lock was granted.
+  @retval false  There are granted or pending obtrusive locks, or the
+                 object is being destroyed.
+*/
+
+bool MDL_lock::fast_path_acquire(MDL_ticket *ticket, uint shard)
+{
+  Fast_path_shard *fast_path= &m_fast_path[shard];
+  bool res= false;
+
+  DBUG_ASSERT(is_fast_path_type(&key, ticket->get_type()));
+  mysql_mutex_lock(&fast_path->m_mutex);
+  /*
+    Obtrusive lockers change the state before they look at the shards,
+    so either we see the new state here or they see our ticket.
+  */
+  if (my_atomic_load32(&m_fast_path_state) == FAST_PATH_ENABLED)
+  {
+    ticket->m_lock= this;
+    ticket->m_fast_path_shard= shard;
+    fast_path->m_tickets.push_front(ticket);
+    fast_path->m_count[ticket->get_type() == MDL_SHARED_WRITE]++;
+    res= true;
+  }
+  mysql_mutex_unlock(&fast_path->m_mutex);
+  return res;
+}
+
+
+/**
+  Release lock granted through the fast path.
+
+  If there are obtrusive locks, waiters are rescheduled, as they might
+  have been waiting for this ticket.
+*/
+
+void MDL_lock::remove_fast_path_ticket(LF_PINS *pins, MDL_ticket *ticket)
+{
+  Fast_path_shard *fast_path= &m_fast_path[ticket->m_fast_path_shard];
+  uint type_idx= ticket->get_type() == MDL_SHARED_WRITE;
+
+  mysql_mutex_lock(&fast_path->m_mutex);
+  if (my_atomic_load32(&m_fast_path_state) == FAST_PATH_ENABLED)
+  {
+    fast_path->m_tickets.remove(ticket);
+    fast_path->m_count[type_idx]--;
+    mysql_mutex_unlock(&fast_path->m_mutex);
+    return;
+  }
+  mysql_mutex_unlock(&fast_path->m_mutex);
+
+  /* Our ticket prevents removal of this object until it is unlinked. */
+  mysql_prlock_wrlock(&m_rwlock);
+  mysql_mutex_lock(&fast_path->m_mutex);
+  fast_path->m_tickets.remove(ticket);
+  fast_path->m_count[type_idx]--;
+  mysql_mutex_unlock(&fast_path->m_mutex);
+  if (is_empty())
+    mdl_locks.remove(pins, this);
+  else
+  {
+    reschedule_waiters();
+    mysql_prlock_unlock(&m_rwlock);
+  }
+}
+
+
+/**
+  Move ticket granted through the fast path to m_granted, where it is
+  visible to the deadlock detector.
+
+  @pre m_rwlock must be write-locked.
+*/
+
+void MDL_lock::materialize_fast_path_ticket(MDL_ticket *ticket)
+{
+  Fast_path_shard *fast_path= &m_fast_path[ticket->m_fast_path_shard];
+
+  mysql_mutex_lock(&fast_path->m_mutex);
+  fast_path->m_tickets.remove(ticket);
+  fast_path->m_count[ticket->get_type() == MDL_SHARED_WRITE]--;
+  mysql_mutex_unlock(&fast_path->m_mutex);
+  ticket->m_fast_path_shard= -1;
+  m_granted.add_ticket(ticket);
+}
+
+
+/**
+  Get bitmap of types of locks granted through the fast path.
+
+  @pre m_rwlock must be write-locked and m_fast_path_state must be
+       FAST_PATH_OBTRUSIVE, so that no new tickets can be added.
+*/
+
+MDL_lock::bitmap_t MDL_lock::fast_path_granted_bitmap() const
+{
+  bitmap_t bitmap= 0;
+
+  for (uint i= 0; i < MDL_FAST_PATH_SHARDS; i++)
+  {
+    mysql_mutex_lock(&m_fast_path[i].m_mutex);
+    if (m_fast_path[i].m_count[0])
+      bitmap|= MDL_BIT(MDL_SHARED_READ);
+    if (m_fast_path[i].m_count[1])
+      bitmap|= MDL_BIT(MDL_SHARED_WRITE);
+    mysql_mutex_unlock(&m_fast_path[i].m_mutex);
+  }
+  return bitmap;
+}
+
+
+/**
+  Disable the fast path for an object which is about to be removed from
+  MDL_map.
+
+  @pre m_rwlock must be write-locked and there must be no tickets in
+       m_granted and m_waiting.
+
+  @retval true   There are no fast path tickets, object can be removed.
+  @retval false  There are fast path tickets, the fast path is enabled
+                 again.
+*/
+
+bool MDL_lock::fast_path_try_destroy()
+{
+  DBUG_ASSERT(is_empty());
+  if (key.mdl_namespace() != MDL_key::TABLE)
+    return true;
+
+  my_atomic_store32(&m_fast_path_state, FAST_PATH_DESTROYED);
+  for (uint i= 0; i < MDL_FAST_PATH_SHARDS; i++)
+  {
+    mysql_mutex_lock(&m_fast_path[i].m_mutex);
+    bool in_use= !m_fast_path[i].m_tickets.is_empty();
+    mysql_mutex_unlock(&m_fast_path[i].m_mutex);
+    if (in_use)
+    {
+      my_atomic_store32(&m_fast_path_state, FAST_PATH_ENABLED);
+      return false;
+    }
+  }
+  return true;
+}
+
+
 /**
   Check if we have any pending locks which conflict with existing
   shared lock.
@@ -1811,6 +2321,7 @@ MDL_context::try_acquire_lock(MDL_request *mdl_request)
       is no need to release it.
     */
     DBUG_ASSERT(! ticket->m_lock->is_empty());
+    ticket->m_lock->update_fast_path_state();
     mysql_prlock_unlock(&ticket->m_lock->m_rwlock);
     MDL_ticket::destroy(ticket);
   }
@@ -1898,6 +2409,15 @@ MDL_context::try_acquire_lock_impl(MDL_request *mdl_request,
                                    )))
     return TRUE;
 
+  if (MDL_lock::is_fast_path_type(key, mdl_request->type) &&
+      mdl_locks.fast_path_acquire(m_pins, key, ticket, fast_path_shard()))
+  {
+    m_fast_path_locks++;
+    m_tickets[mdl_request->duration].push_front(ticket);
+    mdl_request->ticket= ticket;
+    return FALSE;
+  }
+
   /* The below call implicitly locks MDL_lock::m_rwlock on success. */
   if (!(lock= mdl_locks.find_or_insert(m_pins, key)))
   {
@@ -1907,6 +2427,18 @@ MDL_context::try_acquire_lock_impl(MDL_request *mdl_request,
 
   ticket->m_lock= lock;
 
+  if (key->mdl_namespace() == MDL_key::TABLE &&
+      (MDL_BIT(mdl_request->type) & MDL_lock::obtrusive_types()))
+  {
+    /*
+      Disable the fast path before checking for conflicts with tickets
+      granted through it. Our own such tickets must not conflict with us.
+    */
+    lock->set_fast_path_obtrusive();
+    if (m_fast_path_locks)
+      materialize_fast_path_locks(lock);
+  }
+
   if (lock->can_grant_lock(mdl_request->type, this, false))
   {
     lock->m_granted.add_ticket(ticket);
@@ -2609,7 +3141,14 @@ void MDL_context::release_lock(enum_mdl_duration duration, MDL_ticket *ticket)
 
   DBUG_ASSERT(this == ticket->get_ctx());
 
-  lock->remove_ticket(m_pins, &MDL_lock::m_granted, ticket);
+  if (ticket->m_fast_path_shard >= 0)
+  {
+    m_fast_path_locks--;
+    lock->remove_fast_path_ticket(m_pins, ticket);
+    mdl_locks.purge_unused(m_pins);
+  }
+  else
+    lock->remove_ticket(m_pins, &MDL_lock::m_granted, ticket);
 
   m_tickets[duration].remove(ticket);
   MDL_ticket::destroy(ticket);
@@ -2722,6 +3261,7 @@ void MDL_ticket::downgrade_lock(enum_mdl_type type)
   m_lock->m_granted.remove_ticket(this);
   m_type= type;
   m_lock->m_granted.add_ticket(this);
+  m_lock->update_fast_path_state();
   m_lock->reschedule_waiters();
   mysql_prlock_unlock(&m_lock->m_rwlock);
 }
@@ -616,6 +616,7 @@ class MDL_ticket : public MDL_wait_for_subgraph
   virtual uint get_deadlock_weight() const;
 private:
   friend class MDL_context;
+  friend class MDL_lock;
 
   MDL_ticket(MDL_context *ctx_arg, enum_mdl_type type_arg
 #ifndef DBUG_OFF
@@ -627,7 +628,8 @@ class MDL_ticket : public MDL_wait_for_subgraph
      m_duration(duration_arg),
 #endif
      m_ctx(ctx_arg),
-     m_lock(NULL)
+     m_lock(NULL),
+     m_fast_path_shard(-1)
   {}
 
   static MDL_ticket *create(MDL_context *ctx_arg, enum_mdl_type type_arg
@@ -656,6 +658,13 @@ class MDL_ticket : public MDL_wait_for_subgraph
   */
   MDL_lock *m_lock;
 
+  /**
+    Index of MDL_lock fast path shard this ticket is registered in, or -1
+    if the ticket is in MDL_lock::m_granted or m_waiting. Externally
+    accessible.
+  */
+  int m_fast_path_shard;
+
 private:
   MDL_ticket(const MDL_ticket &);               /* not implemented */
   MDL_ticket &operator=(const MDL_ticket &);    /* not implemented */
@@ -920,6 +929,8 @@ class MDL_context
    */
   MDL_wait_for_subgraph *m_waiting_for;
   LF_PINS *m_pins;
+  /** Number of tickets acquired through MDL_lock fast path. */
+  uint m_fast_path_locks;
 private:
   MDL_ticket *find_ticket(MDL_request *mdl_req,
                           enum_mdl_duration *duration);
@@ -928,6 +939,8 @@ class MDL_context
   bool try_acquire_lock_impl(MDL_request *mdl_request,
                              MDL_ticket **out_ticket);
   bool fix_pins();
+  uint fast_path_shard() const;
+  void materialize_fast_path_locks(MDL_lock *lock);
 
 public:
   THD *get_thd() const { return m_owner->get_thd(); }
@@ -941,6 +954,12 @@ class MDL_context
   /** Inform the deadlock detector there is an edge in the wait-for graph. */
   void will_wait_for(MDL_wait_for_subgraph *waiting_for_arg)
   {
+    /*
+      Fast path tickets are invisible to the deadlock detector. Make them
+      visible before this context becomes a node of the wait-for graph.
+    */
+    if (m_fast_path_locks)
+      materialize_fast_path_locks(NULL);
     mysql_prlock_wrlock(&m_LOCK_waiting_for);
     m_waiting_for=  waiting_for_arg;
     mysql_prlock_unlock(&m_LOCK_waiting_for);
@@ -993,6 +1012,8 @@ extern "C" int thd_is_connected(MYSQL_THD thd);
 */
 extern "C" ulong max_write_lock_count;
 
+extern ulong mdl_locks_cache_size;
+
 extern MYSQL_PLUGIN_IMPORT
 int mdl_iterate(int (*callback)(MDL_ticket *ticket, void *arg), void *arg);
 #endif
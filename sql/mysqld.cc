@@ -433,6 +433,7 @@ my_bool opt_skip_slave_start = 0; ///< If set, slave is not autostarted
 my_bool opt_reckless_slave = 0;
 my_bool opt_enable_named_pipe= 0;
 my_bool opt_local_infile, opt_slave_compressed_protocol;
+my_bool opt_net_compress_stream;
 my_bool opt_safe_user_create = 0;
 my_bool opt_show_slave_auth_info;
 my_bool opt_log_slave_updates= 0;
@@ -884,21 +885,24 @@ PSI_mutex_key key_BINLOG_LOCK_index, key_BINLOG_LOCK_xid_list,
   key_mutex_slave_reporting_capability_err_lock, key_relay_log_info_data_lock,
   key_rpl_group_info_sleep_lock,
   key_relay_log_info_log_space_lock, key_relay_log_info_run_lock,
-  key_structure_guard_mutex, key_TABLE_SHARE_LOCK_ha_data,
+  key_structure_guard_mutex, key_LOCK_query_cache_reclaim,
+  key_TABLE_SHARE_LOCK_ha_data,
   key_LOCK_error_messages, key_LOG_INFO_lock,
   key_LOCK_thread_count, key_LOCK_thread_cache,
   key_PARTITION_LOCK_auto_inc;
 PSI_mutex_key key_RELAYLOG_LOCK_index;
 PSI_mutex_key key_LOCK_slave_state, key_LOCK_binlog_state,
-  key_LOCK_rpl_thread, key_LOCK_rpl_thread_pool, key_LOCK_parallel_entry;
+  key_LOCK_rpl_thread, key_LOCK_rpl_thread_pool, key_LOCK_parallel_entry,
+  key_LOCK_rpl_row_keys;
 
 PSI_mutex_key key_LOCK_stats,
   key_LOCK_global_user_client_stats, key_LOCK_global_table_stats,
   key_LOCK_global_index_stats,
   key_LOCK_wakeup_ready, key_LOCK_wait_commit;
 PSI_mutex_key key_LOCK_gtid_waiting;
+PSI_mutex_key key_LOCK_sort_workers;
 
-PSI_mutex_key key_LOCK_after_binlog_sync;
+PSI_mutex_key key_LOCK_binlog_sync, key_LOCK_after_binlog_sync;
 PSI_mutex_key key_LOCK_prepare_ordered, key_LOCK_commit_ordered,
   key_LOCK_slave_background;
 PSI_mutex_key key_TABLE_SHARE_LOCK_share;
@@ -961,10 +965,12 @@ static PSI_mutex_info all_server_mutexes[]=
   { &key_relay_log_info_run_lock, "Relay_log_info::run_lock", 0},
   { &key_rpl_group_info_sleep_lock, "Rpl_group_info::sleep_lock", 0},
   { &key_structure_guard_mutex, "Query_cache::structure_guard_mutex", 0},
+  { &key_LOCK_query_cache_reclaim, "LOCK_query_cache_reclaim", PSI_FLAG_GLOBAL},
   { &key_TABLE_SHARE_LOCK_ha_data, "TABLE_SHARE::LOCK_ha_data", 0},
   { &key_TABLE_SHARE_LOCK_share, "TABLE_SHARE::LOCK_share", 0},
   { &key_LOCK_error_messages, "LOCK_error_messages", PSI_FLAG_GLOBAL},
   { &key_LOCK_prepare_ordered, "LOCK_prepare_ordered", PSI_FLAG_GLOBAL},
+  { &key_LOCK_binlog_sync, "LOCK_binlog_sync", PSI_FLAG_GLOBAL},
   { &key_LOCK_after_binlog_sync, "LOCK_after_binlog_sync", PSI_FLAG_GLOBAL},
   { &key_LOCK_commit_ordered, "LOCK_commit_ordered", PSI_FLAG_GLOBAL},
   { &key_LOCK_slave_background, "LOCK_slave_background", PSI_FLAG_GLOBAL},
@@ -976,12 +982,15 @@ static PSI_mutex_info all_server_mutexes[]=
   { &key_LOCK_binlog_state, "LOCK_binlog_state", 0},
   { &key_LOCK_rpl_thread, "LOCK_rpl_thread", 0},
   { &key_LOCK_rpl_thread_pool, "LOCK_rpl_thread_pool", 0},
-  { &key_LOCK_parallel_entry, "LOCK_parallel_entry", 0}
+  { &key_LOCK_parallel_entry, "LOCK_parallel_entry", 0},
+  { &key_LOCK_rpl_row_keys, "LOCK_rpl_row_keys", 0},
+  { &key_LOCK_sort_workers, "Sort_workers::LOCK_sort_workers", 0}
 };
 
 PSI_rwlock_key key_rwlock_LOCK_grant, key_rwlock_LOCK_logger,
   key_rwlock_LOCK_sys_init_connect, key_rwlock_LOCK_sys_init_slave,
-  key_rwlock_LOCK_system_variables_hash, key_rwlock_query_cache_query_lock;
+  key_rwlock_LOCK_system_variables_hash, key_rwlock_query_cache_query_lock,
+  key_rwlock_LOCK_binlog_dump_cache;
 
 static PSI_rwlock_info all_server_rwlocks[]=
 {
@@ -993,7 +1002,8 @@ static PSI_rwlock_info all_server_rwlocks[]=
   { &key_rwlock_LOCK_sys_init_connect, "LOCK_sys_init_connect", PSI_FLAG_GLOBAL},
   { &key_rwlock_LOCK_sys_init_slave, "LOCK_sys_init_slave", PSI_FLAG_GLOBAL},
   { &key_rwlock_LOCK_system_variables_hash, "LOCK_system_variables_hash", PSI_FLAG_GLOBAL},
-  { &key_rwlock_query_cache_query_lock, "Query_cache_query::lock", 0}
+  { &key_rwlock_query_cache_query_lock, "Query_cache_query::lock", 0},
+  { &key_rwlock_LOCK_binlog_dump_cache, "LOCK_binlog_dump_cache", PSI_FLAG_GLOBAL}
 };
 
 #ifdef HAVE_MMAP
@@ -1003,8 +1013,8 @@ PSI_cond_key key_PAGE_cond, key_COND_active, key_COND_pool;
 PSI_cond_key key_BINLOG_COND_xid_list, key_BINLOG_update_cond,
   key_BINLOG_COND_binlog_background_thread,
   key_BINLOG_COND_binlog_background_thread_end,
-  key_COND_cache_status_changed, key_COND_manager,
-  key_COND_rpl_status, key_COND_server_started,
+  key_COND_cache_status_changed, key_COND_query_cache_reclaim,
+  key_COND_manager, key_COND_rpl_status, key_COND_server_started,
   key_delayed_insert_cond, key_delayed_insert_cond_client,
   key_item_func_sleep_cond, key_master_info_data_cond,
   key_master_info_start_cond, key_master_info_stop_cond,
@@ -1024,6 +1034,7 @@ PSI_cond_key key_COND_rpl_thread_queue, key_COND_rpl_thread,
   key_COND_parallel_entry, key_COND_group_commit_orderer,
   key_COND_prepare_ordered, key_COND_slave_background;
 PSI_cond_key key_COND_wait_gtid, key_COND_gtid_ignore_duplicates;
+PSI_cond_key key_COND_sort_job, key_COND_sort_job_done;
 
 static PSI_cond_info all_server_conds[]=
 {
@@ -1046,6 +1057,7 @@ static PSI_cond_info all_server_conds[]=
   { &key_COND_wakeup_ready, "THD::COND_wakeup_ready", 0},
   { &key_COND_wait_commit, "wait_for_commit::COND_wait_commit", 0},
   { &key_COND_cache_status_changed, "Query_cache::COND_cache_status_changed", 0},
+  { &key_COND_query_cache_reclaim, "COND_query_cache_reclaim", PSI_FLAG_GLOBAL},
   { &key_COND_manager, "COND_manager", PSI_FLAG_GLOBAL},
   { &key_COND_server_started, "COND_server_started", PSI_FLAG_GLOBAL},
   { &key_delayed_insert_cond, "Delayed_insert::cond", 0},
@@ -1074,13 +1086,16 @@ static PSI_cond_info all_server_conds[]=
   { &key_COND_prepare_ordered, "COND_prepare_ordered", 0},
   { &key_COND_slave_background, "COND_slave_background", 0},
   { &key_COND_wait_gtid, "COND_wait_gtid", 0},
-  { &key_COND_gtid_ignore_duplicates, "COND_gtid_ignore_duplicates", 0}
+  { &key_COND_gtid_ignore_duplicates, "COND_gtid_ignore_duplicates", 0},
+  { &key_COND_sort_job, "Sort_workers::COND_sort_job", 0},
+  { &key_COND_sort_job_done, "Sort_workers::COND_sort_job_done", 0}
 };
 
 PSI_thread_key key_thread_bootstrap, key_thread_delayed_insert,
   key_thread_handle_manager, key_thread_main,
   key_thread_one_connection, key_thread_signal_hand,
-  key_thread_slave_background, key_rpl_parallel_thread;
+  key_thread_slave_background, key_rpl_parallel_thread,
+  key_thread_query_cache_reclaim, key_thread_sort_worker;
 
 static PSI_thread_info all_server_threads[]=
 {
@@ -1107,7 +1122,9 @@ static PSI_thread_info all_server_threads[]=
   { &key_thread_one_connection, "one_connection", 0},
   { &key_thread_signal_hand, "signal_handler", PSI_FLAG_GLOBAL},
   { &key_thread_slave_background, "slave_background", PSI_FLAG_GLOBAL},
-  { &key_rpl_parallel_thread, "rpl_parallel_thread", 0}
+  { &key_rpl_parallel_thread, "rpl_parallel_thread", 0},
+  { &key_thread_query_cache_reclaim, "query_cache_reclaim", PSI_FLAG_GLOBAL},
+  { &key_thread_sort_worker, "sort_worker", 0}
 };
 
 #ifdef HAVE_MMAP
@@ -1196,6 +1213,7 @@ void init_net_server_extension(THD *thd)
   thd->m_net_server_extension.m_user_data= thd;
   thd->m_net_server_extension.m_before_header= net_before_header_psi;
   thd->m_net_server_extension.m_after_header= net_after_header_psi;
+  thd->m_net_server_extension.m_compress_stream= NULL;
   /* Activate this private extension for the mysqld server. */
   thd->net.extension= & thd->m_net_server_extension;
 }
@@ -1435,6 +1453,8 @@ int deny_severity = LOG_WARNING;
 #endif
 #ifdef HAVE_QUERY_CACHE
 ulong query_cache_min_res_unit= QUERY_CACHE_MIN_RESULT_DATA_SIZE;
+uint query_cache_partitions= 1;
+my_bool opt_query_cache_async_invalidation= 0;
 Query_cache query_cache;
 #endif
 #ifdef HAVE_SMEM
@@ -2066,6 +2086,9 @@ static void mysqld_exit(int exit_code)
   */
   rpl_deinit_gtid_waiting();
   rpl_deinit_gtid_slave_state();
+#ifdef HAVE_REPLICATION
+  rpl_deinit_binlog_dump_cache();
+#endif
   wait_for_signal_thread_to_end();
   mysql_audit_finalize();
   clean_up_mutexes();
@@ -2266,6 +2289,7 @@ static void clean_up_mutexes()
   mysql_cond_destroy(&COND_server_started);
   mysql_mutex_destroy(&LOCK_prepare_ordered);
   mysql_cond_destroy(&COND_prepare_ordered);
+  mysql_mutex_destroy(&LOCK_binlog_sync);
   mysql_mutex_destroy(&LOCK_after_binlog_sync);
   mysql_mutex_destroy(&LOCK_commit_ordered);
   mysql_mutex_destroy(&LOCK_slave_background);
@@ -4583,6 +4607,8 @@ static int init_thread_environment()
   mysql_mutex_init(key_LOCK_prepare_ordered, &LOCK_prepare_ordered,
                    MY_MUTEX_INIT_SLOW);
   mysql_cond_init(key_COND_prepare_ordered, &COND_prepare_ordered, NULL);
+  mysql_mutex_init(key_LOCK_binlog_sync, &LOCK_binlog_sync,
+                   MY_MUTEX_INIT_SLOW);
   mysql_mutex_init(key_LOCK_after_binlog_sync, &LOCK_after_binlog_sync,
                    MY_MUTEX_INIT_SLOW);
   mysql_mutex_init(key_LOCK_commit_ordered, &LOCK_commit_ordered,
@@ -4631,6 +4657,7 @@ static int init_thread_environment()
 #ifdef HAVE_REPLICATION
   rpl_init_gtid_slave_state();
   rpl_init_gtid_waiting();
+  rpl_init_binlog_dump_cache();
 #endif
 
   DBUG_RETURN(0);
@@ -4846,7 +4873,7 @@ static int init_server_components()
   {
     global_system_variables.query_cache_type= 1;
   }
-  query_cache_init();
+  query_cache_init(query_cache_partitions);
   query_cache_resize(query_cache_size);
   my_rnd_init(&sql_rand,(ulong) server_start_time,(ulong) server_start_time/2);
   setup_fpu();
@@ -7456,6 +7483,9 @@ struct my_option my_long_options[]=
    "with rollback and retry. \"conservative\" limits parallelism in an "
    "effort to avoid any conflicts. \"aggressive\" tries to maximise the "
    "parallelism, possibly at the cost of increased conflict rate. "
+   "\"dependency\" works like \"optimistic\", but makes a transaction "
+   "wait for the commit of an earlier one that changed the same rows "
+   "(by primary or unique key) before applying its row events. "
    "\"minimal\" only parallelizes the commit steps of transactions. "
    "\"none\" disables parallel apply completely.",
    &opt_slave_parallel_mode, &opt_slave_parallel_mode,
@@ -8207,6 +8237,69 @@ static int show_default_keycache(THD *thd, SHOW_VAR *var, char *buff,
 }
 
 
+#ifdef HAVE_QUERY_CACHE
+/*
+  Query cache statistics, summed up over all partitions of the cache.
+*/
+
+static int show_query_cache(THD *thd, SHOW_VAR *var, char *buff,
+                            enum enum_var_type scope)
+{
+  struct st_data {
+    ulong free_memory_blocks, free_memory, hits, inserts, lock_free_hits,
+      lowmem_prunes, refused, queries_in_cache, total_blocks;
+    SHOW_VAR var[10];
+  } *data;
+  SHOW_VAR *v;
+
+  data=(st_data *)buff;
+  v= data->var;
+  bzero((char*) data, offsetof(st_data, var));
+
+  var->type= SHOW_ARRAY;
+  var->value= v;
+
+  for (uint i= 0; i < query_cache.get_partition_count(); i++)
+  {
+    Query_cache *partition= query_cache.get_partition(i);
+    data->free_memory_blocks+= partition->free_memory_blocks;
+    data->free_memory+=        partition->free_memory;
+    data->hits+=               partition->hits + partition->lock_free_hits;
+    data->inserts+=            partition->inserts;
+    data->lock_free_hits+=     partition->lock_free_hits;
+    data->lowmem_prunes+=      partition->lowmem_prunes;
+    data->refused+=            partition->refused;
+    data->queries_in_cache+=   partition->queries_in_cache;
+    data->total_blocks+=       partition->total_blocks;
+  }
+
+#define set_one_qcache_var(X,Y)         \
+  v->name= X;                           \
+  v->type= SHOW_LONG;                   \
+  v->value= &data->Y;                   \
+  v++;
+
+  set_one_qcache_var("free_blocks",      free_memory_blocks);
+  set_one_qcache_var("free_memory",      free_memory);
+  set_one_qcache_var("hits",             hits);
+  set_one_qcache_var("inserts",          inserts);
+  set_one_qcache_var("lock_free_hits",   lock_free_hits);
+  set_one_qcache_var("lowmem_prunes",    lowmem_prunes);
+  set_one_qcache_var("not_cached",       refused);
+  set_one_qcache_var("queries_in_cache", queries_in_cache);
+  set_one_qcache_var("total_blocks",     total_blocks);
+
+  v->name= 0;
+
+  DBUG_ASSERT((char*)(v+1) <= buff + SHOW_VAR_FUNC_BUFF_SIZE);
+
+#undef set_one_qcache_var
+
+  return 0;
+}
+#endif /* HAVE_QUERY_CACHE */
+
+
 static int show_memory_used(THD *thd, SHOW_VAR *var, char *buff,
                             struct system_status_var *status_var,
                             enum enum_var_type scope)
@@ -8268,6 +8361,57 @@ int show_threadpool_idle_threads(THD *thd, SHOW_VAR *var, char *buff,
   *(int *)buff= tp_get_idle_thread_count(); 
   return 0;
 }
+
+#ifndef _WIN32
+int show_threadpool_steals(THD *thd, SHOW_VAR *var, char *buff,
+                           enum enum_var_type scope)
+{
+  ulonglong sum= 0;
+  uint count= tp_get_group_count();
+  for (uint i= 0; i < count; i++)
+    sum+= tp_get_group_steal_count(i);
+  var->type= SHOW_LONGLONG;
+  var->value= buff;
+  *(ulonglong *)buff= sum;
+  return 0;
+}
+
+
+/*
+  Per-group steal counters, shown as Threadpool_group_steals_<group>.
+  The list is built on every call, since thread_pool_size is dynamic.
+*/
+
+int show_threadpool_group_steals(THD *thd, SHOW_VAR *var, char *buff,
+                                 enum enum_var_type scope)
+{
+  uint count= tp_get_group_count();
+  ulonglong *values= (ulonglong *) thd->alloc(sizeof(ulonglong) * count);
+  SHOW_VAR *v= (SHOW_VAR *) thd->alloc(sizeof(SHOW_VAR) * (count + 1));
+
+  var->type= SHOW_ARRAY;
+  var->value= buff;
+
+  if (!values || !v)
+  {
+    ((SHOW_VAR *) buff)->name= 0;
+    return 0;
+  }
+
+  var->value= (char *) v;
+  for (uint i= 0; i < count; i++, v++)
+  {
+    char name[12];
+    my_snprintf(name, sizeof(name), "%u", i);
+    values[i]= tp_get_group_steal_count(i);
+    v->name= thd->strdup(name);
+    v->value= (char *) &values[i];
+    v->type= SHOW_LONGLONG;
+  }
+  v->name= 0;
+  return 0;
+}
+#endif /* !_WIN32 */
 #endif
 
 /*
@@ -8282,6 +8426,10 @@ SHOW_VAR status_vars[]= {
   {"Binlog_bytes_written",     (char*) offsetof(STATUS_VAR, binlog_bytes_written), SHOW_LONGLONG_STATUS},
   {"Binlog_cache_disk_use",    (char*) &binlog_cache_disk_use,  SHOW_LONG},
   {"Binlog_cache_use",         (char*) &binlog_cache_use,       SHOW_LONG},
+#ifdef HAVE_REPLICATION
+  {"Binlog_dump_cache_hits",   (char*) &binlog_dump_cache_hits, SHOW_LONGLONG},
+  {"Binlog_dump_cache_misses", (char*) &binlog_dump_cache_misses, SHOW_LONGLONG},
+#endif
   {"Binlog_stmt_cache_disk_use",(char*) &binlog_stmt_cache_disk_use,  SHOW_LONG},
   {"Binlog_stmt_cache_use",    (char*) &binlog_stmt_cache_use,       SHOW_LONG},
   {"Busy_time",                (char*) offsetof(STATUS_VAR, busy_time), SHOW_DOUBLE_STATUS},
@@ -8369,14 +8517,7 @@ SHOW_VAR status_vars[]= {
   {"Rows_read",                (char*) offsetof(STATUS_VAR, rows_read), SHOW_LONGLONG_STATUS},
   {"Rows_tmp_read",            (char*) offsetof(STATUS_VAR, rows_tmp_read), SHOW_LONGLONG_STATUS},
 #ifdef HAVE_QUERY_CACHE
-  {"Qcache_free_blocks",       (char*) &query_cache.free_memory_blocks, SHOW_LONG_NOFLUSH},
-  {"Qcache_free_memory",       (char*) &query_cache.free_memory, SHOW_LONG_NOFLUSH},
-  {"Qcache_hits",              (char*) &query_cache.hits,       SHOW_LONG},
-  {"Qcache_inserts",           (char*) &query_cache.inserts,    SHOW_LONG},
-  {"Qcache_lowmem_prunes",     (char*) &query_cache.lowmem_prunes, SHOW_LONG},
-  {"Qcache_not_cached",        (char*) &query_cache.refused,    SHOW_LONG},
-  {"Qcache_queries_in_cache",  (char*) &query_cache.queries_in_cache, SHOW_LONG_NOFLUSH},
-  {"Qcache_total_blocks",      (char*) &query_cache.total_blocks, SHOW_LONG_NOFLUSH},
+  {"Qcache",                   (char*) &show_query_cache,       SHOW_FUNC},
 #endif /*HAVE_QUERY_CACHE*/
   {"Queries",                  (char*) &show_queries,            SHOW_SIMPLE_FUNC},
   {"Questions",                (char*) offsetof(STATUS_VAR, questions), SHOW_LONG_STATUS},
@@ -8442,6 +8583,10 @@ SHOW_VAR status_vars[]= {
   */
   {"Subquery_cache_hit",       (char*) &subquery_cache_hit,     SHOW_LONG},
   {"Subquery_cache_miss",      (char*) &subquery_cache_miss,    SHOW_LONG},
+  {"Subquery_persistent_cache_hit", (char*) &subquery_persistent_cache_hit,
+   SHOW_LONG},
+  {"Subquery_persistent_cache_miss", (char*) &subquery_persistent_cache_miss,
+   SHOW_LONG},
   {"Table_locks_immediate",    (char*) &locks_immediate,        SHOW_LONG},
   {"Table_locks_waited",       (char*) &locks_waited,           SHOW_LONG},
 #ifdef HAVE_MMAP
@@ -8450,7 +8595,13 @@ SHOW_VAR status_vars[]= {
   {"Tc_log_page_waits",        (char*) &tc_log_page_waits,      SHOW_LONG},
 #endif
 #ifdef HAVE_POOL_OF_THREADS
+#ifndef _WIN32
+  {"Threadpool_group_steals",  (char *) &show_threadpool_group_steals, SHOW_FUNC},
+#endif
   {"Threadpool_idle_threads",  (char *) &show_threadpool_idle_threads, SHOW_SIMPLE_FUNC},
+#ifndef _WIN32
+  {"Threadpool_steals",        (char *) &show_threadpool_steals, SHOW_SIMPLE_FUNC},
+#endif
   {"Threadpool_threads",       (char *) &tp_stats.num_worker_threads, SHOW_INT},
 #endif
   {"Threads_cached",           (char*) &cached_thread_count,    SHOW_LONG_NOFLUSH},
@@ -8640,6 +8791,7 @@ static int mysql_init_variables(void)
   ready_to_exit= shutdown_in_progress= grant_option= 0;
   aborted_threads= aborted_connects= 0;
   subquery_cache_miss= subquery_cache_hit= 0;
+  subquery_persistent_cache_miss= subquery_persistent_cache_hit= 0;
   delayed_insert_threads= delayed_insert_writes= delayed_rows_in_use= 0;
   delayed_insert_errors= thread_created= 0;
   specialflag= 0;
@@ -9910,6 +10062,9 @@ void refresh_status(THD *thd)
 
   /* Reset the counters of all key caches (default and named). */
   process_key_caches(reset_key_cache_counters, 0);
+#ifdef HAVE_QUERY_CACHE
+  query_cache.reset_statistics();
+#endif
   flush_status_time= time((time_t*) 0);
   mysql_mutex_unlock(&LOCK_status);
 
@@ -10085,6 +10240,7 @@ PSI_stage_info stage_gtid_wait_other_connection= { 0, "Waiting for other master
 PSI_stage_info stage_slave_background_process_request= { 0, "Processing requests", 0};
 PSI_stage_info stage_slave_background_wait_request= { 0, "Waiting for requests", 0};
 PSI_stage_info stage_waiting_for_deadlock_kill= { 0, "Waiting for parallel replication deadlock handling to complete", 0};
+PSI_stage_info stage_waiting_for_row_dependency= { 0, "Waiting for prior transaction changing the same rows to commit", 0};
 
 #ifdef HAVE_PSI_INTERFACE
 
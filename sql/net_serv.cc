@@ -120,6 +120,7 @@ extern my_bool thd_net_is_killed();
 #define MAX_PACKET_LENGTH (256L*256L*256L-1)
 
 static my_bool net_write_buff(NET *, const uchar *, ulong);
+static int net_real_writev(NET *, struct iovec *, uint);
 
 /** Init with packet info. */
 
@@ -166,11 +167,82 @@ my_bool my_net_init(NET *net, Vio *vio, void *thd, uint my_flags)
 }
 
 
+#ifdef HAVE_COMPRESS
+/**
+  Get the compression context of a NET with NET_COMPRESS_STREAM,
+  creating it on first use.
+
+  The layout of NET can't be changed, so in the server the context is
+  stored in the NET_SERVER extension. Connections the server makes as a
+  client, like the one of a slave to its master, get a NET_SERVER without
+  callbacks for it. In the client library NET::extension is not used
+  otherwise and points to the context directly.
+
+  @return Context, or 0 if out of memory
+*/
+
+static COMPRESS_STREAM *net_compress_stream(NET *net)
+{
+  myf flags= MYF(MY_WME | (net->thread_specific_malloc ?
+                           MY_THREAD_SPECIFIC : 0));
+#ifdef MYSQL_SERVER
+  NET_SERVER *server_extension= (NET_SERVER*) net->extension;
+  if (server_extension && server_extension->m_compress_stream)
+    return server_extension->m_compress_stream;
+  if (!server_extension)
+  {
+    if (!(server_extension= (NET_SERVER*) my_malloc(sizeof(NET_SERVER),
+                                                    MYF(flags |
+                                                        MY_ZEROFILL))))
+      return 0;
+    net->extension= server_extension;
+  }
+  return (server_extension->m_compress_stream=
+          my_compress_stream_init(flags));
+#else
+  if (!net->extension)
+    net->extension= my_compress_stream_init(flags);
+  return (COMPRESS_STREAM*) net->extension;
+#endif
+}
+
+
+static void net_end_compress_stream(NET *net)
+{
+#ifdef MYSQL_SERVER
+  NET_SERVER *server_extension= (NET_SERVER*) net->extension;
+  if (!server_extension)
+    return;
+  if (server_extension->m_compress_stream)
+  {
+    my_compress_stream_end(server_extension->m_compress_stream);
+    server_extension->m_compress_stream= 0;
+  }
+  if (!server_extension->m_before_header)
+  {
+    /* Created by net_compress_stream() */
+    my_free(server_extension);
+    net->extension= 0;
+  }
+#else
+  if (net->extension)
+  {
+    my_compress_stream_end((COMPRESS_STREAM*) net->extension);
+    net->extension= 0;
+  }
+#endif
+}
+#endif /* HAVE_COMPRESS */
+
+
 void net_end(NET *net)
 {
   DBUG_ENTER("net_end");
   my_free(net->buff);
   net->buff=0;
+#ifdef HAVE_COMPRESS
+  net_end_compress_stream(net);
+#endif
   DBUG_VOID_RETURN;
 }
 
@@ -581,29 +653,115 @@ net_write_buff(NET *net, const uchar *packet, ulong len)
 }
 
 
+#ifdef MYSQL_SERVER
+/**
+  Write a logical packet, data of which is in several buffers.
+
+  If the packet does not fit into the network buffer, it is not copied
+  there: the buffered data, the packet header and the packet data are
+  sent with one vectored write.
+
+  @param net     Network handler
+  @param iov     iov[0] and iov[1] are reserved for the buffered data and
+                 the packet header, the packet data is in the rest. The
+                 array is modified.
+  @param iovcnt  Number of elements in iov
+
+  @note The packet must be shorter than MAX_PACKET_LENGTH.
+
+  @retval 0  ok
+  @retval 1  error
+*/
+
+my_bool my_net_writev(NET *net, struct iovec *iov, uint iovcnt)
+{
+  uchar buff[NET_HEADER_SIZE];
+  size_t len= 0;
+  uint i;
+  int rc;
+
+  if (unlikely(!net->vio)) /* nowhere to write */
+    return 0;
+
+  DBUG_ASSERT(iovcnt >= 2);
+  for (i= 2; i < iovcnt; i++)
+    len+= iov[i].iov_len;
+  DBUG_ASSERT(len < MAX_PACKET_LENGTH);
+
+  MYSQL_NET_WRITE_START(len);
+  int3store(buff, len);
+  buff[3]= (uchar) net->pkt_nr++;
+
+  /* Compressed packets are assembled in the network buffer. */
+  if (net->compress ||
+      NET_HEADER_SIZE + len <= (size_t) (net->buff_end - net->write_pos))
+  {
+    rc= net_write_buff(net, buff, NET_HEADER_SIZE);
+    for (i= 2; i < iovcnt && !rc; i++)
+      rc= net_write_buff(net, (uchar*) iov[i].iov_base, iov[i].iov_len);
+    MYSQL_NET_WRITE_DONE(rc);
+    return rc;
+  }
+
+  iov[0].iov_base= net->buff;
+  iov[0].iov_len= net->write_pos - net->buff;
+  iov[1].iov_base= buff;
+  iov[1].iov_len= NET_HEADER_SIZE;
+  net->write_pos= net->buff;
+  rc= MY_TEST(net_real_writev(net, iov, iovcnt));
+  MYSQL_NET_WRITE_DONE(rc);
+  return rc;
+}
+#endif /* MYSQL_SERVER */
+
+
 /**
   Read and write one packet using timeouts.
   If needed, the packet is compressed before sending.
+*/
+
+int
+net_real_write(NET *net,const uchar *packet, size_t len)
+{
+  struct iovec iov;
+  iov.iov_base= (void*) packet;
+  iov.iov_len= len;
+  return net_real_writev(net, &iov, 1);
+}
+
+
+/**
+  Write data from several buffers using timeouts.
+
+  @param net     Network handler
+  @param iov     Buffers to write, the array is modified
+  @param iovcnt  Number of elements in iov, must be 1 if compression
+                 is used
 
   @todo
     - TODO is it needed to set this variable if we have no socket
 */
 
-int
-net_real_write(NET *net,const uchar *packet, size_t len)
+static int
+net_real_writev(NET *net, struct iovec *iov, uint iovcnt)
 {
   size_t length;
-  const uchar *pos,*end;
   thr_alarm_t alarmed;
 #ifndef NO_ALARM
   ALARM alarm_buff;
 #endif
   uint retry_count=0;
   my_bool net_blocking = vio_is_blocking(net->vio);
-  DBUG_ENTER("net_real_write");
+#ifdef HAVE_COMPRESS
+  uchar *compressed= 0;
+#endif
+  DBUG_ENTER("net_real_writev");
 
 #if defined(MYSQL_SERVER) && defined(USE_QUERY_CACHE)
-  query_cache_insert(net->thd, (char*) packet, len, net->pkt_nr);
+  for (uint i= 0; i < iovcnt; i++)
+    if (iov[i].iov_len)
+      query_cache_insert(net->thd, (char*) iov[i].iov_base, iov[i].iov_len,
+                         net->pkt_nr);
 #endif
 
   if (net->error == 2)
@@ -614,9 +772,15 @@ net_real_write(NET *net,const uchar *packet, size_t len)
   if (net->compress)
   {
     size_t complen;
+    size_t len= iov->iov_len;
     uchar *b;
     uint header_length=NET_HEADER_SIZE+COMP_HEADER_SIZE;
-    if (!(b= (uchar*) my_malloc(len + NET_HEADER_SIZE +
+    COMPRESS_STREAM *stream= 0;
+    DBUG_ASSERT(iovcnt == 1);
+    if ((net->compress == NET_COMPRESS_STREAM &&
+         !(stream= net_compress_stream(net))) ||
+        !(b= (uchar*) my_malloc((stream ? my_compress_stream_bound(len) :
+                                 len) + NET_HEADER_SIZE +
                                 COMP_HEADER_SIZE + 1,
                                 MYF(MY_WME |
                                     (net->thread_specific_malloc ?
@@ -628,21 +792,43 @@ net_real_write(NET *net,const uchar *packet, size_t len)
       net->reading_or_writing= 0;
       DBUG_RETURN(1);
     }
-    memcpy(b+header_length,packet,len);
 
-    /* Don't compress error packets (compress == 2) */
-    if (net->compress == 2 || my_compress(b+header_length, &len, &complen))
-      complen=0;
+    if (stream)
+    {
+      /*
+        The packet is compressed even if it gets longer, as the reader has
+        to see everything that went through the stream.
+      */
+      complen= len;
+      if (my_compress_stream(stream, b + header_length, &len,
+                             (uchar*) iov->iov_base, complen))
+      {
+        my_free(b);
+        net->error= 2;
+        net->last_errno= ER_NET_ERROR_ON_WRITE;
+        net->reading_or_writing= 0;
+        DBUG_RETURN(1);
+      }
+    }
+    else
+    {
+      memcpy(b+header_length,iov->iov_base,len);
+
+      /* Don't compress error packets (compress == 2) */
+      if (net->compress == 2 || my_compress(b+header_length, &len, &complen))
+        complen=0;
+    }
     int3store(&b[NET_HEADER_SIZE],complen);
     int3store(b,len);
     b[3]=(uchar) (net->compress_pkt_nr++);
-    len+= header_length;
-    packet= b;
+    iov->iov_base= compressed= b;
+    iov->iov_len= len + header_length;
   }
 #endif /* HAVE_COMPRESS */
 
 #ifdef DEBUG_DATA_PACKETS
-  DBUG_DUMP("data_written", packet, len);
+  for (uint i= 0; i < iovcnt; i++)
+    DBUG_DUMP("data_written", (uchar*) iov[i].iov_base, iov[i].iov_len);
 #endif
 
 #ifndef NO_ALARM
@@ -654,11 +840,17 @@ net_real_write(NET *net,const uchar *packet, size_t len)
   /* Write timeout is set in my_net_set_write_timeout */
 #endif /* NO_ALARM */
 
-  pos= packet;
-  end=pos+len;
-  while (pos != end)
+  while (iovcnt && !iov->iov_len)
+  {
+    iov++;
+    iovcnt--;
+  }
+  while (iovcnt)
   {
-    if ((long) (length= vio_write(net->vio,pos,(size_t) (end-pos))) <= 0)
+    if ((long) (length= (iovcnt == 1 ?
+                         vio_write(net->vio, (uchar*) iov->iov_base,
+                                   iov->iov_len) :
+                         vio_writev(net->vio, iov, (int) iovcnt))) <= 0)
     {
       my_bool interrupted = vio_should_retry(net->vio);
 #if !defined(__WIN__)
@@ -706,15 +898,25 @@ net_real_write(NET *net,const uchar *packet, size_t len)
       MYSQL_SERVER_my_error(net->last_errno, MYF(0));
       break;
     }
-    pos+=length;
     update_statistics(thd_increment_bytes_sent(net->thd, length));
+    /* Skip what was written, the write may end in the middle of a buffer */
+    while (iovcnt && length >= iov->iov_len)
+    {
+      length-= iov->iov_len;
+      iov++;
+      iovcnt--;
+    }
+    if (iovcnt)
+    {
+      iov->iov_base= (uchar*) iov->iov_base + length;
+      iov->iov_len-= length;
+    }
   }
 #ifndef __WIN__
  end:
 #endif
 #ifdef HAVE_COMPRESS
-  if (net->compress)
-    my_free((void*) packet);
+  my_free(compressed);
 #endif
   if (thr_alarm_in_use(&alarmed))
   {
@@ -724,7 +926,7 @@ net_real_write(NET *net,const uchar *packet, size_t len)
       vio_blocking(net->vio, net_blocking, &old_mode);
   }
   net->reading_or_writing=0;
-  DBUG_RETURN(((int) (pos != end)));
+  DBUG_RETURN(((int) (iovcnt != 0)));
 }
 
 
@@ -847,6 +1049,9 @@ my_real_read(NET *net, size_t *complen,
   if (header)
   {
     server_extension= static_cast<st_net_server*> (net->extension);
+    /* Connections made by the server as a client have no callbacks */
+    if (server_extension != NULL && !server_extension->m_before_header)
+      server_extension= NULL;
     if (server_extension != NULL)
     {
       void *user_data= server_extension->m_user_data;
@@ -1244,8 +1449,22 @@ my_net_read_packet(NET *net, my_bool read_from_server)
 	return packet_error;
       }
       read_from_server= 0;
-      if (my_uncompress(net->buff + net->where_b, packet_len,
-			&complen))
+      if (net->compress == NET_COMPRESS_STREAM)
+      {
+        COMPRESS_STREAM *stream;
+        if (!(stream= net_compress_stream(net)) ||
+            my_uncompress_stream(stream, net->buff + net->where_b,
+                                 packet_len, &complen))
+        {
+          net->error= 2;			/* caller will close socket */
+          net->last_errno= ER_NET_UNCOMPRESS_ERROR;
+          MYSQL_SERVER_my_error(ER_NET_UNCOMPRESS_ERROR, MYF(0));
+          MYSQL_NET_READ_DONE(1, 0);
+          return packet_error;
+        }
+      }
+      else if (my_uncompress(net->buff + net->where_b, packet_len,
+                             &complen))
       {
 	net->error= 2;			/* caller will close socket */
         net->last_errno= ER_NET_UNCOMPRESS_ERROR;
@@ -32,6 +32,13 @@
 #include <stdarg.h>
 
 static const unsigned int PACKET_BUFFER_EXTRA_ALLOC= 1024;
+/*
+  Column values at least this long are not copied to the packet by
+  Protocol_text::store(Field *), see Protocol_text::write_ext().
+*/
+static const size_t EXT_VALUE_MIN_LENGTH= 512;
+/* As in net_serv.cc */
+static const size_t MAX_PACKET_LENGTH= 256L*256L*256L-1;
 /* Declared non-static only because of the embedded library. */
 bool net_send_error_packet(THD *, uint, const char *, const char *);
 /* Declared non-static only because of the embedded library. */
@@ -990,6 +997,8 @@ bool Protocol::store(I_List<i_string>* str_list)
 void Protocol_text::prepare_for_resend()
 {
   packet->length(0);
+  ext_count= 0;
+  ext_length= 0;
 #ifndef DBUG_OFF
   field_pos= 0;
 #endif
@@ -1004,6 +1013,91 @@ bool Protocol_text::store_null()
   buff[0]= (char)251;
   return packet->append(buff, sizeof(buff), PACKET_BUFFER_EXTRA_ALLOC);
 }
+
+
+/**
+  Store the length of a column value, the value itself stays where it is
+  until the row is written.
+*/
+
+bool Protocol_text::store_ext(const char *from, size_t length)
+{
+  ulong packet_length= packet->length();
+  DBUG_ASSERT(ext_count < MAX_EXT_VALUES);
+  if (packet_length + 9 > packet->alloced_length() &&
+      packet->realloc(packet_length + 9))
+    return 1;
+  uchar *to= net_store_length((uchar*) packet->ptr() + packet_length, length);
+  packet->length((uint) (to - (uchar*) packet->ptr()));
+  ext_values[ext_count].offset= packet->length();
+  ext_values[ext_count].ptr= from;
+  ext_values[ext_count].length= length;
+  ext_count++;
+  ext_length+= length;
+  return 0;
+}
+
+
+bool Protocol_text::write()
+{
+  if (ext_count)
+    return write_ext();
+  return Protocol::write();
+}
+
+
+/**
+  Write a row, some column values of which are not in the packet.
+
+  The parts of the packet and the values are passed to my_net_writev(),
+  which sends long rows without copying them to the network buffer.
+  Rows which would be split into several packets are assembled in the
+  packet.
+*/
+
+bool Protocol_text::write_ext()
+{
+  struct iovec iov[2 + 2 * MAX_EXT_VALUES + 1];
+  char *pos= (char*) packet->ptr();
+  size_t done= 0;
+  uint iovcnt= 2;
+  uint count= ext_count;
+  DBUG_ENTER("Protocol_text::write_ext");
+
+  ext_count= 0;
+  if (packet->length() + ext_length >= MAX_PACKET_LENGTH)
+  {
+    size_t length= packet->length();
+    size_t shift= ext_length;
+    if (packet->realloc(length + ext_length))
+      DBUG_RETURN(1);
+    pos= (char*) packet->ptr();
+    /* Move the packet tail first, then put the value in front of it. */
+    while (count--)
+    {
+      Ext_value *ext= ext_values + count;
+      memmove(pos + ext->offset + shift, pos + ext->offset,
+              length - ext->offset);
+      shift-= ext->length;
+      memcpy(pos + ext->offset + shift, ext->ptr, ext->length);
+      length= ext->offset;
+    }
+    packet->length(packet->length() + ext_length);
+    DBUG_RETURN(Protocol::write());
+  }
+
+  for (Ext_value *ext= ext_values; ext < ext_values + count; ext++)
+  {
+    iov[iovcnt].iov_base= pos + done;
+    iov[iovcnt++].iov_len= ext->offset - done;
+    iov[iovcnt].iov_base= (void*) ext->ptr;
+    iov[iovcnt++].iov_len= ext->length;
+    done= ext->offset;
+  }
+  iov[iovcnt].iov_base= pos + done;
+  iov[iovcnt++].iov_len= packet->length() - done;
+  DBUG_RETURN(my_net_writev(&thd->net, iov, iovcnt));
+}
 #endif
 
 
@@ -1012,13 +1106,20 @@ bool Protocol_text::store_null()
   and store in network buffer.
 */
 
+static inline bool needs_conversion(CHARSET_INFO *fromcs,
+                                    CHARSET_INFO *tocs)
+{
+  /* 'tocs' is set 0 when client issues SET character_set_results=NULL */
+  return tocs && !my_charset_same(fromcs, tocs) &&
+         fromcs != &my_charset_bin &&
+         tocs != &my_charset_bin;
+}
+
+
 bool Protocol::store_string_aux(const char *from, size_t length,
                                 CHARSET_INFO *fromcs, CHARSET_INFO *tocs)
 {
-  /* 'tocs' is set 0 when client issues SET character_set_results=NULL */
-  if (tocs && !my_charset_same(fromcs, tocs) &&
-      fromcs != &my_charset_bin &&
-      tocs != &my_charset_bin)
+  if (needs_conversion(fromcs, tocs))
   {
     /* Store with conversion */
     return net_store_data_cs((uchar*) from, length, fromcs, tocs);
@@ -1183,6 +1284,17 @@ bool Protocol_text::store(Field *field)
     dbug_tmp_restore_column_map(table->read_set, old_map);
 #endif
 
+#ifndef EMBEDDED_LIBRARY
+  /*
+    A long value which is not in our local buffer is kept by the field
+    (in the record or the blob storage) until the next row is read.
+  */
+  if (str.length() >= EXT_VALUE_MIN_LENGTH && ext_count < MAX_EXT_VALUES &&
+      !str.is_alloced() &&
+      (str.ptr() < buff || str.ptr() >= buff + sizeof(buff)) &&
+      !needs_conversion(str.charset(), tocs))
+    return store_ext(str.ptr(), str.length());
+#endif
   return store_string_aux(str.ptr(), str.length(), str.charset(), tocs);
 }
 
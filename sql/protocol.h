@@ -149,8 +149,37 @@ class Protocol
 
 class Protocol_text :public Protocol
 {
+#ifndef EMBEDDED_LIBRARY
+  /**
+    Long column values, which are sent from where the field keeps them
+    instead of being copied to the packet. Each value goes after the
+    first 'offset' bytes of the packet.
+  */
+  struct Ext_value
+  {
+    size_t offset;
+    const char *ptr;
+    size_t length;
+  };
+  static const uint MAX_EXT_VALUES= 32;
+  Ext_value ext_values[MAX_EXT_VALUES];
+  uint ext_count;
+  size_t ext_length;
+
+  bool store_ext(const char *from, size_t length);
+  bool write_ext();
+#endif
 public:
-  Protocol_text(THD *thd_arg) :Protocol(thd_arg) {}
+  Protocol_text(THD *thd_arg) :Protocol(thd_arg)
+  {
+#ifndef EMBEDDED_LIBRARY
+    ext_count= 0;
+    ext_length= 0;
+#endif
+  }
+#ifndef EMBEDDED_LIBRARY
+  virtual bool write();
+#endif
   virtual void prepare_for_resend();
   virtual bool store_null();
   virtual bool store_tiny(longlong from);
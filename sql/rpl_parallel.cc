@@ -415,6 +415,60 @@ do_ftwrl_wait(rpl_group_info *rgi,
 }
 
 
+/*
+  With --slave-parallel-mode=dependency, wait for the prior event group with
+  sub_id wait_sub_id to commit before applying a rows event that changes some
+  of the same rows. This avoids taking row locks ahead of that event group,
+  which would end in a deadlock kill and a retry of this event group.
+
+  Returns non-zero if we were killed while waiting. Like a kill during
+  event execution, this is converted to a deadlock error by our caller if
+  it was a parallel replication deadlock kill, so that we retry.
+*/
+static int
+do_row_dependency_wait(rpl_group_info *rgi, uint64 wait_sub_id)
+{
+  THD *thd= rgi->thd;
+  rpl_parallel_entry *entry= rgi->parallel_entry;
+  PSI_stage_info old_stage;
+  int res= 0;
+  DBUG_ENTER("do_row_dependency_wait");
+
+  mysql_mutex_lock(&entry->LOCK_parallel_entry);
+  if (wait_sub_id <= entry->last_committed_sub_id)
+  {
+    mysql_mutex_unlock(&entry->LOCK_parallel_entry);
+    DBUG_RETURN(0);
+  }
+
+  thread_safe_increment64(&rgi->rli->dependency_waits);
+  ++entry->need_sub_id_signal;
+  thd->ENTER_COND(&entry->COND_parallel_entry, &entry->LOCK_parallel_entry,
+                  &stage_waiting_for_row_dependency, &old_stage);
+  do
+  {
+    if (entry->force_abort || entry->stop_on_error_sub_id <= wait_sub_id)
+      break;
+    if (thd->check_killed())
+    {
+      res= 1;
+      break;
+    }
+    mysql_cond_wait(&entry->COND_parallel_entry, &entry->LOCK_parallel_entry);
+  } while (wait_sub_id > entry->last_committed_sub_id);
+  --entry->need_sub_id_signal;
+  thd->EXIT_COND(&old_stage);
+
+  if (res)
+  {
+    thd->clear_error();
+    thd->get_stmt_da()->reset_diagnostics_area();
+    thd->send_kill_message();
+  }
+  DBUG_RETURN(res);
+}
+
+
 static int
 pool_mark_busy(rpl_parallel_thread_pool *pool, THD *thd)
 {
@@ -981,6 +1035,7 @@ handle_rpl_parallel_thread(void *arg)
   rpl_group_info *group_rgi= NULL;
   group_commit_orderer *gco;
   uint64 event_gtid_sub_id= 0;
+  ulonglong idle_start;
   rpl_sql_thread_info sql_info(NULL);
   int err;
 
@@ -1045,11 +1100,23 @@ handle_rpl_parallel_thread(void *arg)
          to abort the group (force_abort==1).
        - Thread pool shutdown (rpt->stop==1).
     */
+    idle_start= 0;
     while (!( (events= rpt->event_queue) ||
               (rpt->current_owner && !in_event_group) ||
               (rpt->current_owner && group_rgi->parallel_entry->force_abort) ||
               rpt->stop))
+    {
+      /*
+        Inside an event group we are waiting for the SQL driver thread to
+        queue the rest of it; account this as idle time of the workers.
+      */
+      if (in_event_group && !idle_start)
+        idle_start= microsecond_interval_timer();
       mysql_cond_wait(&rpt->COND_rpl_thread, &rpt->LOCK_rpl_thread);
+    }
+    if (idle_start)
+      my_atomic_add64(&group_rgi->rli->worker_idle_time,
+                      (int64) (microsecond_interval_timer() - idle_start));
     rpt->dequeue1(events);
     thd->EXIT_COND(&old_stage);
 
@@ -1258,6 +1325,11 @@ handle_rpl_parallel_thread(void *arg)
             thd->send_kill_message();
             err= 1;
           }
+          else if (qev->wait_sub_id &&
+                   (err= do_row_dependency_wait(rgi, qev->wait_sub_id)))
+          {
+            /* Killed while waiting, handled below as for rpt_handle_event. */
+          }
           else
             err= rpt_handle_event(qev, rpt);
         }
@@ -1696,6 +1768,7 @@ rpl_parallel_thread::get_qev_common(Log_event *ev, ulonglong event_size)
   qev->typ= rpl_parallel_thread::queued_event::QUEUED_EVENT;
   qev->ev= ev;
   qev->event_size= event_size;
+  qev->wait_sub_id= 0;
   qev->next= NULL;
   return qev;
 }
@@ -2091,16 +2164,33 @@ free_rpl_parallel_entry(void *element)
   }
   mysql_cond_destroy(&e->COND_parallel_entry);
   mysql_mutex_destroy(&e->LOCK_parallel_entry);
+  my_free(e->row_owners);
   my_free(e);
 }
 
 
+static uchar *
+get_row_keys_key(const uchar *ptr, size_t *length,
+                 my_bool not_used __attribute__((unused)))
+{
+  const rpl_row_keys *keys= (const rpl_row_keys *)ptr;
+  *length= keys->name_length;
+  return keys->name;
+}
+
+
 rpl_parallel::rpl_parallel() :
-  current(NULL), sql_thread_stopping(false)
+  current(NULL), sql_thread_stopping(false), column_pos(NULL),
+  column_pos_size(0)
 {
   my_hash_init(&domain_hash, &my_charset_bin, 32,
                offsetof(rpl_parallel_entry, domain_id), sizeof(uint32),
                NULL, free_rpl_parallel_entry, HASH_UNIQUE);
+  my_init_dynamic_array(&group_tables, sizeof(rpl_group_table), 16, 16,
+                        MYF(0));
+  my_hash_init(&row_keys, &my_charset_bin, 32, 0, 0, get_row_keys_key,
+               my_free, HASH_UNIQUE);
+  mysql_mutex_init(key_LOCK_rpl_row_keys, &LOCK_row_keys, MY_MUTEX_INIT_FAST);
 }
 
 
@@ -2108,6 +2198,7 @@ void
 rpl_parallel::reset()
 {
   my_hash_reset(&domain_hash);
+  clear_group_tables();
   current= NULL;
   sql_thread_stopping= false;
 }
@@ -2116,6 +2207,11 @@ rpl_parallel::reset()
 rpl_parallel::~rpl_parallel()
 {
   my_hash_free(&domain_hash);
+  clear_group_tables();
+  delete_dynamic(&group_tables);
+  my_free(column_pos);
+  my_hash_free(&row_keys);
+  mysql_mutex_destroy(&LOCK_row_keys);
 }
 
 
@@ -2432,6 +2528,313 @@ abandon_worker_thread(THD *thd, rpl_parallel_thread *cur_thread,
   @retval -1    event should be executed serially, in the sql driver thread
 */
 
+/*
+  Remember the unique keys of a table opened by a worker thread in
+  --slave-parallel-mode=dependency, so that the SQL driver thread can find
+  the columns identifying a row in later row events for the table.
+*/
+void
+rpl_parallel::record_row_keys(TABLE *table)
+{
+  TABLE_SHARE *share= table->s;
+  uint16 parts[RPL_ROW_KEY_MAX_PARTS];
+  uint length= 0;
+  rpl_row_keys *keys;
+  uchar *name;
+  uint16 *keys_parts;
+
+  for (uint i= 0; i < share->keys; i++)
+  {
+    KEY *key= table->key_info + i;
+    if (!(key->flags & HA_NOSAME))
+      continue;
+    if (length + 1 + key->user_defined_key_parts > RPL_ROW_KEY_MAX_PARTS)
+      break;
+    parts[length++]= (uint16) key->user_defined_key_parts;
+    for (uint j= 0; j < key->user_defined_key_parts; j++)
+      parts[length++]= (uint16) (key->key_part[j].fieldnr - 1);
+  }
+
+  mysql_mutex_lock(&LOCK_row_keys);
+  if ((keys= (rpl_row_keys *)my_hash_search(&row_keys,
+                                            (uchar *)share->table_cache_key.str,
+                                            share->table_cache_key.length)))
+  {
+    if (keys->parts_length == length &&
+        !memcmp(keys->parts, parts, length * sizeof(*parts)))
+    {
+      mysql_mutex_unlock(&LOCK_row_keys);
+      return;
+    }
+    /* The table was altered. */
+    my_hash_delete(&row_keys, (uchar *)keys);
+  }
+  if (my_multi_malloc(MYF(0),
+                      &keys, sizeof(*keys),
+                      &name, (uint) share->table_cache_key.length,
+                      &keys_parts, (length + 1) * sizeof(*parts),
+                      NULL))
+  {
+    keys->name= name;
+    keys->name_length= (uint) share->table_cache_key.length;
+    memcpy(name, share->table_cache_key.str, keys->name_length);
+    keys->parts= keys_parts;
+    keys->parts_length= length;
+    memcpy(keys_parts, parts, length * sizeof(*parts));
+    if (my_hash_insert(&row_keys, (uchar *)keys))
+      my_free(keys);
+  }
+  mysql_mutex_unlock(&LOCK_row_keys);
+}
+
+
+void
+rpl_parallel::clear_group_tables()
+{
+  for (uint i= 0; i < group_tables.elements; i++)
+  {
+    rpl_group_table *t= dynamic_element(&group_tables, i, rpl_group_table *);
+    delete t->def;
+    my_free(t->parts);
+  }
+  reset_dynamic(&group_tables);
+}
+
+
+void
+rpl_parallel::add_group_table(Relay_log_info *rli, Table_map_log_event *ev)
+{
+  rpl_group_table t;
+  rpl_row_keys *keys;
+  char name[2*NAME_LEN + 2], *end;
+  size_t dummy_len;
+  ulong nr2= 4;
+
+  /* Same table cache key as the worker will use to open the table. */
+  end= strmake(name, rli->mi->rpl_filter->get_rewrite_db(ev->get_db_name(),
+                                                         &dummy_len),
+               NAME_LEN) + 1;
+  end= strmake(end, ev->get_table_name(), NAME_LEN) + 1;
+
+  t.table_id= ev->get_table_id();
+  t.name_hash= 1;
+  my_charset_bin.coll->hash_sort(&my_charset_bin, (uchar *)name, end - name,
+                                 &t.name_hash, &nr2);
+  t.parts= NULL;
+  t.parts_length= 0;
+  if (!(t.def= ev->create_table_def()))
+    return;
+
+  mysql_mutex_lock(&LOCK_row_keys);
+  if ((keys= (rpl_row_keys *)my_hash_search(&row_keys, (uchar *)name,
+                                            end - name)) &&
+      keys->parts_length &&
+      (t.parts= (uint16 *)my_malloc(keys->parts_length * sizeof(*t.parts),
+                                    MYF(0))))
+  {
+    memcpy(t.parts, keys->parts, keys->parts_length * sizeof(*t.parts));
+    t.parts_length= keys->parts_length;
+  }
+  mysql_mutex_unlock(&LOCK_row_keys);
+
+  if (insert_dynamic(&group_tables, &t))
+  {
+    delete t.def;
+    my_free(t.parts);
+  }
+}
+
+
+/*
+  Record that the event group being queued changes the row with the given
+  key hash, and remember the last prior event group that changed it.
+*/
+static inline void
+add_row_owner(rpl_parallel_entry *e, ulong hash, uint64 *wait_sub_id)
+{
+  uint64 *owner= e->row_owners + hash % RPL_ROW_OWNER_SLOTS;
+  if (*owner > *wait_sub_id && *owner != e->current_sub_id)
+    *wait_sub_id= *owner;
+  *owner= e->current_sub_id;
+}
+
+
+/*
+  Handle one row image (before or after image) of a rows event for
+  row_dependency().
+
+  The row is identified by the values of each of its unique keys that has
+  no NULL columns in the image. If there is no such key (or the keys of the
+  table are not known yet), the whole row image is used instead.
+
+  Returns a pointer to the next row image, or NULL if the image could not be
+  parsed.
+*/
+const uchar *
+rpl_parallel::row_image_dependency(rpl_parallel_entry *e, rpl_group_table *t,
+                                   MY_BITMAP const *cols, uint width,
+                                   const uchar *row, const uchar *end,
+                                   uint64 *wait_sub_id)
+{
+  const uchar *null_ptr= row;
+  const uchar *pos= row + (bitmap_bits_set(cols) + 7) / 8;
+  uint null_mask= 1;
+  bool found_key= false;
+  ulong nr1, nr2;
+
+  if (pos > end)
+    return NULL;
+  for (uint i= 0; i < width; i++)
+  {
+    uint32 length;
+
+    /* Offset UINT_MAX32 marks a column that is NULL or not in the image. */
+    column_pos[2*i]= UINT_MAX32;
+    if (!bitmap_is_set(cols, i))
+      continue;
+    if (null_mask == 0x100)
+    {
+      null_ptr++;
+      null_mask= 1;
+    }
+    if (*null_ptr & null_mask)
+    {
+      null_mask<<= 1;
+      continue;
+    }
+    null_mask<<= 1;
+    if (i >= t->def->size())
+      return NULL;
+    length= t->def->calc_field_size(i, (uchar *)pos);
+    if (length > (size_t) (end - pos))
+      return NULL;
+    column_pos[2*i]= (uint32) (pos - row);
+    column_pos[2*i+1]= length;
+    pos+= length;
+  }
+
+  for (uint k= 0; k < t->parts_length; k+= 1 + t->parts[k])
+  {
+    const uint16 *part= t->parts + k + 1;
+    const uint16 *part_end= part + t->parts[k];
+
+    nr1= t->name_hash + k;
+    nr2= 4;
+    for (; part < part_end; part++)
+    {
+      if (*part >= width || column_pos[2 * *part] == UINT_MAX32)
+        break;
+      my_charset_bin.coll->hash_sort(&my_charset_bin,
+                                     row + column_pos[2 * *part],
+                                     column_pos[2 * *part + 1], &nr1, &nr2);
+    }
+    if (part < part_end)
+      continue;
+    add_row_owner(e, nr1, wait_sub_id);
+    found_key= true;
+  }
+
+  if (!found_key)
+  {
+    nr1= t->name_hash;
+    nr2= 4;
+    my_charset_bin.coll->hash_sort(&my_charset_bin, row, pos - row,
+                                   &nr1, &nr2);
+    add_row_owner(e, nr1, wait_sub_id);
+  }
+  return pos;
+}
+
+
+/*
+  Called by the SQL driver thread for every event of an event group in
+  --slave-parallel-mode=dependency.
+
+  For rows events, find the rows changed and return the sub_id of the last
+  prior event group that changed any of the same rows, or 0 if none. The
+  worker thread waits for that event group to commit before applying the
+  event, rather than running into its row locks and being retried.
+
+  This is a heuristic: the rows are identified by a hash, so there can be
+  false dependencies between unrelated rows, and conflicts not detected
+  here (for example on non-unique indexes) are still handled by the rollback
+  and retry of optimistic mode.
+*/
+uint64
+rpl_parallel::row_dependency(Relay_log_info *rli, rpl_parallel_entry *e,
+                             Log_event *ev, Log_event_type typ)
+{
+  Rows_log_event *rev;
+  rpl_group_table *t= NULL;
+  const uchar *row, *end;
+  uint width;
+  bool update;
+  uint64 wait_sub_id= 0;
+
+  switch (typ)
+  {
+  case GTID_EVENT:
+    clear_group_tables();
+    return 0;
+  case TABLE_MAP_EVENT:
+    add_group_table(rli, static_cast<Table_map_log_event *>(ev));
+    return 0;
+  case WRITE_ROWS_EVENT_V1:
+  case UPDATE_ROWS_EVENT_V1:
+  case DELETE_ROWS_EVENT_V1:
+  case WRITE_ROWS_EVENT:
+  case UPDATE_ROWS_EVENT:
+  case DELETE_ROWS_EVENT:
+    break;
+  default:
+    return 0;
+  }
+
+  rev= static_cast<Rows_log_event *>(ev);
+  for (uint i= group_tables.elements; i > 0; i--)
+  {
+    rpl_group_table *tmp=
+      dynamic_element(&group_tables, i - 1, rpl_group_table *);
+    if (tmp->table_id == rev->get_table_id())
+    {
+      t= tmp;
+      break;
+    }
+  }
+  if (!t)
+    return 0;
+
+  width= (uint) rev->get_width();
+  if (width > column_pos_size)
+  {
+    uint32 *tmp= (uint32 *)my_realloc(column_pos, 2 * width * sizeof(uint32),
+                                      MYF(MY_ALLOW_ZERO_PTR));
+    if (!tmp)
+      return 0;
+    column_pos= tmp;
+    column_pos_size= width;
+  }
+  if (!e->row_owners &&
+      !(e->row_owners= (uint64 *)my_malloc(RPL_ROW_OWNER_SLOTS *
+                                           sizeof(*e->row_owners),
+                                           MYF(MY_ZEROFILL))))
+    return 0;
+
+  update= rev->get_general_type_code() == UPDATE_ROWS_EVENT;
+  row= rev->get_rows_buf();
+  end= rev->get_rows_end();
+  while (row && row < end)
+  {
+    row= row_image_dependency(e, t, rev->get_cols(), width, row, end,
+                              &wait_sub_id);
+    if (row && update)
+      row= row_image_dependency(e, t, rev->get_cols_ai(), width, row, end,
+                                &wait_sub_id);
+  }
+  return wait_sub_id;
+}
+
+
 int
 rpl_parallel::do_event(rpl_group_info *serial_rgi, Log_event *ev,
                        ulonglong event_size)
@@ -2443,6 +2846,7 @@ rpl_parallel::do_event(rpl_group_info *serial_rgi, Log_event *ev,
   Relay_log_info *rli= serial_rgi->rli;
   enum Log_event_type typ;
   bool is_group_event;
+  uint64 wait_sub_id= 0;
   bool did_enter_cond= false;
   PSI_stage_info old_stage;
 
@@ -2599,6 +3003,9 @@ rpl_parallel::do_event(rpl_group_info *serial_rgi, Log_event *ev,
   else
     e= current;
 
+  if (rli->mi->parallel_mode == SLAVE_PARALLEL_DEPENDENCY)
+    wait_sub_id= row_dependency(rli, e, ev, typ);
+
   /*
     Find a worker thread to queue the event for.
     Prefer a new thread, so we maximise parallelism (at least for the group
@@ -2622,6 +3029,7 @@ rpl_parallel::do_event(rpl_group_info *serial_rgi, Log_event *ev,
     delete ev;
     return 1;
   }
+  qev->wait_sub_id= wait_sub_id;
 
   if (typ == GTID_EVENT)
   {
@@ -2700,7 +3108,7 @@ rpl_parallel::do_event(rpl_group_info *serial_rgi, Log_event *ev,
         if (!(gtid_flags & Gtid_log_event::FL_TRANSACTIONAL) ||
             ( (!(gtid_flags & Gtid_log_event::FL_ALLOW_PARALLEL) ||
                (gtid_flags & Gtid_log_event::FL_WAITED)) &&
-              (mode < SLAVE_PARALLEL_AGGRESSIVE)))
+              (mode != SLAVE_PARALLEL_AGGRESSIVE)))
         {
           /*
             This transaction should not be speculatively run in parallel with
@@ -132,6 +132,13 @@ struct rpl_parallel_thread {
     ulonglong event_relay_log_pos;
     my_off_t future_event_master_log_pos;
     size_t event_size;
+    /*
+      With --slave-parallel-mode=dependency, the sub_id of an earlier event
+      group that changed some of the rows of this (rows) event. The worker
+      waits for that event group to commit before applying the event.
+      Zero if there is nothing to wait for.
+    */
+    uint64 wait_sub_id;
   } *event_queue, *last_in_queue;
   uint64 queued_size;
   /* These free lists are protected by LOCK_rpl_thread. */
@@ -339,16 +346,73 @@ struct rpl_parallel_entry {
   uint64 count_committing_event_groups;
   /* The group_commit_orderer object for the events currently being queued. */
   group_commit_orderer *current_gco;
+  /*
+    With --slave-parallel-mode=dependency, for every hash value of a row key
+    (modulo RPL_ROW_OWNER_SLOTS), the sub_id of the last event group queued
+    that changed a row with that key. Allocated on first use; only accessed
+    by the SQL driver thread.
+  */
+  uint64 *row_owners;
 
   rpl_parallel_thread * choose_thread(rpl_group_info *rgi, bool *did_enter_cond,
                                       PSI_stage_info *old_stage, bool reuse);
   int queue_master_restart(rpl_group_info *rgi,
                            Format_description_log_event *fdev);
 };
+
+/* Number of entries in rpl_parallel_entry::row_owners. */
+#define RPL_ROW_OWNER_SLOTS 65536
+/* Max. number of elements in rpl_row_keys::parts. */
+#define RPL_ROW_KEY_MAX_PARTS 64
+
+/*
+  The unique keys of a table, as seen by the worker threads when they open
+  the table. Used by the SQL driver thread in --slave-parallel-mode=dependency
+  to find the columns in row events that identify a row.
+
+  The name is the table cache key "db\0table\0". For every unique key,
+  parts holds the number of key columns followed by the column numbers.
+*/
+struct rpl_row_keys {
+  uchar *name;
+  uint name_length;
+  uint parts_length;
+  uint16 *parts;
+};
+
+
+/*
+  A table mapped by a Table_map_log_event in the event group that the SQL
+  driver thread is currently queueing.
+*/
+struct rpl_group_table {
+  ulong table_id;
+  /* Hash of the table name, to keep keys of different tables apart. */
+  ulong name_hash;
+  table_def *def;
+  /* Copy of rpl_row_keys::parts, NULL if the keys are not known yet. */
+  uint16 *parts;
+  uint parts_length;
+};
+
+
 struct rpl_parallel {
   HASH domain_hash;
   rpl_parallel_entry *current;
   bool sql_thread_stopping;
+  /*
+    State for --slave-parallel-mode=dependency.
+
+    group_tables are the rpl_group_table of the event group being queued, and
+    column_pos is scratch space for the columns of a row; both are only used
+    by the SQL driver thread. row_keys holds rpl_row_keys, filled in by the
+    worker threads, and is protected by LOCK_row_keys.
+  */
+  DYNAMIC_ARRAY group_tables;
+  uint32 *column_pos;
+  uint column_pos_size;
+  HASH row_keys;
+  mysql_mutex_t LOCK_row_keys;
 
   rpl_parallel();
   ~rpl_parallel();
@@ -359,6 +423,15 @@ struct rpl_parallel {
   bool workers_idle();
   int wait_for_workers_idle(THD *thd);
   int do_event(rpl_group_info *serial_rgi, Log_event *ev, ulonglong event_size);
+  void record_row_keys(TABLE *table);
+  uint64 row_dependency(Relay_log_info *rli, rpl_parallel_entry *e,
+                        Log_event *ev, Log_event_type typ);
+  void clear_group_tables();
+  void add_group_table(Relay_log_info *rli, Table_map_log_event *ev);
+  const uchar *row_image_dependency(rpl_parallel_entry *e,
+                                    rpl_group_table *t, MY_BITMAP const *cols,
+                                    uint width, const uchar *row,
+                                    const uchar *end, uint64 *wait_sub_id);
 };
 
 
@@ -65,6 +65,7 @@ Relay_log_info::Relay_log_info(bool is_slave_recovery)
    gtid_skip_flag(GTID_SKIP_NOT), inited(0), abort_slave(0), stop_for_until(0),
    slave_running(MYSQL_SLAVE_NOT_RUN), until_condition(UNTIL_NONE),
    until_log_pos(0), retried_trans(0), executed_entries(0),
+   dependency_waits(0), worker_idle_time(0),
    m_flags(0)
 {
   DBUG_ENTER("Relay_log_info::Relay_log_info");
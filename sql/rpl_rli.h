@@ -324,6 +324,18 @@ class Relay_log_info : public Slave_reporting_capability
     Protected by slave_executed_entries_lock
   */
   int64 executed_entries;
+  /*
+    With --slave-parallel-mode=dependency, the number of times a worker had
+    to wait for an earlier transaction changing the same row to commit.
+    Updated with thread_safe_increment64().
+  */
+  int64 dependency_waits;
+  /*
+    Total time, in microseconds, that parallel replication workers spent
+    inside an event group waiting for the SQL driver thread to queue more
+    events. Updated with my_atomic_add64().
+  */
+  int64 worker_idle_time;
 
   /*
     If the end of the hot relay log is made of master's events ignored by the
@@ -2830,6 +2830,14 @@ void show_master_info_get_fields(THD *thd, List<Item> *field_list,
                           Item_empty_string(thd, "Gtid_Slave_Pos",
                                             gtid_pos_length),
                           mem_root);
+    field_list->push_back(new (mem_root)
+                          Item_return_int(thd, "Parallel_dependency_waits", 10,
+                                          MYSQL_TYPE_LONGLONG),
+                          mem_root);
+    field_list->push_back(new (mem_root)
+                          Item_float(thd, "Parallel_worker_idle_time", 0.0,
+                                     3, 10),
+                          mem_root);
   }
   DBUG_VOID_RETURN;
 }
@@ -3026,6 +3034,9 @@ static bool send_show_master_info_data(THD *thd, Master_info *mi, bool full,
       protocol->store((uint32)    mi->received_heartbeats);
       protocol->store((double)    mi->heartbeat_period, 3, &tmp);
       protocol->store(gtid_pos->ptr(), gtid_pos->length(), &my_charset_bin);
+      protocol->store((ulonglong) mi->rli.dependency_waits);
+      protocol->store((double)    mi->rli.worker_idle_time / 1000000.0, 3,
+                      &tmp);
     }
 
     mysql_mutex_unlock(&mi->rli.err_lock);
@@ -11277,6 +11277,8 @@ static bool send_server_handshake_packet(MPVIO_EXT *mpvio,
     thd->client_capabilities|= CLIENT_TRANSACTIONS;
 
   thd->client_capabilities|= CAN_CLIENT_COMPRESS;
+  if (!opt_net_compress_stream)
+    thd->client_capabilities&= ~CLIENT_COMPRESS_STREAM;
 
   if (ssl_acceptor_fd)
   {
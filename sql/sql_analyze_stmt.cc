@@ -67,6 +67,15 @@ void Filesort_tracker::print_json_members(Json_writer *writer)
     else
       writer->add_size(sort_buffer_size);
   }
+
+  if (sort_threads != 0)
+  {
+    writer->add_member("r_sort_threads");
+    if (sort_threads == uint(-1))
+      writer->add_str(varied_str);
+    else
+      writer->add_ll(sort_threads);
+  }
 }
 
 
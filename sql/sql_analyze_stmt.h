@@ -181,7 +181,7 @@ class Filesort_tracker : public Sql_alloc
     time_tracker(do_timing), r_limit(0), r_used_pq(0),
     r_examined_rows(0), r_sorted_rows(0), r_output_rows(0),
     sort_passes(0),
-    sort_buffer_size(0)
+    sort_buffer_size(0), sort_threads(0)
   {}
   
   /* Functions that filesort uses to report various things about its execution */
@@ -223,6 +223,14 @@ class Filesort_tracker : public Sql_alloc
     else
       sort_buffer_size= bufsize;
   }
+
+  inline void report_sort_threads(uint threads)
+  {
+    if (sort_threads && sort_threads != threads)
+      sort_threads= uint(-1); // different number of threads
+    else
+      sort_threads= threads;
+  }
   
   /* Functions to get the statistics */
   void print_json_members(Json_writer *writer);
@@ -282,6 +290,12 @@ class Filesort_tracker : public Sql_alloc
     other          - value
   */
   ulonglong sort_buffer_size;
+
+  /*
+    Number of worker threads of a parallel sort, with the same meaning of
+    0 and -1 as for sort_buffer_size
+  */
+  uint sort_threads;
 };
 
 
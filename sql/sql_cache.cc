@@ -337,6 +337,7 @@ TODO list:
 #include "sql_base.h"                           // TMP_TABLE_KEY_EXTRA
 #include "debug_sync.h"                         // DEBUG_SYNC
 #include "sql_table.h"
+#include "sql_expression_cache.h"               // mark_table_version_changed
 #ifdef HAVE_QUERY_CACHE
 #include <m_ctype.h>
 #include <my_dir.h>
@@ -946,6 +947,17 @@ inline void Query_cache_query::lock_reading()
 }
 
 
+/*
+  Used by the lock free lookup, which must never wait for a writer: the
+  writer may be waiting for the lookup to let go of the query.
+*/
+
+bool Query_cache_query::try_lock_reading()
+{
+  return mysql_rwlock_tryrdlock(&lock) == 0;
+}
+
+
 inline void Query_cache_query::unlock_writing()
 {
   RW_UNLOCK(&lock);
@@ -961,7 +973,7 @@ inline void Query_cache_query::unlock_reading()
 void Query_cache_query::init_n_lock()
 {
   DBUG_ENTER("Query_cache_query::init_n_lock");
-  res=0; wri = 0; len = 0; ready= 0;
+  res=0; wri = 0; len = 0; ready= 0; published= 0;
   mysql_rwlock_init(key_rwlock_query_cache_query_lock, &lock);
   lock_writing();
   DBUG_PRINT("qcache", ("inited & locked query for block 0x%lx",
@@ -1000,6 +1012,130 @@ uchar *query_cache_query_get_key(const uchar *record, size_t *length,
 }
 }
 
+/*****************************************************************************
+  Lock free lookup of cached results
+
+  Queries with complete results are published in a lock free hash, keyed
+  by a 64 bit digest of the query key, which is shared by all partitions.
+  A lookup pins the hash element, takes a reference on it, and then tries
+  to read lock the query block; the reference keeps the block where it is
+  until the read lock is taken. A writer that removes a query holds the
+  write lock on it and waits for all references to be dropped before the
+  element is deleted, see Query_cache::lf_unpublish().
+*****************************************************************************/
+
+struct Query_cache_lf_entry
+{
+  ulonglong digest;
+  /* partition the query is cached in */
+  Query_cache *partition;
+  Query_cache_block *block;
+  /* references taken by lookups, -1 when the element is being removed */
+  int32 refs;
+};
+
+static LF_HASH lf_queries;
+
+static ulonglong query_cache_key_digest(const uchar *key, size_t key_length)
+{
+  ulong nr1= 1, nr2= 4;
+  my_charset_bin.coll->hash_sort(&my_charset_bin, key, key_length,
+                                 &nr1, &nr2);
+  return ((ulonglong) nr1) ^ (((ulonglong) nr2) << 32);
+}
+
+/*****************************************************************************
+  Asynchronous invalidation
+
+  With query_cache_async_invalidation a statement that changes a table
+  only bumps the generation counter of the table. Queries registered
+  with an older generation of one of their tables are stale: they are
+  never sent, and the reclaim thread frees them in batches.
+*****************************************************************************/
+
+static int32 volatile table_generations[QUERY_CACHE_TABLE_GENERATIONS];
+/* set when tables were changed after the last pass of the reclaim thread */
+static int32 volatile reclaim_pending;
+static bool reclaim_thread_running, reclaim_thread_stop;
+static mysql_mutex_t LOCK_query_cache_reclaim;
+static mysql_cond_t COND_query_cache_reclaim;
+
+pthread_handler_t
+query_cache_reclaim_thread(void *arg __attribute__((unused)))
+{
+  THD *thd;
+  my_thread_init();
+  DBUG_ENTER("query_cache_reclaim_thread");
+
+  thd= new THD;
+  thd->system_thread= SYSTEM_THREAD_QUERY_CACHE_RECLAIM;
+  thd->thread_stack= (char*) &thd;           /* Set approximate stack start */
+  mysql_mutex_lock(&LOCK_thread_count);
+  thd->thread_id= thread_id++;
+  mysql_mutex_unlock(&LOCK_thread_count);
+  thd->store_globals();
+  thd->security_ctx->skip_grants();
+  thd->set_command(COM_DAEMON);
+
+  mysql_mutex_lock(&LOCK_query_cache_reclaim);
+  while (!reclaim_thread_stop)
+  {
+    if (!my_atomic_load32(&reclaim_pending))
+    {
+      mysql_cond_wait(&COND_query_cache_reclaim, &LOCK_query_cache_reclaim);
+      continue;
+    }
+    mysql_mutex_unlock(&LOCK_query_cache_reclaim);
+    /* Tables changed from now on are left to the next pass */
+    my_atomic_store32(&reclaim_pending, 0);
+    query_cache.reclaim_stale_queries(thd);
+    mysql_mutex_lock(&LOCK_query_cache_reclaim);
+  }
+  mysql_mutex_unlock(&LOCK_query_cache_reclaim);
+
+  delete thd;
+  DBUG_LEAVE; // Can't use DBUG_RETURN after my_thread_end
+  my_thread_end();
+
+  /* Signal Query_cache::destroy() that we are (almost) stopped */
+  mysql_mutex_lock(&LOCK_query_cache_reclaim);
+  reclaim_thread_running= false;
+  mysql_cond_broadcast(&COND_query_cache_reclaim);
+  mysql_mutex_unlock(&LOCK_query_cache_reclaim);
+  return 0;
+}
+
+
+/**
+  Wake up the reclaim thread, starting it on first use.
+*/
+
+static void query_cache_request_reclaim()
+{
+  int32 idle= 0;
+  if (!my_atomic_cas32(&reclaim_pending, &idle, 1))
+    return;                                     // Already requested
+
+  mysql_mutex_lock(&LOCK_query_cache_reclaim);
+  if (!reclaim_thread_running && !reclaim_thread_stop)
+  {
+    pthread_t th;
+    int error;
+    if ((error= mysql_thread_create(key_thread_query_cache_reclaim, &th,
+                                    &connection_attrib,
+                                    query_cache_reclaim_thread, NULL)))
+    {
+      sql_print_warning("Can't create query cache reclaim thread "
+                        "(errno= %d)", error);
+      my_atomic_store32(&reclaim_pending, 0);
+    }
+    else
+      reclaim_thread_running= true;
+  }
+  mysql_cond_broadcast(&COND_query_cache_reclaim);
+  mysql_mutex_unlock(&LOCK_query_cache_reclaim);
+}
+
 /*****************************************************************************
   Functions to store things into the query cache
 *****************************************************************************/
@@ -1069,6 +1205,14 @@ Query_cache::insert(THD *thd, Query_cache_tls *query_cache_tls,
 {
   DBUG_ENTER("Query_cache::insert");
 
+  if (partitions)
+  {
+    if (query_cache_tls->partition)
+      query_cache_tls->partition->insert(thd, query_cache_tls, packet,
+                                         length, pkt_nr);
+    DBUG_VOID_RETURN;
+  }
+
   /* First we check if query cache is disable without doing a mutex lock */
   if (is_disabled() || query_cache_tls->first_query_block == NULL)
     DBUG_VOID_RETURN;
@@ -1111,8 +1255,8 @@ Query_cache::insert(THD *thd, Query_cache_tls *query_cache_tls,
     header->result(result);
     DBUG_PRINT("qcache", ("free query 0x%lx", (ulong) query_block));
     // The following call will remove the lock on query_block
-    query_cache.free_query(query_block);
-    query_cache.refused++;
+    free_query(query_block);
+    refused++;
     // append_result_data no success => we need unlock
     unlock();
     DBUG_VOID_RETURN;
@@ -1132,6 +1276,13 @@ Query_cache::abort(THD *thd, Query_cache_tls *query_cache_tls)
 {
   DBUG_ENTER("query_cache_abort");
 
+  if (partitions)
+  {
+    if (query_cache_tls->partition)
+      query_cache_tls->partition->abort(thd, query_cache_tls);
+    DBUG_VOID_RETURN;
+  }
+
   /* See the comment on double-check locking usage above. */
   if (is_disabled() || query_cache_tls->first_query_block == NULL)
     DBUG_VOID_RETURN;
@@ -1172,6 +1323,12 @@ void Query_cache::end_of_result(THD *thd)
   if (query_cache_tls->first_query_block == NULL)
     DBUG_VOID_RETURN;
 
+  if (partitions)
+  {
+    query_cache_tls->partition->end_of_result(thd);
+    DBUG_VOID_RETURN;
+  }
+
   /* Ensure that only complete results are cached. */
   DBUG_ASSERT(thd->get_stmt_da()->is_eof());
 
@@ -1221,9 +1378,9 @@ void Query_cache::end_of_result(THD *thd)
     }
     last_result_block= header->result()->prev;
     allign_size= ALIGN_SIZE(last_result_block->used);
-    len= MY_MAX(query_cache.min_allocation_unit, allign_size);
-    if (last_result_block->length >= query_cache.min_allocation_unit + len)
-      query_cache.split_block(last_result_block,len);
+    len= MY_MAX(min_allocation_unit, allign_size);
+    if (last_result_block->length >= min_allocation_unit + len)
+      split_block(last_result_block,len);
 
     header->found_rows(limit_found_rows);
     header->set_results_ready(); // signal for plugin
@@ -1232,6 +1389,7 @@ void Query_cache::end_of_result(THD *thd)
     /* Drop the writer. */
     header->writer(0);
     query_cache_tls->first_query_block= NULL;
+    lf_publish(query_block);
     BLOCK_UNLOCK_WR(query_block);
     DBUG_EXECUTE("check_querycache", check_integrity(1););
   }
@@ -1255,6 +1413,8 @@ void mysql_query_cache_invalidate4(THD *thd,
                                    const char *key, unsigned key_length,
                                    int using_trx)
 {
+  if (thd)
+    mark_table_version_changed(thd, key, key_length);
   query_cache.invalidate(thd, key, (uint32) key_length, (my_bool) using_trx);
 }
 
@@ -1271,14 +1431,17 @@ Query_cache::Query_cache(ulong query_cache_limit_arg,
   :query_cache_size(0),
    query_cache_limit(query_cache_limit_arg),
    queries_in_cache(0), hits(0), inserts(0), refused(0),
-   total_blocks(0), lowmem_prunes(0),
+   total_blocks(0), lowmem_prunes(0), lock_free_hits(0),
    m_cache_status(OK),
+   partitions(0), partition_count(0),
+   lf_writer_pins(0), lf_readers(0), lf_readers_blocked(0),
    min_allocation_unit(ALIGN_SIZE(min_allocation_unit_arg)),
    min_result_data_size(ALIGN_SIZE(min_result_data_size_arg)),
    def_query_hash_size(ALIGN_SIZE(def_query_hash_size_arg)),
    def_table_hash_size(ALIGN_SIZE(def_table_hash_size_arg)),
    initialized(0)
 {
+  bzero(table_filter, sizeof(table_filter));
   ulong min_needed= (ALIGN_SIZE(sizeof(Query_cache_block)) +
 		     ALIGN_SIZE(sizeof(Query_cache_block_table)) +
 		     ALIGN_SIZE(sizeof(Query_cache_query)) + 3);
@@ -1296,6 +1459,20 @@ ulong Query_cache::resize(ulong query_cache_size_arg)
 			query_cache_size_arg));
   DBUG_ASSERT(initialized);
 
+  if (partitions)
+  {
+    ulong partition_size= query_cache_size_arg / partition_count;
+    new_query_cache_size= 0;
+    for (uint i= 0; i < partition_count; i++)
+      new_query_cache_size+= partitions[i].resize(partition_size);
+    query_cache_size= new_query_cache_size;
+    if (new_query_cache_size && global_system_variables.query_cache_type != 0)
+      m_cache_status= OK;
+    else
+      m_cache_status= DISABLED;
+    DBUG_RETURN(new_query_cache_size);
+  }
+
   lock_and_suspend();
 
   /*
@@ -1319,6 +1496,7 @@ ulong Query_cache::resize(ulong query_cache_size_arg)
         query->writer(0);
         refused++;
       }
+      lf_unpublish(block);
       query->unlock_n_destroy();
       block= block->next;
     } while (block != queries_blocks);
@@ -1349,12 +1527,61 @@ ulong Query_cache::resize(ulong query_cache_size_arg)
 ulong Query_cache::set_min_res_unit(ulong size)
 {
   DBUG_ASSERT(size % 8 == 0);
+  for (uint i= 0; partitions && i < partition_count; i++)
+    partitions[i].set_min_res_unit(size);
   if (size < min_allocation_unit)
     size= ALIGN_SIZE(min_allocation_unit);
   return (min_result_data_size= size);
 }
 
 
+/**
+  Choose the partition which caches the given statement.
+
+  The statement text and the current database are part of the key of
+  a cached query, so a statement is always looked up in the same
+  partition. With query_cache_strip_comments the same query may be
+  spread over several partitions if it comes with different comments.
+*/
+
+Query_cache *Query_cache::choose_partition(THD *thd, const char *query,
+                                           uint query_length)
+{
+  ulong nr1= 1, nr2= 4;
+  my_charset_bin.coll->hash_sort(&my_charset_bin, (const uchar*) query,
+                                 query_length, &nr1, &nr2);
+  if (thd->db)
+    my_charset_bin.coll->hash_sort(&my_charset_bin, (const uchar*) thd->db,
+                                   thd->db_length, &nr1, &nr2);
+  return partitions + nr1 % partition_count;
+}
+
+
+/**
+  Bit of a table key in the table filter of a partition.
+*/
+
+uint Query_cache::table_filter_bit(const uchar *key, uint32 key_length)
+{
+  ulong nr1= 1, nr2= 4;
+  my_charset_bin.coll->hash_sort(&my_charset_bin, key, key_length,
+                                 &nr1, &nr2);
+  return (uint) (nr1 % QUERY_CACHE_TABLE_FILTER_BITS);
+}
+
+
+void Query_cache::reset_statistics()
+{
+  for (uint i= 0; i < get_partition_count(); i++)
+  {
+    Query_cache *partition= get_partition(i);
+    partition->hits= partition->inserts= partition->refused=
+      partition->lowmem_prunes= 0;
+    partition->lock_free_hits= 0;
+  }
+}
+
+
 void Query_cache::store_query(THD *thd, TABLE_LIST *tables_used)
 {
   TABLE_COUNTER_TYPE local_tables;
@@ -1376,6 +1603,13 @@ void Query_cache::store_query(THD *thd, TABLE_LIST *tables_used)
     DBUG_PRINT("qcache", ("Query cache not ready"));
     DBUG_VOID_RETURN;
   }
+  if (partitions)
+  {
+    /* Store in the partition send_result_to_client() looked into */
+    if (thd->query_cache_tls.partition)
+      thd->query_cache_tls.partition->store_query(thd, tables_used);
+    DBUG_VOID_RETURN;
+  }
   if (thd->lex->sql_command != SQLCOM_SELECT)
   {
     DBUG_PRINT("qcache", ("Ignoring not SELECT command"));
@@ -1510,6 +1744,13 @@ def_week_frmt: %lu, in_trans: %d, autocommit: %d",
     Query_cache_block *competitor = (Query_cache_block *)
       my_hash_search(&queries, (uchar*) query, tot_length);
     DBUG_PRINT("qcache", ("competitor 0x%lx", (ulong) competitor));
+    if (competitor && is_stale(competitor))
+    {
+      /* Not reclaimed yet, replace it */
+      BLOCK_LOCK_WR(competitor);
+      free_query(competitor);
+      competitor= 0;
+    }
     if (competitor == 0)
     {
       /* Query is not in cache and no one is working with it; Store it */
@@ -1689,9 +1930,6 @@ Query_cache::send_result_to_client(THD *thd, char *org_sql, uint query_length)
 {
   ulonglong engine_data;
   Query_cache_query *query;
-#ifndef EMBEDDED_LIBRARY
-  Query_cache_block *first_result_block;
-#endif
   Query_cache_block *result_block;
   Query_cache_block_table *block_table, *block_table_end;
   ulong tot_length;
@@ -1710,6 +1948,14 @@ Query_cache::send_result_to_client(THD *thd, char *org_sql, uint query_length)
       thd->variables.query_cache_type == 0)
     goto err;
 
+  if (partitions)
+  {
+    Query_cache *partition= choose_partition(thd, org_sql, query_length);
+    thd->query_cache_tls.partition= partition;
+    DBUG_RETURN(partition->send_result_to_client(thd, org_sql,
+                                                 query_length));
+  }
+
   /*
     The following can only happen for prepared statements that was found
     during parsing or later that the query was not cacheable.
@@ -1835,22 +2081,6 @@ Query_cache::send_result_to_client(THD *thd, char *org_sql, uint query_length)
       goto err;
     }
   }
-  /*
-    Try to obtain an exclusive lock on the query cache. If the cache is
-    disabled or if a full cache flush is in progress, the attempt to
-    get the lock is aborted.
-
-    The TIMEOUT parameter indicate that the lock is allowed to timeout.
-  */
-  if (try_lock(thd, Query_cache::TIMEOUT))
-    goto err;
-
-  if (query_cache_size == 0)
-  {
-    thd->query_cache_is_applicable= 0;            // Query can't be cached
-    goto err_unlock;
-  }
-
   Query_cache_block *query_block;
   if (thd->variables.query_cache_strip_comments)
   {
@@ -1935,6 +2165,32 @@ def_week_frmt: %lu, in_trans: %d, autocommit: %d",
   memcpy((uchar *)(sql + (tot_length - QUERY_CACHE_FLAGS_SIZE)),
 	 (uchar*) &flags, QUERY_CACHE_FLAGS_SIZE);
 
+  /*
+    Most hits are served without structure_guard_mutex. Everything that
+    the lock free lookup can not decide is left to the locked one below.
+  */
+#ifdef WITH_WSREP
+  if (!(WSREP_CLIENT(thd) && wsrep_must_sync_wait(thd)))
+#endif /* WITH_WSREP */
+  if (send_result_lock_free(thd, sql, tot_length))
+    DBUG_RETURN(1);				// Result sent to client
+
+  /*
+    Try to obtain an exclusive lock on the query cache. If the cache is
+    disabled or if a full cache flush is in progress, the attempt to
+    get the lock is aborted.
+
+    The TIMEOUT parameter indicate that the lock is allowed to timeout.
+  */
+  if (try_lock(thd, Query_cache::TIMEOUT))
+    goto err;
+
+  if (query_cache_size == 0)
+  {
+    thd->query_cache_is_applicable= 0;            // Query can't be cached
+    goto err_unlock;
+  }
+
 #ifdef WITH_WSREP
   bool once_more;
   once_more= true;
@@ -1971,9 +2227,6 @@ def_week_frmt: %lu, in_trans: %d, autocommit: %d",
 
   query = query_block->query();
   result_block= query->result();
-#ifndef EMBEDDED_LIBRARY
-  first_result_block= result_block;
-#endif
 
   if (result_block == 0 || result_block->type != Query_cache_block::RESULT)
   {
@@ -2003,6 +2256,13 @@ def_week_frmt: %lu, in_trans: %d, autocommit: %d",
     TABLE *tmptable;
     Query_cache_table *table = block_table->parent;
 
+    if (block_table->generation != table->generation())
+    {
+      DBUG_PRINT("qcache", ("Table changed after the query was cached"));
+      BLOCK_UNLOCK_RD(query_block);
+      goto err_unlock;
+    }
+
     /*
       Check that we have not temporary tables with same names of tables
       of this query. If we have such tables, we will not send data from
@@ -2116,6 +2376,38 @@ def_week_frmt: %lu, in_trans: %d, autocommit: %d",
   hits++;
   unlock();
 
+  send_cached_result(thd, query_block);
+  DBUG_RETURN(1);				// Result sent to client
+
+err_unlock:
+  unlock();
+  MYSQL_QUERY_CACHE_MISS(thd->query());
+  /*
+    query_plan_flags doesn't have to be changed here as it contains
+    QPLAN_QC_NO by default
+  */
+  DBUG_RETURN(0);				// Query was not cached
+
+err:
+  thd->query_cache_is_applicable= 0;            // Query can't be cached
+  DBUG_RETURN(0);				// Query was not cached
+}
+
+
+/**
+  Send the result of a query which is read locked by the caller to the
+  client and release the lock.
+*/
+
+void Query_cache::send_cached_result(THD *thd, Query_cache_block *query_block)
+{
+  Query_cache_query *query= query_block->query();
+  Query_cache_block *result_block= query->result();
+#ifndef EMBEDDED_LIBRARY
+  Query_cache_block *first_result_block= result_block;
+#endif
+  DBUG_ENTER("Query_cache::send_cached_result");
+
   /*
     Send cached result to client
   */
@@ -2165,20 +2457,152 @@ def_week_frmt: %lu, in_trans: %d, autocommit: %d",
 
   BLOCK_UNLOCK_RD(query_block);
   MYSQL_QUERY_CACHE_HIT(thd->query(), (ulong) thd->limit_found_rows);
-  DBUG_RETURN(1);				// Result sent to client
+  DBUG_VOID_RETURN;
+}
+
+
+/**
+  Look the query up in the lock free hash and send the result to the
+  client if it can be used as is.
+
+  @param thd         thread handler
+  @param key         query key (query, database and flags)
+  @param key_length  length of the key
+
+  @note A hit found this way does not move the query to the end of the
+  list of queries, so it is pruned in the order it was last found under
+  structure_guard_mutex.
+
+  @retval 1  the result was sent
+  @retval 0  the query must be looked up under structure_guard_mutex
+*/
+
+int Query_cache::send_result_lock_free(THD *thd, const char *key,
+                                       ulong key_length)
+{
+  Query_cache_tls *query_cache_tls= &thd->query_cache_tls;
+  Query_cache_lf_entry *entry;
+  Query_cache_block *query_block= 0;
+  Query_cache_query *query;
+  Query_cache_block_table *block_table, *block_table_end;
+  ulonglong digest;
+  uchar *block_key;
+  size_t block_key_length;
+  DBUG_ENTER("Query_cache::send_result_lock_free");
+
+  if (!query_cache_tls->lf_pins &&
+      !(query_cache_tls->lf_pins= lf_hash_get_pins(&lf_queries)))
+    DBUG_RETURN(0);
+
+  my_atomic_add32(&lf_readers, 1);
+  if (my_atomic_load32(&lf_readers_blocked))
+    goto err;
+
+  digest= query_cache_key_digest((const uchar*) key, key_length);
+  entry= (Query_cache_lf_entry *) lf_hash_search(&lf_queries,
+                                                 query_cache_tls->lf_pins,
+                                                 &digest, sizeof(digest));
+  if (entry && entry->partition == this)
+  {
+    int32 refs= my_atomic_load32(&entry->refs);
+    while (refs >= 0 && !my_atomic_cas32(&entry->refs, &refs, refs + 1))
+    {}
+    if (refs >= 0)
+    {
+      query_block= entry->block;
+      if (!query_block->query()->try_lock_reading())
+        query_block= 0;                         // Being removed
+      my_atomic_add32(&entry->refs, -1);
+    }
+  }
+  lf_hash_search_unpin(query_cache_tls->lf_pins);
+  if (!query_block)
+    goto err;
+
+  /* Different queries may have the same digest */
+  block_key= query_cache_query_get_key((uchar*) query_block,
+                                       &block_key_length, 0);
+  if (block_key_length != key_length ||
+      memcmp(block_key, key, key_length))
+    goto err_unlock;
+
+  query= query_block->query();
+  if (thd->in_multi_stmt_transaction_mode() &&
+      (query->tables_type() & HA_CACHE_TBL_TRANSACT))
+    goto err_unlock;
 
-err_unlock:
-  unlock();
-  MYSQL_QUERY_CACHE_MISS(thd->query());
   /*
-    query_plan_flags doesn't have to be changed here as it contains
-    QPLAN_QC_NO by default
+    Same checks as in send_result_to_client(); the tables can not be
+    moved by pack_cache() as long as we are counted in lf_readers.
   */
-  DBUG_RETURN(0);				// Query was not cached
+  THD_STAGE_INFO(thd, stage_checking_privileges_on_cached_query);
+  block_table= query_block->table(0);
+  block_table_end= block_table+query_block->n_tables;
+  for (; block_table != block_table_end; block_table++)
+  {
+    TABLE_LIST table_list;
+    TABLE *tmptable;
+    Query_cache_table *table = block_table->parent;
+
+    if (block_table->generation != table->generation())
+      goto err_unlock;
+    for (tmptable= thd->temporary_tables; tmptable ; tmptable= tmptable->next)
+    {
+      if (tmptable->s->table_cache_key.length - TMP_TABLE_KEY_EXTRA ==
+          table->key_length() &&
+          !memcmp(tmptable->s->table_cache_key.str, table->data(),
+                  table->key_length()))
+        goto err_unlock;
+    }
 
+    bzero((char*) &table_list,sizeof(table_list));
+    table_list.db = table->db();
+    table_list.alias= table_list.table_name= table->table();
+#ifndef NO_EMBEDDED_ACCESS_CHECKS
+    if (check_table_access(thd,SELECT_ACL,&table_list, FALSE, 1,TRUE) ||
+        table_list.grant.want_privilege)
+      goto err_unlock;
+#endif /*!NO_EMBEDDED_ACCESS_CHECKS*/
+    if (table->callback())
+    {
+      char qcache_se_key_name[FN_REFLEN + 10];
+      uint qcache_se_key_len, db_length= strlen(table->db());
+      ulonglong engine_data= table->engine_data();
+
+      qcache_se_key_len= build_normalized_name(qcache_se_key_name,
+                                               sizeof(qcache_se_key_name),
+                                               table->db(),
+                                               db_length,
+                                               table->table(),
+                                               table->key_length() -
+                                               db_length - 2 -
+                                               table->suffix_length(),
+                                               table->suffix_length());
+
+      if (!(*table->callback())(thd, qcache_se_key_name,
+                                qcache_se_key_len, &engine_data))
+      {
+        /*
+          Invalidation needs structure_guard_mutex, the locked lookup
+          asks the handler again and does it.
+        */
+        DBUG_ASSERT(! thd->transaction_rollback_request);
+        trans_rollback_stmt(thd);
+        goto err_unlock;
+      }
+    }
+  }
+  my_atomic_add32(&lf_readers, -1);
+  thread_safe_increment64(&lock_free_hits);
+
+  send_cached_result(thd, query_block);
+  DBUG_RETURN(1);
+
+err_unlock:
+  BLOCK_UNLOCK_RD(query_block);
 err:
-  thd->query_cache_is_applicable= 0;            // Query can't be cached
-  DBUG_RETURN(0);				// Query was not cached
+  my_atomic_add32(&lf_readers, -1);
+  DBUG_RETURN(0);
 }
 
 
@@ -2313,6 +2737,13 @@ void Query_cache::invalidate(THD *thd, char *db)
   if (is_disabled())
     DBUG_VOID_RETURN;
 
+  if (partitions)
+  {
+    for (uint i= 0; i < partition_count; i++)
+      partitions[i].invalidate(thd, db);
+    DBUG_VOID_RETURN;
+  }
+
   DBUG_ASSERT(ok_for_lower_case_names(db));
 
   bool restart= FALSE;
@@ -2404,6 +2835,13 @@ void Query_cache::flush()
   if (is_disabled())
     DBUG_VOID_RETURN;
 
+  if (partitions)
+  {
+    for (uint i= 0; i < partition_count; i++)
+      partitions[i].flush();
+    DBUG_VOID_RETURN;
+  }
+
   QC_DEBUG_SYNC("wait_in_query_cache_flush1");
 
   lock_and_suspend();
@@ -2414,7 +2852,7 @@ void Query_cache::flush()
     DUMP(this);
   }
 
-  DBUG_EXECUTE("check_querycache",query_cache.check_integrity(1););
+  DBUG_EXECUTE("check_querycache",check_integrity(1););
   unlock();
   DBUG_VOID_RETURN;
 }
@@ -2437,6 +2875,13 @@ void Query_cache::pack(THD *thd, ulong join_limit, uint iteration_limit)
   if (is_disabled())
     DBUG_VOID_RETURN;
 
+  if (partitions)
+  {
+    for (uint i= 0; i < partition_count; i++)
+      partitions[i].pack(thd, join_limit, iteration_limit);
+    DBUG_VOID_RETURN;
+  }
+
   /*
     If the entire qc is being invalidated we can bail out early
     instead of waiting for the lock.
@@ -2470,22 +2915,64 @@ void Query_cache::destroy()
   }
   else
   {
-    /* Underlying code expects the lock. */
-    lock_and_suspend();
-    free_cache();
-    unlock();
-
-    mysql_cond_destroy(&COND_cache_status_changed);
-    mysql_mutex_destroy(&structure_guard_mutex);
-    initialized = 0;
-    DBUG_ASSERT(m_requests_in_progress == 0);
+    /* Stop the reclaim thread, which works on all partitions */
+    mysql_mutex_lock(&LOCK_query_cache_reclaim);
+    reclaim_thread_stop= true;
+    mysql_cond_broadcast(&COND_query_cache_reclaim);
+    while (reclaim_thread_running)
+      mysql_cond_wait(&COND_query_cache_reclaim, &LOCK_query_cache_reclaim);
+    mysql_mutex_unlock(&LOCK_query_cache_reclaim);
+    mysql_cond_destroy(&COND_query_cache_reclaim);
+    mysql_mutex_destroy(&LOCK_query_cache_reclaim);
+
+    if (partitions)
+    {
+      for (uint i= 0; i < partition_count; i++)
+        partitions[i].destroy_partition();
+      delete [] partitions;
+      partitions= 0;
+      partition_count= 0;
+    }
+    destroy_partition();
+    lf_hash_destroy(&lf_queries);
   }
   DBUG_VOID_RETURN;
 }
 
 
+void Query_cache::destroy_partition()
+{
+  DBUG_ENTER("Query_cache::destroy_partition");
+  /* Underlying code expects the lock. */
+  lock_and_suspend();
+  free_cache();
+  unlock();
+
+  if (lf_writer_pins)
+    lf_hash_put_pins(lf_writer_pins);
+  lf_writer_pins= 0;
+  mysql_cond_destroy(&COND_cache_status_changed);
+  mysql_mutex_destroy(&structure_guard_mutex);
+  initialized = 0;
+  DBUG_ASSERT(m_requests_in_progress == 0);
+  DBUG_VOID_RETURN;
+}
+
+
 void Query_cache::disable_query_cache(THD *thd)
 {
+  if (partitions)
+  {
+    /*
+      Nothing is cached in this object itself, so it can be disabled at
+      once; the partitions get disabled when their last request is done.
+    */
+    for (uint i= 0; i < partition_count; i++)
+      partitions[i].disable_query_cache(thd);
+    m_cache_status= DISABLED;
+    return;
+  }
+
   m_cache_status= DISABLE_REQUEST;
   /*
     If there is no requests in progress try to free buffer.
@@ -2501,17 +2988,18 @@ void Query_cache::disable_query_cache(THD *thd)
   init/destroy
 *****************************************************************************/
 
-void Query_cache::init()
+void Query_cache::init(uint partition_count_arg)
 {
   DBUG_ENTER("Query_cache::init");
-  mysql_mutex_init(key_structure_guard_mutex,
-                   &structure_guard_mutex, MY_MUTEX_INIT_FAST);
-  mysql_cond_init(key_COND_cache_status_changed,
-                  &COND_cache_status_changed, NULL);
-  m_cache_lock_status= Query_cache::UNLOCKED;
-  m_cache_status= Query_cache::OK;
-  m_requests_in_progress= 0;
-  initialized = 1;
+  lf_hash_init(&lf_queries, sizeof(Query_cache_lf_entry), LF_HASH_UNIQUE,
+               offsetof(Query_cache_lf_entry, digest), sizeof(ulonglong),
+               0, &my_charset_bin);
+  mysql_mutex_init(key_LOCK_query_cache_reclaim,
+                   &LOCK_query_cache_reclaim, MY_MUTEX_INIT_FAST);
+  mysql_cond_init(key_COND_query_cache_reclaim,
+                  &COND_query_cache_reclaim, NULL);
+  reclaim_thread_stop= false;
+  init_partition();
   /*
     Using state_map from latin1 should be fine in all cases:
     1. We do not support UCS2, UTF16, UTF32 as a client character set.
@@ -2534,6 +3022,23 @@ void Query_cache::init()
     (i.e. not inside a string literal or comment).
   */
   query_state_map= my_charset_latin1.state_map;
+
+  if (partition_count_arg > 1)
+  {
+    if ((partitions= new Query_cache[partition_count_arg]))
+    {
+      partition_count= partition_count_arg;
+      for (uint i= 0; i < partition_count; i++)
+      {
+        partitions[i].init_partition();
+        partitions[i].result_size_limit(query_cache_limit);
+        partitions[i].set_min_res_unit(min_result_data_size);
+      }
+    }
+    else
+      sql_print_warning("Could not allocate %u query cache partitions, "
+                        "using one", partition_count_arg);
+  }
   /*
     If we explicitly turn off query cache from the command line query
     cache will be disabled for the reminder of the server life
@@ -2549,6 +3054,23 @@ void Query_cache::init()
 }
 
 
+void Query_cache::init_partition()
+{
+  DBUG_ENTER("Query_cache::init_partition");
+  mysql_mutex_init(key_structure_guard_mutex,
+                   &structure_guard_mutex, MY_MUTEX_INIT_FAST);
+  mysql_cond_init(key_COND_cache_status_changed,
+                  &COND_cache_status_changed, NULL);
+  m_cache_lock_status= Query_cache::UNLOCKED;
+  m_cache_status= Query_cache::OK;
+  m_requests_in_progress= 0;
+  /* Without pins the queries of this partition are never published */
+  lf_writer_pins= lf_hash_get_pins(&lf_queries);
+  initialized = 1;
+  DBUG_VOID_RETURN;
+}
+
+
 ulong Query_cache::init_cache()
 {
   uint mem_bin_count, num, step;
@@ -2740,6 +3262,7 @@ void Query_cache::make_disabled()
   first_block= 0;
   total_blocks= 0;
   tables_blocks= 0;
+  bzero(table_filter, sizeof(table_filter));
   DBUG_VOID_RETURN;
 }
 
@@ -2757,6 +3280,7 @@ void Query_cache::free_cache()
 {
   DBUG_ENTER("Query_cache::free_cache");
 
+  lf_suspend_readers();
   /* Destroy locks */
   Query_cache_block *block= queries_blocks;
   if (block)
@@ -2764,6 +3288,7 @@ void Query_cache::free_cache()
     do
     {
       Query_cache_query *query= block->query();
+      lf_unpublish(block);
       mysql_rwlock_destroy(&query->lock);
       block= block->next;
     } while (block != queries_blocks);
@@ -2773,6 +3298,7 @@ void Query_cache::free_cache()
   make_disabled();
   my_hash_free(&queries);
   my_hash_free(&tables);
+  lf_resume_readers();
   DBUG_VOID_RETURN;
 }
 
@@ -2879,6 +3405,7 @@ void Query_cache::free_query_internal(Query_cache_block *query_block)
 
   Query_cache_query *query= query_block->query();
 
+  lf_unpublish(query_block);
   if (query->writer() != 0)
   {
     /* Tell MySQL that this query should not be cached anymore */
@@ -2926,6 +3453,96 @@ void Query_cache::free_query_internal(Query_cache_block *query_block)
 }
 
 
+/**
+  Make a query with complete results visible to the lock free lookup.
+
+  @note The query block must be write locked.
+*/
+
+void Query_cache::lf_publish(Query_cache_block *query_block)
+{
+  Query_cache_query *query= query_block->query();
+  Query_cache_lf_entry entry;
+  uchar *key;
+  size_t key_length;
+  DBUG_ENTER("Query_cache::lf_publish");
+
+  if (!lf_writer_pins)
+    DBUG_VOID_RETURN;
+
+  key= query_cache_query_get_key((uchar*) query_block, &key_length, 0);
+  entry.digest= query->digest= query_cache_key_digest(key, key_length);
+  entry.partition= this;
+  entry.block= query_block;
+  entry.refs= 0;
+  /* On a digest collision the query is only found under the mutex */
+  if (!lf_hash_insert(&lf_queries, lf_writer_pins, &entry))
+    query->published= 1;
+  DBUG_VOID_RETURN;
+}
+
+
+/**
+  Remove a query from the lock free lookup.
+
+  Lookups which got a reference to the query before it was write locked
+  fail to read lock it and drop the reference, so waiting for them is
+  short.
+
+  @note The query block must be write locked, or lock free readers
+  suspended.
+*/
+
+void Query_cache::lf_unpublish(Query_cache_block *query_block)
+{
+  Query_cache_query *query= query_block->query();
+  Query_cache_lf_entry *entry;
+  DBUG_ENTER("Query_cache::lf_unpublish");
+
+  if (!query->published)
+    DBUG_VOID_RETURN;
+
+  entry= (Query_cache_lf_entry *) lf_hash_search(&lf_queries, lf_writer_pins,
+                                                 &query->digest,
+                                                 sizeof(ulonglong));
+  DBUG_ASSERT(entry && entry->block == query_block);
+  if (entry)
+  {
+    int32 unused= 0;
+    while (!my_atomic_cas32(&entry->refs, &unused, -1))
+    {
+      unused= 0;
+      pthread_yield();
+    }
+  }
+  lf_hash_search_unpin(lf_writer_pins);
+  if (entry)
+    lf_hash_delete(&lf_queries, lf_writer_pins, &query->digest,
+                   sizeof(ulonglong));
+  query->published= 0;
+  DBUG_VOID_RETURN;
+}
+
+
+/**
+  Wait for the lock free lookups of this partition to finish and keep
+  new ones from starting, until lf_resume_readers() is called.
+*/
+
+void Query_cache::lf_suspend_readers()
+{
+  my_atomic_add32(&lf_readers_blocked, 1);
+  while (my_atomic_load32(&lf_readers))
+    pthread_yield();
+}
+
+
+void Query_cache::lf_resume_readers()
+{
+  my_atomic_add32(&lf_readers_blocked, -1);
+}
+
+
 /*
   free_query() - free query from query cache.
 
@@ -2951,6 +3568,102 @@ void Query_cache::free_query(Query_cache_block *query_block)
   DBUG_VOID_RETURN;
 }
 
+
+/**
+  Generation counter of the table with the given key.
+*/
+
+int32 volatile *Query_cache::table_generation(const uchar *key,
+                                              uint32 key_length)
+{
+  ulong nr1= 1, nr2= 4;
+  my_charset_bin.coll->hash_sort(&my_charset_bin, key, key_length,
+                                 &nr1, &nr2);
+  return table_generations + nr1 % QUERY_CACHE_TABLE_GENERATIONS;
+}
+
+
+/**
+  Check if a table of the query was changed after the query was
+  registered.
+*/
+
+my_bool Query_cache::is_stale(Query_cache_block *query_block)
+{
+  Query_cache_block_table *block_table= query_block->table(0);
+  Query_cache_block_table *block_table_end=
+    block_table + query_block->n_tables;
+  for (; block_table != block_table_end; block_table++)
+  {
+    if (block_table->generation != block_table->parent->generation())
+      return TRUE;
+  }
+  return FALSE;
+}
+
+
+/**
+  Free all stale queries, see query_cache_async_invalidation.
+
+  The tables are checked first, so that the list of queries is only
+  walked if some table was changed since the last call.
+*/
+
+void Query_cache::reclaim_stale_queries(THD *thd)
+{
+  bool changed= FALSE;
+  DBUG_ENTER("Query_cache::reclaim_stale_queries");
+
+  if (is_disabled())
+    DBUG_VOID_RETURN;
+
+  if (partitions)
+  {
+    for (uint i= 0; i < partition_count; i++)
+      partitions[i].reclaim_stale_queries(thd);
+    DBUG_VOID_RETURN;
+  }
+
+  if (try_lock(thd, Query_cache::WAIT))
+    DBUG_VOID_RETURN;
+
+  if (query_cache_size > 0 && tables_blocks)
+  {
+    Query_cache_block *table_block= tables_blocks;
+    do
+    {
+      Query_cache_table *table= table_block->table();
+      int32 generation= table->generation();
+      if (table->reclaimed_gen != generation)
+      {
+        table->reclaimed_gen= generation;
+        changed= TRUE;
+      }
+      table_block= table_block->next;
+    } while (table_block != tables_blocks);
+  }
+
+  if (changed)
+  {
+    /* Freeing a query does not touch the other queries in the list */
+    Query_cache_block *query_block= queries_blocks;
+    for (ulong count= queries_in_cache; count; count--)
+    {
+      Query_cache_block *next= query_block->next;
+      if (is_stale(query_block))
+      {
+        BLOCK_LOCK_WR(query_block);
+        free_query(query_block);
+      }
+      query_block= next;
+    }
+    DBUG_EXECUTE("check_querycache", check_integrity(1););
+  }
+
+  unlock();
+  DBUG_VOID_RETURN;
+}
+
 /*****************************************************************************
  Query data creation
 *****************************************************************************/
@@ -3240,6 +3953,26 @@ void Query_cache::invalidate_table(THD *thd, TABLE *table)
 
 void Query_cache::invalidate_table(THD *thd, uchar * key, uint32  key_length)
 {
+  if (opt_query_cache_async_invalidation)
+  {
+    /* Leave freeing the queries of the table to the reclaim thread */
+    my_atomic_add32(table_generation(key, key_length), 1);
+    query_cache_request_reclaim();
+    return;
+  }
+
+  if (partitions)
+  {
+    /* Only visit the partitions that may have the table registered */
+    uint bit= table_filter_bit(key, key_length);
+    for (uint i= 0; i < partition_count; i++)
+    {
+      if (partitions[i].table_filter_is_set(bit))
+        partitions[i].invalidate_table(thd, key, key_length);
+    }
+    return;
+  }
+
   DEBUG_SYNC(thd, "wait_in_query_cache_invalidate1");
 
   /*
@@ -3505,6 +4238,11 @@ Query_cache::insert_table(THD *thd, uint key_len, const char *key,
       free_memory_block(table_block);
       DBUG_RETURN(0);
     }
+    if (hash)
+    {
+      uint bit= table_filter_bit((const uchar*) key, key_len);
+      table_filter[bit / 8]|= (uchar) (1 << (bit % 8));
+    }
     char *db= header->db();
     header->table(db + db_length + 1);
     header->key_length(key_len);
@@ -3513,6 +4251,8 @@ Query_cache::insert_table(THD *thd, uint key_len, const char *key,
     header->callback(callback);
     header->engine_data(engine_data);
     header->set_hashed(hash);
+    header->gen= table_generation((const uchar*) key, key_len);
+    header->reclaimed_gen= header->generation();
 
     /*
       We insert this table without the assumption that it isn't refrenenced by
@@ -3532,6 +4272,7 @@ Query_cache::insert_table(THD *thd, uint key_len, const char *key,
   node->next->prev= node;
   node->prev= list_root;
   node->parent= table_block->table();
+  node->generation= node->parent->generation();
   /*
     Increase the counter to keep track on how long this chain
     of queries is.
@@ -3570,6 +4311,9 @@ void Query_cache::unlink_table(Query_cache_block_table *node)
     if (header->is_hashed())
       my_hash_delete(&tables,(uchar *) table_block);
     free_memory_block(table_block);
+    /* No tables are left; all of them can be forgotten by the filter */
+    if (!tables_blocks)
+      bzero(table_filter, sizeof(table_filter));
   }
   DBUG_VOID_RETURN;
 }
@@ -4180,7 +4924,7 @@ void Query_cache::pack_cache()
 {
   DBUG_ENTER("Query_cache::pack_cache");
 
-  DBUG_EXECUTE("check_querycache",query_cache.check_integrity(1););
+  DBUG_EXECUTE("check_querycache",check_integrity(1););
 
   uchar *border = 0;
   Query_cache_block *before = 0;
@@ -4191,6 +4935,8 @@ void Query_cache::pack_cache()
 
   if (first_block)
   {
+    /* Blocks are moved, which lock free lookups can not cope with */
+    lf_suspend_readers();
     do
     {
       Query_cache_block *next=block->pnext;
@@ -4209,10 +4955,11 @@ void Query_cache::pack_cache()
       new_block->pnext->pprev = new_block;
       insert_into_free_memory_list(new_block);
     }
+    lf_resume_readers();
     DUMP(this);
   }
 
-  DBUG_EXECUTE("check_querycache",query_cache.check_integrity(1););
+  DBUG_EXECUTE("check_querycache",check_integrity(1););
   DBUG_VOID_RETURN;
 }
 
@@ -4392,6 +5139,15 @@ my_bool Query_cache::move_by_type(uchar **border,
     }
     /* Fix hash to point at moved block */
     my_hash_replace(&queries, &record_idx, (uchar*) new_block);
+    if (new_query->published)
+    {
+      Query_cache_lf_entry *entry= (Query_cache_lf_entry *)
+        lf_hash_search(&lf_queries, lf_writer_pins,
+                       &new_query->digest, sizeof(ulonglong));
+      if (entry && entry->block == block)
+        entry->block= new_block;
+      lf_hash_search_unpin(lf_writer_pins);
+    }
     DBUG_PRINT("qcache", ("moved %lu bytes to 0x%lx, new gap at 0x%lx",
 			len, (ulong) new_block, (ulong) *border));
     break;
@@ -4799,6 +5555,13 @@ my_bool Query_cache::check_integrity(bool locked)
   uint i;
   DBUG_ENTER("check_integrity");
 
+  if (partitions)
+  {
+    for (i= 0; i < partition_count; i++)
+      result|= partitions[i].check_integrity(locked);
+    DBUG_RETURN(result);
+  }
+
   if (!locked)
     lock_and_suspend();
 
@@ -18,6 +18,7 @@
 
 #include "hash.h"
 #include "my_base.h"                            /* ha_rows */
+#include <lf.h>
 
 class MY_LOCALE;
 struct TABLE_LIST;
@@ -40,6 +41,13 @@ typedef struct st_changed_table_list CHANGED_TABLE_LIST;
 #define QUERY_CACHE_DEF_QUERY_HASH_SIZE		1024
 #define QUERY_CACHE_DEF_TABLE_HASH_SIZE		1024
 
+/* maximal number of query cache partitions (query_cache_partitions) */
+#define QUERY_CACHE_MAX_PARTITIONS		64
+/* number of bits in the table key filter of a query cache partition */
+#define QUERY_CACHE_TABLE_FILTER_BITS		1024
+/* number of table generation counters (query_cache_async_invalidation) */
+#define QUERY_CACHE_TABLE_GENERATIONS		4096
+
 /* minimal result data size when data allocated */
 #define QUERY_CACHE_MIN_RESULT_DATA_SIZE	(1024*4)
 
@@ -99,6 +107,12 @@ struct Query_cache_block_table
   */
   TABLE_COUNTER_TYPE n;
 
+  /**
+    Generation of the table when the query was registered. The query is
+    stale once the generation of the table has moved on.
+  */
+  int32 generation;
+
   /**
     Pointers to the next and previous node, linking all queries with 
     a common table.
@@ -156,9 +170,13 @@ struct Query_cache_query
   Query_cache_block *res;
   Query_cache_tls *wri;
   ulong len;
+  /* hash of the key, used by the lock free lookup */
+  ulonglong digest;
   unsigned int last_pkt_nr;
   uint8 tbls_type;
   uint8 ready;
+  /* set if the query can be found by the lock free lookup */
+  uint8 published;
 
   Query_cache_query() {}                      /* Remove gcc warning */
   inline void init_n_lock();
@@ -186,6 +204,7 @@ struct Query_cache_query
   inline bool is_results_ready()           { return ready; }
   void lock_writing();
   void lock_reading();
+  bool try_lock_reading();
   bool try_lock_writing();
   void unlock_writing();
   void unlock_reading();
@@ -213,6 +232,17 @@ struct Query_cache_table
   */
   my_bool hashed;
 
+  /**
+    Generation counter of the table, bumped instead of invalidating the
+    queries with query_cache_async_invalidation. Tables whose keys hash
+    to the same value share the counter.
+  */
+  int32 volatile *gen;
+  /**
+    Generation up to which stale queries of the table were reclaimed.
+  */
+  int32 reclaimed_gen;
+
   inline char *db()			     { return (char *) data(); }
   inline char *table()			     { return tbl; }
   inline void table(char *table_arg)	     { tbl= table_arg; }
@@ -227,6 +257,7 @@ struct Query_cache_table
   inline ulonglong engine_data()             { return engine_data_buff; }
   inline void engine_data(ulonglong data_arg){ engine_data_buff= data_arg; }
   inline my_bool is_hashed()                 { return hashed; }
+  inline int32 generation()                  { return my_atomic_load32(gen); }
   inline void set_hashed(my_bool hash)       { hashed= hash; }
   inline uchar* data()
   {
@@ -302,6 +333,8 @@ class Query_cache
   /* statistics */
   ulong free_memory, queries_in_cache, hits, inserts, refused,
     free_memory_blocks, total_blocks, lowmem_prunes;
+  /* hits served without structure_guard_mutex (included in hits) */
+  int64 lock_free_hits;
 
 
 private:
@@ -315,8 +348,50 @@ class Query_cache
   enum Cache_staus {OK, DISABLE_REQUEST, DISABLED};
   Cache_staus m_cache_status;
 
+  /*
+    Partitions of the cache, if query_cache_partitions > 1. The global
+    query_cache object then owns no memory itself and only dispatches
+    requests to the partitions, each of which is a complete cache with
+    its own memory bins, query list and structure_guard_mutex.
+  */
+  Query_cache *partitions;
+  uint partition_count;
+  /*
+    Bit filter of the keys of all tables which were registered in this
+    partition since the last flush. Bits are set under
+    structure_guard_mutex and only ever cleared together with all
+    tables, so a clear bit means that there is nothing to invalidate.
+  */
+  uchar table_filter[QUERY_CACHE_TABLE_FILTER_BITS / 8];
+
+  /*
+    Lock free lookup of complete results, see send_result_lock_free().
+    lf_writer_pins are used by the thread that holds structure_guard_mutex
+    to publish and unpublish queries. lf_readers counts the lookups in
+    progress and lf_readers_blocked keeps new ones from starting while
+    blocks of this partition are being moved or freed.
+  */
+  LF_PINS *lf_writer_pins;
+  volatile int32 lf_readers, lf_readers_blocked;
+
   void free_query_internal(Query_cache_block *point);
   void invalidate_table_internal(THD *thd, uchar *key, uint32 key_length);
+  Query_cache *choose_partition(THD *thd, const char *query,
+                                uint query_length);
+  static uint table_filter_bit(const uchar *key, uint32 key_length);
+  inline bool table_filter_is_set(uint bit)
+  { return table_filter[bit / 8] & (1 << (bit % 8)); }
+  void init_partition();
+  void destroy_partition();
+  void lf_publish(Query_cache_block *query_block);
+  void lf_unpublish(Query_cache_block *query_block);
+  void lf_suspend_readers();
+  void lf_resume_readers();
+  static int32 volatile *table_generation(const uchar *key,
+                                          uint32 key_length);
+  my_bool is_stale(Query_cache_block *query_block);
+  int send_result_lock_free(THD *thd, const char *key, ulong key_length);
+  void send_cached_result(THD *thd, Query_cache_block *query_block);
 
 protected:
   /*
@@ -454,12 +529,17 @@ class Query_cache
   inline bool is_disable_in_progress(void)
   { return m_cache_status == DISABLE_REQUEST; }
 
-  /* initialize cache (mutex) */
-  void init();
+  /* initialize cache (mutex), split into the given number of partitions */
+  void init(uint partition_count_arg= 1);
   /* resize query cache (return real query size, 0 if disabled) */
   ulong resize(ulong query_cache_size);
   /* set limit on result size */
-  inline void result_size_limit(ulong limit){query_cache_limit=limit;}
+  inline void result_size_limit(ulong limit)
+  {
+    query_cache_limit= limit;
+    for (uint i= 0; partitions && i < partition_count; i++)
+      partitions[i].result_size_limit(limit);
+  }
   /* set minimal result data allocation unit size */
   ulong set_min_res_unit(ulong size);
 
@@ -538,6 +618,15 @@ class Query_cache
   void unlock(void);
 
   void disable_query_cache(THD *thd);
+
+  /* Partitions, the unpartitioned cache is its own single partition */
+  uint get_partition_count() { return partitions ? partition_count : 1; }
+  Query_cache *get_partition(uint i)
+  { return partitions ? partitions + i : this; }
+  /* Reset the statistics which are cleared by FLUSH STATUS */
+  void reset_statistics();
+  /* Remove the queries made stale by query_cache_async_invalidation */
+  void reclaim_stale_queries(THD *thd);
 };
 
 #ifdef HAVE_QUERY_CACHE
@@ -570,7 +659,7 @@ struct Query_cache_query_flags
 #define query_cache_store_query(A, B) query_cache.store_query(A, B)
 #define query_cache_destroy() query_cache.destroy()
 #define query_cache_result_size_limit(A) query_cache.result_size_limit(A)
-#define query_cache_init() query_cache.init()
+#define query_cache_init(A) query_cache.init(A)
 #define query_cache_resize(A) query_cache.resize(A)
 #define query_cache_set_min_res_unit(A) query_cache.set_min_res_unit(A)
 #define query_cache_invalidate3(A, B, C) query_cache.invalidate(A, B, C)
@@ -589,7 +678,7 @@ struct Query_cache_query_flags
 #define query_cache_store_query(A, B)     do { } while(0)
 #define query_cache_destroy()             do { } while(0)
 #define query_cache_result_size_limit(A)  do { } while(0)
-#define query_cache_init()                do { } while(0)
+#define query_cache_init(A)               do { } while(0)
 #define query_cache_resize(A)             do { } while(0)
 #define query_cache_set_min_res_unit(A)   do { } while(0)
 #define query_cache_invalidate3(A, B, C)  do { } while(0)
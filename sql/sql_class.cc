@@ -59,6 +59,7 @@
 #include "sp_cache.h"
 #include "transaction.h"
 #include "sql_select.h" /* declares create_tmp_table() */
+#include "sql_expression_cache.h"        // Expression_cache_persistent
 #include "debug_sync.h"
 #include "sql_parse.h"                          // is_update_query
 #include "sql_callback.h"
@@ -976,6 +977,7 @@ THD::THD(bool is_wsrep_applier)
 #endif
   net.vio=0;
   net.buff= 0;
+  net.extension= 0;
   client_capabilities= 0;                       // minimalistic client
   system_thread= NON_SYSTEM_THREAD;
   cleanup_done= abort_on_warning= 0;
@@ -1037,6 +1039,10 @@ THD::THD(bool is_wsrep_applier)
 
   sp_proc_cache= NULL;
   sp_func_cache= NULL;
+  expr_cache_persistent= NULL;
+  bzero(changed_table_slots, sizeof(changed_table_slots));
+  has_changed_table_slots= false;
+  statement_table_version= 0;
 
   /* For user vars replication*/
   if (opt_bin_log)
@@ -1608,6 +1614,8 @@ void THD::cleanup(void)
   my_hash_free(&user_vars);
   sp_cache_clear(&sp_proc_cache);
   sp_cache_clear(&sp_func_cache);
+  delete expr_cache_persistent;
+  expr_cache_persistent= NULL;
 
   mysql_ull_cleanup(this);
   /* All metadata locks must have been released by now. */
@@ -1693,6 +1701,8 @@ THD::~THD()
     lf_hash_put_pins(tdc_hash_pins);
   if (xid_hash_pins)
     lf_hash_put_pins(xid_hash_pins);
+  if (query_cache_tls.lf_pins)
+    lf_hash_put_pins(query_cache_tls.lf_pins);
   /* Ensure everything is freed */
   status_var.local_memory_used-= sizeof(THD);
   if (status_var.local_memory_used != 0)
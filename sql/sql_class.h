@@ -68,6 +68,7 @@ class Query_log_event;
 class Load_log_event;
 class sp_rcontext;
 class sp_cache;
+class Expression_cache_persistent;
 class Lex_input_stream;
 class Parser_state;
 class Rows_log_event;
@@ -397,6 +398,7 @@ class MY_LOCALE;
 */
 
 struct Query_cache_block;
+class Query_cache;
 
 struct Query_cache_tls
 {
@@ -405,12 +407,17 @@ struct Query_cache_tls
     functions and methods to maintain proper locking.
   */
   Query_cache_block *first_query_block;
+  /* Partition the current statement was looked up in */
+  Query_cache *partition;
+  /* Pins for the lock free lookup of cached results */
+  LF_PINS *lf_pins;
   void set_first_query_block(Query_cache_block *first_query_block_arg)
   {
     first_query_block= first_query_block_arg;
   }
 
-  Query_cache_tls() :first_query_block(NULL) {}
+  Query_cache_tls()
+    :first_query_block(NULL), partition(NULL), lf_pins(NULL) {}
 };
 
 /* SIGNAL / RESIGNAL / GET DIAGNOSTICS */
@@ -541,6 +548,7 @@ typedef struct system_variables
   ulonglong group_concat_max_len;
   ulonglong default_regex_flags;
   ulonglong max_mem_used;
+  ulonglong subquery_persistent_cache_size;
 
   /**
      Place holders to store Multi-source variables in sys_var.cc during
@@ -559,6 +567,7 @@ typedef struct system_variables
   ulong max_error_count;
   ulong max_length_for_sort_data;
   ulong max_sort_length;
+  ulong max_sort_threads;
   ulong max_tmp_tables;
   ulong max_insert_delayed_threads;
   ulong min_examined_row_limit;
@@ -628,6 +637,7 @@ typedef struct system_variables
   my_bool old_alter_table;
   my_bool old_passwords;
   my_bool big_tables;
+  my_bool group_concat_spill;
   my_bool query_cache_strip_comments;
   my_bool sql_log_slow;
   my_bool sql_log_bin;
@@ -679,6 +689,9 @@ typedef struct system_variables
   ulong wsrep_OSU_method;
   double long_query_time_double, max_statement_time_double;
 
+  /* Thread pool: high priority queue accesses per transaction */
+  uint threadpool_high_prio_tickets;
+
   my_bool pseudo_slave_mode;
 
 } SV;
@@ -1452,7 +1465,8 @@ enum enum_thread_type
   SYSTEM_THREAD_EVENT_WORKER= 16,
   SYSTEM_THREAD_BINLOG_BACKGROUND= 32,
   SYSTEM_THREAD_SLAVE_INIT= 64,
-  SYSTEM_THREAD_SLAVE_BACKGROUND= 128
+  SYSTEM_THREAD_SLAVE_BACKGROUND= 128,
+  SYSTEM_THREAD_QUERY_CACHE_RECLAIM= 256
 };
 
 inline char const *
@@ -1468,6 +1482,7 @@ show_system_thread(enum_thread_type thread)
     RETURN_NAME_AS_STRING(SYSTEM_THREAD_EVENT_SCHEDULER);
     RETURN_NAME_AS_STRING(SYSTEM_THREAD_EVENT_WORKER);
     RETURN_NAME_AS_STRING(SYSTEM_THREAD_SLAVE_INIT);
+    RETURN_NAME_AS_STRING(SYSTEM_THREAD_QUERY_CACHE_RECLAIM);
   default:
     sprintf(buf, "<UNKNOWN SYSTEM THREAD: %d>", thread);
     return buf;
@@ -2820,6 +2835,24 @@ class THD :public Statement,
   sp_cache   *sp_proc_cache;
   sp_cache   *sp_func_cache;
 
+  /* Subquery results kept between statements, see sql_expression_cache.h */
+  Expression_cache_persistent *expr_cache_persistent;
+  /*
+    Version slots of the tables changed by this connection, to be
+    published at the end of the statement and transaction, see
+    publish_table_versions()
+  */
+  ulonglong changed_table_slots[TABLE_VERSION_SLOTS / 64];
+  bool has_changed_table_slots;
+  /* Table version clock at the start of the current statement */
+  int64 statement_table_version;
+
+  void mark_table_version_changed(uint slot)
+  {
+    changed_table_slots[slot / 64]|= 1ULL << (slot % 64);
+    has_changed_table_slots= true;
+  }
+
   /** number of name_const() substitutions, see sp_head.cc:subst_spvars() */
   uint       query_name_consts;
 
@@ -5007,6 +5040,9 @@ user_var_entry *get_variable(HASH *hash, LEX_STRING &name,
    memory simultaneously with iteration, so it should be ~2-3x faster.
  */
 
+class Sort_param;
+class Unique_merge_workers;
+
 class Unique :public Sql_alloc
 {
   DYNAMIC_ARRAY file_ptrs;
@@ -5021,8 +5057,15 @@ class Unique :public Sql_alloc
   uint full_size;
   uint min_dupl_count;   /* always 0 for unions, > 0 for intersections */
   bool with_counters;
+  uint merge_threads;    /* worker threads of the last merge, 0 for none */
 
-  bool merge(TABLE *table, uchar *buff, bool without_last_merge);
+  void init_sort_param(Sort_param *sort_param, TABLE *table, uchar *buff);
+  bool merge(TABLE *table, uchar *buff, Unique_merge_workers *parallel,
+             bool without_last_merge);
+  bool last_merge_parallel(Sort_param *sort_param,
+                           Unique_merge_workers *parallel, IO_CACHE *outfile);
+  int walk_parallel(Unique_merge_workers *parallel, uchar *buff,
+                    tree_walk_action action, void *walk_action_arg);
 
 public:
   ulong elements;
@@ -5065,6 +5108,8 @@ class Unique :public Sql_alloc
 
   void reset();
   bool walk(TABLE *table, tree_walk_action action, void *walk_action_arg);
+  /* Set the number of worker threads of the merge, see max_sort_threads */
+  void set_merge_threads(uint threads) { merge_threads= threads; }
 
   uint get_size() const { return size; }
   ulonglong get_max_in_memory_size() const { return max_in_memory_size; }
@@ -1177,8 +1177,9 @@ void prepare_new_connection_state(THD* thd)
 {
   Security_context *sctx= thd->security_ctx;
 
-  if (thd->client_capabilities & CLIENT_COMPRESS)
-    thd->net.compress=1;				// Use compression
+  if (thd->client_capabilities & CLIENT_COMPRESS)	// Use compression
+    thd->net.compress= (thd->client_capabilities & CLIENT_COMPRESS_STREAM ?
+                        NET_COMPRESS_STREAM : 1);
 
   /*
     Much of this is duplicated in create_embedded_thd() for the
@@ -690,6 +690,15 @@ bool Explain_node::print_explain_json_cache(Json_writer *writer,
         double hit_ratio= double(cache_tracker->hit) / cache_reads * 100.0;
         writer->add_member("r_hit_ratio").add_double(hit_ratio);
       }
+      longlong persistent_reads= (cache_tracker->persistent_hit +
+                                  cache_tracker->persistent_miss);
+      if (persistent_reads != 0)
+      {
+        writer->add_member("r_persistent_hits").
+          add_ll(cache_tracker->persistent_hit);
+        writer->add_member("r_persistent_misses").
+          add_ll(cache_tracker->persistent_miss);
+      }
     }
     return true;
   }
@@ -1671,6 +1680,8 @@ void Explain_table_access::print_explain_json(Explain_query *query,
                                               "incremental":"flat");
     writer->add_member("buffer_size").add_size(bka_type.join_buffer_size);
     writer->add_member("join_type").add_str(bka_type.join_alg);
+    if (bka_type.hybrid)
+      writer->add_member("hybrid").add_bool(true);
     if (bka_type.mrr_type.length())
       writer->add_member("mrr_type").add_str(bka_type.mrr_type);
     if (where_cond)
@@ -1687,6 +1698,8 @@ void Explain_table_access::print_explain_json(Explain_query *query,
         writer->add_double(jbuf_tracker.get_filtered_after_where()*100.0);
       else
         writer->add_null();
+      if (bka_type.hybrid)
+        writer->add_member("r_partitions").add_ll(bka_type.r_partitions);
     }
   }
 
@@ -1806,6 +1819,8 @@ void Explain_table_access::append_tag_name(String *str, enum explain_extra_tag t
       str->append(STRING_WITH_LEN(", "));
       str->append(bka_type.join_alg);
       str->append(STRING_WITH_LEN(" join"));
+      if (bka_type.hybrid)
+        str->append(STRING_WITH_LEN(", hybrid"));
       str->append(STRING_WITH_LEN(")"));
       if (bka_type.mrr_type.length())
       {
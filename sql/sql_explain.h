@@ -485,7 +485,7 @@ enum explain_extra_tag
 class EXPLAIN_BKA_TYPE
 {
 public:
-  EXPLAIN_BKA_TYPE() : join_alg(NULL) {}
+  EXPLAIN_BKA_TYPE() : join_alg(NULL), hybrid(false), r_partitions(0) {}
 
   size_t join_buffer_size;
 
@@ -499,6 +499,15 @@ class EXPLAIN_BKA_TYPE
 
   /* Information about MRR usage.  */
   StringBuffer<64> mrr_type;
+
+  /* 
+    TRUE <=> BNLH join partitions the records to temporary files when
+    the join buffer gets full (optimizer_switch join_cache_hybrid)
+  */
+  bool hybrid;
+
+  /* ANALYZE: the largest number of partitions the records were written to */
+  uint r_partitions;
   
   bool is_using_jbuf() { return (join_alg != NULL); }
 };
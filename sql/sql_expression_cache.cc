@@ -17,6 +17,8 @@
 #include "sql_base.h"
 #include "sql_select.h"
 #include "sql_expression_cache.h"
+#include "my_atomic.h"
+#include "my_bit.h"
 
 /**
   Minimum hit ration to proceed on disk if in memory table overflowed.
@@ -33,18 +35,266 @@
   impact in the case when the cache is not applicable)
 */
 #define EXPCACHE_CHECK_HIT_RATIO_AFTER 200
+/**
+  Maximum number of tables a subquery may read to keep its results in the
+  persistent cache
+*/
+#define EXPCACHE_PERSISTENT_MAX_TABLES 64
 
 /*
   Expression cache is used only for caching subqueries now, so its statistic
   variables we call subquery_cache*.
 */
 ulong subquery_cache_miss, subquery_cache_hit;
+ulong subquery_persistent_cache_miss, subquery_persistent_cache_hit;
+
+/* Table version clock, incremented by publish_table_versions() */
+static int64 table_version_clock;
+static int64 table_versions[TABLE_VERSION_SLOTS];
+
+
+int64 current_table_version()
+{
+  return my_atomic_load64_explicit(&table_version_clock,
+                                   MY_MEMORY_ORDER_SEQ_CST);
+}
+
+
+int64 table_version(uint slot)
+{
+  return my_atomic_load64_explicit(&table_versions[slot],
+                                   MY_MEMORY_ORDER_SEQ_CST);
+}
+
+
+/**
+  Mark a table changed by the connection, for changes that are not done
+  through the handler of the table, like DDL
+
+  @param thd     Thread handle
+  @param key     "db\0table_name\0"
+  @param length  length of the key
+*/
+
+void mark_table_version_changed(THD *thd, const char *key, size_t length)
+{
+  thd->mark_table_version_changed(table_version_slot(key, length));
+}
+
+
+/**
+  Publish the changes of tables done by a connection
+
+  @param thd           Thread handle
+  @param end_of_trans  TRUE at the end of a transaction, FALSE at the end
+                       of a statement
+
+  @details
+  Called when the changes are visible to other connections. The results
+  that persistent caches have kept since the start of a statement that
+  began before are dropped on the next lookup.
+
+  The changes of a multi-statement transaction are published at the end
+  of every statement, for the tables without transactions, and again at
+  the end of the transaction.
+*/
+
+void publish_table_versions(THD *thd, bool end_of_trans)
+{
+  bool keep= !end_of_trans && thd->in_multi_stmt_transaction_mode();
+  int64 version;
+
+  if (!thd->has_changed_table_slots)
+    return;
+  version= my_atomic_add64_explicit(&table_version_clock, 1,
+                                    MY_MEMORY_ORDER_SEQ_CST) + 1;
+  for (uint i= 0; i < TABLE_VERSION_SLOTS / 64; i++)
+  {
+    ulonglong bits= thd->changed_table_slots[i];
+    for (; bits; bits&= bits - 1)
+    {
+      uint slot= i * 64 + my_count_bits((bits & (~bits + 1)) - 1);
+      int64 old= table_version(slot);
+      while (old < version &&
+             !my_atomic_cas64_strong_explicit(&table_versions[slot], &old,
+                                              version,
+                                              MY_MEMORY_ORDER_SEQ_CST,
+                                              MY_MEMORY_ORDER_SEQ_CST))
+      {}
+    }
+    if (!keep)
+      thd->changed_table_slots[i]= 0;
+  }
+  if (!keep)
+    thd->has_changed_table_slots= false;
+}
+
+
+struct Expression_cache_persistent::Entry
+{
+  Entry *prev, *next;
+  size_t size;
+  /* Table version clock at the start of the statement that computed it */
+  int64 version;
+  uint slot_count, key_length, value_length;
+
+  uint16 *slots() { return (uint16*) (this + 1); }
+  uchar *key() { return (uchar*) (slots() + slot_count); }
+  uchar *value() { return key() + key_length; }
+};
+
+
+uchar *Expression_cache_persistent::get_key(const uchar *arg, size_t *length,
+                                            my_bool not_used
+                                            __attribute__((unused)))
+{
+  Entry *entry= (Entry*) arg;
+  *length= entry->key_length;
+  return entry->key();
+}
+
+
+Expression_cache_persistent::Expression_cache_persistent()
+  :first(NULL), last(NULL), used(0)
+{
+  my_hash_init(&entries, &my_charset_bin, 64, 0, 0, get_key,
+               (my_hash_free_key) my_free, HASH_THREAD_SPECIFIC);
+}
+
+
+Expression_cache_persistent::~Expression_cache_persistent()
+{
+  my_hash_free(&entries);
+}
+
+
+void Expression_cache_persistent::unlink(Entry *entry)
+{
+  if (entry->prev)
+    entry->prev->next= entry->next;
+  else
+    first= entry->next;
+  if (entry->next)
+    entry->next->prev= entry->prev;
+  else
+    last= entry->prev;
+}
+
+
+void Expression_cache_persistent::remove(Entry *entry)
+{
+  unlink(entry);
+  used-= entry->size;
+  my_hash_delete(&entries, (uchar*) entry);
+}
+
+
+/**
+  Find the result of a subquery
+
+  @param key           digest of the subquery and its parameters
+  @param[out] value_length  length of the result
+
+  @return the result, or NULL if it is not in the cache or one of the
+  tables of the subquery has been changed since it was computed
+*/
+
+const uchar *Expression_cache_persistent::find(const String *key,
+                                               size_t *value_length)
+{
+  Entry *entry;
+  if (!(entry= (Entry*) my_hash_search(&entries, (const uchar*) key->ptr(),
+                                       key->length())))
+    return NULL;
+  for (uint i= 0; i < entry->slot_count; i++)
+  {
+    if (table_version(entry->slots()[i]) > entry->version)
+    {
+      remove(entry);
+      return NULL;
+    }
+  }
+  if (entry != first)
+  {
+    unlink(entry);
+    entry->prev= NULL;
+    entry->next= first;
+    first->prev= entry;
+    first= entry;
+  }
+  *value_length= entry->value_length;
+  return entry->value();
+}
+
+
+/**
+  Put the result of a subquery into the cache
+
+  @param key         digest of the subquery and its parameters
+  @param value       the result
+  @param version     table version clock at the start of the statement
+  @param slots       version slots of the tables of the subquery
+  @param slot_count  number of the slots
+  @param max_size    size limit of the cache
+*/
+
+void Expression_cache_persistent::put(const String *key, const String *value,
+                                      int64 version, const uint16 *slots,
+                                      uint slot_count, ulonglong max_size)
+{
+  size_t size= (sizeof(Entry) + slot_count * sizeof(uint16) +
+                key->length() + value->length());
+  Entry *entry;
+
+  if ((entry= (Entry*) my_hash_search(&entries, (const uchar*) key->ptr(),
+                                      key->length())))
+    remove(entry);
+  if (size > max_size)
+    return;
+  trim(max_size - size);
+  if (!(entry= (Entry*) my_malloc(size, MYF(MY_THREAD_SPECIFIC))))
+    return;
+  entry->size= size;
+  entry->version= version;
+  entry->slot_count= slot_count;
+  entry->key_length= key->length();
+  entry->value_length= value->length();
+  memcpy(entry->slots(), slots, slot_count * sizeof(uint16));
+  memcpy(entry->key(), key->ptr(), key->length());
+  memcpy(entry->value(), value->ptr(), value->length());
+  if (my_hash_insert(&entries, (uchar*) entry))
+  {
+    my_free(entry);
+    return;
+  }
+  entry->prev= NULL;
+  if ((entry->next= first))
+    first->prev= entry;
+  else
+    last= entry;
+  first= entry;
+  used+= size;
+}
+
+
+/**
+  Evict the least recently used entries until they take max_size bytes
+*/
+
+void Expression_cache_persistent::trim(ulonglong max_size)
+{
+  while (used > max_size && last)
+    remove(last);
+}
+
 
 Expression_cache_tmptable::Expression_cache_tmptable(THD *thd,
                                                      List<Item> &dependants,
-                                                     Item *value)
+                                                     Item *value, Item *expr)
   :cache_table(NULL), table_thd(thd), tracker(NULL), items(dependants), val(value),
-   hit(0), miss(0), inited (0)
+   hit(0), miss(0), inited (0), expr(expr), persistent(NULL),
+   table_slots(NULL), table_slot_count(0), persistent_result(NULL),
+   persistent_warn_count(0), persistent_hit(0), persistent_miss(0)
 {
   DBUG_ENTER("Expression_cache_tmptable::Expression_cache_tmptable");
   DBUG_VOID_RETURN;
@@ -62,7 +312,7 @@ void Expression_cache_tmptable::disable_cache()
   free_tmp_table(table_thd, cache_table);
   cache_table= NULL;
   update_tracker();
-  if (tracker)
+  if (tracker && !persistent)
     tracker->cache= NULL;
 }
 
@@ -110,6 +360,7 @@ void Expression_cache_tmptable::init()
 
   /* add result field */
   items.push_front(val);
+  init_persistent();
 
   cache_table_param.init();
   /* dependent items and result */
@@ -131,9 +382,9 @@ void Expression_cache_tmptable::init()
     DBUG_VOID_RETURN;
   }
 
-  if (cache_table->s->db_type() != heap_hton)
+  if (cache_table->s->db_type() != heap_hton || cache_table->s->blob_fields)
   {
-    DBUG_PRINT("error", ("we need only heap table"));
+    DBUG_PRINT("error", ("we need only heap table without blobs"));
     goto error;
   }
 
@@ -182,14 +433,16 @@ Expression_cache_tmptable::~Expression_cache_tmptable()
   /* Add accumulated statistics */
   statistic_add(subquery_cache_miss, miss, &LOCK_status);
   statistic_add(subquery_cache_hit, hit, &LOCK_status);
+  statistic_add(subquery_persistent_cache_miss, persistent_miss,
+                &LOCK_status);
+  statistic_add(subquery_persistent_cache_hit, persistent_hit, &LOCK_status);
 
   if (cache_table)
     disable_cache();
-  else
-  {
-    update_tracker();
-    tracker= NULL;
-  }
+  update_tracker();
+  if (tracker)
+    tracker->cache= NULL;
+  tracker= NULL;
 }
 
 
@@ -204,6 +457,10 @@ Expression_cache_tmptable::~Expression_cache_tmptable()
   the function returns the result of the expression extracted from
   the cache.
 
+  If the parameters are not in the temporary table, they are looked up in
+  the persistent cache of the connection, when the results are kept
+  there.
+
   @retval Expression_cache::HIT if the set of parameters is in the cache
   @retval Expression_cache::MISS - otherwise
 */
@@ -212,6 +469,7 @@ Expression_cache::result Expression_cache_tmptable::check_value(Item **value)
 {
   int res;
   DBUG_ENTER("Expression_cache_tmptable::check_value");
+  persistent_key.length(0);
 
   if (cache_table)
   {
@@ -230,12 +488,17 @@ Expression_cache::result Expression_cache_tmptable::check_value(Item **value)
                    ("Early check: hit rate is not so good to keep the cache"));
         disable_cache();
       }
-
-      DBUG_RETURN(MISS);
     }
-
-    hit++;
-    *value= cached_result;
+    else
+    {
+      hit++;
+      *value= cached_result;
+      DBUG_RETURN(Expression_cache::HIT);
+    }
+  }
+  if (persistent && check_persistent())
+  {
+    *value= val;
     DBUG_RETURN(Expression_cache::HIT);
   }
   DBUG_RETURN(Expression_cache::MISS);
@@ -257,9 +520,28 @@ Expression_cache::result Expression_cache_tmptable::check_value(Item **value)
 
 my_bool Expression_cache_tmptable::put_value(Item *value)
 {
-  int error;
   DBUG_ENTER("Expression_cache_tmptable::put_value");
   DBUG_ASSERT(inited);
+  DBUG_ASSERT(value == val);
+
+  if (persistent)
+    put_persistent();
+  DBUG_RETURN(put_tmptable(value));
+}
+
+
+/**
+  Put the result of the expression for the current parameters into the
+  temporary table
+
+  @retval FALSE OK
+  @retval TRUE  Error
+*/
+
+my_bool Expression_cache_tmptable::put_tmptable(Item *value)
+{
+  int error;
+  DBUG_ENTER("Expression_cache_tmptable::put_tmptable");
 
   if (!cache_table)
   {
@@ -316,6 +598,400 @@ my_bool Expression_cache_tmptable::put_value(Item *value)
 }
 
 
+/**
+  Unit of the subquery of a subquery predicate, which is wrapped into an
+  Item_in_optimizer for IN
+*/
+
+static st_select_lex_unit *subquery_unit(Item *expr)
+{
+  if (expr->type() == Item::FUNC_ITEM)
+    expr= ((Item_func *) expr)->arguments()[1];
+  if (expr->type() != Item::SUBSELECT_ITEM)
+    return NULL;
+  return ((Item_subselect *) expr)->unit;
+}
+
+
+/**
+  Add a version slot to the slots of a subquery
+
+  @retval FALSE OK
+  @retval TRUE  too many slots
+*/
+
+static bool add_table_slot(uint slot, uint16 *slots, uint *count)
+{
+  for (uint i= 0; i < *count; i++)
+  {
+    if (slots[i] == slot)
+      return FALSE;
+  }
+  if (*count == EXPCACHE_PERSISTENT_MAX_TABLES)
+    return TRUE;
+  slots[(*count)++]= (uint16) slot;
+  return FALSE;
+}
+
+
+/**
+  Collect the version slots of the tables read by a unit
+
+  @retval FALSE OK
+  @retval TRUE  the unit reads a table whose changes are not published,
+                or too many tables
+*/
+
+static bool collect_table_slots(st_select_lex_unit *unit, uint16 *slots,
+                                uint *count)
+{
+  for (st_select_lex *sl= unit->first_select(); sl; sl= sl->next_select())
+  {
+    List_iterator_fast<TABLE_LIST> ti(sl->leaf_tables);
+    TABLE_LIST *tl;
+    st_select_lex_unit *inner;
+    while ((tl= ti++))
+    {
+      TABLE *table= tl->table;
+      if (tl->jtbm_subselect || tl->derived)
+      {
+        if (collect_table_slots(tl->jtbm_subselect ?
+                                tl->jtbm_subselect->unit : tl->derived,
+                                slots, count))
+          return TRUE;
+        continue;
+      }
+      if (!table || table->s->tmp_table != NO_TMP_TABLE ||
+          table->file->table_cache_type() == HA_CACHE_TBL_NOCACHE ||
+          add_table_slot(table->s->version_slot, slots, count))
+        return TRUE;
+    }
+    for (inner= sl->first_inner_unit(); inner; inner= inner->next_unit())
+      if (collect_table_slots(inner, slots, count))
+        return TRUE;
+  }
+  return FALSE;
+}
+
+
+/**
+  String result restored from the persistent cache
+*/
+
+class Item_string_persistent: public Item_string
+{
+public:
+  Item_string_persistent(THD *thd, CHARSET_INFO *cs)
+    :Item_string(thd, "", 0, cs)
+  {}
+  void set(const char *str, uint length)
+  {
+    str_value.set(str, length, collation.collation);
+    max_length= length;
+  }
+};
+
+
+/**
+  Append the value of an item to a key or a result of the persistent cache
+
+  @details
+  Values of the same item are equal if and only if their images are equal.
+  The image of a value of another item may be equal, so the item must be
+  identified by the rest of the key.
+*/
+
+static void append_value(String *to, Item *item, String *tmp)
+{
+  char buff[8];
+  String *res= NULL;
+
+  switch (item->cmp_type()) {
+  case INT_RESULT:
+    int8store(buff, item->val_int());
+    break;
+  case REAL_RESULT:
+  {
+    double nr= item->val_real();
+    float8store(buff, nr);
+    break;
+  }
+  case TIME_RESULT:
+    int8store(buff, item->val_temporal_packed(item->field_type()));
+    break;
+  case DECIMAL_RESULT:
+  case STRING_RESULT:
+    res= item->val_str(tmp);
+    break;
+  case ROW_RESULT:
+    DBUG_ASSERT(0);
+    break;
+  }
+  if (item->null_value)
+  {
+    to->append('\0');
+    return;
+  }
+  to->append('\1');
+  if (res)
+  {
+    int4store(buff, res->length());
+    to->append(buff, 4);
+    to->append(res->ptr(), res->length());
+  }
+  else
+    to->append(buff, 8);
+}
+
+
+/**
+  Decide if the results are also kept in the persistent cache of the
+  connection
+
+  @details
+  The results are kept if subquery_persistent_cache_size is set, the
+  statement is not a part of a multi-statement transaction or a stored
+  program and could be stored in the query cache, and the subquery reads
+  only base tables, the changes of which are published by
+  publish_table_versions(). The views of the statement are versioned too.
+
+  The key of a result starts with the digest of the text of the statement
+  and the subquery and of the settings of the connection that the result
+  depends on.
+*/
+
+void Expression_cache_tmptable::init_persistent()
+{
+  THD *thd= table_thd;
+  LEX *lex= thd->lex;
+  st_select_lex_unit *unit;
+  uint16 slots[EXPCACHE_PERSISTENT_MAX_TABLES];
+  uint count= 0;
+  char buff[STRING_BUFFER_USUAL_SIZE];
+  String text(buff, sizeof(buff), &my_charset_bin);
+  List_iterator<Item> li(items);
+  Item *item;
+  DBUG_ENTER("Expression_cache_tmptable::init_persistent");
+
+  if (thd->expr_cache_persistent)
+    thd->expr_cache_persistent->trim(thd->variables.
+                                     subquery_persistent_cache_size);
+  if (!thd->variables.subquery_persistent_cache_size)
+    DBUG_VOID_RETURN;
+  if (thd->in_multi_stmt_transaction_mode() || thd->spcont ||
+      !(lex->safe_to_cache_query || lex->safe_to_cache_prepared) ||
+      !(unit= subquery_unit(expr)) || val->cmp_type() == ROW_RESULT)
+    DBUG_VOID_RETURN;
+  li++;  // skip result field
+  while ((item= li++))
+  {
+    if (item->cmp_type() == ROW_RESULT)
+      DBUG_VOID_RETURN;
+  }
+  if (collect_table_slots(unit, slots, &count))
+  {
+    DBUG_PRINT("info", ("tables of the subquery are not versioned"));
+    DBUG_VOID_RETURN;
+  }
+  /* Views of the statement, the subquery may read through them */
+  for (TABLE_LIST *tl= lex->query_tables; tl; tl= tl->next_global)
+  {
+    char key[MAX_DBKEY_LENGTH];
+    if (tl->view &&
+        add_table_slot(table_version_slot(key,
+                                          tdc_create_key(key, tl->view_db.str,
+                                                         tl->view_name.str)),
+                       slots, &count))
+      DBUG_VOID_RETURN;
+  }
+
+  switch (val->cmp_type()) {
+  case INT_RESULT:
+    if ((persistent_result= new (thd->mem_root) Item_int(thd, 0LL)))
+      persistent_result->unsigned_flag= expr->unsigned_flag;
+    break;
+  case REAL_RESULT:
+    persistent_result= new (thd->mem_root) Item_float(thd, 0.0,
+                                                      val->decimals);
+    break;
+  case DECIMAL_RESULT:
+    persistent_result= new (thd->mem_root) Item_decimal(thd, 0LL, FALSE);
+    break;
+  case STRING_RESULT:
+    persistent_result= new (thd->mem_root)
+      Item_string_persistent(thd, val->collation.collation);
+    break;
+  case TIME_RESULT:
+    persistent_result= val;             // see Item_cache_temporal
+    break;
+  case ROW_RESULT:
+    break;
+  }
+  if (!persistent_result ||
+      !(table_slots= (uint16*) thd->memdup(slots, count * sizeof(uint16))))
+    DBUG_VOID_RETURN;
+  table_slot_count= count;
+
+  /*
+    The same text may be a subquery of other semantics in another place of
+    another statement, like in WHERE and HAVING or with another comparison
+    of ALL, which is not printed after the IN to EXISTS transformation.
+  */
+  text.length(0);
+  text.append(thd->query(), thd->query_length());
+  text.append((const char*) &unit->first_select()->select_number,
+              sizeof(unit->first_select()->select_number));
+  expr->print(&text, QT_ORDINARY);
+  text.append((const char*) &thd->variables.sql_mode,
+              sizeof(thd->variables.sql_mode));
+  text.append((const char*) &thd->variables.collation_connection,
+              sizeof(thd->variables.collation_connection));
+  text.append((const char*) &thd->variables.time_zone,
+              sizeof(thd->variables.time_zone));
+  text.append((const char*) &thd->variables.div_precincrement,
+              sizeof(thd->variables.div_precincrement));
+  text.append((const char*) &thd->variables.group_concat_max_len,
+              sizeof(thd->variables.group_concat_max_len));
+  if (thd->db)
+    text.append(thd->db, thd->db_length);
+  if (thd->is_error())
+    DBUG_VOID_RETURN;
+  my_md5(persistent_digest, text.ptr(), text.length());
+
+  if (!thd->expr_cache_persistent &&
+      !(thd->expr_cache_persistent= new Expression_cache_persistent()))
+    DBUG_VOID_RETURN;
+  persistent= thd->expr_cache_persistent;
+  DBUG_VOID_RETURN;
+}
+
+
+/**
+  Make the key of the persistent cache for the current parameters
+
+  @retval FALSE OK
+  @retval TRUE  Error, the key is empty
+*/
+
+bool Expression_cache_tmptable::make_persistent_key()
+{
+  List_iterator<Item> li(items);
+  Item *item;
+  char buff[MAX_FIELD_WIDTH];
+  String tmp(buff, sizeof(buff), &my_charset_bin);
+
+  persistent_key.length(0);
+  persistent_key.append((const char*) persistent_digest, MD5_HASH_SIZE);
+  li++;  // skip result field
+  while ((item= li++))
+    append_value(&persistent_key, item, &tmp);
+  if (table_thd->is_error())
+  {
+    persistent_key.length(0);
+    return TRUE;
+  }
+  return FALSE;
+}
+
+
+/**
+  Look the current parameters up in the persistent cache
+
+  @details
+  A result that is found is stored into the result Item_cache, and into
+  the temporary table for the next lookups of the statement.
+
+  @retval TRUE  found, the result is in val
+  @retval FALSE not found
+*/
+
+bool Expression_cache_tmptable::check_persistent()
+{
+  const uchar *pos;
+  size_t length;
+  DBUG_ENTER("Expression_cache_tmptable::check_persistent");
+
+  if (make_persistent_key() ||
+      !(pos= persistent->find(&persistent_key, &length)))
+  {
+    persistent_warn_count=
+      table_thd->get_stmt_da()->current_statement_warn_count();
+    persistent_miss++;
+    DBUG_RETURN(FALSE);
+  }
+  if (!pos[0])
+    ((Item_cache *) val)->set_null();
+  else
+  {
+    pos++;
+    switch (val->cmp_type()) {
+    case INT_RESULT:
+      ((Item_int *) persistent_result)->value= sint8korr(pos);
+      break;
+    case REAL_RESULT:
+      float8get(((Item_float *) persistent_result)->value, pos);
+      break;
+    case TIME_RESULT:
+      ((Item_cache_temporal *) val)->store_packed(sint8korr(pos), expr);
+      break;
+    case DECIMAL_RESULT:
+    {
+      my_decimal value;
+      str2my_decimal(E_DEC_FATAL_ERROR, (const char*) pos + 4, uint4korr(pos),
+                     &my_charset_bin, &value);
+      ((Item_decimal *) persistent_result)->set_decimal_value(&value);
+      break;
+    }
+    case STRING_RESULT:
+      ((Item_string_persistent *) persistent_result)->
+        set((const char*) pos + 4, uint4korr(pos));
+      break;
+    case ROW_RESULT:
+      DBUG_ASSERT(0);
+      break;
+    }
+    if (persistent_result != val)
+    {
+      ((Item_cache *) val)->store(persistent_result);
+      ((Item_cache *) val)->cache_value();
+    }
+  }
+  persistent_hit++;
+  DBUG_PRINT("info", ("found in the persistent cache"));
+  /* The lookup in the temporary table before was a miss */
+  put_tmptable(val);
+  DBUG_RETURN(TRUE);
+}
+
+
+/**
+  Put the result of the expression for the current parameters into the
+  persistent cache
+*/
+
+void Expression_cache_tmptable::put_persistent()
+{
+  char buff[MAX_FIELD_WIDTH];
+  String tmp(buff, sizeof(buff), &my_charset_bin);
+  THD *thd= table_thd;
+
+  /*
+    The key is empty if the lookup failed. Results with warnings are not
+    kept, as the warnings would be lost on a hit.
+  */
+  if (!persistent_key.length() || thd->is_error() ||
+      thd->get_stmt_da()->current_statement_warn_count() !=
+      persistent_warn_count)
+    return;
+  persistent_value.length(0);
+  append_value(&persistent_value, val, &tmp);
+  persistent->put(&persistent_key, &persistent_value,
+                  thd->statement_table_version, table_slots,
+                  table_slot_count,
+                  thd->variables.subquery_persistent_cache_size);
+}
+
+
 void Expression_cache_tmptable::print(String *str, enum_query_type query_type)
 {
   List_iterator<Item> li(items);
@@ -18,6 +18,7 @@
 #define SQL_EXPRESSION_CACHE_INCLUDED
 
 #include "sql_select.h"
+#include "my_md5.h"
 
 
 /**
@@ -30,6 +31,7 @@
 */
 
 extern ulong subquery_cache_miss, subquery_cache_hit;
+extern ulong subquery_persistent_cache_miss, subquery_persistent_cache_hit;
 
 class Expression_cache :public Sql_alloc
 {
@@ -80,16 +82,21 @@ class Expression_cache_tracker :public Sql_alloc
 public:
   enum expr_cache_state {UNINITED, STOPPED, OK};
   Expression_cache_tracker(Expression_cache *c) :
-    cache(c), hit(0), miss(0), state(UNINITED)
+    cache(c), hit(0), miss(0), persistent_hit(0), persistent_miss(0),
+    state(UNINITED)
   {}
 
   Expression_cache *cache;
   ulong hit, miss;
+  /* Lookups in the persistent cache, done on misses of the cache above */
+  ulong persistent_hit, persistent_miss;
   enum expr_cache_state state;
 
   static const char* state_str[3];
   void set(ulong h, ulong m, enum expr_cache_state s)
   {hit= h; miss= m; state= s;}
+  void set_persistent(ulong h, ulong m)
+  {persistent_hit= h; persistent_miss= m;}
 
   void fetch_current_stats()
   {
@@ -99,6 +106,57 @@ class Expression_cache_tracker :public Sql_alloc
 };
 
 
+/**
+  Results of subqueries kept between the statements of a connection
+
+  @details
+  An entry is found by a digest of the subquery and the values of its
+  parameters, see Expression_cache_tmptable::init_persistent(). It keeps
+  the table version clock at the start of the statement that computed it
+  and the version slots of the tables the subquery reads, and is dropped
+  when one of the slots was changed after that, like the query cache
+  invalidates the queries of a changed table. The entries are evicted in
+  least recently used order when they take more than
+  subquery_persistent_cache_size bytes.
+*/
+
+class Expression_cache_persistent
+{
+public:
+  Expression_cache_persistent();
+  ~Expression_cache_persistent();
+
+  const uchar *find(const String *key, size_t *value_length);
+  void put(const String *key, const String *value, int64 version,
+           const uint16 *slots, uint slot_count, ulonglong max_size);
+  void trim(ulonglong max_size);
+
+private:
+  struct Entry;
+  static uchar *get_key(const uchar *arg, size_t *length, my_bool);
+  void unlink(Entry *entry);
+  void remove(Entry *entry);
+
+  HASH entries;
+  /* Most and least recently used entries */
+  Entry *first, *last;
+  /* Bytes taken by the entries */
+  ulonglong used;
+};
+
+
+/*
+  Versions of the data of tables, see table_version_slot(). A slot holds
+  the table version clock of the last publish_table_versions() of a
+  change of one of its tables.
+*/
+
+int64 current_table_version();
+int64 table_version(uint slot);
+void mark_table_version_changed(THD *thd, const char *key, size_t length);
+void publish_table_versions(THD *thd, bool end_of_trans);
+
+
 /**
   Implementation of expression cache over a temporary table
 */
@@ -106,7 +164,8 @@ class Expression_cache_tracker :public Sql_alloc
 class Expression_cache_tmptable :public Expression_cache
 {
 public:
-  Expression_cache_tmptable(THD *thd, List<Item> &dependants, Item *value);
+  Expression_cache_tmptable(THD *thd, List<Item> &dependants, Item *value,
+                            Item *expr);
   virtual ~Expression_cache_tmptable();
   virtual result check_value(Item **value);
   virtual my_bool put_value(Item *value);
@@ -128,11 +187,17 @@ class Expression_cache_tmptable :public Expression_cache
                                          Expression_cache_tracker::OK :
                                          Expression_cache_tracker::STOPPED) :
                                Expression_cache_tracker::UNINITED));
+      tracker->set_persistent(persistent_hit, persistent_miss);
     }
   }
 
 private:
   void disable_cache();
+  my_bool put_tmptable(Item *value);
+  void init_persistent();
+  bool make_persistent_key();
+  bool check_persistent();
+  void put_persistent();
 
   /* tmp table parameters */
   TMP_TABLE_PARAM cache_table_param;
@@ -154,6 +219,23 @@ class Expression_cache_tmptable :public Expression_cache
   ulong hit, miss;
   /* Set on if the object has been succesfully initialized with init() */
   bool inited;
+
+  /* The cached expression, a subquery predicate */
+  Item *expr;
+  /* Session cache of the results, NULL if they are not kept there */
+  Expression_cache_persistent *persistent;
+  uchar persistent_digest[MD5_HASH_SIZE];
+  /* Digest of the subquery and the values of the parameters */
+  String persistent_key;
+  String persistent_value;
+  /* Version slots of the tables the subquery reads */
+  uint16 *table_slots;
+  uint table_slot_count;
+  /* Constant that a result found in the persistent cache is stored to */
+  Item *persistent_result;
+  /* Warnings of the statement before the evaluation of the expression */
+  ulong persistent_warn_count;
+  ulong persistent_hit, persistent_miss;
 };
 
 #endif /* SQL_EXPRESSION_CACHE_INCLUDED */
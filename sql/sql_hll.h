@@ -0,0 +1,160 @@
+/* Copyright (c) 2017, MariaDB Corporation.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+#ifndef SQL_HLL_INCLUDED
+#define SQL_HLL_INCLUDED
+
+#include "my_global.h"
+#include "m_string.h"                           // bzero
+#include "my_bit.h"                             // my_count_bits
+#include <math.h>
+
+/**
+  HyperLogLog sketch of a set of 64-bit hash values.
+
+  The low HLL_PRECISION bits of a hash select one of HLL_REGISTERS
+  registers, which keeps the highest rank (number of trailing zero bits
+  plus one) seen in the remaining bits. The number of distinct hashes is
+  estimated from the ranks with the estimator of O. Ertl, "New
+  cardinality estimation algorithms for HyperLogLog sketches" (2017), which
+  needs no bias correction tables. The standard error is
+  1.04 / sqrt(HLL_REGISTERS), 0.8%.
+
+  The sketch has a fixed size, and two sketches of parts of a set are
+  merged to the sketch of the whole set by taking the highest rank of
+  every register.
+
+  The registers are owned by the caller, see init().
+*/
+
+#define HLL_PRECISION 14
+#define HLL_REGISTERS (1U << HLL_PRECISION)
+
+class Hll_sketch
+{
+  /* Bits of a hash value that are left for the rank */
+  static const uint rank_bits= 64 - HLL_PRECISION;
+  uchar *registers;
+
+public:
+  Hll_sketch() :registers(0) {}
+
+  /** Use registers, of HLL_REGISTERS bytes, for the sketch */
+  void init(uchar *registers_arg) { registers= registers_arg; clear(); }
+  bool is_inited() const { return registers != 0; }
+  void reset() { registers= 0; }
+  void clear() { bzero(registers, HLL_REGISTERS); }
+
+  void add(ulonglong hash)
+  {
+    uchar *reg= registers + (hash & (HLL_REGISTERS - 1));
+    ulonglong rest= hash >> HLL_PRECISION;
+    uchar rank= (uchar) (rest ? my_count_bits((rest & (~rest + 1)) - 1) + 1 :
+                         rank_bits + 1);
+    if (rank > *reg)
+      *reg= rank;
+  }
+
+  void merge(const Hll_sketch *other)
+  {
+    for (uint i= 0; i < HLL_REGISTERS; i++)
+      set_if_bigger(registers[i], other->registers[i]);
+  }
+
+  ulonglong estimate() const
+  {
+    uint counts[rank_bits + 2];
+    const double m= HLL_REGISTERS;
+    double z;
+    bzero(counts, sizeof(counts));
+    for (uint i= 0; i < HLL_REGISTERS; i++)
+      counts[registers[i]]++;
+    if (counts[0] == HLL_REGISTERS)
+      return 0;
+    z= m * tau(1.0 - counts[rank_bits + 1] / m);
+    for (uint k= rank_bits; k >= 1; k--)
+      z= 0.5 * (z + counts[k]);
+    z+= m * sigma(counts[0] / m);
+    return (ulonglong) (m * m / (2 * M_LN2 * z) + 0.5);
+  }
+
+  /** Hash of an integer, every bit depends on every bit of the value */
+  static ulonglong hash_int(ulonglong val)
+  {
+    val^= val >> 33;
+    val*= 0xff51afd7ed558ccdULL;
+    val^= val >> 33;
+    val*= 0xc4ceb9fe1a85ec53ULL;
+    val^= val >> 33;
+    return val;
+  }
+
+  /** Hash of a row of values, from the hash of the previous values */
+  static ulonglong hash_combine(ulonglong hash, ulonglong value)
+  {
+    return hash_int((hash * 0x9e3779b97f4a7c15ULL) ^ value);
+  }
+
+  /** Hash of a byte string */
+  static ulonglong hash_bytes(const uchar *pos, size_t length,
+                              ulonglong seed= 0)
+  {
+    const uchar *end= pos + length;
+    ulonglong hash= seed ^ (length * 0x9e3779b97f4a7c15ULL);
+    for (; pos + 8 <= end; pos+= 8)
+      hash= (hash ^ hash_int(uint8korr(pos))) * 0x9e3779b97f4a7c15ULL;
+    if (pos < end)
+    {
+      ulonglong tail= 0;
+      for (uint shift= 0; pos < end; pos++, shift+= 8)
+        tail|= (ulonglong) *pos << shift;
+      hash= (hash ^ hash_int(tail)) * 0x9e3779b97f4a7c15ULL;
+    }
+    return hash_int(hash);
+  }
+
+private:
+  static double sigma(double x)
+  {
+    double y= 1.0, z= x, prev;
+    if (x == 1.0)
+      return HUGE_VAL;
+    do
+    {
+      x*= x;
+      prev= z;
+      z+= x * y;
+      y+= y;
+    } while (z != prev);
+    return z;
+  }
+
+  static double tau(double x)
+  {
+    double y= 1.0, z= 1.0 - x, prev;
+    if (x == 0.0 || x == 1.0)
+      return 0.0;
+    do
+    {
+      x= sqrt(x);
+      prev= z;
+      y*= 0.5;
+      z-= (1.0 - x) * (1.0 - x) * y;
+    } while (z != prev);
+    return z / 3.0;
+  }
+};
+
+#endif /* SQL_HLL_INCLUDED */
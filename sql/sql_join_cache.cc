@@ -2695,7 +2695,7 @@ int JOIN_CACHE_HASHED::init(bool for_explain)
   ref_key_info= join_tab->get_keyinfo_by_key_no(join_tab->ref.key);
   ref_used_key_parts= join_tab->ref.key_parts;
 
-  hash_func= &JOIN_CACHE_HASHED::get_hash_idx_simple;
+  hash_func= &JOIN_CACHE_HASHED::get_hash_value_simple;
   hash_cmp_func= &JOIN_CACHE_HASHED::equal_keys_simple;
 
   KEY_PART_INFO *key_part= ref_key_info->key_part;
@@ -2704,7 +2704,7 @@ int JOIN_CACHE_HASHED::init(bool for_explain)
   {
     if (!key_part->field->eq_cmp_as_binary())
     {
-      hash_func= &JOIN_CACHE_HASHED::get_hash_idx_complex;
+      hash_func= &JOIN_CACHE_HASHED::get_hash_value_complex;
       hash_cmp_func= &JOIN_CACHE_HASHED::equal_keys_complex;
       break;
     }
@@ -2756,6 +2756,7 @@ int JOIN_CACHE_HASHED::init_hash_table()
   {    
     key_entry_length= get_size_of_rec_offset() + // key chain header
                       size_of_key_ofs +          // reference to the next key 
+                      size_of_hash_value +       // hash value of the key
                       (use_emb_key ?  get_size_of_rec_offset() : key_length);
 
     ulong space_per_rec= avg_record_length +
@@ -2843,6 +2844,7 @@ uint JOIN_CACHE_HASHED::get_max_key_addon_space_per_record()
     That's why the multiplier 2 is used in the formula below. 
   */ 
   len= (use_emb_key ?  get_size_of_rec_offset() : ref->key_length) +
+        size_of_hash_value + // size of the hash value of the key
         size_of_rec_ofs +    // size of the key chain header
         size_of_rec_ofs +    // >= size of the reference to the next key 
         2*size_of_rec_ofs;   // >= 2*( size of hash table entry)
@@ -2888,13 +2890,8 @@ void JOIN_CACHE_HASHED::reset(bool for_writing)
     Additionally to what the default implementation does this function
     performs the following. 
     It extracts from the record the key value used in lookups for matching
-    records and searches for this key in the hash tables from the join cache.
-    If it finds the key in the hash table it joins the record to the chain
-    of records with this key. If the key is not found in the hash table the
-    key is placed into it and a chain containing only the newly added record 
-    is attached to the key entry. The key value is either placed in the hash 
-    element added for the key or, if the use_emb_key flag is set, remains in
-    the record from the partial join.
+    records and attaches the record to the chain of records with this key
+    in the hash table of the join cache with link_record_by_key().
     If the match flag field of a record contains MATCH_IMPOSSIBLE the key is
     not created for this record. 
     
@@ -2908,8 +2905,6 @@ bool JOIN_CACHE_HASHED::put_record()
 {
   bool is_full;
   uchar *key;
-  uint key_len= key_length;
-  uchar *key_ref_ptr;
   uchar *link= 0;
   TABLE_REF *ref= &join_tab->ref;
   uchar *next_ref_ptr= pos;
@@ -2932,8 +2927,42 @@ bool JOIN_CACHE_HASHED::put_record()
     key= ref->key_buff;
   }
 
+  link_record_by_key(next_ref_ptr, key, get_hash_value(key));
+  return is_full;
+}
+
+
+/* 
+  Attach a record from the buffer of a hashed join cache to its key entry
+
+  SYNOPSIS
+    link_record_by_key()
+      rec_ref_ptr  position of the reference to the next record in the key
+                   chain of the record that has been just written
+      key          the key of the record
+      hash_value   hash value of the key
+
+  DESCRIPTION
+    The function searches for the key in the hash table from the join cache.
+    If it finds the key in the hash table it joins the record to the chain
+    of records with this key. If the key is not found in the hash table the
+    key is placed into it and a chain containing only the newly added record 
+    is attached to the key entry. The key value is either placed in the hash 
+    element added for the key or, if the use_emb_key flag is set, remains in
+    the record from the partial join.
+
+  RETURN VALUE
+    none
+*/
+
+void JOIN_CACHE_HASHED::link_record_by_key(uchar *rec_ref_ptr, uchar *key,
+                                           uint32 hash_value)
+{
+  uchar *key_ref_ptr;
+  uint key_len= key_length;
+
   /* Look for the key in the hash table */
-  if (key_search(key, key_len, &key_ref_ptr))
+  if (key_search(key, hash_value, key_len, &key_ref_ptr))
   {
     uchar *last_next_ref_ptr;
     /* 
@@ -2945,11 +2974,11 @@ bool JOIN_CACHE_HASHED::put_record()
     */
     last_next_ref_ptr= get_next_rec_ref(key_ref_ptr+get_size_of_key_offset());
     /* rec->next_rec= key_entry->last_rec->next_rec */
-    memcpy(next_ref_ptr, last_next_ref_ptr, get_size_of_rec_offset());
+    memcpy(rec_ref_ptr, last_next_ref_ptr, get_size_of_rec_offset());
     /* key_entry->last_rec->next_rec= rec */ 
-    store_next_rec_ref(last_next_ref_ptr, next_ref_ptr);
+    store_next_rec_ref(last_next_ref_ptr, rec_ref_ptr);
     /* key_entry->last_rec= rec */
-    store_next_rec_ref(key_ref_ptr+get_size_of_key_offset(), next_ref_ptr);
+    store_next_rec_ref(key_ref_ptr+get_size_of_key_offset(), rec_ref_ptr);
   }
   else
   {
@@ -2963,8 +2992,10 @@ bool JOIN_CACHE_HASHED::put_record()
     cp-= get_size_of_rec_offset()+get_size_of_key_offset();
     store_next_key_ref(key_ref_ptr, cp);
     store_null_key_ref(cp);
-    store_next_rec_ref(next_ref_ptr, next_ref_ptr);
-    store_next_rec_ref(cp+get_size_of_key_offset(), next_ref_ptr);
+    store_next_rec_ref(rec_ref_ptr, rec_ref_ptr);
+    store_next_rec_ref(cp+get_size_of_key_offset(), rec_ref_ptr);
+    cp-= size_of_hash_value;
+    int4store(cp, hash_value);
     if (use_emb_key)
     {
       cp-= get_size_of_rec_offset();
@@ -2980,7 +3011,6 @@ bool JOIN_CACHE_HASHED::put_record()
     /* Increment the counter of key_entries in the hash table */ 
     key_entries++;
   }  
-  return is_full;
 }
 
 
@@ -3092,16 +3122,46 @@ bool JOIN_CACHE_HASHED::skip_if_not_needed_match()
 
 bool JOIN_CACHE_HASHED::key_search(uchar *key, uint key_len,
                                    uchar **key_ref_ptr) 
+{
+  return key_search(key, get_hash_value(key), key_len, key_ref_ptr);
+}
+
+
+/* 
+  Search for a key with a known hash value in the hash table
+
+  SYNOPSIS
+    key_search()
+      key             pointer to the key value
+      hash_value      hash value of the key as returned by get_hash_value()
+      key_len         key value length
+      key_ref_ptr OUT the same as for the variant without hash_value
+
+  DESCRIPTION
+    The function does the same as the variant of key_search without the
+    hash_value parameter. It walks the chain of key entries of the hash
+    element for hash_value and compares the keys only for the entries
+    that store the same hash value.
+
+  RETURN VALUE
+    TRUE    the key is found in the hash table
+    FALSE   otherwise
+*/
+
+bool JOIN_CACHE_HASHED::key_search(uchar *key, uint32 hash_value,
+                                   uint key_len, uchar **key_ref_ptr) 
 {
   bool is_found= FALSE;
-  uint idx= (this->*hash_func)(key, key_length);
-  uchar *ref_ptr= hash_table+size_of_key_ofs*idx;
+  uchar *ref_ptr= get_hash_entry(hash_value);
   while (!is_null_key_ref(ref_ptr))
   {
     uchar *next_key;
     ref_ptr= get_next_key_ref(ref_ptr);
-    next_key= use_emb_key ? get_emb_key(ref_ptr-get_size_of_rec_offset()) :
-                            ref_ptr-key_length;
+    if (uint4korr(ref_ptr-size_of_hash_value) != hash_value)
+      continue;
+    next_key= use_emb_key ?
+              get_emb_key(ref_ptr-size_of_hash_value-get_size_of_rec_offset()) :
+              ref_ptr-size_of_hash_value-key_length;
 
     if ((this->*hash_cmp_func)(next_key, key, key_len))
     {
@@ -3118,21 +3178,22 @@ bool JOIN_CACHE_HASHED::key_search(uchar *key, uint key_len,
   Hash function that considers a key in the hash table as byte array
 
   SYNOPSIS
-    get_hash_idx_simple()
+    get_hash_value_simple()
       key             pointer to the key value
       key_len         key value length
       
   DESCRIPTION
-    The function calculates an index of the hash entry in the hash table
-    of the join buffer for the given key. It considers the key just as
-    a sequence of bytes of the length key_len.
+    The function calculates the hash value for the given key. It considers
+    the key just as a sequence of bytes of the length key_len.
+    The index of the hash entry for the key in the hash table of the join
+    buffer is the hash value modulo the number of hash entries.
 
   RETURN VALUE
-    the calculated index of the hash entry for the given key  
+    the calculated hash value for the given key  
 */
 
 inline
-uint JOIN_CACHE_HASHED::get_hash_idx_simple(uchar* key, uint key_len)
+uint32 JOIN_CACHE_HASHED::get_hash_value_simple(uchar* key, uint key_len)
 {
   ulong nr= 1;
   ulong nr2= 4;
@@ -3143,7 +3204,7 @@ uint JOIN_CACHE_HASHED::get_hash_idx_simple(uchar* key, uint key_len)
     nr^= (ulong) ((((uint) nr & 63)+nr2)*((uint) *pos))+ (nr << 8);
     nr2+= 3;
   }
-  return nr % hash_entries;
+  return (uint32) nr;
 }
 
 
@@ -3151,14 +3212,14 @@ uint JOIN_CACHE_HASHED::get_hash_idx_simple(uchar* key, uint key_len)
   Hash function that takes into account collations of the components of the key  
 
   SYNOPSIS
-    get_hash_idx_complex()
+    get_hash_value_complex()
       key             pointer to the key value
       key_len         key value length
       
   DESCRIPTION
-    The function calculates an index of the hash entry in the hash table
-    of the join buffer for the given key. It takes into account that the
-    components of the key may be of a varchar type with different collations.
+    The function calculates the hash value for the given key. It takes
+    into account that the components of the key may be of a varchar type
+    with different collations.
     The function guarantees that the same hash value for any two equal
     keys that may differ as byte sequences.
     The function takes the info about the components of the key, their
@@ -3167,14 +3228,13 @@ uint JOIN_CACHE_HASHED::get_hash_idx_simple(uchar* key, uint key_len)
     operation.
 
   RETURN VALUE
-    the calculated index of the hash entry for the given key  
+    the calculated hash value for the given key  
 */
 
 inline
-uint JOIN_CACHE_HASHED::get_hash_idx_complex(uchar *key, uint key_len)
+uint32 JOIN_CACHE_HASHED::get_hash_value_complex(uchar *key, uint key_len)
 {
-  return 
-    (uint) (key_hashnr(ref_key_info, ref_used_key_parts, key) % hash_entries);
+  return (uint32) key_hashnr(ref_key_info, ref_used_key_parts, key);
 }
 
 
@@ -3818,6 +3878,807 @@ int JOIN_CACHE_BNLH::init(bool for_explain)
 }
 
 
+/*
+  Allocate the buffers for a batch of records to be probed in the BNLH cache
+
+  SYNOPSIS
+    alloc_probe_batch()
+
+  DESCRIPTION
+    The function allocates the array of BNLH_PROBE_BATCH Probe_record
+    structures together with the space for a copy of the record of
+    join_tab, of its join key and of its rowid for each element. The
+    memory is allocated only once for the cache in the memory root of
+    the statement.
+
+  RETURN VALUE
+    FALSE   the buffers have been allocated
+    TRUE    otherwise
+*/
+
+bool JOIN_CACHE_BNLH::alloc_probe_batch()
+{
+  TABLE *table= join_tab->table;
+  uint reclength= table->s->reclength;
+  uint ref_length= table->file->ref_length;
+  uchar *ptr;
+
+  if (probe_batch)
+    return FALSE;
+  if (!(ptr= (uchar*) join->thd->alloc(BNLH_PROBE_BATCH *
+                                       (sizeof(Probe_record) + reclength +
+                                        key_length + ref_length))))
+    return TRUE;
+  probe_batch= (Probe_record*) ptr;
+  ptr+= BNLH_PROBE_BATCH * sizeof(Probe_record);
+  for (uint i= 0; i < BNLH_PROBE_BATCH; i++)
+  {
+    probe_batch[i].record= ptr;
+    probe_batch[i].key= ptr+reclength;
+    probe_batch[i].rowid= ptr+reclength+key_length;
+    ptr+= reclength+key_length+ref_length;
+  }
+  return FALSE;
+}
+
+
+/*
+  Find matches from the next table for records from the BNLH join buffer
+
+  SYNOPSIS
+    join_matching_records()
+      skip_last    do not look for matches for the last partial join record 
+
+  DESCRIPTION
+    This implementation of the virtual function join_matching_records does
+    the same as JOIN_CACHE::join_matching_records(), but reads the records
+    of join_tab in batches of BNLH_PROBE_BATCH records before it looks for
+    matches for them. For each batch the function
+    - reads the records, copying each of them aside together with its
+      join key and, if needed, its rowid, and calculates the hash values
+      of the keys prefetching the hash table entries for them
+    - prefetches the first key entries of the chains attached to the
+      hash table entries
+    - looks for the key of each record in the hash table, comparing the
+      stored hash values of the key entries before the keys, and generates
+      the extensions for the matching records from the join buffer,
+      copying the record back into the record buffer of join_tab first.
+    The records of join_tab with blob fields can't be copied aside as their
+    blob data stay in the buffers of the handler, so for such tables the
+    records are probed one by one by JOIN_CACHE::join_matching_records().
+    When the records are partitioned in the hybrid mode the function either
+    scans join_tab, writing the records that belong to the partitions not
+    kept in the join buffer to the files of the partitions, or reads the
+    records of join_tab from the file of the partition probe_part.
+
+  RETURN VALUE
+    return one of enum_nested_loop_state
+*/
+
+enum_nested_loop_state JOIN_CACHE_BNLH::join_matching_records(bool skip_last)
+{
+  int error= 0;
+  enum_nested_loop_state rc= NESTED_LOOP_OK;
+  TABLE *table= join_tab->table;
+  KEY *keyinfo= join_tab->get_keyinfo_by_key_no(join_tab->ref.key);
+  uint reclength= table->s->reclength;
+  bool check_only_first_match= join_tab->check_only_first_match();
+  bool outer_join_first_inner= join_tab->is_first_inner_for_outer_join();
+  DBUG_ENTER("JOIN_CACHE_BNLH::join_matching_records");
+
+  if (table->s->blob_fields)
+    DBUG_RETURN(JOIN_CACHE::join_matching_records(skip_last));
+
+  table->null_row= 0;
+
+  /* 
+    Return at once if there are no records in the join buffer unless
+    join_tab has to be scanned to write its records to the partitions
+  */
+  if (!records && !(spill_partitions && !probe_part))
+    DBUG_RETURN(NESTED_LOOP_OK);
+
+  /* See JOIN_CACHE::join_matching_records() */
+  if (skip_last)     
+    put_record();     
+ 
+  if (probe_part)
+  {
+    /* The records of join_tab are read from the file of the partition */
+    save_or_restore_used_tabs(join_tab, FALSE);
+    goto probe;
+  }
+
+  if (join_tab->use_quick == 2 && join_tab->select->quick)
+  { 
+    /* A dynamic range access was used last. Clean up after it */
+    delete join_tab->select->quick;
+    join_tab->select->quick= 0;
+  }
+
+  if ((rc= join_tab_execution_startup(join_tab)) < 0)
+    goto finish2;
+
+  if (alloc_probe_batch())
+  {
+    rc= NESTED_LOOP_ERROR;
+    goto finish2;
+  }
+
+  /* Prepare to retrieve all records of the joined table */
+  if ((error= join_tab_scan->open()))
+    goto finish;
+
+probe:
+  do
+  {
+    uint count, i;
+
+    /* Read the records of the next batch and hash their keys */
+    for (count= 0; count < BNLH_PROBE_BATCH; )
+    {
+      Probe_record *probe= probe_batch+count;
+      if ((error= probe_part ? read_probe_record(probe) :
+                               join_tab_scan->next()))
+        break;
+      if (join->thd->check_killed())
+      {
+        /* The user has aborted the execution of the query */
+        join->thd->send_kill_message();
+        rc= NESTED_LOOP_KILLED;
+        goto finish; 
+      }
+      if (!probe_part)
+      {
+        if (join_tab->keep_current_rowid)
+        {
+          table->file->position(table->record[0]);
+          memcpy(probe->rowid, table->file->ref, table->file->ref_length);
+        }
+        memcpy(probe->record, table->record[0], reclength);
+        key_copy(probe->key, table->record[0], keyinfo, key_length, TRUE);
+        probe->hash_value= get_hash_value(probe->key);
+        if (spill_partitions)
+        {
+          uint part_no= get_spill_partition(probe->hash_value);
+          if (part_no || !first_part_in_buffer)
+          {
+            /* No record can match if the partition has no records */
+            Spill_partition *part= spill_parts+part_no;
+            if (part->build_records && write_probe_record(part, probe))
+            {
+              error= 1;
+              break;
+            }
+            continue;
+          }
+        }
+      }
+      prefetch_for_read(get_hash_entry(probe->hash_value));
+      count++;
+    }
+    if (error > 0)
+      goto finish;
+
+    /* Prefetch the first key entries of the chains for the batch */
+    for (i= 0; i < count; i++)
+    {
+      uchar *ref_ptr= get_hash_entry(probe_batch[i].hash_value);
+      if (!is_null_key_ref(ref_ptr))
+        prefetch_for_read(get_next_key_ref(ref_ptr)-size_of_hash_value);
+    }
+
+    for (i= 0; i < count; i++)
+    {
+      Probe_record *probe= probe_batch+i;
+      uchar *key_ref_ptr;
+      uchar *rec_ptr;
+
+      /* Look for the chain of records from the buffer matching the key */
+      if (!key_search(probe->key, probe->hash_value, key_length,
+                      &key_ref_ptr))
+        continue;
+      last_matching_rec_ref_ptr=
+        get_next_rec_ref(key_ref_ptr+get_size_of_key_offset());
+      next_matching_rec_ref_ptr= 0;
+      join_tab->jbuf_tracker->r_scans++;
+
+      /* Return the record to the record buffer of join_tab */
+      memcpy(table->record[0], probe->record, reclength);
+      table->status= 0;
+      if (join_tab->keep_current_rowid)
+        memcpy(table->file->ref, probe->rowid, table->file->ref_length);
+
+      /* Read each possible candidate from the buffer and look for matches */
+      while ((rec_ptr= get_next_candidate_for_match()))
+      {
+        join_tab->jbuf_tracker->r_rows++;
+        if ((!check_only_first_match && !outer_join_first_inner) ||
+            !skip_next_candidate_for_match(rec_ptr))
+        {
+          read_next_candidate_for_match(rec_ptr);
+          rc= generate_full_extensions(rec_ptr);
+          if (rc != NESTED_LOOP_OK && rc != NESTED_LOOP_NO_MORE_ROWS)
+            goto finish;   
+        }
+      }
+    }
+  } while (!error);
+
+finish: 
+  if (error)                 
+    rc= error < 0 ? NESTED_LOOP_NO_MORE_ROWS: NESTED_LOOP_ERROR;
+finish2:    
+  join_tab_scan->close();
+  DBUG_RETURN(rc);
+}
+
+
+/*
+  Check whether the records of a BNLH join buffer can be partitioned
+
+  SYNOPSIS
+    can_spill()
+
+  DESCRIPTION
+    The function checks whether the hybrid mode can be used for the cache
+    when its join buffer gets full. This requires the optimizer switch flag
+    join_cache_hybrid to be set. The records are written to the files of
+    the partitions as they are stored in the join buffer, so the mode is
+    not used when the records refer to other join buffers or are referred
+    to from them, when blob data of a record stay in the record buffers and
+    when join_tab has blob fields. Neither is it used when the access to
+    join_tab is checked for each record.
+
+  RETURN VALUE
+    TRUE    the records of the join buffer can be partitioned
+    FALSE   otherwise
+*/
+
+bool JOIN_CACHE_BNLH::can_spill()
+{
+  return get_join_alg() == BNLH_JOIN_ALG &&
+         optimizer_flag(join->thd, OPTIMIZER_SWITCH_JOIN_CACHE_HYBRID) &&
+         !prev_cache && !next_cache && !blobs &&
+         !join_tab->table->s->blob_fields && join_tab->use_quick != 2;
+}
+
+
+/*
+  Start partitioning the records of a full BNLH join buffer
+
+  SYNOPSIS
+    start_spill()
+
+  DESCRIPTION
+    The function chooses the number of partitions so that the records of
+    a partition are expected to fit into the join buffer, opens the files
+    of the partitions and writes all records from the join buffer to them.
+    Then it loads the records of the first partition back into the buffer.
+    If they all fit there they stay in the buffer until the buffer gets
+    full again, otherwise the first partition is written to its file like
+    all other partitions.
+
+  RETURN VALUE
+    FALSE   the records have been partitioned
+    TRUE    the partition files could not be opened, the records from the
+            join buffer are to be joined as usual
+*/
+
+bool JOIN_CACHE_BNLH::start_spill()
+{
+  Spill_partition *part;
+  ha_rows first_part_records;
+  my_off_t first_part_end;
+  uint i;
+  uint max_parts= (uint) MY_MIN(BNLH_MAX_SPILL_PARTITIONS,
+                                buff_size / (2*BNLH_SPILL_FILE_BUFF_SIZE));
+  double rows= (join_tab-1)->get_partial_join_cardinality();
+  DBUG_ENTER("JOIN_CACHE_BNLH::start_spill");
+
+  set_if_bigger(max_parts, 2);
+  if (!spill_parts &&
+      !(spill_parts= (Spill_partition*) join->thd->alloc(max_parts *
+                                                  sizeof(Spill_partition))))
+    DBUG_RETURN(TRUE);
+
+  /* 
+    The estimate of the number of records is not reliable, so at least
+    twice as many records as there are in the buffer are expected.
+  */ 
+  set_if_bigger(rows, 2.0*records);
+  rows= ceil(rows*1.25/records);
+  spill_partitions= rows < max_parts ? (uint) rows : max_parts;
+  set_if_bigger(spill_partitions, 2);
+
+  for (i= 0; i < spill_partitions; i++)
+  {
+    part= spill_parts+i;
+    if (open_cached_file(&part->build_file, mysql_tmpdir, TEMP_PREFIX,
+                         BNLH_SPILL_FILE_BUFF_SIZE, MYF(MY_WME)))
+      break;
+    if (open_cached_file(&part->probe_file, mysql_tmpdir, TEMP_PREFIX,
+                         BNLH_SPILL_FILE_BUFF_SIZE, MYF(MY_WME)))
+    {
+      close_cached_file(&part->build_file);
+      break;
+    }
+    part->build_records= part->probe_records= 0;
+  }
+  if (i < spill_partitions)
+  {
+    spill_partitions= i;
+    end_spill();
+    DBUG_RETURN(TRUE);
+  }
+  DBUG_PRINT("info", ("records: %lu  partitions: %u",
+                      (ulong) records, spill_partitions));
+
+  spill_error= FALSE;
+  first_part_in_buffer= FALSE;
+  probe_part= 0;
+  if (explain_jbuf)
+    set_if_bigger(explain_jbuf->r_partitions, spill_partitions);
+  if (spill_buffer())
+    spill_error= TRUE;
+  reset(TRUE);
+
+  /* Keep the records of the first partition in the buffer if they fit */
+  part= spill_parts;
+  first_part_records= part->build_records;
+  first_part_end= my_b_tell(&part->build_file);
+  if (reinit_io_cache(&part->build_file, READ_CACHE, 0, 0, 0) ||
+      load_partition(part))
+    spill_error= TRUE;
+  first_part_in_buffer= !part->build_records &&
+    rem_space() >= pack_length_with_blob_ptrs+extra_key_length();
+  if (!first_part_in_buffer)
+  {
+    reset(TRUE);
+    part->build_records= first_part_records;
+  }
+  /* Append to the file, or write it anew as all its records are loaded */
+  if (reinit_io_cache(&part->build_file, WRITE_CACHE,
+                      first_part_in_buffer ? 0 : first_part_end, 0, 0))
+    spill_error= TRUE;
+  DBUG_RETURN(FALSE);
+}
+
+
+/*
+  Stop partitioning the records of a BNLH join cache
+
+  SYNOPSIS
+    end_spill()
+
+  DESCRIPTION
+    The function closes the files of all partitions, the temporary files
+    are removed when they are closed.
+
+  RETURN VALUE
+    none
+*/
+
+void JOIN_CACHE_BNLH::end_spill()
+{
+  for (uint i= 0; i < spill_partitions; i++)
+  {
+    close_cached_file(&spill_parts[i].build_file);
+    close_cached_file(&spill_parts[i].probe_file);
+  }
+  spill_partitions= 0;
+  probe_part= 0;
+}
+
+
+/*
+  Write all records from a BNLH join buffer to the files of their partitions
+
+  SYNOPSIS
+    spill_buffer()
+
+  DESCRIPTION
+    The function walks through the key entries of the hash table writing
+    the records of the chain attached to each entry to the file of the
+    partition for the key. The records without keys, that is the records
+    with the match flag set to MATCH_IMPOSSIBLE, are written to the file of
+    the first partition. The join buffer is to be reset after this.
+
+  RETURN VALUE
+    FALSE   the records have been written
+    TRUE    otherwise
+*/
+
+bool JOIN_CACHE_BNLH::spill_buffer()
+{
+  uchar *key;
+
+  reset(FALSE);
+  while (get_next_key(&key))
+  {
+    uint32 hash_value= get_curr_key_hash_value();
+    uchar *last_rec_ref_ptr= get_curr_key_chain();
+    uchar *rec_ref_ptr= last_rec_ref_ptr;
+    do
+    {
+      rec_ref_ptr= get_next_rec_ref(rec_ref_ptr);
+      if (write_build_record(rec_ref_ptr, TRUE, hash_value, key))
+        return TRUE;
+    } while (rec_ref_ptr != last_rec_ref_ptr);
+  }
+
+  if (with_match_flag && join_tab->on_precond)
+  {
+    uchar *rec_ref_ptr= buff;
+    while (rec_ref_ptr < end_pos)
+    {
+      uchar *rec_len_ptr= rec_ref_ptr+get_size_of_rec_offset();
+      uchar *rec_ptr= rec_len_ptr+get_size_of_rec_length();
+      if ((enum Match_flag) rec_ptr[0] == MATCH_IMPOSSIBLE &&
+          write_build_record(rec_ref_ptr, FALSE, 0, 0))
+        return TRUE;
+      rec_ref_ptr= rec_ptr+get_rec_length(rec_len_ptr);
+    }
+  }
+  return FALSE;
+}
+
+
+/*
+  Write a record from a BNLH join buffer to the file of its partition
+
+  SYNOPSIS
+    write_build_record()
+      rec_ref_ptr  position of the record in the join buffer
+      has_key      FALSE if the record has no key as it is null complemented
+      hash_value   hash value of the key of the record
+      key          the key of the record
+
+  DESCRIPTION
+    The function writes the record at the position rec_ref_ptr in the join
+    buffer to the file of the partition for its key. The record is written
+    as it is stored in the buffer starting from its length, prepended with
+    the length, the has_key flag and the hash value. The key value follows
+    them unless the key is embedded into the record.
+
+  RETURN VALUE
+    FALSE   the record has been written
+    TRUE    otherwise
+*/
+
+bool JOIN_CACHE_BNLH::write_build_record(uchar *rec_ref_ptr, bool has_key,
+                                         uint32 hash_value, uchar *key)
+{
+  uchar header[9];
+  uchar *rec_len_ptr= rec_ref_ptr+get_size_of_rec_offset();
+  uint len= get_size_of_rec_length()+get_rec_length(rec_len_ptr);
+  Spill_partition *part= spill_parts +
+                         (has_key ? get_spill_partition(hash_value) : 0);
+
+  int4store(header, len);
+  header[4]= (uchar) has_key;
+  int4store(header+5, hash_value);
+  if (my_b_write(&part->build_file, header, sizeof(header)) ||
+      (has_key && !use_emb_key &&
+       my_b_write(&part->build_file, key, key_length)) ||
+      my_b_write(&part->build_file, rec_len_ptr, len))
+    return TRUE;
+  part->build_records++;
+  return FALSE;
+}
+
+
+/*
+  Load the records of a partition into a BNLH join buffer
+
+  SYNOPSIS
+    load_partition()
+      part   the partition whose records are loaded
+
+  DESCRIPTION
+    The function reads the records from the file of the partition 'part'
+    into the join buffer while there is enough space for them there. Each
+    record is attached to the entry for its key in the hash table. The file
+    is supposed to be positioned at the first record that has not been loaded
+    yet. The member build_records of the partition is decremented for each
+    loaded record.
+
+  RETURN VALUE
+    FALSE   the records have been loaded
+    TRUE    reading from the file has failed
+*/
+
+bool JOIN_CACHE_BNLH::load_partition(Spill_partition *part)
+{
+  uchar header[9];
+
+  while (part->build_records &&
+         rem_space() >= pack_length_with_blob_ptrs+extra_key_length())
+  {
+    uchar *rec_ref_ptr= pos;
+    uchar *rec_len_ptr= pos+get_size_of_rec_offset();
+    uint len;
+
+    if (my_b_read(&part->build_file, header, sizeof(header)))
+      return TRUE;
+    len= uint4korr(header);
+    DBUG_ASSERT(len <= pack_length);
+    if ((header[4] && !use_emb_key &&
+         my_b_read(&part->build_file, key_buff, key_length)) ||
+        my_b_read(&part->build_file, rec_len_ptr, len))
+      return TRUE;
+    part->build_records--;
+    records++;
+    curr_rec_pos= last_rec_pos= rec_len_ptr+get_size_of_rec_length();
+    end_pos= pos= rec_len_ptr+len;
+    if (header[4])
+      link_record_by_key(rec_ref_ptr,
+                         use_emb_key ? get_curr_emb_key() : key_buff,
+                         uint4korr(header+5));
+  }
+  return FALSE;
+}
+
+
+/*
+  Write a record of join_tab to the file of its partition
+
+  SYNOPSIS
+    write_probe_record()
+      part   the partition of the record
+      probe  the record with its key, its hash value and its rowid
+
+  DESCRIPTION
+    The function writes the hash value and the key of the record followed
+    by the record itself and, if it is needed, by its rowid to the file for
+    the records of join_tab of the partition 'part'.
+
+  RETURN VALUE
+    FALSE   the record has been written
+    TRUE    otherwise
+*/
+
+bool JOIN_CACHE_BNLH::write_probe_record(Spill_partition *part,
+                                         Probe_record *probe)
+{
+  uchar hash[4];
+  TABLE *table= join_tab->table;
+
+  int4store(hash, probe->hash_value);
+  if (my_b_write(&part->probe_file, hash, sizeof(hash)) ||
+      my_b_write(&part->probe_file, probe->key, key_length) ||
+      my_b_write(&part->probe_file, probe->record, table->s->reclength) ||
+      (join_tab->keep_current_rowid &&
+       my_b_write(&part->probe_file, probe->rowid, table->file->ref_length)))
+  {
+    spill_error= TRUE;
+    return TRUE;
+  }
+  part->probe_records++;
+  return FALSE;
+}
+
+
+/*
+  Read the next record of join_tab from the file of a partition
+
+  SYNOPSIS
+    read_probe_record()
+      probe  OUT the record with its key, its hash value and its rowid
+
+  DESCRIPTION
+    The function reads the next record of join_tab written by
+    write_probe_record() from the file of the partition probe_part.
+
+  RETURN VALUE
+    0    the record has been read
+    -1   there are no more records in the file
+    1    reading from the file has failed
+*/
+
+int JOIN_CACHE_BNLH::read_probe_record(Probe_record *probe)
+{
+  uchar hash[4];
+  TABLE *table= join_tab->table;
+
+  if (!probe_records_left)
+    return -1;
+  if (my_b_read(&probe_part->probe_file, hash, sizeof(hash)) ||
+      my_b_read(&probe_part->probe_file, probe->key, key_length) ||
+      my_b_read(&probe_part->probe_file, probe->record,
+                table->s->reclength) ||
+      (join_tab->keep_current_rowid &&
+       my_b_read(&probe_part->probe_file, probe->rowid,
+                 table->file->ref_length)))
+  {
+    spill_error= TRUE;
+    return 1;
+  }
+  probe_records_left--;
+  probe->hash_value= uint4korr(hash);
+  return 0;
+}
+
+
+/* 
+  Add a record into the BNLH join buffer
+
+  SYNOPSIS
+    put_record()
+
+  DESCRIPTION
+    This implementation of the virtual function put_record adds the record
+    to the join buffer as JOIN_CACHE_HASHED::put_record() does until the
+    buffer gets full. At that moment the function starts partitioning the
+    records if the hybrid mode can be used for the cache. After this the
+    record is written to the file of its partition, unless it belongs to
+    the first partition while the records of this partition are kept in
+    the join buffer. In the last case the record is added to the buffer,
+    and when the buffer gets full the records of the first partition are
+    written to its file as well.
+    
+  RETURN VALUE
+    TRUE    if it has been decided that it should be the last record
+            in the join buffer,
+    FALSE   otherwise
+*/
+
+bool JOIN_CACHE_BNLH::put_record()
+{
+  bool is_full;
+  uchar *key= 0;
+  uint32 hash_value= 0;
+  uchar *rec_ref_ptr= pos;
+  uchar *save_last_rec_pos= last_rec_pos;
+
+  if (!spill_partitions)
+  {
+    if (!JOIN_CACHE_HASHED::put_record())
+      return FALSE;
+    /* Partition the records instead of joining them if possible */
+    return !can_spill() || start_spill();
+  }
+
+  /* 
+    The record is written into the join buffer first as it is written to
+    the file of its partition the same way as the records from the buffer
+  */
+  pos+= get_size_of_rec_offset();
+  write_record_data(0, &is_full);
+  if (!last_written_is_null_compl)
+  {
+    if (use_emb_key)
+      key= get_curr_emb_key();
+    else
+    {
+      TABLE_REF *ref= &join_tab->ref;
+      cp_buffer_from_ref(join->thd, join_tab->table, ref);
+      key= ref->key_buff;
+    }
+    hash_value= get_hash_value(key);
+  }
+
+  if (first_part_in_buffer && (!key || !get_spill_partition(hash_value)))
+  {
+    if (key)
+      link_record_by_key(rec_ref_ptr, key, hash_value);
+    if (is_full)
+    {
+      /* The first partition does not fit into the buffer either */
+      if (spill_buffer())
+        spill_error= TRUE;
+      reset(TRUE);
+      first_part_in_buffer= FALSE;
+    }
+    return FALSE;
+  }
+
+  if (write_build_record(rec_ref_ptr, key != 0, hash_value, key))
+    spill_error= TRUE;
+  /* Remove the record from the join buffer */
+  records--;
+  last_rec_pos= save_last_rec_pos;
+  end_pos= pos= rec_ref_ptr;
+  return FALSE;
+}
+
+
+/*
+  Join records from the BNLH join buffer with records of join_tab
+
+  SYNOPSIS
+    join_records()
+      skip_last    do not find matches for the last record from the buffer
+
+  DESCRIPTION
+    This implementation of the virtual function join_records does the same
+    as JOIN_CACHE::join_records() when the records have not been partitioned.
+    Otherwise it first scans join_tab to join its records with the records
+    of the first partition if they are kept in the join buffer, and to write
+    the other records of join_tab to the files of their partitions. Then the
+    records of each partition written to a file are loaded into the join
+    buffer in as many chunks as needed and the records of join_tab from the
+    partition are joined with each chunk by JOIN_CACHE::join_records().
+    After this the files of the partitions are closed.
+
+  RETURN VALUE
+    return one of enum_nested_loop_state, except NESTED_LOOP_NO_MORE_ROWS.
+*/ 
+
+enum_nested_loop_state JOIN_CACHE_BNLH::join_records(bool skip_last)
+{
+  enum_nested_loop_state rc= NESTED_LOOP_OK;
+  Spill_partition *part, *part_end;
+  DBUG_ENTER("JOIN_CACHE_BNLH::join_records");
+
+  if (!spill_partitions)
+    DBUG_RETURN(JOIN_CACHE::join_records(skip_last));
+
+  DBUG_ASSERT(!skip_last);
+  if (spill_error)
+    goto finish;
+
+  probe_part= 0;
+  rc= JOIN_CACHE::join_records(FALSE);
+
+  part_end= spill_parts+spill_partitions;
+  for (part= spill_parts; part < part_end && !spill_error; part++)
+  {
+    if (rc != NESTED_LOOP_OK && rc != NESTED_LOOP_NO_MORE_ROWS)
+      break;
+    if (!part->build_records)
+      continue;
+    if (reinit_io_cache(&part->build_file, READ_CACHE, 0, 0, 0))
+    {
+      spill_error= TRUE;
+      break;
+    }
+    probe_part= part;
+    while (part->build_records)
+    {
+      /* Join the next chunk of the partition with all its join_tab records */
+      if (load_partition(part) ||
+          reinit_io_cache(&part->probe_file, READ_CACHE, 0, 0, 0))
+      {
+        spill_error= TRUE;
+        break;
+      }
+      probe_records_left= part->probe_records;
+      rc= JOIN_CACHE::join_records(FALSE);
+      if (rc != NESTED_LOOP_OK && rc != NESTED_LOOP_NO_MORE_ROWS)
+        break;
+    }
+    probe_part= 0;
+  }
+
+finish:
+  if (spill_error)
+  {
+    if (!join->thd->is_error())
+      my_error(ER_TEMP_FILE_WRITE_FAILURE, MYF(0));
+    rc= NESTED_LOOP_ERROR;
+  }
+  reset(TRUE);
+  end_spill();
+  DBUG_RETURN(rc);
+}
+
+
+void JOIN_CACHE_BNLH::save_explain_data(EXPLAIN_BKA_TYPE *explain)
+{
+  JOIN_CACHE::save_explain_data(explain);
+  explain->hybrid= can_spill();
+  explain_jbuf= explain;
+}
+
+
+void JOIN_CACHE_BNLH::free()
+{
+  end_spill();
+  JOIN_CACHE::free();
+}
+
+
 /* 
   Calculate the increment of the MRR buffer for a record write       
 
@@ -659,7 +659,7 @@ class JOIN_CACHE :public Sql_alloc
   }
      
   /* Join records from the join buffer with records from the next join table */ 
-  enum_nested_loop_state join_records(bool skip_last);
+  virtual enum_nested_loop_state join_records(bool skip_last);
 
   /* Add a comment on the join algorithm employed by the join cache */
   virtual void save_explain_data(EXPLAIN_BKA_TYPE *explain);
@@ -668,7 +668,7 @@ class JOIN_CACHE :public Sql_alloc
 
   virtual ~JOIN_CACHE() {}
   void reset_join(JOIN *j) { join= j; }
-  void free()
+  virtual void free()
   { 
     my_free(buff);
     buff= 0;
@@ -705,9 +705,13 @@ class JOIN_CACHE :public Sql_alloc
         uchar[] value;
         cache_ref *value_ref; // offset from the beginning of the buffer
       } hash_table_key;
+      uint32 hash_value; // full hash value of the key
       key_ref next_key; // offset backward from the beginning of hash table
       cache_ref *last_rec // offset from the beginning of the buffer
     }
+  The full hash value stored in a key entry is compared before the keys
+  themselves when a chain of key entries is searched, so that the full key
+  comparison is done only for the entries that are very likely to match.
   The references linking the records in a chain are always placed at the very
   beginning of the record info stored in the join buffer. The records are 
   linked in a circular list. A new record is always added to the end of this 
@@ -763,7 +767,7 @@ class JOIN_CACHE :public Sql_alloc
 class JOIN_CACHE_HASHED: public JOIN_CACHE
 {
 
-  typedef uint (JOIN_CACHE_HASHED::*Hash_func) (uchar *key, uint key_len);
+  typedef uint32 (JOIN_CACHE_HASHED::*Hash_func) (uchar *key, uint key_len);
   typedef bool (JOIN_CACHE_HASHED::*Hash_cmp_func) (uchar *key1, uchar *key2,
                                                     uint key_len);
   
@@ -791,8 +795,8 @@ class JOIN_CACHE_HASHED: public JOIN_CACHE
   /* The offset of the data fields from the beginning of the record fields */
   uint data_fields_offset;
 
-  inline uint get_hash_idx_simple(uchar *key, uint key_len);
-  inline uint get_hash_idx_complex(uchar *key, uint key_len);
+  inline uint32 get_hash_value_simple(uchar *key, uint key_len);
+  inline uint32 get_hash_value_complex(uchar *key, uint key_len);
 
   inline bool equal_keys_simple(uchar *key1, uchar *key2, uint key_len);
   inline bool equal_keys_complex(uchar *key1, uchar *key2, uint key_len);
@@ -849,6 +853,21 @@ class JOIN_CACHE_HASHED: public JOIN_CACHE
 
   uint get_size_of_key_offset() { return size_of_key_ofs; }
 
+  /* Size of the hash value stored in a key entry */
+  static const uint size_of_hash_value= 4;
+
+  /* Get the hash value of a key for the hash table */
+  uint32 get_hash_value(uchar *key)
+  {
+    return (this->*hash_func)(key, key_length);
+  }
+
+  /* Get the position of the hash table entry for a hash value */
+  uchar *get_hash_entry(uint32 hash_value)
+  {
+    return hash_table+size_of_key_ofs*(hash_value % hash_entries);
+  }
+
   /* 
     Get the position of the next_key_ptr field pointed to by 
     a linking reference stored at the position key_ref_ptr. 
@@ -969,9 +988,23 @@ class JOIN_CACHE_HASHED: public JOIN_CACHE
   */
   bool skip_if_not_needed_match();
 
+  /* Get the hash value stored in the current key entry */
+  uint32 get_curr_key_hash_value()
+  {
+    return uint4korr(curr_key_entry +
+                     (use_emb_key ? get_size_of_rec_offset() : key_length));
+  }
+
   /* Search for a key in the hash table of the join buffer */
   bool key_search(uchar *key, uint key_len, uchar **key_ref_ptr);
 
+  /* Search for a key with a known hash value in the hash table */
+  bool key_search(uchar *key, uint32 hash_value, uint key_len,
+                  uchar **key_ref_ptr);
+
+  /* Attach a record written into the join buffer to the entry for its key */
+  void link_record_by_key(uchar *rec_ref_ptr, uchar *key, uint32 hash_value);
+
   /* Reallocate the join buffer of a hashed join cache */
   int realloc_buffer();
 
@@ -1142,11 +1175,102 @@ class JOIN_CACHE_BNL :public JOIN_CACHE
 /*
   The class JOIN_CACHE_BNLH is used when the BNLH join algorithm is
   employed to perform a join operation   
+
+  The records of join_tab are probed against the hash table in batches of
+  BNLH_PROBE_BATCH records: the keys of all records of a batch are built
+  and hashed first and the hash table entries for them are prefetched,
+  so that the lookups for the batch do not wait for each cache miss one
+  after another.
+
+  With the optimizer switch flag join_cache_hybrid the cache works as
+  a hybrid hash join: when the join buffer gets full the records from it
+  and all records put after them are partitioned by the hash values of
+  their keys and written to temporary files, except the records of the
+  first partition that are kept in the buffer while they fit there. The
+  records of join_tab read by the only scan of the table are probed
+  against the records of the first partition at once, or written to the
+  files of their partitions otherwise. After this the partitions are
+  joined one by one, each of them loaded into the join buffer in as many
+  chunks as needed, so join_tab is never re-scanned.
 */
 
+#define BNLH_PROBE_BATCH 16
+
+/* Maximum number of partitions for the hybrid mode of a BNLH cache */
+#define BNLH_MAX_SPILL_PARTITIONS 64
+/* Size of the buffer of a partition file of a BNLH cache */
+#define BNLH_SPILL_FILE_BUFF_SIZE (IO_SIZE*2)
+
 class JOIN_CACHE_BNLH :public JOIN_CACHE_HASHED
 {
 
+  /* A record of join_tab read ahead to be probed in a batch */
+  struct Probe_record
+  {
+    uchar *record;
+    uchar *key;
+    uchar *rowid;
+    uint32 hash_value;
+  };
+
+  /* The batch of records to probe, allocated by alloc_probe_batch() */
+  Probe_record *probe_batch;
+
+  /* 
+    A partition of records in the hybrid mode: the records from the join
+    buffer and the records of join_tab whose keys are hashed to it
+  */
+  struct Spill_partition
+  {
+    IO_CACHE build_file;
+    IO_CACHE probe_file;
+    /* The number of records in build_file not loaded into the buffer yet */
+    ha_rows build_records;
+    /* The number of records in probe_file */
+    ha_rows probe_records;
+  };
+
+  /* The partitions, allocated by start_spill() */
+  Spill_partition *spill_parts;
+  /* The number of partitions, 0 if the records are not partitioned */
+  uint spill_partitions;
+  /* TRUE while the records of the first partition stay in the buffer */
+  bool first_part_in_buffer;
+  /* TRUE if writing to or reading from a partition file has failed */
+  bool spill_error;
+  /* The partition whose records of join_tab are probed, 0 for a scan */
+  Spill_partition *probe_part;
+  /* The number of records of probe_part that have not been read yet */
+  ha_rows probe_records_left;
+  /* Explain data where the number of partitions is reported for ANALYZE */
+  EXPLAIN_BKA_TYPE *explain_jbuf;
+
+  bool alloc_probe_batch();
+
+  bool can_spill();
+
+  /* Get the partition for a key with the given hash value */
+  uint get_spill_partition(uint32 hash_value)
+  {
+    return (uint) (((ulonglong) (uint32) (hash_value * 2654435761U) *
+                    spill_partitions) >> 32);
+  }
+
+  bool start_spill();
+
+  void end_spill();
+
+  bool spill_buffer();
+
+  bool write_build_record(uchar *rec_ref_ptr, bool has_key,
+                          uint32 hash_value, uchar *key);
+
+  bool load_partition(Spill_partition *part);
+
+  bool write_probe_record(Spill_partition *part, Probe_record *probe);
+
+  int read_probe_record(Probe_record *probe);
+
 protected:
 
   /* 
@@ -1178,6 +1302,8 @@ class JOIN_CACHE_BNLH :public JOIN_CACHE_HASHED
 
   void read_next_candidate_for_match(uchar *rec_ptr);
 
+  enum_nested_loop_state join_matching_records(bool skip_last);
+
 public:
 
   /* 
@@ -1185,7 +1311,10 @@ class JOIN_CACHE_BNLH :public JOIN_CACHE_HASHED
     used to join table 'tab' to the result of joining the previous tables 
     specified by the 'j' parameter.
   */   
-  JOIN_CACHE_BNLH(JOIN *j, JOIN_TAB *tab) : JOIN_CACHE_HASHED(j, tab) {}
+  JOIN_CACHE_BNLH(JOIN *j, JOIN_TAB *tab)
+    : JOIN_CACHE_HASHED(j, tab), probe_batch(0), spill_parts(0),
+      spill_partitions(0), first_part_in_buffer(FALSE),
+      spill_error(FALSE), probe_part(0), explain_jbuf(0) {}
 
   /* 
     This constructor creates a linked BNLH join cache. The cache is to be 
@@ -1194,7 +1323,9 @@ class JOIN_CACHE_BNLH :public JOIN_CACHE_HASHED
     cache object to which this cache is linked.
   */   
   JOIN_CACHE_BNLH(JOIN *j, JOIN_TAB *tab, JOIN_CACHE *prev) 
-    : JOIN_CACHE_HASHED(j, tab, prev) {}
+    : JOIN_CACHE_HASHED(j, tab, prev), probe_batch(0), spill_parts(0),
+      spill_partitions(0), first_part_in_buffer(FALSE),
+      spill_error(FALSE), probe_part(0), explain_jbuf(0) {}
 
   /* Initialize the BNLH cache */       
   int init(bool for_explain);
@@ -1203,6 +1334,16 @@ class JOIN_CACHE_BNLH :public JOIN_CACHE_HASHED
 
   bool is_key_access() { return TRUE; }
 
+  /* Add a record into the buffer, partitioning the records if it's full */
+  bool put_record();
+
+  /* Join the records from the buffer and from all partitions */
+  enum_nested_loop_state join_records(bool skip_last);
+
+  void save_explain_data(EXPLAIN_BKA_TYPE *explain);
+
+  void free();
+
 };
 
 
@@ -1392,6 +1533,12 @@ class JOIN_CACHE_BKAH :public JOIN_CACHE_BNLH
 
   bool prepare_look_for_matches(bool skip_last);
 
+  /* Records come from MRR one by one in the order of the keys */
+  enum_nested_loop_state join_matching_records(bool skip_last)
+  {
+    return JOIN_CACHE::join_matching_records(skip_last);
+  }
+
   /*
     The implementations of the methods
     - get_next_candidate_for_match
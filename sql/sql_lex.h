@@ -2594,6 +2594,11 @@ struct LEX: public Query_tables_list
 
   enum enum_yes_no_unknown tx_chain, tx_release;
   bool safe_to_cache_query;
+  /*
+    safe_to_cache_query of a prepared statement before it was cleared
+    because the query is not expanded, see setup_set_params()
+  */
+  bool safe_to_cache_prepared;
   bool subqueries, ignore;
   st_parsing_options parsing_options;
   Alter_info alter_info;
@@ -62,6 +62,7 @@
                               // sp_grant_privileges, ...
 #include "sql_test.h"         // mysql_print_status
 #include "sql_select.h"       // handle_select, mysql_select,
+#include "sql_expression_cache.h" // current_table_version
                               // mysql_explain_union
 #include "sql_load.h"         // mysql_load
 #include "sql_servers.h"      // create_servers, alter_servers,
@@ -2477,6 +2478,13 @@ mysql_execute_command(THD *thd)
     already.
   */
   DBUG_ASSERT(! thd->transaction_rollback_request || thd->in_sub_stmt);
+  /*
+    Results kept by the persistent subquery cache are valid while no table
+    they read is changed after the start of the statement that computed
+    them. Take the clock before the tables are opened.
+  */
+  if (!thd->in_sub_stmt)
+    thd->statement_table_version= current_table_version();
   /*
     In many cases first table of main SELECT_LEX have special meaning =>
     check that it is first table in global list and relink it first in 
@@ -3483,6 +3483,7 @@ void Prepared_statement::setup_set_params()
     Note: BUG#25843 applies here too (query cache lookup uses thd->db, not
     db from "prepare" time).
   */
+  lex->safe_to_cache_prepared= lex->safe_to_cache_query;
   if (query_cache_maybe_disabled(thd)) // we won't expand the query
     lex->safe_to_cache_query= FALSE;   // so don't cache it at Execution
 
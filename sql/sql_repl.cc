@@ -41,6 +41,8 @@ enum enum_gtid_until_state {
 
 int max_binlog_dump_events = 0; // unlimited
 my_bool opt_sporadic_binlog_dump_fail = 0;
+ulong opt_binlog_dump_cache_size= 0;
+ulonglong binlog_dump_cache_hits= 0, binlog_dump_cache_misses= 0;
 #ifndef DBUG_OFF
 static int binlog_dump_count = 0;
 #endif
@@ -2598,6 +2600,220 @@ static my_off_t get_binlog_end_pos(binlog_send_info *info,
   return 0;
 }
 
+/*
+  A window of the most recently sent events of the binlog, shared by all
+  binlog dump threads.
+
+  With many slaves connected, the dump threads all send the same events near
+  the end of the active binlog. The first dump thread to read an event from
+  the binlog file stores it here, decrypted and with its checksum verified,
+  and the other dump threads copy it into their packet from here instead of
+  reading and checking it again. Dump threads that lag behind the window
+  read from the binlog file as before.
+
+  The window holds the bytes [start_pos, end_pos) of the binlog file
+  log_name, the byte at position pos being stored at buf[pos % size].
+*/
+class Binlog_dump_cache
+{
+public:
+  void init();
+  void destroy();
+  bool resize(ulong new_size);
+  void reset();
+  bool enabled() { return size != 0; }
+  bool read_event(const char *name, my_off_t pos, String *packet,
+                  ulonglong *gen);
+  void store_event(const char *name, my_off_t pos, ulonglong gen,
+                   const uchar *ev, ulong len);
+
+private:
+  void copy_out(my_off_t pos, uchar *dst, ulong len);
+
+  mysql_rwlock_t lock;
+  uchar *buf;
+  ulong size;
+  char log_name[FN_REFLEN];
+  my_off_t start_pos, end_pos;
+  /*
+    Incremented by RESET MASTER, which reuses binlog file names, so that
+    events read before it are not stored afterwards.
+  */
+  ulonglong generation;
+};
+
+static Binlog_dump_cache binlog_dump_cache;
+
+
+void Binlog_dump_cache::init()
+{
+  mysql_rwlock_init(key_rwlock_LOCK_binlog_dump_cache, &lock);
+  buf= NULL;
+  size= 0;
+  log_name[0]= 0;
+  start_pos= end_pos= 0;
+  generation= 0;
+}
+
+
+void Binlog_dump_cache::destroy()
+{
+  my_free(buf);
+  mysql_rwlock_destroy(&lock);
+}
+
+
+/* Change the size of the cache, 0 disables it. Returns true on error. */
+bool Binlog_dump_cache::resize(ulong new_size)
+{
+  uchar *new_buf= NULL;
+  bool res= false;
+
+  if (new_size && !(new_buf= (uchar *) my_malloc(new_size, MYF(MY_WME))))
+  {
+    new_size= 0;
+    res= true;
+  }
+  mysql_rwlock_wrlock(&lock);
+  my_free(buf);
+  buf= new_buf;
+  size= new_size;
+  log_name[0]= 0;
+  start_pos= end_pos= 0;
+  mysql_rwlock_unlock(&lock);
+  return res;
+}
+
+
+void Binlog_dump_cache::reset()
+{
+  mysql_rwlock_wrlock(&lock);
+  log_name[0]= 0;
+  start_pos= end_pos= 0;
+  generation++;
+  mysql_rwlock_unlock(&lock);
+}
+
+
+void Binlog_dump_cache::copy_out(my_off_t pos, uchar *dst, ulong len)
+{
+  ulong offset= (ulong) (pos % size);
+  ulong part= MY_MIN(len, size - offset);
+  memcpy(dst, buf + offset, part);
+  memcpy(dst + part, buf, len - part);
+}
+
+
+/*
+  Append the event at position pos of binlog file name to the packet, if it
+  is in the cache.
+
+  Also returns the current generation of the cache, to pass to
+  store_event() on a miss.
+*/
+bool Binlog_dump_cache::read_event(const char *name, my_off_t pos,
+                                   String *packet, ulonglong *gen)
+{
+  bool hit= false;
+
+  mysql_rwlock_rdlock(&lock);
+  *gen= generation;
+  if (size && pos >= start_pos &&
+      pos + LOG_EVENT_MINIMAL_HEADER_LEN <= end_pos &&
+      !strcmp(name, log_name))
+  {
+    uchar header[LOG_EVENT_MINIMAL_HEADER_LEN];
+    ulong len;
+
+    copy_out(pos, header, sizeof(header));
+    len= uint4korr(header + EVENT_LEN_OFFSET);
+    if (pos + len <= end_pos && !packet->reserve(len))
+    {
+      copy_out(pos, (uchar *) packet->ptr() + packet->length(), len);
+      packet->length(packet->length() + len);
+      hit= true;
+    }
+  }
+  mysql_rwlock_unlock(&lock);
+
+  my_atomic_add64((volatile int64 *) (hit ? &binlog_dump_cache_hits
+                                          : &binlog_dump_cache_misses), 1);
+  return hit;
+}
+
+
+/*
+  Store an event that a dump thread read from the binlog.
+
+  Only events that extend the window are stored; a dump thread reading
+  events older than the window, or in an older binlog file, leaves it alone.
+  An event past the end of the window starts a new window.
+*/
+void Binlog_dump_cache::store_event(const char *name, my_off_t pos,
+                                    ulonglong gen, const uchar *ev, ulong len)
+{
+  mysql_rwlock_wrlock(&lock);
+  if (gen != generation || len > size)
+    goto end;
+  if (strcmp(name, log_name))
+  {
+    if (log_name[0] && strcmp(name, log_name) < 0)
+      goto end;
+    strmake_buf(log_name, name);
+    start_pos= end_pos= pos;
+  }
+  else if (pos > end_pos)
+    start_pos= end_pos= pos;
+  else if (pos < end_pos)
+    goto end;
+
+  {
+    ulong offset= (ulong) (pos % size);
+    ulong part= MY_MIN(len, size - offset);
+    memcpy(buf + offset, ev, part);
+    memcpy(buf, ev + part, len - part);
+  }
+  end_pos+= len;
+  if (end_pos - start_pos > size)
+    start_pos= end_pos - size;
+
+end:
+  mysql_rwlock_unlock(&lock);
+}
+
+
+/*
+  Read the next event of the binlog into the packet, from the binlog dump
+  cache if it has it.
+*/
+static int read_binlog_event(binlog_send_info *info, IO_CACHE *log,
+                             LOG_INFO *linfo, ulong ev_offset)
+{
+  String *packet= info->packet;
+  my_off_t pos= my_b_tell(log);
+  ulonglong gen;
+  int error;
+  enum enum_binlog_checksum_alg checksum_alg=
+    opt_master_verify_checksum ? info->current_checksum_alg
+                               : BINLOG_CHECKSUM_ALG_OFF;
+
+  if (!binlog_dump_cache.enabled())
+    return Log_event::read_log_event(log, packet, info->fdev, checksum_alg);
+
+  if (binlog_dump_cache.read_event(linfo->log_file_name, pos, packet, &gen))
+  {
+    my_b_seek(log, pos + packet->length() - ev_offset);
+    return 0;
+  }
+  if (!(error= Log_event::read_log_event(log, packet, info->fdev,
+                                         checksum_alg)))
+    binlog_dump_cache.store_event(linfo->log_file_name, pos, gen,
+                                  (uchar *) packet->ptr() + ev_offset,
+                                  packet->length() - ev_offset);
+  return error;
+}
+
+
 /**
  * This function sends events from one binlog file
  * but only up until end_pos
@@ -2626,9 +2842,7 @@ static int send_events(binlog_send_info *info, IO_CACHE* log, LOG_INFO* linfo,
       return 1;
 
     info->last_pos= linfo->pos;
-    error= Log_event::read_log_event(log, packet, info->fdev,
-                       opt_master_verify_checksum ? info->current_checksum_alg
-                                                  : BINLOG_CHECKSUM_ALG_OFF);
+    error= read_binlog_event(info, log, linfo, ev_offset);
     linfo->pos= my_b_tell(log);
 
     if (error)
@@ -3883,6 +4097,7 @@ int reset_master(THD* thd, rpl_gtid *init_state, uint32 init_state_len,
   if (mysql_bin_log.reset_logs(thd, 1, init_state, init_state_len,
                                next_log_number))
     return 1;
+  binlog_dump_cache.reset();
   RUN_HOOK(binlog_transmit, after_reset_master, (thd, 0 /* flags */));
   return 0;
 }
@@ -4379,6 +4594,29 @@ rpl_deinit_gtid_waiting()
 }
 
 
+void
+rpl_init_binlog_dump_cache()
+{
+  binlog_dump_cache.init();
+  if (binlog_dump_cache.resize(opt_binlog_dump_cache_size))
+    opt_binlog_dump_cache_size= 0;
+}
+
+
+void
+rpl_deinit_binlog_dump_cache()
+{
+  binlog_dump_cache.destroy();
+}
+
+
+bool
+rpl_resize_binlog_dump_cache(ulong size)
+{
+  return binlog_dump_cache.resize(size);
+}
+
+
 /*
   Format the current GTID state as a string, for returning the value of
   @@global.gtid_slave_pos.
@@ -40,6 +40,8 @@ extern bool server_id_supplied;
 
 extern int max_binlog_dump_events;
 extern my_bool opt_sporadic_binlog_dump_fail;
+extern ulong opt_binlog_dump_cache_size;
+extern ulonglong binlog_dump_cache_hits, binlog_dump_cache_misses;
 
 int start_slave(THD* thd, Master_info* mi, bool net_report);
 int stop_slave(THD* thd, Master_info* mi, bool net_report);
@@ -77,6 +79,9 @@ void rpl_init_gtid_slave_state();
 void rpl_deinit_gtid_slave_state();
 void rpl_init_gtid_waiting();
 void rpl_deinit_gtid_waiting();
+void rpl_init_binlog_dump_cache();
+void rpl_deinit_binlog_dump_cache();
+bool rpl_resize_binlog_dump_cache(ulong size);
 int gtid_state_from_binlog_pos(const char *name, uint32 pos, String *out_str);
 int rpl_append_gtid_state(String *dest, bool use_binlog);
 int rpl_load_gtid_state(slave_connection_state *state, bool use_binlog);
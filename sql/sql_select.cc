@@ -6311,10 +6311,29 @@ best_access_path(JOIN      *join,
     tmp= s->quick ? s->quick->read_time : s->scan_time();
     tmp+= (s->records - rnd_records)/(double) TIME_FOR_COMPARE;
 
-    /* We read the table as many times as join buffer becomes full. */
-    tmp*= (1.0 + floor((double) cache_record_length(join,idx) *
-                          record_count /
-                          (double) thd->variables.join_buff_size));
+    double cache_bytes= (double) cache_record_length(join,idx) * record_count;
+    double refills= floor(cache_bytes /
+                          (double) thd->variables.join_buff_size);
+    if (refills >= 1.0 &&
+        optimizer_flag(thd, OPTIMIZER_SWITCH_JOIN_CACHE_HYBRID) &&
+        !s->table->s->blob_fields)
+    {
+      /*
+        The hybrid hash join reads the table only once. The records of
+        the partitions that are not kept in the join buffer are written
+        to temporary files and read back, both those from the buffer and
+        those of the table.
+      */
+      double spilled= refills / (refills + 1.0);
+      tmp+= 2.0 * spilled *
+             (cache_bytes + (double) s->table->s->reclength * rnd_records) /
+             IO_SIZE;
+    }
+    else
+    {
+      /* We read the table as many times as join buffer becomes full. */
+      tmp*= (1.0 + refills);
+    }
     best_time= tmp + 
                (record_count*join_sel) / TIME_FOR_COMPARE * rnd_records;
     best= tmp;
@@ -16243,6 +16262,7 @@ create_tmp_table(THD *thd, TMP_TABLE_PARAM *param, List<Item> &fields,
   ulong reclength, string_total_length;
   bool  using_unique_constraint= false;
   bool  use_packed_rows= false;
+  bool  blobs_need_disk= false;
   bool  not_all_columns= !(select_options & TMP_TABLE_ALL_COLUMNS);
   char  *tmpname,path[FN_REFLEN];
   uchar	*pos, *group_buff, *bitmaps;
@@ -16619,9 +16639,25 @@ create_tmp_table(THD *thd, TMP_TABLE_PARAM *param, List<Item> &fields,
   share->fields= field_count;
   share->column_bitmap_size= bitmap_buffer_size(share->fields);
 
+  /*
+    HEAP tables store BLOB columns in variable-length records, but they
+    can't have BLOB columns in a key. The rows of HEAP tables are
+    referenced by memory addresses, which would make the order of rows
+    with equal sort keys random for information schema tables.
+  */
+  if (blob_count)
+  {
+    blobs_need_disk= distinct || param->schema_table;
+    for (ORDER *tmp= group ; tmp && !blobs_need_disk ; tmp= tmp->next)
+    {
+      Field *field= (*tmp->item)->get_tmp_table_field();
+      blobs_need_disk= !field || (field->flags & BLOB_FLAG);
+    }
+  }
+
   /* If result table is small; use a heap */
   /* future: storage engine selection can be made dynamic? */
-  if (blob_count || using_unique_constraint
+  if (blobs_need_disk || using_unique_constraint
       || (thd->variables.big_tables && !(select_options & SELECT_SMALL_RESULT))
       || (select_options & TMP_TABLE_FORCE_MYISAM)
       || thd->variables.tmp_table_size == 0)
@@ -16790,6 +16826,14 @@ create_tmp_table(THD *thd, TMP_TABLE_PARAM *param, List<Item> &fields,
 
   if (thd->variables.tmp_table_size == ~ (ulonglong) 0)		// No limit
     share->max_rows= ~(ha_rows) 0;
+  else if (share->db_type() == heap_hton && use_packed_rows)
+  {
+    /*
+      HEAP stores such rows in variable-length records that are usually
+      much shorter than reclength, it limits the memory of the table itself
+    */
+    share->max_rows= ~(ha_rows) 0;
+  }
   else
     share->max_rows= (ha_rows) (((share->db_type() == heap_hton) ?
                                  MY_MIN(thd->variables.tmp_table_size,
@@ -21651,7 +21695,7 @@ remove_duplicates(JOIN *join, TABLE *table, List<Item> &fields, Item *having)
 
   free_io_cache(table);				// Safety
   table->file->info(HA_STATUS_VARIABLE);
-  if (table->s->db_type() == heap_hton ||
+  if ((table->s->db_type() == heap_hton && !table->s->blob_fields) ||
       (!table->s->blob_fields &&
        ((ALIGN_SIZE(keylength) + HASH_OVERHEAD) * table->file->stats.records <
 	thd->variables.sortbuff_size)))
@@ -21,11 +21,13 @@
 #include "my_base.h"                            /* ha_rows */
 #include "my_sys.h"                             /* qsort2_cmp */
 #include "queues.h"
+#include "mysql/psi/mysql_thread.h"          /* mysql_mutex_t */
 
 typedef struct st_buffpek BUFFPEK;
 typedef struct st_sort_field SORT_FIELD;
 
 class Field;
+class THD;
 struct TABLE;
 
 /* Defines used by filesort and uniques */
@@ -83,6 +85,8 @@ class Sort_param {
   SORT_ADDON_FIELD *addon_field; // Descriptors for companion fields.
   uchar *unique_buff;
   bool not_killable;
+  /* Set when the workers of a parallel sort have to stop */
+  const volatile bool *workers_abort;
   char* tmp_buffer;
   // The fields below are used only by Unique class.
   qsort2_cmp compare;
@@ -98,6 +102,83 @@ class Sort_param {
 };
 
 
+/**
+  A piece of work done by the worker threads of a parallel sort.
+*/
+
+class Sort_job
+{
+public:
+  Sort_job() :next(0), busy(false) {}
+  virtual ~Sort_job() {}
+  /**
+    Do the job.
+
+    @param worker  Number of the worker thread, from 0 to threads()-1
+
+    @retval false  ok
+    @retval true   error
+  */
+  virtual bool run(uint worker)= 0;
+
+  Sort_job *next;                        // Next job in the queue
+  bool busy;                             // Queued or running
+};
+
+
+/**
+  Worker threads of a parallel sort.
+
+  The thread that owns the sort adds jobs and waits for them. Only this
+  thread has a THD: the jobs must not use current_thd, must not allocate
+  MY_THREAD_SPECIFIC memory and must check Sort_param::workers_abort
+  instead of THD::killed. A Unique may also be merged by a thread without
+  a THD, then wait() is passed NULL.
+*/
+
+class Sort_workers
+{
+public:
+  Sort_workers();
+  ~Sort_workers();
+  uint start(uint count);
+  void stop();
+  uint threads() const { return thread_count; }
+  void add(Sort_job *job);
+  bool wait(THD *thd, Sort_job *job= NULL);
+
+  void work(uint worker);
+
+  struct Worker
+  {
+    Sort_workers *workers;
+    uint number;
+    pthread_t thread_id;
+  };
+
+  volatile bool abort;                   // Stop running and skip new jobs
+private:
+
+  mysql_mutex_t LOCK_sort_workers;
+  mysql_cond_t COND_sort_job;            // A job was added
+  mysql_cond_t COND_sort_job_done;       // A job was done
+  Worker *worker_list;
+  uint thread_count;
+  uint jobs_busy;
+  Sort_job *first_job, **last_job;
+  bool job_failed;
+  bool shutdown;
+};
+
+
+bool merge_many_buff_parallel(Sort_param *param, Sort_workers *workers,
+                              uchar **sort_buffers, BUFFPEK *buffpek,
+                              uint *maxbuffer, IO_CACHE *t_file);
+bool merge_index_parallel(Sort_param *param, Sort_workers *workers,
+                          uchar **sort_buffers, BUFFPEK *buffpek,
+                          uint maxbuffer, IO_CACHE *tempfile,
+                          IO_CACHE *outfile, int flag= 1,
+                          BUFFPEK *part_results= NULL, uint *part_count= NULL);
 int merge_many_buff(Sort_param *param, uchar *sort_buffer,
 		    BUFFPEK *buffpek,
 		    uint *maxbuffer, IO_CACHE *t_file);
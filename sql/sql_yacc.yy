@@ -1065,6 +1065,7 @@ bool my_yyoverflow(short **a, YYSTYPE **b, ulong *yystacksize);
 %token  AND_AND_SYM                   /* OPERATOR */
 %token  AND_SYM                       /* SQL-2003-R */
 %token  ANY_SYM                       /* SQL-2003-R */
+%token  APPROX_COUNT_DISTINCT_SYM
 %token  AS                            /* SQL-2003-R */
 %token  ASC                           /* SQL-2003-N */
 %token  ASCII_SYM                     /* MYSQL-FUNC */
@@ -10056,6 +10057,16 @@ sum_expr:
             if ($$ == NULL)
               MYSQL_YYABORT;
           }
+        | APPROX_COUNT_DISTINCT_SYM '('
+          { Select->in_sum_expr++; }
+          expr_list
+          { Select->in_sum_expr--; }
+          ')'
+          {
+            $$= new (thd->mem_root) Item_sum_approx_count_distinct(thd, *$4);
+            if ($$ == NULL)
+              MYSQL_YYABORT;
+          }
         | BIT_AND  '(' in_sum_expr ')'
           {
             $$= new (thd->mem_root) Item_sum_and(thd, $3);
@@ -1437,9 +1437,9 @@ static Sys_var_ulonglong Sys_max_heap_table_size(
        VALID_RANGE(16384, (ulonglong)~(intptr)0), DEFAULT(16*1024*1024),
        BLOCK_SIZE(1024));
 
-static ulong mdl_locks_cache_size;
 static Sys_var_ulong Sys_metadata_locks_cache_size(
-       "metadata_locks_cache_size", "Unused",
+       "metadata_locks_cache_size",
+       "Size of the cache of unused metadata lock objects",
        READ_ONLY GLOBAL_VAR(mdl_locks_cache_size), CMD_LINE(REQUIRED_ARG),
        VALID_RANGE(1, 1024*1024), DEFAULT(1024),
        BLOCK_SIZE(1));
@@ -1970,7 +1970,8 @@ Sys_var_slave_parallel_mode::global_value_ptr(THD *thd,
 
 /* The order here must match enum_slave_parallel_mode in mysqld.h. */
 static const char *slave_parallel_mode_names[] = {
-  "none", "minimal", "conservative", "optimistic", "aggressive", NULL
+  "none", "minimal", "conservative", "optimistic", "aggressive",
+  "dependency", NULL
 };
 export TYPELIB slave_parallel_mode_typelib = {
   array_elements(slave_parallel_mode_names)-1,
@@ -1987,6 +1988,9 @@ static Sys_var_slave_parallel_mode Sys_slave_parallel_mode(
        "with rollback and retry. \"conservative\" limits parallelism in an "
        "effort to avoid any conflicts. \"aggressive\" tries to maximise the "
        "parallelism, possibly at the cost of increased conflict rate. "
+       "\"dependency\" works like \"optimistic\", but makes a transaction "
+       "wait for the commit of an earlier one that changed the same rows "
+       "(by primary or unique key) before applying its row events. "
        "\"minimal\" only parallelizes the commit steps of transactions. "
        "\"none\" disables parallel apply completely.",
        GLOBAL_VAR(opt_slave_parallel_mode), NO_CMD_LINE,
@@ -2115,6 +2119,16 @@ static Sys_var_ulong Sys_max_sort_length(
        SESSION_VAR(max_sort_length), CMD_LINE(REQUIRED_ARG),
        VALID_RANGE(4, 8192*1024L), DEFAULT(1024), BLOCK_SIZE(1));
 
+static Sys_var_ulong Sys_max_sort_threads(
+       "max_sort_threads",
+       "Maximum number of worker threads that sort and merge the buffers of "
+       "a sort that does not fit in sort_buffer_size, or that merge the "
+       "sorted runs of COUNT(DISTINCT), GROUP_CONCAT and index_merge that do "
+       "not fit in memory. Every worker uses a buffer of the size of the "
+       "sort or the run. 0 means that this is done by the query thread only",
+       SESSION_VAR(max_sort_threads), CMD_LINE(REQUIRED_ARG),
+       VALID_RANGE(0, 64), DEFAULT(0), BLOCK_SIZE(1));
+
 static Sys_var_ulong Sys_max_sp_recursion_depth(
        "max_sp_recursion_depth",
        "Maximum stored procedure recursion depth",
@@ -2240,6 +2254,14 @@ static Sys_var_ulong Sys_net_retry_count(
        BLOCK_SIZE(1), NO_MUTEX_GUARD, NOT_IN_BINLOG, ON_CHECK(0),
        ON_UPDATE(fix_net_retry_count));
 
+static Sys_var_mybool Sys_net_compress_stream(
+       "net_compress_stream",
+       "Let clients of the compressed protocol keep the compression context "
+       "between packets. This gives better compression of small packets, "
+       "at the cost of about 300K of memory per compressed connection",
+       GLOBAL_VAR(opt_net_compress_stream), CMD_LINE(OPT_ARG),
+       DEFAULT(TRUE));
+
 static Sys_var_mybool Sys_old_mode(
        "old", "Use compatible behavior from previous MariaDB version. See also --old-mode",
        SESSION_VAR(old_mode), CMD_LINE(OPT_ARG), DEFAULT(FALSE));
@@ -2359,6 +2381,7 @@ export const char *optimizer_switch_names[]=
   "extended_keys",
   "exists_to_in",
   "orderby_uses_equalities",
+  "join_cache_hybrid",
   "default", 
   NullS
 };
@@ -2748,6 +2771,22 @@ static Sys_var_ulong Sys_query_cache_min_res_unit(
        BLOCK_SIZE(8), NO_MUTEX_GUARD, NOT_IN_BINLOG, ON_CHECK(0),
        ON_UPDATE(fix_qcache_min_res_unit));
 
+static Sys_var_uint Sys_query_cache_partitions(
+       "query_cache_partitions",
+       "Number of partitions the query cache is split into. Each partition "
+       "has its own lock and query_cache_size/query_cache_partitions bytes "
+       "of memory, and a query is always cached in the same partition",
+       READ_ONLY GLOBAL_VAR(query_cache_partitions), CMD_LINE(REQUIRED_ARG),
+       VALID_RANGE(1, QUERY_CACHE_MAX_PARTITIONS), DEFAULT(1), BLOCK_SIZE(1));
+
+static Sys_var_mybool Sys_query_cache_async_invalidation(
+       "query_cache_async_invalidation",
+       "If set, a statement that changes a table does not remove the "
+       "cached queries using the table. The queries are only marked as "
+       "outdated, and a background thread removes them in batches",
+       READ_ONLY GLOBAL_VAR(opt_query_cache_async_invalidation),
+       CMD_LINE(OPT_ARG), DEFAULT(FALSE));
+
 static const char *query_cache_type_names[]= { "OFF", "ON", "DEMAND", 0 };
 
 static bool check_query_cache_type(sys_var *self, THD *thd, set_var *var)
@@ -2916,6 +2955,32 @@ static Sys_var_mybool Sys_master_verify_checksum(
        GLOBAL_VAR(opt_master_verify_checksum), CMD_LINE(OPT_ARG),
        DEFAULT(FALSE));
 
+static bool fix_binlog_dump_cache_size(sys_var *self, THD *thd,
+                                       enum_var_type type)
+{
+  ulong size= opt_binlog_dump_cache_size;
+  bool res;
+
+  mysql_mutex_unlock(&LOCK_global_system_variables);
+  res= rpl_resize_binlog_dump_cache(size);
+  mysql_mutex_lock(&LOCK_global_system_variables);
+  if (res)
+    opt_binlog_dump_cache_size= 0;
+  return res;
+}
+
+static Sys_var_ulong Sys_binlog_dump_cache_size(
+       "binlog_dump_cache_size",
+       "Size of a memory cache of the most recent binlog events, shared by "
+       "all binlog dump threads. The first dump thread to send an event "
+       "stores it there, and other dump threads sending the same event take "
+       "it from the cache instead of reading it from the binlog file. 0 "
+       "disables the cache",
+       GLOBAL_VAR(opt_binlog_dump_cache_size), CMD_LINE(REQUIRED_ARG),
+       VALID_RANGE(0, 1024*1024*1024), DEFAULT(0), BLOCK_SIZE(IO_SIZE),
+       NO_MUTEX_GUARD, NOT_IN_BINLOG, ON_CHECK(0),
+       ON_UPDATE(fix_binlog_dump_cache_size));
+
 /* These names must match RPL_SKIP_XXX #defines in slave.h. */
 static const char *replicate_events_marked_for_skip_names[]= {
   "REPLICATE", "FILTER_ON_SLAVE", "FILTER_ON_MASTER", 0
@@ -3256,6 +3321,21 @@ static Sys_var_uint Sys_threadpool_oversubscribe(
   GLOBAL_VAR(threadpool_oversubscribe), CMD_LINE(REQUIRED_ARG),
   VALID_RANGE(1, 1000), DEFAULT(3), BLOCK_SIZE(1)
 );
+static Sys_var_uint Sys_threadpool_high_prio_tickets(
+  "thread_pool_high_prio_tickets",
+  "Number of times a connection with an open transaction or table locks "
+  "can be put into the high priority queue of its thread group, before "
+  "it has to wait in the common queue. 0 disables high priority scheduling",
+  SESSION_VAR(threadpool_high_prio_tickets), CMD_LINE(REQUIRED_ARG),
+  VALID_RANGE(0, UINT_MAX), DEFAULT(UINT_MAX), BLOCK_SIZE(1)
+);
+static Sys_var_mybool Sys_threadpool_work_stealing(
+  "thread_pool_work_stealing",
+  "If set, an idle worker thread picks up queued requests of another "
+  "thread group that is stalled or has no idle threads, instead of "
+  "going to sleep",
+  GLOBAL_VAR(threadpool_work_stealing), CMD_LINE(OPT_ARG), DEFAULT(FALSE)
+);
 static Sys_var_uint Sys_threadpool_size(
  "thread_pool_size",
  "Number of thread groups in the pool. "
@@ -3889,6 +3969,16 @@ static Sys_var_ulonglong Sys_group_concat_max_len(
        SESSION_VAR(group_concat_max_len), CMD_LINE(REQUIRED_ARG),
        VALID_RANGE(4, SIZE_T_MAX), DEFAULT(1024), BLOCK_SIZE(1));
 
+static Sys_var_mybool Sys_group_concat_spill(
+       "group_concat_spill",
+       "Let GROUP_CONCAT() with DISTINCT or ORDER BY sort its values in "
+       "buffers limited by tmp_table_size and max_heap_table_size, which "
+       "are written to a temporary file when full, instead of keeping all "
+       "values in memory. "
+       "The values of GROUP_CONCAT(DISTINCT ...) without ORDER BY are "
+       "then returned in sorted order",
+       SESSION_VAR(group_concat_spill), CMD_LINE(OPT_ARG), DEFAULT(FALSE));
+
 static char *glob_hostname_ptr;
 static Sys_var_charptr Sys_hostname(
        "hostname", "Server host name",
@@ -5235,6 +5325,15 @@ static Sys_var_harows Sys_expensive_subquery_limit(
        SESSION_VAR(expensive_subquery_limit), CMD_LINE(REQUIRED_ARG),
        VALID_RANGE(0, HA_POS_ERROR), DEFAULT(100), BLOCK_SIZE(1));
 
+static Sys_var_ulonglong Sys_subquery_persistent_cache_size(
+       "subquery_persistent_cache_size",
+       "Memory for the results of correlated subqueries that the subquery "
+       "cache of a connection keeps between statements, until a table that "
+       "the subquery reads is changed. 0 keeps the results only for the "
+       "execution of a statement",
+       SESSION_VAR(subquery_persistent_cache_size), CMD_LINE(REQUIRED_ARG),
+       VALID_RANGE(0, (ulonglong)~(intptr)0), DEFAULT(0), BLOCK_SIZE(1));
+
 static Sys_var_mybool Sys_encrypt_tmp_disk_tables(
        "encrypt_tmp_disk_tables",
        "Encrypt temporary on-disk tables (created as part of query execution)",
@@ -366,6 +366,9 @@ class Filesort_info
 
   size_t sort_buffer_size() const
   { return filesort_buffer.sort_buffer_size(); }
+
+  Filesort_buffer *get_filesort_buffer()
+  { return &filesort_buffer; }
 };
 
 
@@ -601,6 +604,29 @@ struct TABLE_STATISTICS_CB
 };
 
 
+/*
+  Number of data versions of tables kept for the persistent subquery
+  cache. Tables are mapped to the versions by a hash of their names, see
+  table_version_slot().
+*/
+#define TABLE_VERSION_SLOTS 1024
+
+/**
+  Slot of the data version of a table
+
+  @param key     "db\0table_name\0", the table cache key of a base table
+  @param length  length of the key
+*/
+
+static inline uint table_version_slot(const char *key, size_t length)
+{
+  ulong nr1= 1, nr2= 4;
+  my_charset_bin.coll->hash_sort(&my_charset_bin, (const uchar*) key, length,
+                                 &nr1, &nr2);
+  return (uint) (nr1 % TABLE_VERSION_SLOTS);
+}
+
+
 /**
   This structure is shared between different table objects. There is one
   instance of table share per one table in the database.
@@ -732,6 +758,7 @@ struct TABLE_SHARE
   bool can_cmp_whole_record;
   bool table_creation_was_logged;
   ulong table_map_id;                   /* for row-based replication */
+  uint version_slot;                    /* see table_version_slot() */
 
   /*
     Things that are incompatible between the stored version and the
@@ -813,6 +840,8 @@ struct TABLE_SHARE
     db.length=         strlen(db.str);
     table_name.str=    db.str + db.length + 1;
     table_name.length= strlen(table_name.str);
+    version_slot= table_version_slot(db.str,
+                                     db.length + table_name.length + 2);
   }
 
 
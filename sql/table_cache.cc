@@ -52,6 +52,7 @@
 #include "lf.h"
 #include "table.h"
 #include "sql_base.h"
+#include "sql_expression_cache.h"  // mark_table_version_changed
 
 
 /** Configuration. */
@@ -648,7 +649,7 @@ TABLE_SHARE *tdc_acquire_share(THD *thd, const char *db, const char *table_name,
     mysql_mutex_lock(&element->LOCK_table_share);
     element->share= share;
     share->tdc= element;
-    element->ref_count++;
+    element->add_ref(1);
     element->version= tdc_refresh_version();
     element->flushed= false;
     mysql_mutex_unlock(&element->LOCK_table_share);
@@ -676,6 +677,22 @@ TABLE_SHARE *tdc_acquire_share(THD *thd, const char *db, const char *table_name,
     }
   }
 
+  /*
+    Fast path: the share is loaded and referenced by somebody else, thus it
+    is not on the unused_shares list and cannot go away. Take reference
+    without LOCK_table_share and LOCK_unused_shares. Error reporting is
+    left to the locked path below.
+  */
+  if ((share= element->try_acquire_ref()))
+  {
+    if (!share->error && (flags & (share->is_view ? GTS_VIEW : GTS_TABLE)))
+    {
+      lf_hash_search_unpin(thd->tdc_hash_pins);
+      goto end;
+    }
+    tdc_release_share(share);
+  }
+
   mysql_mutex_lock(&element->LOCK_table_share);
   if (!(share= element->share))
   {
@@ -706,8 +723,7 @@ TABLE_SHARE *tdc_acquire_share(THD *thd, const char *db, const char *table_name,
     goto err;
   }
 
-  was_unused= !element->ref_count;
-  element->ref_count++;
+  was_unused= element->add_ref(1) == 1;
   mysql_mutex_unlock(&element->LOCK_table_share);
   if (was_unused)
   {
@@ -766,7 +782,7 @@ void tdc_release_share(TABLE_SHARE *share)
 
   if (share->tdc->ref_count > 1)
   {
-    share->tdc->ref_count--;
+    share->tdc->add_ref(-1);
     if (!share->is_view)
       mysql_cond_broadcast(&share->tdc->COND_release);
     mysql_mutex_unlock(&share->tdc->LOCK_table_share);
@@ -776,7 +792,7 @@ void tdc_release_share(TABLE_SHARE *share)
 
   mysql_mutex_lock(&LOCK_unused_shares);
   mysql_mutex_lock(&share->tdc->LOCK_table_share);
-  if (--share->tdc->ref_count)
+  if (share->tdc->add_ref(-1))
   {
     if (!share->is_view)
       mysql_cond_broadcast(&share->tdc->COND_release);
@@ -854,6 +870,12 @@ bool tdc_remove_table(THD *thd, enum_tdc_remove_table_type remove_type,
               thd->mdl_context.is_lock_owner(MDL_key::TABLE, db, table_name,
                                              MDL_EXCLUSIVE));
 
+  if (remove_type != TDC_RT_REMOVE_UNUSED)
+  {
+    /* The table is dropped or altered */
+    char key[MAX_DBKEY_LENGTH];
+    mark_table_version_changed(thd, key, tdc_create_key(key, db, table_name));
+  }
 
   mysql_mutex_lock(&LOCK_unused_shares);
   if (!(element= tdc_lock_share(thd, db, table_name)))
@@ -880,7 +902,7 @@ bool tdc_remove_table(THD *thd, enum_tdc_remove_table_type remove_type,
   }
   mysql_mutex_unlock(&LOCK_unused_shares);
 
-  element->ref_count++;
+  element->add_ref(1);
 
   element->wait_for_mdl_deadlock_detector();
   /*
@@ -33,8 +33,10 @@ class TDC_element
   typedef I_P_List <TABLE, TABLE_share> TABLE_list;
   typedef I_P_List <TABLE, All_share_tables> All_share_tables_list;
   /**
-    Protects ref_count, m_flush_tickets, all_tables, free_tables, flushed,
-    all_tables_refs.
+    Protects m_flush_tickets, all_tables, free_tables, flushed,
+    all_tables_refs. Transitions of ref_count from and to zero are also
+    protected by this mutex, other updates are done atomically (see
+    try_acquire_ref()).
   */
   mysql_mutex_t LOCK_table_share;
   mysql_cond_t COND_release;
@@ -103,6 +105,47 @@ class TDC_element
   }
 
 
+  /**
+    Acquire a reference to an element which is already in use.
+
+    Lock-free counterpart of the ref_count increment done under
+    LOCK_table_share. Only succeeds if ref_count is non-zero: such element
+    is not linked to the unused_shares list and its share cannot be freed
+    until the reference is released with tdc_release_share().
+
+    @pre element must be pinned.
+
+    @return share, or NULL if element is unused or not fully loaded.
+  */
+
+  TABLE_SHARE *try_acquire_ref()
+  {
+    int32 count= my_atomic_load32((int32 volatile*) &ref_count);
+    while (count)
+    {
+      if (my_atomic_cas32((int32 volatile*) &ref_count, &count, count + 1))
+      {
+        DBUG_ASSERT(share);
+        return share;
+      }
+    }
+    return 0;
+  }
+
+
+  /**
+    Atomically adjust ref_count, caller must own LOCK_table_share.
+
+    @return new value of ref_count
+  */
+
+  uint add_ref(int32 value)
+  {
+    mysql_mutex_assert_owner(&LOCK_table_share);
+    return my_atomic_add32((int32 volatile*) &ref_count, value) + value;
+  }
+
+
   /**
     Get last element of free_tables.
   */
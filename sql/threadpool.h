@@ -23,6 +23,7 @@ extern uint threadpool_max_size;
 extern uint threadpool_stall_limit;  /* time interval in 10 ms units for stall checks*/
 extern uint threadpool_max_threads;  /* Maximum threads in pool */
 extern uint threadpool_oversubscribe;  /* Maximum active threads in group */
+extern my_bool threadpool_work_stealing; /* Idle workers help other groups */
 
 
 
@@ -47,6 +48,31 @@ extern void tp_end(void);
 /* Used in SHOW for threadpool_idle_thread_count */
 extern int  tp_get_idle_thread_count();
 
+/* Work queues of a thread group, in the order they are served */
+enum tp_priority
+{
+  TP_PRIORITY_HIGH,
+  TP_PRIORITY_LOW,
+  TP_PRIORITY_COUNT
+};
+
+/* Used in INFORMATION_SCHEMA.THREAD_POOL_QUEUES */
+struct TP_QUEUE_STATS
+{
+  /* Number of connections currently in the queue */
+  uint length;
+  /* Number of events dequeued so far */
+  ulonglong events;
+  /* Total time in microseconds dequeued events spent in the queue */
+  ulonglong wait_time;
+};
+
+extern void tp_get_queue_stats(uint group, int prio, TP_QUEUE_STATS *stats);
+
+/* Used in SHOW for threadpool_steals and threadpool_group_steals */
+extern uint tp_get_group_count();
+extern ulonglong tp_get_group_steal_count(uint group);
+
 /*
   Threadpool statistics
 */
@@ -70,3 +96,7 @@ extern void tp_scheduler(void);
 
 extern int show_threadpool_idle_threads(THD *thd, SHOW_VAR *var, char *buff,
                                         enum enum_var_type scope);
+extern int show_threadpool_steals(THD *thd, SHOW_VAR *var, char *buff,
+                                  enum enum_var_type scope);
+extern int show_threadpool_group_steals(THD *thd, SHOW_VAR *var, char *buff,
+                                        enum enum_var_type scope);
@@ -116,6 +116,9 @@ struct connection_t
   connection_t *next_in_queue;
   connection_t **prev_in_queue;
   ulonglong abs_wait_timeout;
+  ulonglong enqueue_time;
+  /* Remaining number of high priority queue accesses */
+  uint tickets;
   bool logged_in;
   bool bound_to_poll_descriptor;
   bool waiting;
@@ -125,14 +128,26 @@ typedef I_P_List<connection_t,
                      I_P_List_adapter<connection_t,
                                       &connection_t::next_in_queue,
                                       &connection_t::prev_in_queue>,
-                     I_P_List_null_counter,
+                     I_P_List_counter,
                      I_P_List_fast_push_back<connection_t> >
 connection_queue_t;
 
+/* Statistics for one of the group's work queues */
+struct queue_stats_t
+{
+  ulonglong events;    /* number of events dequeued */
+  ulonglong wait_time; /* total microseconds dequeued events were queued */
+};
+
 struct thread_group_t 
 {
   mysql_mutex_t mutex;
-  connection_queue_t queue;
+  /*
+    Work queues, indexed by TP_PRIORITY_HIGH and TP_PRIORITY_LOW.
+    See queue_put()/queue_get() for how connections are assigned to them.
+  */
+  connection_queue_t queues[TP_PRIORITY_COUNT];
+  queue_stats_t queue_stats[TP_PRIORITY_COUNT];
   worker_list_t waiting_threads; 
   worker_thread_t *listener;
   pthread_attr_t *pthread_attr;
@@ -144,6 +159,8 @@ struct thread_group_t
   int io_event_count;
   int queue_event_count;
   ulonglong last_thread_creation_time;
+  /* Number of events this group's workers took from sibling groups */
+  ulonglong steal_count;
   int  shutdown_pipe[2];
   bool shutdown;
   bool stalled;
@@ -185,6 +202,7 @@ static void connection_abort(connection_t *connection);
 static void set_wait_timeout(connection_t *connection);
 static void set_next_timeout_check(ulonglong abstime);
 static void print_pool_blocked_message(bool);
+static connection_t *queue_steal(thread_group_t *thread_group);
 
 /**
  Asynchronous network IO.
@@ -412,18 +430,150 @@ static void* native_event_get_userdata(native_event *event)
 #endif
 
 
-/* Dequeue element from a workqueue */
+/**
+  Check whether a connection's next request should be scheduled with high
+  priority.
+
+  Connections that are inside a multi-statement transaction, or hold
+  table locks, are preferred as long as they have tickets left, so they
+  can release their locks sooner. Tickets prevent such connections from
+  starving all others.
+*/
+
+static bool connection_is_high_prio(const connection_t *c)
+{
+  return c->tickets > 0 &&
+    (c->thd->in_active_multi_stmt_transaction() ||
+     c->thd->locked_tables_mode != LTM_NONE);
+}
+
+
+/* Check whether the group has no queued work at all */
+
+static bool queue_is_empty(thread_group_t *thread_group)
+{
+  return thread_group->queues[TP_PRIORITY_HIGH].is_empty() &&
+         thread_group->queues[TP_PRIORITY_LOW].is_empty();
+}
+
+
+/**
+  Append a connection to one of the group's work queues.
+  Group mutex must be held.
+
+  @param now - current microsecond_interval_timer() value, the listener
+               takes it once for a whole batch of events.
+*/
+
+static void queue_push(thread_group_t *thread_group, connection_t *connection,
+                       ulonglong now)
+{
+  int prio= connection_is_high_prio(connection) ? TP_PRIORITY_HIGH
+                                                : TP_PRIORITY_LOW;
+  connection->enqueue_time= now;
+  thread_group->queues[prio].push_back(connection);
+}
+
+
+/**
+  Remove the first element from a given work queue, and account
+  for the time it spent waiting there.
+*/
+
+static connection_t *queue_pop(thread_group_t *thread_group, int prio)
+{
+  connection_t *c= thread_group->queues[prio].front();
+  if (c)
+  {
+    queue_stats_t *stats= &thread_group->queue_stats[prio];
+    thread_group->queues[prio].remove(c);
+    stats->events++;
+    stats->wait_time+= microsecond_interval_timer() - c->enqueue_time;
+    if (prio == TP_PRIORITY_HIGH)
+      c->tickets--;
+  }
+  return c;
+}
+
+
+/* 
+  Dequeue element from a workqueue.
+  High priority queue is always served first.
+*/
 
 static connection_t *queue_get(thread_group_t *thread_group)
 {
   DBUG_ENTER("queue_get");
   thread_group->queue_event_count++;
-  connection_t *c= thread_group->queue.front();
-  if (c)
+  connection_t *c= queue_pop(thread_group, TP_PRIORITY_HIGH);
+  if (!c)
+    c= queue_pop(thread_group, TP_PRIORITY_LOW);
+  DBUG_RETURN(c);  
+}
+
+
+/**
+  Take a queued connection from an overloaded sibling group.
+
+  Called by a worker that found no work in its own group, before it goes
+  to sleep. A sibling is considered overloaded if it is stalled, or if it
+  has queued events and no idle worker to pick them up.
+
+  The stolen connection is moved to the current group for the duration of
+  the request. It is removed from the sibling's poll descriptor, so that
+  start_io() can migrate it back to its home group once the request is
+  done (see change_group()).
+
+  Caller holds the mutex of its own group, therefore siblings are only
+  try-locked, to avoid lock order problems between groups. Stealing is
+  opportunistic, a busy sibling mutex just means we try the next group.
+
+  @param thread_group - group of the current (idle) worker
+
+  @return stolen connection, or NULL if no sibling group is overloaded
+*/
+
+static connection_t *queue_steal(thread_group_t *thread_group)
+{
+  DBUG_ENTER("queue_steal");
+  uint count= group_count;
+  uint start= (uint)(thread_group - all_groups);
+
+  for (uint i= 1; i <= count; i++)
   {
-    thread_group->queue.remove(c);
+    thread_group_t *victim= &all_groups[(start + i) % count];
+    connection_t *c= NULL;
+
+    /* Dirty read, avoids locking groups that have nothing to steal. */
+    if (victim == thread_group || queue_is_empty(victim))
+      continue;
+
+    if (mysql_mutex_trylock(&victim->mutex) != 0)
+      continue;
+
+    if (!victim->shutdown && !queue_is_empty(victim) &&
+        (victim->stalled || victim->waiting_threads.is_empty()))
+    {
+      c= queue_get(victim);
+      victim->connection_count--;
+      if (c->bound_to_poll_descriptor)
+      {
+        int fd= mysql_socket_getfd(c->thd->net.vio->mysql_socket);
+        io_poll_disassociate_fd(victim->pollfd, fd);
+        c->bound_to_poll_descriptor= false;
+      }
+    }
+    mysql_mutex_unlock(&victim->mutex);
+
+    if (c)
+    {
+      c->thread_group= thread_group;
+      thread_group->connection_count++;
+      thread_group->steal_count++;
+      DBUG_RETURN(c);
+    }
   }
-  DBUG_RETURN(c);  
+  DBUG_RETURN(NULL);
 }
 
 
@@ -592,7 +742,7 @@ void check_stall(thread_group_t *thread_group)
     do wait and indicate that via thd_wait_begin/end callbacks, thread creation
     will be faster.
   */
-  if (!thread_group->queue.is_empty() && !thread_group->queue_event_count)
+  if (!queue_is_empty(thread_group) && !thread_group->queue_event_count)
   {
     thread_group->stalled= true;
     wake_or_create_thread(thread_group);
@@ -711,17 +861,21 @@ static connection_t * listener(worker_thread_t *current_thread,
      more workers.
     */
     
-    bool listener_picks_event= thread_group->queue.is_empty();
+    bool listener_picks_event= queue_is_empty(thread_group);
     
     /* 
       If listener_picks_event is set, listener thread will handle first event, 
       and put the rest into the queue. If listener_pick_event is not set, all 
       events go to the queue.
     */
-    for(int i=(listener_picks_event)?1:0; i < cnt ; i++)
+    if (cnt > (listener_picks_event ? 1 : 0))
     {
-      connection_t *c= (connection_t *)native_event_get_userdata(&ev[i]);
-      thread_group->queue.push_back(c);
+      ulonglong now= microsecond_interval_timer();
+      for(int i=(listener_picks_event)?1:0; i < cnt ; i++)
+      {
+        connection_t *c= (connection_t *)native_event_get_userdata(&ev[i]);
+        queue_push(thread_group, c, now);
+      }
     }
     
     if (listener_picks_event)
@@ -913,7 +1067,8 @@ int thread_group_init(thread_group_t *thread_group, pthread_attr_t* thread_attr)
   thread_group->pollfd= -1;
   thread_group->shutdown_pipe[0]= -1;
   thread_group->shutdown_pipe[1]= -1;
-  thread_group->queue.empty();
+  for (int i= 0; i < TP_PRIORITY_COUNT; i++)
+    thread_group->queues[i].empty();
   DBUG_RETURN(0);
 }
 
@@ -1019,7 +1174,7 @@ static void queue_put(thread_group_t *thread_group, connection_t *connection)
   DBUG_ENTER("queue_put");
 
   mysql_mutex_lock(&thread_group->mutex);
-  thread_group->queue.push_back(connection);
+  queue_push(thread_group, connection, microsecond_interval_timer());
 
   if (thread_group->active_thread_count == 0)
     wake_or_create_thread(thread_group);
@@ -1115,6 +1270,17 @@ connection_t *get_event(worker_thread_t *current_thread,
       }
     }
 
+    /*
+      Before going to sleep, help an overloaded sibling group,
+      if work stealing is enabled.
+    */
+    if (!oversubscribed && threadpool_work_stealing)
+    {
+      connection= queue_steal(thread_group);
+      if (connection)
+        break;
+    }
+
     /* And now, finally sleep */ 
     current_thread->woken = false; /* wake() sets this to true */
 
@@ -1174,7 +1340,7 @@ void wait_begin(thread_group_t *thread_group)
   DBUG_ASSERT(thread_group->connection_count > 0);
  
   if ((thread_group->active_thread_count == 0) && 
-     (thread_group->queue.is_empty() || !thread_group->listener))
+     (queue_is_empty(thread_group) || !thread_group->listener))
   {
     /* 
       Group might stall while this thread waits, thus wake 
@@ -1217,6 +1383,8 @@ connection_t *alloc_connection(THD *thd)
     connection->logged_in= false;
     connection->bound_to_poll_descriptor= false;
     connection->abs_wait_timeout= ULONGLONG_MAX;
+    connection->enqueue_time= 0;
+    connection->tickets= 0;
   }
   DBUG_RETURN(connection);
 }
@@ -1453,6 +1621,14 @@ static void handle_event(connection_t *connection)
   if(err)
     goto end;
 
+  /*
+    Outside of a transaction, the connection gets a fresh budget
+    of high priority tickets.
+  */
+  if (!connection->thd->in_active_multi_stmt_transaction() &&
+      connection->thd->locked_tables_mode == LTM_NONE)
+    connection->tickets= connection->thd->variables.threadpool_high_prio_tickets;
+
   set_wait_timeout(connection);
   err= start_io(connection);
 
@@ -1630,6 +1806,47 @@ int tp_get_idle_thread_count()
 }
 
 
+/**
+  Number of events stolen by workers of a thread group from its siblings.
+  Don't do any locking, it is not required for stats.
+*/
+
+ulonglong tp_get_group_steal_count(uint group)
+{
+  DBUG_ASSERT(group < threadpool_max_size);
+  return all_groups[group].steal_count;
+}
+
+
+/**
+  Statistics of a work queue in a thread group, for
+  INFORMATION_SCHEMA.THREAD_POOL_QUEUES.
+
+  Group mutex is taken to get a consistent snapshot.
+*/
+
+void tp_get_queue_stats(uint group, int prio, TP_QUEUE_STATS *stats)
+{
+  thread_group_t *thread_group= &all_groups[group];
+  DBUG_ASSERT(group < threadpool_max_size);
+  DBUG_ASSERT(prio >= 0 && prio < TP_PRIORITY_COUNT);
+
+  mysql_mutex_lock(&thread_group->mutex);
+  stats->length= thread_group->queues[prio].elements();
+  stats->events= thread_group->queue_stats[prio].events;
+  stats->wait_time= thread_group->queue_stats[prio].wait_time;
+  mysql_mutex_unlock(&thread_group->mutex);
+}
+
+
+/** Current number of active thread groups. */
+
+uint tp_get_group_count()
+{
+  return group_count;
+}
+
+
 /* Report threadpool problems */
 
 /** 
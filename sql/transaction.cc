@@ -23,6 +23,7 @@
 #include "transaction.h"
 #include "rpl_handler.h"
 #include "debug_sync.h"         // DEBUG_SYNC
+#include "sql_expression_cache.h" // publish_table_versions
 #include "sql_acl.h"
 
 /* Conditions under which the transaction state must not change. */
@@ -456,6 +457,7 @@ bool trans_commit_stmt(THD *thd)
     (void) RUN_HOOK(transaction, after_commit, (thd, FALSE));
 
   thd->transaction.stmt.reset();
+  publish_table_versions(thd, FALSE);
 
   DBUG_RETURN(MY_TEST(res));
 }
@@ -496,6 +498,7 @@ bool trans_rollback_stmt(THD *thd)
   (void) RUN_HOOK(transaction, after_rollback, (thd, FALSE));
 
   thd->transaction.stmt.reset();
+  publish_table_versions(thd, FALSE);
 
   DBUG_RETURN(FALSE);
 }
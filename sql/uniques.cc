@@ -84,6 +84,8 @@ Unique::Unique(qsort_cmp2 comp_func, void * comp_func_fixed_arg,
    size(size_arg),
    elements(0)
 {
+  THD *thd= current_thd;
+  merge_threads= thd ? (uint) thd->variables.max_sort_threads : 0;
   min_dupl_count= min_dupl_count_arg;
   full_size= size;
   if (min_dupl_count_arg)
@@ -607,6 +609,73 @@ static bool merge_walk(uchar *merge_buffer, ulong merge_buffer_size,
 }
 
 
+/**
+  Worker threads that do the last merge of a Unique, each with a merge
+  buffer of its own, see merge_index_parallel().
+*/
+
+class Unique_merge_workers
+{
+public:
+  Unique_merge_workers() :buffers(0), parts(0), part_count(0) {}
+  ~Unique_merge_workers() { end(); }
+  bool start(uint count, size_t buff_sz);
+  void end();
+
+  Sort_workers workers;
+  uchar **buffers;
+  BUFFPEK *parts;                       // Result of every part of the merge
+  uint part_count;
+};
+
+
+/**
+  Start the workers and allocate their buffers.
+
+  @retval false  ok
+  @retval true   The merge has to be done by the calling thread
+*/
+
+bool Unique_merge_workers::start(uint count, size_t buff_sz)
+{
+  uint threads, i;
+  if (count < 2 || !(threads= workers.start(count)))
+    return true;
+  if (threads < 2 ||
+      !my_multi_malloc(MYF(MY_THREAD_SPECIFIC | MY_ZEROFILL),
+                       &buffers, threads * sizeof(*buffers),
+                       &parts, threads * sizeof(*parts),
+                       NullS))
+  {
+    end();
+    return true;
+  }
+  for (i= 0; i < threads; i++)
+  {
+    if (!(buffers[i]= (uchar*) my_malloc(buff_sz, MYF(MY_THREAD_SPECIFIC))))
+    {
+      end();
+      return true;
+    }
+  }
+  return false;
+}
+
+
+void Unique_merge_workers::end()
+{
+  if (buffers)
+  {
+    for (uint i= 0; i < workers.threads(); i++)
+      my_free(buffers[i]);
+    my_free(buffers);
+    buffers= 0;
+    parts= 0;
+  }
+  workers.stop();
+}
+
+
 /*
   DESCRIPTION
     Walks consecutively through all unique elements:
@@ -645,22 +714,123 @@ bool Unique::walk(TABLE *table, tree_walk_action action, void *walk_action_arg)
   size_t buff_sz= (max_in_memory_size / full_size + 1) * full_size;
   if (!(merge_buffer = (uchar *)my_malloc(buff_sz, MYF(MY_THREAD_SPECIFIC|MY_WME))))
     return 1;
+  Unique_merge_workers parallel;
+  bool in_parallel= (file_ptrs.elements > 1 &&
+                     buff_sz >= full_size * MERGEBUFF2 &&
+                     !parallel.start(merge_threads, buff_sz));
   if (buff_sz < full_size * (file_ptrs.elements + 1UL))
-    res= merge(table, merge_buffer, buff_sz >= full_size * MERGEBUFF2) ;
+    res= merge(table, merge_buffer, in_parallel ? &parallel : NULL,
+               buff_sz >= full_size * MERGEBUFF2) ;
   
   if (!res)
   {  
-    res= merge_walk(merge_buffer, (ulong) max_in_memory_size, full_size,
-                    (BUFFPEK *) file_ptrs.buffer,
-                    (BUFFPEK *) file_ptrs.buffer + file_ptrs.elements,
-                    action, walk_action_arg,
-                    tree.compare, tree.custom_arg, &file, with_counters);
+    if (in_parallel)
+      res= walk_parallel(&parallel, merge_buffer, action, walk_action_arg);
+    else
+      res= merge_walk(merge_buffer, (ulong) max_in_memory_size, full_size,
+                      (BUFFPEK *) file_ptrs.buffer,
+                      (BUFFPEK *) file_ptrs.buffer + file_ptrs.elements,
+                      action, walk_action_arg,
+                      tree.compare, tree.custom_arg, &file, with_counters);
   }
   my_free(merge_buffer);
   return res;
 }
 
 
+/*
+  DESCRIPTION
+    Do the walk() of the flushed trees with the last merge done by worker
+    threads. Every worker merges the elements of a part of the key space
+    to a temporary file, then the parts are read in order and the action
+    is called for each element.
+  SYNOPSIS
+    Unique::walk_parallel()
+  All params are 'IN':
+    parallel  started workers
+    buff      buffer of full_size bytes for the elements that are read
+    action    function-visitor, typed in include/my_tree.h
+    arg       argument for visitor, which is passed to it on each call
+  RETURN VALUE
+    0    OK
+    <> 0 error
+*/
+
+int Unique::walk_parallel(Unique_merge_workers *parallel, uchar *buff,
+                          tree_walk_action action, void *walk_action_arg)
+{
+  IO_CACHE parts_file;
+  Sort_param sort_param;
+  my_off_t end_of_parts= 0;
+  int res= 1;
+
+  if (open_cached_file(&parts_file, mysql_tmpdir, TEMP_PREFIX,
+                       DISK_BUFFER_SIZE, MYF(MY_WME)))
+    return 1;
+  init_sort_param(&sort_param, NULL, parallel->buffers[0]);
+  if (merge_index_parallel(&sort_param, &parallel->workers,
+                           parallel->buffers, (BUFFPEK*) file_ptrs.buffer,
+                           file_ptrs.elements - 1, &file, &parts_file, 0,
+                           parallel->parts, &parallel->part_count))
+    goto end;
+  for (uint i= 0; i < parallel->part_count; i++)
+    set_if_bigger(end_of_parts, parallel->parts[i].file_pos +
+                                parallel->parts[i].count * full_size);
+
+  for (uint i= 0; i < parallel->part_count; i++)
+  {
+    BUFFPEK *part= parallel->parts + i;
+    if (reinit_io_cache(&parts_file, READ_CACHE, part->file_pos, 0, 0))
+      goto end;
+    parts_file.end_of_file= end_of_parts;
+    for (ha_rows row= 0; row < part->count; row++)
+    {
+      element_count cnt= 1;
+      if (my_b_read(&parts_file, buff, full_size))
+        goto end;
+      if (with_counters)
+        memcpy(&cnt, buff + size, sizeof(cnt));
+      if (action(buff, cnt, walk_action_arg))
+        goto end;
+    }
+  }
+  res= 0;
+end:
+  close_cached_file(&parts_file);
+  return res;
+}
+
+
+/*
+  Set up the Sort_param of a merge of the flushed trees. The duplicates
+  are removed in buff + max_keys_per_buffer * full_size.
+*/
+
+void Unique::init_sort_param(Sort_param *sort_param, TABLE *table,
+                             uchar *buff)
+{
+  bzero((char*) sort_param, sizeof(*sort_param));
+  sort_param->max_rows= elements;
+  sort_param->sort_form= table;
+  sort_param->rec_length= sort_param->sort_length= sort_param->ref_length=
+    full_size;
+  sort_param->min_dupl_count= min_dupl_count;
+  sort_param->res_length= sort_param->rec_length-
+                          (min_dupl_count ? sizeof(min_dupl_count) : 0);
+  sort_param->max_keys_per_buffer=
+    (uint) (max_in_memory_size / sort_param->sort_length);
+  sort_param->not_killable= 1;
+
+  /* Merge workers set unique_buff in their own buffers */
+  sort_param->unique_buff= buff + (sort_param->max_keys_per_buffer *
+                                   sort_param->sort_length);
+
+  sort_param->compare= (qsort2_cmp) buffpek_compare;
+  sort_param->cmp_context.key_compare= tree.compare;
+  sort_param->cmp_context.key_compare_arg= tree.custom_arg;
+}
+
+
 /*
   DESCRIPTION
     Perform multi-pass sort merge of the elements accessed through table->sort,
@@ -671,13 +841,15 @@ bool Unique::walk(TABLE *table, tree_walk_action action, void *walk_action_arg)
   All params are 'IN':
     table               the parameter to access sort context
     buff                merge buffer
+    parallel            started workers that do the merge, or NULL
     without_last_merge  TRUE <=> do not perform the last merge
   RETURN VALUE
     0    OK
     <> 0 error
  */
 
-bool Unique::merge(TABLE *table, uchar *buff, bool without_last_merge)
+bool Unique::merge(TABLE *table, uchar *buff,
+                   Unique_merge_workers *parallel, bool without_last_merge)
 {
   IO_CACHE *outfile= table->sort.io_cache;
   BUFFPEK *file_ptr= (BUFFPEK*) file_ptrs.buffer;
@@ -696,37 +868,28 @@ bool Unique::merge(TABLE *table, uchar *buff, bool without_last_merge)
     return 1;
 
   Sort_param sort_param; 
-  bzero((char*) &sort_param,sizeof(sort_param));
-  sort_param.max_rows= elements;
-  sort_param.sort_form= table;
-  sort_param.rec_length= sort_param.sort_length= sort_param.ref_length=
-   full_size;
-  sort_param.min_dupl_count= min_dupl_count;
-  sort_param.res_length= 0;
-  sort_param.max_keys_per_buffer= 
-    (uint) (max_in_memory_size / sort_param.sort_length);
-  sort_param.not_killable= 1;
-
-  sort_param.unique_buff= buff +(sort_param.max_keys_per_buffer *
-				       sort_param.sort_length);
-
-  sort_param.compare= (qsort2_cmp) buffpek_compare;
-  sort_param.cmp_context.key_compare= tree.compare;
-  sort_param.cmp_context.key_compare_arg= tree.custom_arg;
+  init_sort_param(&sort_param, table, buff);
 
   /* Merge the buffers to one file, removing duplicates */
-  if (merge_many_buff(&sort_param,buff,file_ptr,&maxbuffer,&file))
+  if (parallel ?
+      merge_many_buff_parallel(&sort_param, &parallel->workers,
+                               parallel->buffers, file_ptr, &maxbuffer,
+                               &file) :
+      merge_many_buff(&sort_param,buff,file_ptr,&maxbuffer,&file) != 0)
     goto err;
   if (flush_io_cache(&file) ||
       reinit_io_cache(&file,READ_CACHE,0L,0,0))
     goto err;
-  sort_param.res_length= sort_param.rec_length-
-                         (min_dupl_count ? sizeof(min_dupl_count) : 0);
   if (without_last_merge)
   {
     file_ptrs.elements= maxbuffer+1;
     return 0;
   }
+  if (parallel && maxbuffer > 0)
+  {
+    error= last_merge_parallel(&sort_param, parallel, outfile);
+    goto err;
+  }
   if (merge_index(&sort_param, buff, file_ptr, maxbuffer, &file, outfile))
     goto err;
   error= 0;
@@ -743,6 +906,63 @@ bool Unique::merge(TABLE *table, uchar *buff, bool without_last_merge)
 }
 
 
+/*
+  DESCRIPTION
+    Do the last merge of merge() in worker threads. The parts of the
+    result are written by the workers with gaps for the duplicates that
+    they have removed, and are moved together afterwards.
+  SYNOPSIS
+    Unique::last_merge_parallel()
+    sort_param  as set up by merge()
+    parallel    started workers
+    outfile     the result, positioned after the last element
+  RETURN VALUE
+    0    OK
+    <> 0 error
+*/
+
+bool Unique::last_merge_parallel(Sort_param *sort_param,
+                                 Unique_merge_workers *parallel,
+                                 IO_CACHE *outfile)
+{
+  my_off_t to_pos;
+  uchar *buff= parallel->buffers[0];
+  size_t buff_sz= sort_param->max_keys_per_buffer * sort_param->rec_length;
+
+  if (merge_index_parallel(sort_param, &parallel->workers,
+                           parallel->buffers, (BUFFPEK*) file_ptrs.buffer,
+                           file_ptrs.elements - 1, &file, outfile, 1,
+                           parallel->parts, &parallel->part_count))
+    return 1;
+  to_pos= parallel->part_count ? parallel->parts[0].file_pos : 0;
+  for (uint i= 0; i < parallel->part_count; i++)
+  {
+    BUFFPEK *part= parallel->parts + i;
+    my_off_t from_pos= part->file_pos;
+    my_off_t length= part->count * sort_param->res_length;
+    if (from_pos == to_pos)
+    {
+      to_pos+= length;
+      continue;
+    }
+    while (length)
+    {
+      size_t chunk= (size_t) MY_MIN(length, buff_sz);
+      if (mysql_file_pread(outfile->file, buff, chunk, from_pos,
+                           MYF(MY_WME | MY_NABP)) ||
+          mysql_file_pwrite(outfile->file, buff, chunk, to_pos,
+                            MYF(MY_WME | MY_NABP)))
+        return 1;
+      from_pos+= chunk;
+      to_pos+= chunk;
+      length-= chunk;
+    }
+  }
+  /* Set the end of the output as if it was written through the cache */
+  return reinit_io_cache(outfile, WRITE_CACHE, to_pos, 0, 1);
+}
+
+
 /*
   Modify the TABLE element so that when one calls init_records()
   the rows will be read in priority order.
@@ -777,8 +997,13 @@ bool Unique::get(TABLE *table)
   if (!(sort_buffer= (uchar*) my_malloc(buff_sz, MYF(MY_THREAD_SPECIFIC|MY_WME))))
     return 1;
 
-  if (merge(table, sort_buffer, FALSE))
-    goto err;  
+  {
+    Unique_merge_workers parallel;
+    bool in_parallel= (file_ptrs.elements > 1 &&
+                       !parallel.start(merge_threads, buff_sz));
+    if (merge(table, sort_buffer, in_parallel ? &parallel : NULL, FALSE))
+      goto err;
+  }
   rc= 0;  
 
 err:  
@@ -44,7 +44,7 @@ int heap_check_heap(HP_INFO *info, my_bool print_status)
 {
   int error;
   uint key;
-  ulong records=0, deleted=0, pos, next_block;
+  ulong records=0, deleted=0, chunks=0, pos, next_block;
   HP_SHARE *share=info->s;
   HP_INFO save_info= *info;			/* Needed because scan_init */
   DBUG_ENTER("heap_check_heap");
@@ -53,6 +53,9 @@ int heap_check_heap(HP_INFO *info, my_bool print_status)
   {
     if (share->keydef[key].algorithm == HA_KEY_ALG_BTREE)
       error|= check_one_rb_key(info, key, share->records, print_status);
+    else if (share->keydef[key].hash_layout == HP_HASH_OPEN)
+      error|= hp_ohash_check(share->keydef + key, key, share->records,
+                             print_status);
     else
       error|= check_one_key(share->keydef + key, key, share->records,
 			    share->blength, print_status);
@@ -79,10 +82,15 @@ int heap_check_heap(HP_INFO *info, my_bool print_status)
     }
     hp_find_record(info,pos);
 
-    if (!info->current_ptr[share->reclength])
+    if (!info->current_ptr[share->visible])
       deleted++;
     else
+    {
       records++;
+      if (share->columns)
+        chunks+= hp_varlen_chunks(share,
+                                  info->current_ptr + share->head_length);
+    }
   }
 
   if (records != share->records || deleted != share->deleted)
@@ -92,6 +100,12 @@ int heap_check_heap(HP_INFO *info, my_bool print_status)
                         deleted, (ulong) share->deleted));
     error= 1;
   }
+  if (chunks != share->chunks)
+  {
+    DBUG_PRINT("error",("Found chunks: %lu (%lu)",
+			chunks, (ulong) share->chunks));
+    error= 1;
+  }
   *info= save_info;
   DBUG_RETURN(error);
 }
@@ -21,9 +21,26 @@
 
 int hp_rectest(register HP_INFO *info, register const uchar *old)
 {
+  HP_SHARE *share= info->s;
+  HP_COLUMNDEF *column, *end;
+  uint start;
   DBUG_ENTER("hp_rectest");
 
-  if (memcmp(info->current_ptr,old,(size_t) info->s->reclength))
+  /*
+    Only the head of variable-length records is compared. The pointers of
+    BLOB columns in the head differ in the stored and in the read record.
+  */
+  for (start= 0, column= share->columndef, end= column + share->columns;
+       column < end && column->offset < share->head_length;
+       column++)
+  {
+    if (memcmp(info->current_ptr + start, old + start,
+               (size_t) (column->offset - start)))
+      DBUG_RETURN((my_errno=HA_ERR_RECORD_CHANGED));
+    start= column->offset + column->length;
+  }
+  if (memcmp(info->current_ptr + start, old + start,
+             (size_t) (share->head_length - start)))
   {
     DBUG_RETURN((my_errno=HA_ERR_RECORD_CHANGED)); /* Record have changed */
   }
@@ -34,6 +34,38 @@ static int
 heap_prepare_hp_create_info(TABLE *table_arg, bool internal_table,
                             HP_CREATE_INFO *hp_create_info);
 
+/*
+  LOCK_STRIPES=N lets several connections change the table at the same
+  time, see hp_lock.c. 0 keeps the table-level locking.
+*/
+
+struct ha_table_option_struct
+{
+  ulonglong lock_stripes;
+};
+
+static ha_create_table_option heap_table_option_list[]=
+{
+  HA_TOPTION_NUMBER("LOCK_STRIPES", lock_stripes, 0, 0, 1024, 1),
+  HA_TOPTION_END
+};
+
+/*
+  HASH_LAYOUT=OPEN keeps a HASH index in open addressing buckets instead
+  of hash chains, see hp_ohash.c
+*/
+
+struct ha_index_option_struct
+{
+  uint hash_layout;
+};
+
+static ha_create_table_option heap_index_option_list[]=
+{
+  HA_IOPTION_ENUM("HASH_LAYOUT", hash_layout, "CHAINED,OPEN", 0),
+  HA_IOPTION_END
+};
+
 
 int heap_panic(handlerton *hton, ha_panic_function flag)
 {
@@ -55,6 +87,8 @@ int heap_init(void *p)
   heap_hton->create=     heap_create_handler;
   heap_hton->panic=      heap_panic;
   heap_hton->flags=      HTON_CAN_RECREATE;
+  heap_hton->table_options= heap_table_option_list;
+  heap_hton->index_options= heap_index_option_list;
 
   return 0;
 }
@@ -73,7 +107,7 @@ static handler *heap_create_handler(handlerton *hton,
 
 ha_heap::ha_heap(handlerton *hton, TABLE_SHARE *table_arg)
   :handler(hton, table_arg), file(0), records_changed(0), key_stat_version(0), 
-  internal_table(0)
+  internal_table(0), remember_ptr(0), lock_rows(0)
 {}
 
 /*
@@ -237,6 +271,7 @@ int ha_heap::write_row(uchar * buf)
     if ((res= update_auto_increment()))
       return res;
   }
+  heap_write_lock(file);
   res= heap_write(file,buf);
   if (!res && (++records_changed*HEAP_STATS_UPDATE_THRESHOLD > 
                file->s->records))
@@ -248,12 +283,14 @@ int ha_heap::write_row(uchar * buf)
     records_changed= 0;
     file->s->key_stat_version++;
   }
+  heap_write_unlock(file);
   return res;
 }
 
 int ha_heap::update_row(const uchar * old_data, uchar * new_data)
 {
   int res;
+  heap_write_lock(file);
   res= heap_update(file,old_data,new_data);
   if (!res && ++records_changed*HEAP_STATS_UPDATE_THRESHOLD > 
               file->s->records)
@@ -265,12 +302,14 @@ int ha_heap::update_row(const uchar * old_data, uchar * new_data)
     records_changed= 0;
     file->s->key_stat_version++;
   }
+  heap_write_unlock(file);
   return res;
 }
 
 int ha_heap::delete_row(const uchar * buf)
 {
   int res;
+  heap_write_lock(file);
   res= heap_delete(file,buf);
   if (!res && table->s->tmp_table == NO_TMP_TABLE && 
       ++records_changed*HEAP_STATS_UPDATE_THRESHOLD > file->s->records)
@@ -282,6 +321,7 @@ int ha_heap::delete_row(const uchar * buf)
     records_changed= 0;
     file->s->key_stat_version++;
   }
+  heap_write_unlock(file);
   return res;
 }
 
@@ -290,7 +330,13 @@ int ha_heap::index_read_map(uchar *buf, const uchar *key,
                             enum ha_rkey_function find_flag)
 {
   DBUG_ASSERT(inited==INDEX);
-  int error = heap_rkey(file,buf,active_index, key, keypart_map, find_flag);
+  int error;
+  heap_read_lock(file);
+  do
+    error= heap_rkey(file, buf, active_index, key, keypart_map, find_flag);
+  while (lock_rows && !error &&
+         (error= heap_lock_row(file, buf)) == HA_ERR_RECORD_DELETED);
+  heap_read_unlock(file);
   return error;
 }
 
@@ -298,8 +344,14 @@ int ha_heap::index_read_last_map(uchar *buf, const uchar *key,
                                  key_part_map keypart_map)
 {
   DBUG_ASSERT(inited==INDEX);
-  int error= heap_rkey(file, buf, active_index, key, keypart_map,
-		       HA_READ_PREFIX_LAST);
+  int error;
+  heap_read_lock(file);
+  do
+    error= heap_rkey(file, buf, active_index, key, keypart_map,
+                     HA_READ_PREFIX_LAST);
+  while (lock_rows && !error &&
+         (error= heap_lock_row(file, buf)) == HA_ERR_RECORD_DELETED);
+  heap_read_unlock(file);
   return error;
 }
 
@@ -307,35 +359,65 @@ int ha_heap::index_read_idx_map(uchar *buf, uint index, const uchar *key,
                                 key_part_map keypart_map,
                                 enum ha_rkey_function find_flag)
 {
-  int error = heap_rkey(file, buf, index, key, keypart_map, find_flag);
+  int error;
+  heap_read_lock(file);
+  do
+    error= heap_rkey(file, buf, index, key, keypart_map, find_flag);
+  while (lock_rows && !error &&
+         (error= heap_lock_row(file, buf)) == HA_ERR_RECORD_DELETED);
+  heap_read_unlock(file);
   return error;
 }
 
 int ha_heap::index_next(uchar * buf)
 {
   DBUG_ASSERT(inited==INDEX);
-  int error=heap_rnext(file,buf);
+  int error;
+  heap_read_lock(file);
+  do
+    error= heap_rnext(file, buf);
+  while (lock_rows && !error &&
+         (error= heap_lock_row(file, buf)) == HA_ERR_RECORD_DELETED);
+  heap_read_unlock(file);
   return error;
 }
 
 int ha_heap::index_prev(uchar * buf)
 {
   DBUG_ASSERT(inited==INDEX);
-  int error=heap_rprev(file,buf);
+  int error;
+  heap_read_lock(file);
+  do
+    error= heap_rprev(file, buf);
+  while (lock_rows && !error &&
+         (error= heap_lock_row(file, buf)) == HA_ERR_RECORD_DELETED);
+  heap_read_unlock(file);
   return error;
 }
 
 int ha_heap::index_first(uchar * buf)
 {
   DBUG_ASSERT(inited==INDEX);
-  int error=heap_rfirst(file, buf, active_index);
+  int error;
+  heap_read_lock(file);
+  do
+    error= heap_rfirst(file, buf, active_index);
+  while (lock_rows && !error &&
+         (error= heap_lock_row(file, buf)) == HA_ERR_RECORD_DELETED);
+  heap_read_unlock(file);
   return error;
 }
 
 int ha_heap::index_last(uchar * buf)
 {
   DBUG_ASSERT(inited==INDEX);
-  int error=heap_rlast(file, buf, active_index);
+  int error;
+  heap_read_lock(file);
+  do
+    error= heap_rlast(file, buf, active_index);
+  while (lock_rows && !error &&
+         (error= heap_lock_row(file, buf)) == HA_ERR_RECORD_DELETED);
+  heap_read_unlock(file);
   return error;
 }
 
@@ -344,9 +426,26 @@ int ha_heap::rnd_init(bool scan)
   return scan ? heap_scan_init(file) : 0;
 }
 
+int ha_heap::rnd_end()
+{
+  heap_unlock_row(file);
+  return 0;
+}
+
+int ha_heap::index_end()
+{
+  heap_unlock_row(file);
+  return 0;
+}
+
 int ha_heap::rnd_next(uchar *buf)
 {
-  int error=heap_scan(file, buf);
+  int error;
+  heap_read_lock(file);
+  error= heap_scan(file, buf);
+  if (lock_rows && !error)
+    error= heap_lock_row(file, buf);
+  heap_read_unlock(file);
   return error;
 }
 
@@ -355,7 +454,11 @@ int ha_heap::rnd_pos(uchar * buf, uchar *pos)
   int error;
   HEAP_PTR heap_position;
   memcpy(&heap_position, pos, sizeof(HEAP_PTR));
+  heap_read_lock(file);
   error=heap_rrnd(file, buf, heap_position);
+  if (lock_rows && !error)
+    error= heap_lock_row(file, buf);
+  heap_read_unlock(file);
   return error;
 }
 
@@ -364,6 +467,26 @@ void ha_heap::position(const uchar *record)
   *(HEAP_PTR*) ref= heap_position(file);	// Ref is aligned
 }
 
+int ha_heap::remember_rnd_pos()
+{
+  remember_ptr= file->current_ptr;
+  remember_record= file->current_record;
+  remember_block= file->next_block;
+  return 0;
+}
+
+int ha_heap::restart_rnd_next(uchar *buf)
+{
+  file->current_record= remember_record;
+  file->next_block= remember_block;
+  return heap_rrnd(file, buf, remember_ptr);
+}
+
+void ha_heap::unlock_row()
+{
+  heap_unlock_row(file);
+}
+
 int ha_heap::info(uint flag)
 {
   HEAPINFO hp_info;
@@ -371,6 +494,7 @@ int ha_heap::info(uint flag)
   if (!table)
     return 1;
 
+  heap_read_lock(file);
   (void) heap_info(file,&hp_info,flag);
 
   errkey=                     hp_info.errkey;
@@ -391,6 +515,7 @@ int ha_heap::info(uint flag)
   */
   if (key_stat_version != file->s->key_stat_version)
     update_key_stats();
+  heap_read_unlock(file);
   return 0;
 }
 
@@ -403,12 +528,16 @@ int ha_heap::extra(enum ha_extra_function operation)
 
 int ha_heap::reset()
 {
+  heap_unlock_row(file);
   return heap_reset(file);
 }
 
 
 int ha_heap::delete_all_rows()
 {
+  /* Other statements may use the table, delete the rows one by one */
+  if (lock_rows)
+    return HA_ERR_WRONG_COMMAND;
   heap_clear(file);
   if (table->s->tmp_table == NO_TMP_TABLE)
   {
@@ -431,6 +560,8 @@ int ha_heap::reset_auto_increment(ulonglong value)
 
 int ha_heap::external_lock(THD *thd, int lock_type)
 {
+  if (lock_type == F_UNLCK)
+    heap_unlock_row(file);
   return 0;					// No external locking
 }
 
@@ -542,12 +673,58 @@ int ha_heap::indexes_are_disabled(void)
   return heap_indexes_are_disabled(file);
 }
 
+/*
+  Check if the statement may change a table with LOCK_STRIPES > 0 while
+  other statements use it
+
+  NOTES
+    LOCK TABLES, statements with triggers or stored functions and DDL keep
+    the table lock. So do statements that are written to the binary log,
+    as the log must have the changes of a table in the order they were
+    made.
+*/
+
+static bool heap_concurrent_statement(THD *thd)
+{
+  switch (thd_sql_command(thd)) {
+  case SQLCOM_INSERT:
+  case SQLCOM_INSERT_SELECT:
+  case SQLCOM_REPLACE:
+  case SQLCOM_REPLACE_SELECT:
+  case SQLCOM_UPDATE:
+  case SQLCOM_DELETE:
+  case SQLCOM_LOAD:
+  case SQLCOM_SELECT:
+    break;
+  default:
+    return false;
+  }
+  return (!thd_in_lock_tables(thd) && !thd->lex->requires_prelocking() &&
+          !(mysql_bin_log.is_open() &&
+            (thd->variables.option_bits & OPTION_BIN_LOG)));
+}
+
+
 THR_LOCK_DATA **ha_heap::store_lock(THD *thd,
 				    THR_LOCK_DATA **to,
 				    enum thr_lock_type lock_type)
 {
   if (lock_type != TL_IGNORE && file->lock.type == TL_UNLOCK)
+  {
+    lock_rows= false;
+    if (file->s->lock_stripes && heap_concurrent_statement(thd))
+    {
+      /* Allow other readers and writers, the rows read are locked */
+      if (lock_type >= TL_WRITE_CONCURRENT_INSERT && lock_type <= TL_WRITE)
+      {
+        lock_type= TL_WRITE_ALLOW_WRITE;
+        lock_rows= true;
+      }
+      else if (lock_type == TL_READ_NO_INSERT)
+        lock_type= TL_READ;
+    }
     file->lock.type=lock_type;
+  }
   *to++= &file->lock;
   return to;
 }
@@ -600,12 +777,112 @@ ha_rows ha_heap::records_in_range(uint inx, key_range *min_key,
 }
 
 
+static HP_COLUMNDEF *heap_add_column(HP_COLUMNDEF *columndef,
+                                     HP_COLUMNDEF *column, uint8 type,
+                                     uint offset, uint length)
+{
+  if (type == HP_COLUMN_FIXED && column > columndef &&
+      column[-1].type == HP_COLUMN_FIXED &&
+      column[-1].offset + column[-1].length == offset)
+  {
+    /* Adjacent fixed-length columns are copied together */
+    column[-1].length+= length;
+    return column;
+  }
+  bzero(column, sizeof(*column));
+  column->type= type;
+  column->offset= offset;
+  column->length= length;
+  return column + 1;
+}
+
+
+/*
+  Describe the columns of variable-length records
+
+  SYNOPSIS
+    heap_prepare_columns()
+    table_arg		Table
+    head_length		Bytes of the record kept in the record block
+    columndef		Where to store the columns, 0 to only check if the
+                        table should use variable-length records
+
+  DESCRIPTION
+    The columns after the head of the record and all BLOB columns are
+    stored in the chunks, see hp_dynrec.c. Bytes of the record that do not
+    belong to a column are stored as fixed-length columns.
+
+  RETURN
+    0	Use fixed-length records
+    #	Number of columns in columndef, or the maximum number of columns if
+        columndef is 0
+*/
+
+static uint heap_prepare_columns(TABLE *table_arg, uint head_length,
+                                 HP_COLUMNDEF *columndef)
+{
+  TABLE_SHARE *share= table_arg->s;
+  HP_COLUMNDEF *column= columndef;
+  uint end= head_length, varchar_length= 0;
+
+  for (Field **field= table_arg->field; *field; field++)
+  {
+    uint offset= (uint) ((*field)->ptr - table_arg->record[0]);
+    uint length= (*field)->pack_length();
+    uint8 type= HP_COLUMN_FIXED;
+
+    if ((*field)->flags & BLOB_FLAG)
+      type= HP_COLUMN_BLOB;
+    else if (offset < head_length)
+      continue;
+    else if ((*field)->real_type() == MYSQL_TYPE_VARCHAR)
+    {
+      type= HP_COLUMN_VARCHAR;
+      varchar_length+= length;
+    }
+    if (offset >= head_length)
+    {
+      if (offset < end)
+        return 0;                               // Not in record order
+      if (offset > end && columndef)
+        column= heap_add_column(columndef, column, HP_COLUMN_FIXED, end,
+                                 offset - end);
+      end= offset + length;
+    }
+    if (columndef)
+    {
+      HP_COLUMNDEF *last= column;
+      column= heap_add_column(columndef, column, type, offset, length);
+      if (column != last && type != HP_COLUMN_FIXED)
+      {
+        last->length_bytes= (type == HP_COLUMN_BLOB ?
+                             ((Field_blob*) *field)->pack_length_no_ptr() :
+                             ((Field_varstring*) *field)->length_bytes);
+        if ((*field)->null_ptr)
+        {
+          last->null_bit= (*field)->null_bit;
+          last->null_pos= (uint) ((*field)->null_ptr - table_arg->record[0]);
+        }
+      }
+    }
+  }
+  if (!share->blob_fields && varchar_length < HP_VARLEN_MIN_LENGTH)
+    return 0;
+  if (!columndef)
+    return share->fields * 2 + 1;
+  if (end < share->reclength)
+    column= heap_add_column(columndef, column, HP_COLUMN_FIXED, end,
+                            share->reclength - end);
+  return (uint) (column - columndef);
+}
+
+
 static int
 heap_prepare_hp_create_info(TABLE *table_arg, bool internal_table,
                             HP_CREATE_INFO *hp_create_info)
 {
   uint key, parts, mem_per_row= 0, keys= table_arg->s->keys;
-  uint auto_key= 0, auto_key_type= 0;
+  uint auto_key= 0, auto_key_type= 0, head_length, columns;
   ha_rows max_rows;
   HP_KEYDEF *keydef;
   HA_KEYSEG *seg;
@@ -614,14 +891,34 @@ heap_prepare_hp_create_info(TABLE *table_arg, bool internal_table,
 
   bzero(hp_create_info, sizeof(*hp_create_info));
 
+  /* The key columns are kept in the head of variable-length records */
+  head_length= share->null_bytes;
   for (key= parts= 0; key < keys; key++)
-    parts+= table_arg->key_info[key].user_defined_key_parts;
+  {
+    KEY *pos= table_arg->key_info + key;
+    for (uint i= 0; i < pos->user_defined_key_parts; i++)
+    {
+      Field *field= pos->key_part[i].field;
+      set_if_bigger(head_length, (uint) (field->ptr - table_arg->record[0]) +
+                                 field->pack_length());
+    }
+    parts+= pos->user_defined_key_parts;
+  }
+  columns= heap_prepare_columns(table_arg, head_length, 0);
 
   if (!(keydef= (HP_KEYDEF*) my_malloc(keys * sizeof(HP_KEYDEF) +
-				       parts * sizeof(HA_KEYSEG),
+				       parts * sizeof(HA_KEYSEG) +
+                                       columns * sizeof(HP_COLUMNDEF),
 				       MYF(MY_WME | MY_THREAD_SPECIFIC))))
     return my_errno;
   seg= reinterpret_cast<HA_KEYSEG*>(keydef + keys);
+  if (columns)
+  {
+    hp_create_info->columndef= reinterpret_cast<HP_COLUMNDEF*>(seg + parts);
+    hp_create_info->columns= heap_prepare_columns(table_arg, head_length,
+                                                  hp_create_info->columndef);
+    hp_create_info->head_length= head_length;
+  }
   for (key= 0; key < keys; key++)
   {
     KEY *pos= table_arg->key_info+key;
@@ -631,12 +928,18 @@ heap_prepare_hp_create_info(TABLE *table_arg, bool internal_table,
     keydef[key].keysegs=   (uint) pos->user_defined_key_parts;
     keydef[key].flag=      (pos->flags & (HA_NOSAME | HA_NULL_ARE_EQUAL));
     keydef[key].seg=       seg;
+    keydef[key].hash_layout= HP_HASH_CHAINED;
+    if (!internal_table && pos->option_struct)
+      keydef[key].hash_layout= (uint8) pos->option_struct->hash_layout;
 
     switch (pos->algorithm) {
     case HA_KEY_ALG_UNDEF:
     case HA_KEY_ALG_HASH:
       keydef[key].algorithm= HA_KEY_ALG_HASH;
-      mem_per_row+= sizeof(char*) * 2; // = sizeof(HASH_INFO)
+      if (keydef[key].hash_layout == HP_HASH_OPEN)
+        mem_per_row+= sizeof(HP_HASH_BUCKET) * 2 / HP_HASH_SLOTS;
+      else
+        mem_per_row+= sizeof(char*) * 2; // = sizeof(HASH_INFO)
       break;
     case HA_KEY_ALG_BTREE:
       keydef[key].algorithm= HA_KEY_ALG_BTREE;
@@ -705,7 +1008,11 @@ heap_prepare_hp_create_info(TABLE *table_arg, bool internal_table,
       }
     }
   }
-  mem_per_row+= MY_ALIGN(share->reclength + 1, sizeof(char*));
+  if (columns)
+    mem_per_row+= MY_ALIGN(head_length + HP_VARLEN_REF_LENGTH + 1,
+                           sizeof(char*)) + HP_CHUNK_LENGTH;
+  else
+    mem_per_row+= MY_ALIGN(share->reclength + 1, sizeof(char*));
   if (table_arg->found_next_number_field)
   {
     keydef[share->next_number_index].flag|= HA_AUTO_KEY;
@@ -714,8 +1021,18 @@ heap_prepare_hp_create_info(TABLE *table_arg, bool internal_table,
   hp_create_info->auto_key= auto_key;
   hp_create_info->auto_key_type= auto_key_type;
   hp_create_info->max_table_size=current_thd->variables.max_heap_table_size;
+  /*
+    create_tmp_table() does not limit the number of rows of temporary
+    tables that are likely to get variable-length records, so the memory
+    of internal tables is limited here
+  */
+  if (internal_table)
+    set_if_smaller(hp_create_info->max_table_size,
+                   current_thd->variables.tmp_table_size);
   hp_create_info->with_auto_increment= found_real_auto_increment;
   hp_create_info->internal_table= internal_table;
+  if (!internal_table && share->option_struct)
+    hp_create_info->lock_stripes= (uint) share->option_struct->lock_stripes;
 
   max_rows= (ha_rows) (hp_create_info->max_table_size / mem_per_row);
   if (share->max_rows && share->max_rows < max_rows)
@@ -741,6 +1058,27 @@ int ha_heap::create(const char *name, TABLE *table_arg,
                                      &hp_create_info);
   if (error)
     return error;
+  for (uint key= 0; key < hp_create_info.keys; key++)
+  {
+    HP_KEYDEF *keydef= hp_create_info.keydef + key;
+    if (keydef->algorithm != HA_KEY_ALG_BTREE)
+      continue;
+    if (keydef->hash_layout == HP_HASH_OPEN)
+    {
+      my_free(hp_create_info.keydef);
+      my_error(ER_ILLEGAL_HA_CREATE_OPTION, MYF(0), "MEMORY",
+               "HASH_LAYOUT with BTREE indexes");
+      return HA_WRONG_CREATE_OPTION;
+    }
+    /* The rb-trees can't be searched again after a concurrent change */
+    if (hp_create_info.lock_stripes)
+    {
+      my_free(hp_create_info.keydef);
+      my_error(ER_ILLEGAL_HA_CREATE_OPTION, MYF(0), "MEMORY",
+               "LOCK_STRIPES with BTREE indexes");
+      return HA_WRONG_CREATE_OPTION;
+    }
+  }
   hp_create_info.auto_increment= (create_info->auto_increment_value ?
 				  create_info->auto_increment_value - 1 : 0);
   error= heap_create(name, &hp_create_info, &internal_share, &created);
@@ -762,6 +1100,22 @@ void ha_heap::get_auto_increment(ulonglong offset, ulonglong increment,
                                  ulonglong *first_value,
                                  ulonglong *nb_reserved_values)
 {
+  if (lock_rows)
+  {
+    /* Other writers may insert rows, reserve the values in the share */
+    ulonglong nr;
+    heap_write_lock(file);
+    nr= file->s->auto_increment;
+    if (increment == 1)
+      nr++;
+    else
+      nr= ((nr + increment - offset) / increment) * increment + offset;
+    *first_value= nr;
+    *nb_reserved_values= nb_desired_values;
+    file->s->auto_increment= nr + (nb_desired_values - 1) * increment;
+    heap_write_unlock(file);
+    return;
+  }
   ha_heap::info(HA_STATUS_AUTO);
   *first_value= stats.auto_increment_value;
   /* such table has only table-level locking so reserves up to +inf */
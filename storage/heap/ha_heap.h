@@ -34,6 +34,11 @@ class ha_heap: public handler
   ulong   records_changed;
   uint    key_stat_version;
   my_bool internal_table;
+  /* scan position saved by remember_rnd_pos() */
+  uchar   *remember_ptr;
+  ulong   remember_record, remember_block;
+  /* rows read by the statement are row locked, see hp_lock.c */
+  bool    lock_rows;
 public:
   ha_heap(handlerton *hton, TABLE_SHARE *table);
   ~ha_heap() {}
@@ -43,11 +48,14 @@ class ha_heap: public handler
     return ((table_share->key_info[inx].algorithm == HA_KEY_ALG_BTREE) ?
             "BTREE" : "HASH");
   }
-  /* Rows also use a fixed-size format */
-  enum row_type get_row_type() const { return ROW_TYPE_FIXED; }
+  /* Tables with BLOB or long VARCHAR columns use variable-length rows */
+  enum row_type get_row_type() const
+  {
+    return file && file->s->columns ? ROW_TYPE_DYNAMIC : ROW_TYPE_FIXED;
+  }
   ulonglong table_flags() const
   {
-    return (HA_FAST_KEY_READ | HA_NO_BLOBS | HA_NULL_IN_KEY |
+    return (HA_FAST_KEY_READ | HA_NULL_IN_KEY |
             HA_BINLOG_ROW_CAPABLE | HA_BINLOG_STMT_CAPABLE |
             HA_CAN_SQL_HANDLER |
             HA_REC_NOT_IN_SEQ | HA_CAN_INSERT_DELAYED | HA_NO_TRANSACTIONS |
@@ -87,10 +95,15 @@ class ha_heap: public handler
   int index_prev(uchar * buf);
   int index_first(uchar * buf);
   int index_last(uchar * buf);
+  int index_end();
   int rnd_init(bool scan);
+  int rnd_end();
   int rnd_next(uchar *buf);
   int rnd_pos(uchar * buf, uchar *pos);
   void position(const uchar *record);
+  int remember_rnd_pos();
+  int restart_rnd_next(uchar *buf);
+  void unlock_row();
   int can_continue_handler_scan();
   int info(uint);
   int extra(enum ha_extra_function operation);
@@ -32,6 +32,24 @@ C_MODE_START
 #define HP_MIN_RECORDS_IN_BLOCK 16
 #define HP_MAX_RECORDS_IN_BLOCK 8192
 
+/*
+  Variable-length records (see hp_dynrec.c) keep a reference to their
+  chunks after the head of the record: a pointer to the first chunk and the
+  length of the data stored in the chunks. Each chunk starts with a
+  pointer to the next chunk of the record.
+
+  The format is used for tables with BLOB columns and for tables where the
+  VARCHAR columns outside of the keys could hold at least
+  HP_VARLEN_MIN_LENGTH bytes.
+*/
+
+#define HP_CHUNK_LENGTH 128
+#define HP_VARLEN_REF_LENGTH (sizeof(uchar*) + 4)
+#define HP_VARLEN_MIN_LENGTH 256
+
+/* Most read locks of a table with LOCK_STRIPES (see hp_lock.c) */
+#define HP_MAX_READ_STRIPES 16
+
 	/* Some extern variables */
 
 extern LIST *heap_open_list,*heap_share_list;
@@ -51,6 +69,23 @@ typedef struct st_hp_hash_info
   ulong hash_of_key;
 } HASH_INFO;
 
+/*
+  A bucket of an open hash index fills one cache line. A slot holds the
+  hash value of its key (HP_HASH_EMPTY and HP_HASH_DELETED mark free slots)
+  next to the record pointer, so a lookup seldom reads a wrong record.
+*/
+
+#define HP_HASH_SLOTS		5
+#define HP_HASH_EMPTY		0
+#define HP_HASH_DELETED		1
+#define HP_HASH_BUCKET_ALIGN	64
+
+typedef struct st_hp_hash_bucket
+{
+  uint32 hash_of_key[HP_HASH_SLOTS];
+  uchar *ptr_to_rec[HP_HASH_SLOTS];
+} HP_HASH_BUCKET;
+
 typedef struct {
   HA_KEYSEG *keyseg;
   uint key_length;
@@ -75,6 +110,15 @@ extern int hp_rb_delete_key(HP_INFO *info,HP_KEYDEF *keyinfo,
 			    const uchar *record,uchar *recpos,int flag);
 extern int hp_delete_key(HP_INFO *info,HP_KEYDEF *keyinfo,
 			 const uchar *record,uchar *recpos,int flag);
+extern int hp_ohash_write_key(HP_INFO *info, HP_KEYDEF *keyinfo,
+			      const uchar *record, uchar *recpos);
+extern int hp_ohash_delete_key(HP_INFO *info, HP_KEYDEF *keyinfo,
+			       const uchar *record, uchar *recpos, int flag);
+extern uchar *hp_ohash_search(HP_INFO *info, HP_KEYDEF *keyinfo,
+			      const uchar *key, uint nextflag);
+extern void hp_ohash_free(HP_SHARE *share, HP_KEYDEF *keyinfo);
+extern int hp_ohash_check(HP_KEYDEF *keyinfo, uint keynr, ulong records,
+			  my_bool print_status);
 extern HASH_INFO *_heap_find_hash(HP_BLOCK *block,ulong pos);
 extern uchar *hp_search(HP_INFO *info,HP_KEYDEF *keyinfo,const uchar *key,
 		       uint nextflag);
@@ -97,16 +141,24 @@ extern uint hp_rb_key_length(HP_KEYDEF *keydef, const uchar *key);
 extern uint hp_rb_null_key_length(HP_KEYDEF *keydef, const uchar *key);
 extern uint hp_rb_var_key_length(HP_KEYDEF *keydef, const uchar *key);
 extern my_bool hp_if_null_in_key(HP_KEYDEF *keyinfo, const uchar *record);
+extern int hp_store_varlen(HP_SHARE *share, const uchar *record, uchar *ref);
+extern void hp_free_varlen(HP_SHARE *share, const uchar *ref);
+extern ulong hp_varlen_chunks(HP_SHARE *share, const uchar *ref);
+extern int hp_extract_record(HP_INFO *info, uchar *record, const uchar *pos);
 extern int hp_close(register HP_INFO *info);
 extern void hp_clear(HP_SHARE *info);
 extern void hp_clear_keys(HP_SHARE *info);
 extern uint hp_rb_pack_key(HP_KEYDEF *keydef, uchar *key, const uchar *old,
                            key_part_map keypart_map);
+extern my_bool hp_init_locks(HP_SHARE *share, uint lock_stripes);
+extern void hp_free_locks(HP_SHARE *share);
 
 extern mysql_mutex_t THR_LOCK_heap;
 
 #ifdef HAVE_PSI_INTERFACE
 extern PSI_mutex_key hp_key_mutex_HP_SHARE_intern_lock;
+extern PSI_mutex_key hp_key_mutex_HP_SHARE_row_lock;
+extern PSI_rwlock_key hp_key_rwlock_HP_SHARE_stripe_lock;
 void init_heap_psi_keys();
 #endif /* HAVE_PSI_INTERFACE */
 
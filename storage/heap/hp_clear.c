@@ -35,6 +35,12 @@ void hp_clear(HP_SHARE *info)
     (void) hp_free_level(&info->block,info->block.levels,info->block.root,
 			(uchar*) 0);
   info->block.levels=0;
+  if (info->overflow.levels)
+    (void) hp_free_level(&info->overflow,info->overflow.levels,
+                         info->overflow.root,(uchar*) 0);
+  info->overflow.levels=0;
+  info->chunks= info->deleted_chunks= 0;
+  info->chunk_del_link=0;
   hp_clear_keys(info);
   info->records= info->deleted= 0;
   info->data_length= 0;
@@ -93,6 +99,11 @@ void hp_clear_keys(HP_SHARE *info)
     {
       delete_tree(&keyinfo->rb_tree);
     }
+    else if (keyinfo->hash_layout == HP_HASH_OPEN)
+    {
+      hp_ohash_free(info, keyinfo);
+      keyinfo->hash_buckets= 0;
+    }
     else
     {
       HP_BLOCK *block= &keyinfo->block;
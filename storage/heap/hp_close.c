@@ -35,10 +35,14 @@ int hp_close(register HP_INFO *info)
 {
   int error=0;
   DBUG_ENTER("hp_close");
+  heap_unlock_row(info);
 #ifndef DBUG_OFF
-  if (info->s->changed && heap_check_heap(info,0))
+  if (info->s->changed)
   {
-    error=my_errno=HA_ERR_CRASHED;
+    heap_write_lock(info);
+    if (heap_check_heap(info,0))
+      error=my_errno=HA_ERR_CRASHED;
+    heap_write_unlock(info);
   }
 #endif
   info->s->changed=0;
@@ -46,6 +50,8 @@ int hp_close(register HP_INFO *info)
     heap_open_list=list_delete(heap_open_list,&info->open_list);
   if (!--info->s->open_count && info->s->delete_on_close)
     hp_free(info->s);				/* Table was deleted */
+  my_free(info->rec_buff);
+  my_free(info->found);
   my_free(info);
   DBUG_RETURN(error);
 }
@@ -65,6 +65,9 @@ int heap_create(const char *name, HP_CREATE_INFO *create_info,
     for (i= key_segs= max_length= 0, keyinfo= keydef; i < keys; i++, keyinfo++)
     {
       bzero((char*) &keyinfo->block,sizeof(keyinfo->block));
+      bzero((char*) keyinfo->hash, sizeof(keyinfo->hash));
+      keyinfo->hash_moved= 0;
+      keyinfo->hash_version= 0;
       bzero((char*) &keyinfo->rb_tree ,sizeof(keyinfo->rb_tree));
       for (j= length= 0; j < keyinfo->keysegs; j++)
       {
@@ -146,7 +149,9 @@ int heap_create(const char *name, HP_CREATE_INFO *create_info,
     }
     if (!(share= (HP_SHARE*) my_malloc((uint) sizeof(HP_SHARE)+
 				       keys*sizeof(HP_KEYDEF)+
-				       key_segs*sizeof(HA_KEYSEG),
+				       key_segs*sizeof(HA_KEYSEG)+
+                                       create_info->columns *
+                                       sizeof(HP_COLUMNDEF),
 				       MYF(MY_ZEROFILL |
                                            (create_info->internal_table ?
                                             MY_THREAD_SPECIFIC : 0)))))
@@ -154,7 +159,23 @@ int heap_create(const char *name, HP_CREATE_INFO *create_info,
     share->keydef= (HP_KEYDEF*) (share + 1);
     share->key_stat_version= 1;
     keyseg= (HA_KEYSEG*) (share->keydef + keys);
-    init_block(&share->block, reclength + 1, min_records, max_records);
+    if ((share->columns= create_info->columns))
+    {
+      /*
+        Only the head of the record and the reference to its chunks are
+        stored in the record block, the rest goes to the overflow block
+      */
+      share->columndef= (HP_COLUMNDEF*) (keyseg + key_segs);
+      memcpy(share->columndef, create_info->columndef,
+             (size_t) (sizeof(HP_COLUMNDEF) * create_info->columns));
+      share->head_length= create_info->head_length;
+      share->visible= share->head_length + HP_VARLEN_REF_LENGTH;
+      init_block(&share->overflow, HP_CHUNK_LENGTH, min_records, max_records);
+      share->chunk_length= share->overflow.recbuffer - sizeof(uchar*);
+    }
+    else
+      share->head_length= share->visible= reclength;
+    init_block(&share->block, share->visible + 1, min_records, max_records);
 	/* Fix keys */
     memcpy(share->keydef, keydef, (size_t) (sizeof(keydef[0]) * keys));
     for (i= 0, keyinfo= share->keydef; i < keys; i++, keyinfo++)
@@ -180,6 +201,12 @@ int heap_create(const char *name, HP_CREATE_INFO *create_info,
 	keyinfo->delete_key= hp_rb_delete_key;
 	keyinfo->write_key= hp_rb_write_key;
       }
+      else if (keyinfo->hash_layout == HP_HASH_OPEN)
+      {
+	keyinfo->delete_key= hp_ohash_delete_key;
+	keyinfo->write_key= hp_ohash_write_key;
+        keyinfo->hash_buckets= 0;
+      }
       else
       {
 	init_block(&keyinfo->block, sizeof(HASH_INFO), min_records,
@@ -214,6 +241,13 @@ int heap_create(const char *name, HP_CREATE_INFO *create_info,
 
     if (!create_info->internal_table)
     {
+      if (create_info->lock_stripes &&
+          hp_init_locks(share, create_info->lock_stripes))
+      {
+        my_free(share->name);
+        my_free(share);
+        goto err;
+      }
       thr_lock_init(&share->lock);
       mysql_mutex_init(hp_key_mutex_HP_SHARE_intern_lock,
                        &share->intern_lock, MY_MUTEX_INIT_FAST);
@@ -346,6 +380,7 @@ void hp_free(HP_SHARE *share)
     heap_share_list= list_delete(heap_share_list, &share->open_list);
     thr_lock_delete(&share->lock);
     mysql_mutex_destroy(&share->intern_lock);
+    hp_free_locks(share);
   }
   hp_clear(share);			/* Remove blocks from memory */
   my_free(share->name);
@@ -0,0 +1,338 @@
+/* Copyright (c) 2017, MariaDB Corporation.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+/*
+  Variable-length records.
+
+  The head of the record (all bytes up to the end of the last key column)
+  is stored in the record block like a fixed-length record and is followed
+  by a reference to the chunks with the rest of the record. The columns
+  listed in HP_SHARE::columndef are packed one after another into the
+  chunks: fixed-length columns as they are, VARCHAR columns with their
+  length prefix and only the used bytes, BLOB columns with their length
+  prefix and their data. NULL VARCHAR and BLOB columns are stored as empty.
+
+  When a record is read the chunks are copied to HP_INFO::rec_buff and the
+  columns are unpacked from there, so BLOB columns of the returned record
+  point into rec_buff until the next read with the same handler.
+*/
+
+#include "heapdef.h"
+
+typedef struct st_hp_chunk_pos
+{
+  uchar *chunk, *pos, *end;
+} HP_CHUNK_POS;
+
+static const uchar zero_length[4]= {0, 0, 0, 0};
+
+#define column_is_null(column, record) \
+  ((column)->null_bit && ((record)[(column)->null_pos] & (column)->null_bit))
+
+
+static ulong hp_blob_length(uint length_bytes, const uchar *pos)
+{
+  switch (length_bytes) {
+  case 1:
+    return (ulong) *pos;
+  case 2:
+    return (ulong) uint2korr(pos);
+  case 3:
+    return (ulong) uint3korr(pos);
+  case 4:
+    return (ulong) uint4korr(pos);
+  default:
+    DBUG_ASSERT(0);
+  }
+  return 0;
+}
+
+
+/* Number of bytes the column takes in the chunks */
+
+static ulong hp_column_length(HP_COLUMNDEF *column, const uchar *record)
+{
+  const uchar *pos= record + column->offset;
+
+  switch (column->type) {
+  case HP_COLUMN_VARCHAR:
+    if (column_is_null(column, record))
+      return column->length_bytes;
+    return column->length_bytes +
+           (column->length_bytes == 1 ? (uint) *pos : uint2korr(pos));
+  case HP_COLUMN_BLOB:
+    if (column_is_null(column, record))
+      return column->length_bytes;
+    return column->length_bytes + hp_blob_length(column->length_bytes, pos);
+  default:
+    return column->length;
+  }
+}
+
+
+static uchar *hp_alloc_chunk(HP_SHARE *share)
+{
+  ulong block_pos;
+  size_t length;
+  uchar *chunk;
+
+  if ((chunk= share->chunk_del_link))
+  {
+    share->chunk_del_link= *((uchar**) chunk);
+    share->deleted_chunks--;
+    share->chunks++;
+    return chunk;
+  }
+  if (!(block_pos= (share->chunks % share->overflow.records_in_block)))
+  {
+    if (share->data_length + share->index_length >= share->max_table_size)
+    {
+      DBUG_PRINT("error",
+                 ("record file full. chunks: %lu  data_length: %llu  "
+                  "index_length: %llu  max_table_size: %llu",
+                  share->chunks, share->data_length, share->index_length,
+                  share->max_table_size));
+      my_errno= HA_ERR_RECORD_FILE_FULL;
+      return NULL;
+    }
+    if (hp_get_new_block(share, &share->overflow, &length))
+      return NULL;
+    share->data_length+= length;
+  }
+  share->chunks++;
+  return ((uchar*) share->overflow.level_info[0].last_blocks +
+          block_pos * share->overflow.recbuffer);
+}
+
+
+/* Put a chain of chunks to the list of free chunks */
+
+static void hp_free_chain(HP_SHARE *share, uchar *first)
+{
+  uchar *last;
+  ulong chunks;
+
+  if (!first)
+    return;
+  for (last= first, chunks= 1; *((uchar**) last); chunks++)
+    last= *((uchar**) last);
+  *((uchar**) last)= share->chunk_del_link;
+  share->chunk_del_link= first;
+  share->chunks-= chunks;
+  share->deleted_chunks+= chunks;
+}
+
+
+static void hp_store_data(HP_SHARE *share, HP_CHUNK_POS *to,
+                          const uchar *from, size_t length)
+{
+  while (length)
+  {
+    size_t part;
+    if (to->pos == to->end)
+    {
+      to->chunk= *((uchar**) to->chunk);
+      to->pos= to->chunk + sizeof(uchar*);
+      to->end= to->pos + share->chunk_length;
+    }
+    part= MY_MIN(length, (size_t) (to->end - to->pos));
+    memcpy(to->pos, from, part);
+    to->pos+= part;
+    from+= part;
+    length-= part;
+  }
+}
+
+
+/*
+  Store the columns of a record in new chunks
+
+  SYNOPSIS
+    hp_store_varlen()
+    share		Heap table
+    record		Record to store
+    ref			Where to store the reference to the chunks,
+                        HP_VARLEN_REF_LENGTH bytes
+
+  NOTES
+    All chunks are allocated before anything is stored, so on error no
+    chunks are left allocated.
+
+  RETURN
+    0	ok
+    #	error number
+*/
+
+int hp_store_varlen(HP_SHARE *share, const uchar *record, uchar *ref)
+{
+  HP_COLUMNDEF *column, *end= share->columndef + share->columns;
+  HP_CHUNK_POS to;
+  ulonglong length;
+  ulong chunks;
+  uchar *first= 0, *chunk;
+  DBUG_ENTER("hp_store_varlen");
+
+  for (length= 0, column= share->columndef; column < end; column++)
+    length+= hp_column_length(column, record);
+  if (length > UINT_MAX32)
+    DBUG_RETURN(my_errno= HA_ERR_TO_BIG_ROW);
+
+  for (chunks= (ulong) ((length + share->chunk_length - 1) /
+                        share->chunk_length);
+       chunks ; chunks--)
+  {
+    if (!(chunk= hp_alloc_chunk(share)))
+    {
+      hp_free_chain(share, first);
+      DBUG_RETURN(my_errno);
+    }
+    *((uchar**) chunk)= first;
+    first= chunk;
+  }
+
+  if ((to.chunk= first))
+  {
+    to.pos= first + sizeof(uchar*);
+    to.end= to.pos + share->chunk_length;
+  }
+  else
+    to.pos= to.end= 0;
+  for (column= share->columndef; column < end; column++)
+  {
+    const uchar *pos= record + column->offset;
+    if (column->type == HP_COLUMN_FIXED)
+      hp_store_data(share, &to, pos, column->length);
+    else if (column_is_null(column, record))
+      hp_store_data(share, &to, zero_length, column->length_bytes);
+    else if (column->type == HP_COLUMN_VARCHAR)
+      hp_store_data(share, &to, pos, hp_column_length(column, record));
+    else
+    {
+      const uchar *data;
+      memcpy(&data, pos + column->length_bytes, sizeof(data));
+      hp_store_data(share, &to, pos, column->length_bytes);
+      hp_store_data(share, &to, data,
+                    hp_blob_length(column->length_bytes, pos));
+    }
+  }
+
+  memcpy(ref, &first, sizeof(first));
+  int4store(ref + sizeof(first), (uint32) length);
+  DBUG_RETURN(0);
+}
+
+
+/* Free the chunks of a record */
+
+void hp_free_varlen(HP_SHARE *share, const uchar *ref)
+{
+  uchar *first;
+  memcpy(&first, ref, sizeof(first));
+  hp_free_chain(share, first);
+}
+
+
+/* Number of chunks of a record, used by heap_check_heap() */
+
+ulong hp_varlen_chunks(HP_SHARE *share __attribute__((unused)),
+                       const uchar *ref)
+{
+  uchar *chunk;
+  ulong chunks;
+  memcpy(&chunk, ref, sizeof(chunk));
+  for (chunks= 0; chunk; chunks++)
+    chunk= *((uchar**) chunk);
+  return chunks;
+}
+
+
+/*
+  Copy a stored record to the record buffer of the caller
+
+  SYNOPSIS
+    hp_extract_record()
+    info		Heap handler
+    record		Where to store the record
+    pos			Record in the record block
+
+  RETURN
+    0	ok
+    #	error number
+*/
+
+int hp_extract_record(HP_INFO *info, uchar *record, const uchar *pos)
+{
+  HP_SHARE *share= info->s;
+  HP_COLUMNDEF *column, *end;
+  uchar *chunk, *to;
+  const uchar *from;
+  ulong length, left;
+
+  if (!share->columns)
+  {
+    memcpy(record, pos, (size_t) share->reclength);
+    return 0;
+  }
+
+  memcpy(record, pos, (size_t) share->head_length);
+  memcpy(&chunk, pos + share->head_length, sizeof(chunk));
+  length= uint4korr(pos + share->head_length + sizeof(chunk));
+  if (length > info->rec_buff_length)
+  {
+    size_t new_length= MY_MAX(length, info->rec_buff_length * 2);
+    uchar *buff;
+    if (!(buff= (uchar*) my_realloc(info->rec_buff, new_length,
+                                    MYF(MY_ALLOW_ZERO_PTR |
+                                        (share->internal ?
+                                         MY_THREAD_SPECIFIC : 0)))))
+      return my_errno= HA_ERR_OUT_OF_MEM;
+    info->rec_buff= buff;
+    info->rec_buff_length= new_length;
+  }
+
+  for (to= info->rec_buff, left= length; left; chunk= *((uchar**) chunk))
+  {
+    ulong part= MY_MIN(left, share->chunk_length);
+    memcpy(to, chunk + sizeof(uchar*), part);
+    to+= part;
+    left-= part;
+  }
+
+  for (from= info->rec_buff, column= share->columndef,
+       end= column + share->columns; column < end; column++)
+  {
+    uchar *field= record + column->offset;
+    switch (column->type) {
+    case HP_COLUMN_VARCHAR:
+      length= column->length_bytes +
+              (column->length_bytes == 1 ? (uint) *from : uint2korr(from));
+      memcpy(field, from, length);
+      from+= length;
+      break;
+    case HP_COLUMN_BLOB:
+      length= hp_blob_length(column->length_bytes, from);
+      memcpy(field, from, column->length_bytes);
+      from+= column->length_bytes;
+      memcpy(field + column->length_bytes, &from, sizeof(from));
+      from+= length;
+      break;
+    default:
+      memcpy(field, from, column->length);
+      from+= column->length;
+      break;
+    }
+  }
+  return 0;
+}
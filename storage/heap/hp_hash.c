@@ -104,6 +104,8 @@ uchar *hp_search(HP_INFO *info, HP_KEYDEF *keyinfo, const uchar *key,
   uint old_nextflag;
   HP_SHARE *share=info->s;
   DBUG_ENTER("hp_search");
+  if (keyinfo->hash_layout == HP_HASH_OPEN)
+    DBUG_RETURN(hp_ohash_search(info, keyinfo, key, nextflag));
   old_nextflag=nextflag;
   flag=1;
   prev_ptr=0;
@@ -178,6 +180,8 @@ uchar *hp_search_next(HP_INFO *info, HP_KEYDEF *keyinfo, const uchar *key,
 		      HASH_INFO *pos)
 {
   DBUG_ENTER("hp_search_next");
+  if (keyinfo->hash_layout == HP_HASH_OPEN)
+    DBUG_RETURN(hp_ohash_search(info, keyinfo, key, 1));
 
   while ((pos= pos->next_key))
   {
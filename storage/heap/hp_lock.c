@@ -0,0 +1,171 @@
+/* Copyright (c) 2017, MariaDB Corporation.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+/*
+  Locks of tables created with LOCK_STRIPES > 0.
+
+  Such tables may be used by several writers and readers at the same time,
+  the table lock only keeps out LOCK TABLES and DDL. The blocks and the
+  indexes of the table are protected by up to HP_MAX_READ_STRIPES
+  read/write locks: a reader takes only the stripe of its handler, so
+  readers in different connections seldom touch the same lock, while a
+  writer takes all stripes for the time it changes one row.
+
+  A handler that reads rows for a change takes the row lock of the row it
+  has read and keeps it until it reads the next row or ends the scan, so
+  the row can't be changed between the read and the update. There are
+  lock_stripes row locks, striped by the position of the record. A handler
+  holds at most one row lock and never waits for a row lock while it holds
+  a stripe lock, which makes deadlocks impossible.
+*/
+
+#include "heapdef.h"
+
+#define row_lock_of(share, pos) \
+  ((share)->row_lock + \
+   ((size_t) (pos) / (share)->block.recbuffer) % (share)->lock_stripes)
+
+
+my_bool hp_init_locks(HP_SHARE *share, uint lock_stripes)
+{
+  uint i, read_stripes= MY_MIN(lock_stripes, HP_MAX_READ_STRIPES);
+  if (!(share->stripe_lock= (mysql_rwlock_t*)
+        my_malloc(read_stripes * sizeof(mysql_rwlock_t), MYF(MY_WME))))
+    return 1;
+  if (!(share->row_lock= (mysql_mutex_t*)
+        my_malloc(lock_stripes * sizeof(mysql_mutex_t), MYF(MY_WME))))
+  {
+    my_free(share->stripe_lock);
+    return 1;
+  }
+  for (i= 0; i < read_stripes; i++)
+    mysql_rwlock_init(hp_key_rwlock_HP_SHARE_stripe_lock,
+                      share->stripe_lock + i);
+  for (i= 0; i < lock_stripes; i++)
+    mysql_mutex_init(hp_key_mutex_HP_SHARE_row_lock, share->row_lock + i,
+                     MY_MUTEX_INIT_FAST);
+  share->read_stripes= read_stripes;
+  share->lock_stripes= lock_stripes;
+  return 0;
+}
+
+
+void hp_free_locks(HP_SHARE *share)
+{
+  uint i;
+  for (i= 0; i < share->read_stripes; i++)
+    mysql_rwlock_destroy(share->stripe_lock + i);
+  for (i= 0; i < share->lock_stripes; i++)
+    mysql_mutex_destroy(share->row_lock + i);
+  my_free(share->stripe_lock);
+  my_free(share->row_lock);
+  share->read_stripes= share->lock_stripes= 0;
+}
+
+
+void heap_read_lock(HP_INFO *info)
+{
+  if (info->s->lock_stripes)
+    mysql_rwlock_rdlock(info->s->stripe_lock + info->lock_stripe);
+}
+
+
+void heap_read_unlock(HP_INFO *info)
+{
+  if (info->s->lock_stripes)
+    mysql_rwlock_unlock(info->s->stripe_lock + info->lock_stripe);
+}
+
+
+void heap_write_lock(HP_INFO *info)
+{
+  HP_SHARE *share= info->s;
+  uint i;
+  for (i= 0; i < share->read_stripes; i++)
+    mysql_rwlock_wrlock(share->stripe_lock + i);
+}
+
+
+void heap_write_unlock(HP_INFO *info)
+{
+  HP_SHARE *share= info->s;
+  uint i;
+  for (i= share->read_stripes; i-- > 0; )
+    mysql_rwlock_unlock(share->stripe_lock + i);
+}
+
+
+/*
+  Lock the row last read by the handler
+
+  SYNOPSIS
+    heap_lock_row()
+    info		Heap handler, the read lock must be held
+    record		The row as it was read
+
+  NOTES
+    The row lock of the previous row is released. If the row lock is
+    taken by another handler, the read lock is released while waiting
+    for it and the row is read again. A row found by a key that no longer
+    matches the key is treated as deleted.
+
+  RETURN
+    0				ok
+    HA_ERR_RECORD_DELETED	The row was deleted while waiting
+    #				error number
+*/
+
+int heap_lock_row(HP_INFO *info, uchar *record)
+{
+  HP_SHARE *share= info->s;
+  uchar *pos= info->current_ptr;
+  mysql_mutex_t *lock;
+  DBUG_ENTER("heap_lock_row");
+
+  heap_unlock_row(info);
+  if (!share->lock_stripes)
+    DBUG_RETURN(0);
+  lock= row_lock_of(share, pos);
+  if (mysql_mutex_trylock(lock))
+  {
+    heap_read_unlock(info);
+    mysql_mutex_lock(lock);
+    heap_read_lock(info);
+    if (!pos[share->visible] ||
+        (info->lastinx >= 0 &&
+         hp_key_cmp(share->keydef + info->lastinx, pos, info->lastkey)))
+    {
+      mysql_mutex_unlock(lock);
+      DBUG_RETURN(my_errno= HA_ERR_RECORD_DELETED);
+    }
+    if (hp_extract_record(info, record, pos))
+    {
+      mysql_mutex_unlock(lock);
+      DBUG_RETURN(my_errno);
+    }
+  }
+  info->locked_row= lock;
+  DBUG_RETURN(0);
+}
+
+
+void heap_unlock_row(HP_INFO *info)
+{
+  if (info->locked_row)
+  {
+    mysql_mutex_unlock(info->locked_row);
+    info->locked_row= 0;
+  }
+}
@@ -0,0 +1,654 @@
+/* Copyright (c) 2017, MariaDB Corporation.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+/*
+  HASH indexes created with HASH_LAYOUT=OPEN
+
+  The keys are kept in one array of cache line sized buckets instead of
+  the HASH_INFO chains of hp_write_key(). A key goes to the first bucket
+  with a free slot, starting from its home bucket (linear probing). Every
+  slot holds the hash value of its key, so a search compares only the
+  records of the slots with the same hash value, and the keys can be
+  moved to a new array without reading the records.
+
+  A search reads the buckets from the home bucket on, until it has read
+  max_probe buckets or a bucket with an empty slot: a key is never stored
+  after a bucket that had an empty slot when the key was written. For the
+  same reason a deleted key leaves an empty slot if its bucket has one;
+  in a full bucket the slot is only marked as deleted.
+
+  The array is resized when it gets 3/4 full or less than 1/16 used. The
+  old array is kept in hash[1] and every following change of the index
+  moves a few of its buckets to the new one, so that no single insert
+  pays for rehashing the whole index. Until the old array
+  is empty, searches read both arrays.
+*/
+
+#include "heapdef.h"
+
+#define HP_HASH_MIN_BUCKETS	16
+#define HP_HASH_MOVE_BUCKETS	4
+
+
+/* Mix the bits of hp_hashnr(), the values of free slots are not used */
+
+static inline uint32 hp_ohash_value(ulong hashnr)
+{
+  uint32 hash= (uint32) (((ulonglong) hashnr * 0x9E3779B97F4A7C15ULL) >> 32);
+  return hash > HP_HASH_DELETED ? hash : hash + 2;
+}
+
+
+static inline HP_HASH_BUCKET *hp_ohash_bucket(HP_HASH_TABLE *table,
+                                              HP_HASH_POS *pos)
+{
+  return table->bucket + ((pos->home + pos->probe) & (table->size - 1));
+}
+
+
+static inline my_bool hp_ohash_has_empty(HP_HASH_BUCKET *bucket)
+{
+  uint i;
+  for (i= 0; i < HP_HASH_SLOTS; i++)
+    if (bucket->hash_of_key[i] == HP_HASH_EMPTY)
+      return 1;
+  return 0;
+}
+
+
+static void hp_ohash_start(HP_KEYDEF *keyinfo, uint32 hash, HP_HASH_POS *pos)
+{
+  pos->table= 0;
+  pos->home= hash & (keyinfo->hash[0].size - 1);
+  pos->probe= 0;
+  pos->slot= -1;
+}
+
+
+/*
+  Find the next slot with the hash value
+
+  SYNOPSIS
+    hp_ohash_next()
+    keyinfo		Key definition
+    hash		Value from hp_ohash_value()
+    pos			Last slot found, from hp_ohash_start() for the first
+
+  NOTES
+    The probe sequence of hash[0] is followed by that of hash[1]
+
+  RETURN
+    The record of the slot, 0 if there are no more
+*/
+
+static uchar *hp_ohash_next(HP_KEYDEF *keyinfo, uint32 hash, HP_HASH_POS *pos)
+{
+  for (;;)
+  {
+    HP_HASH_TABLE *table= keyinfo->hash + pos->table;
+    if (table->bucket)
+    {
+      HP_HASH_BUCKET *bucket= hp_ohash_bucket(table, pos);
+      while (++pos->slot < HP_HASH_SLOTS)
+      {
+        if (bucket->hash_of_key[pos->slot] == hash)
+          return bucket->ptr_to_rec[pos->slot];
+      }
+      if (pos->probe < table->max_probe && !hp_ohash_has_empty(bucket))
+      {
+        pos->probe++;
+        pos->slot= -1;
+        continue;
+      }
+    }
+    if (pos->table || !keyinfo->hash[1].entries)
+      return 0;
+    pos->table= 1;
+    pos->home= hash & (keyinfo->hash[1].size - 1);
+    pos->probe= 0;
+    pos->slot= -1;
+  }
+}
+
+
+/* Put a key into a table that has a free slot */
+
+static void hp_ohash_insert(HP_HASH_TABLE *table, uint32 hash, uchar *recpos)
+{
+  ulong home= hash & (table->size - 1), probe;
+  for (probe= 0; probe < table->size; probe++)
+  {
+    HP_HASH_BUCKET *bucket= table->bucket + ((home + probe) &
+                                             (table->size - 1));
+    uint i;
+    for (i= 0; i < HP_HASH_SLOTS; i++)
+    {
+      if (bucket->hash_of_key[i] <= HP_HASH_DELETED)
+      {
+        if (bucket->hash_of_key[i] == HP_HASH_DELETED)
+          table->deleted--;
+        bucket->hash_of_key[i]= hash;
+        bucket->ptr_to_rec[i]= recpos;
+        table->entries++;
+        set_if_bigger(table->max_probe, probe);
+        return;
+      }
+    }
+  }
+  DBUG_ASSERT(0);                               /* hp_ohash_reserve() */
+}
+
+
+/* Number of buckets to keep keys at most half full */
+
+static ulong hp_ohash_size(ulong keys)
+{
+  ulong size= HP_HASH_MIN_BUCKETS;
+  while (size * HP_HASH_SLOTS < keys * 2)
+    size*= 2;
+  return size;
+}
+
+
+static size_t hp_ohash_length(ulong size)
+{
+  return size * sizeof(HP_HASH_BUCKET) + HP_HASH_BUCKET_ALIGN - 1;
+}
+
+
+static int hp_ohash_alloc(HP_SHARE *share, HP_HASH_TABLE *table, ulong size)
+{
+  size_t length= hp_ohash_length(size);
+  if (!(table->alloc= (uchar*) my_malloc(length,
+                                         MYF(MY_ZEROFILL |
+                                             (share->internal ?
+                                              MY_THREAD_SPECIFIC : 0)))))
+    return my_errno= HA_ERR_OUT_OF_MEM;
+  table->bucket= (HP_HASH_BUCKET*) MY_ALIGN((size_t) table->alloc,
+                                            HP_HASH_BUCKET_ALIGN);
+  table->size= size;
+  table->max_probe= table->entries= table->deleted= 0;
+  share->index_length+= length;
+  return 0;
+}
+
+
+static void hp_ohash_free_table(HP_SHARE *share, HP_HASH_TABLE *table)
+{
+  if (table->alloc)
+  {
+    my_free(table->alloc);
+    share->index_length-= hp_ohash_length(table->size);
+  }
+  bzero((char*) table, sizeof(*table));
+}
+
+
+void hp_ohash_free(HP_SHARE *share, HP_KEYDEF *keyinfo)
+{
+  hp_ohash_free_table(share, keyinfo->hash);
+  hp_ohash_free_table(share, keyinfo->hash + 1);
+  keyinfo->hash_moved= 0;
+  keyinfo->hash_version++;
+}
+
+
+/* Move the keys of a bucket to another table */
+
+static void hp_ohash_move_bucket(HP_HASH_TABLE *to, HP_HASH_TABLE *from,
+                                 HP_HASH_BUCKET *bucket)
+{
+  uint i;
+  for (i= 0; i < HP_HASH_SLOTS; i++)
+  {
+    if (bucket->hash_of_key[i] > HP_HASH_DELETED)
+    {
+      hp_ohash_insert(to, bucket->hash_of_key[i], bucket->ptr_to_rec[i]);
+      /* Keep the probe sequences of the keys not yet moved */
+      bucket->hash_of_key[i]= HP_HASH_DELETED;
+      from->entries--;
+      from->deleted++;
+    }
+  }
+}
+
+
+/* Move some buckets of hash[1] to hash[0] */
+
+static void hp_ohash_move(HP_SHARE *share, HP_KEYDEF *keyinfo, ulong buckets)
+{
+  HP_HASH_TABLE *old= keyinfo->hash + 1;
+  ulong end= MY_MIN(keyinfo->hash_moved + buckets, old->size);
+
+  for (; keyinfo->hash_moved < end; keyinfo->hash_moved++)
+    hp_ohash_move_bucket(keyinfo->hash, old,
+                         old->bucket + keyinfo->hash_moved);
+  if (!old->entries)
+  {
+    hp_ohash_free_table(share, old);
+    keyinfo->hash_moved= 0;
+  }
+  keyinfo->hash_version++;
+}
+
+
+/*
+  Buckets to move for every change of the index. A shrinking index moves
+  more, to be done before the smaller table gets full.
+*/
+
+static ulong hp_ohash_move_step(HP_KEYDEF *keyinfo)
+{
+  return MY_MAX(HP_HASH_MOVE_BUCKETS,
+                keyinfo->hash[1].size / keyinfo->hash[0].size);
+}
+
+
+/* Start moving the keys to a table of size buckets */
+
+static int hp_ohash_resize(HP_SHARE *share, HP_KEYDEF *keyinfo, ulong size)
+{
+  HP_HASH_TABLE table;
+  DBUG_ENTER("hp_ohash_resize");
+  DBUG_PRINT("info", ("buckets: %lu -> %lu  keys: %lu", keyinfo->hash[0].size,
+                      size, keyinfo->hash[0].entries));
+  DBUG_ASSERT(!keyinfo->hash[1].bucket);
+
+  if (hp_ohash_alloc(share, &table, size))
+    DBUG_RETURN(my_errno);
+  keyinfo->hash[1]= keyinfo->hash[0];
+  keyinfo->hash[0]= table;
+  keyinfo->hash_moved= 0;
+  keyinfo->hash_version++;
+  if (!keyinfo->hash[1].entries)
+    hp_ohash_free_table(share, keyinfo->hash + 1);
+  DBUG_RETURN(0);
+}
+
+
+/*
+  Move all keys to a new table at once. Used if the keys of hash[1] don't
+  fit into hash[0], which can only happen if many keys were deleted while
+  they were moved.
+*/
+
+static int hp_ohash_rebuild(HP_SHARE *share, HP_KEYDEF *keyinfo)
+{
+  HP_HASH_TABLE table;
+  uint t;
+  ulong b;
+
+  if (hp_ohash_alloc(share, &table,
+                     hp_ohash_size(keyinfo->hash[0].entries +
+                                   keyinfo->hash[1].entries + 1)))
+    return my_errno;
+  for (t= 0; t < 2; t++)
+  {
+    HP_HASH_TABLE *from= keyinfo->hash + t;
+    for (b= 0; b < from->size; b++)
+      hp_ohash_move_bucket(&table, from, from->bucket + b);
+    hp_ohash_free_table(share, from);
+  }
+  keyinfo->hash[0]= table;
+  keyinfo->hash_moved= 0;
+  keyinfo->hash_version++;
+  return 0;
+}
+
+
+/* Make room for one more key in hash[0] */
+
+static int hp_ohash_reserve(HP_SHARE *share, HP_KEYDEF *keyinfo)
+{
+  HP_HASH_TABLE *table= keyinfo->hash;
+  ulong slots= table->size * HP_HASH_SLOTS;
+
+  if (!table->bucket)
+    return hp_ohash_alloc(share, table, hp_ohash_size(share->min_records));
+  if (keyinfo->hash[1].bucket)
+    hp_ohash_move(share, keyinfo, hp_ohash_move_step(keyinfo));
+  if ((table->entries + table->deleted + 1) * 4 <= slots * 3)
+    return 0;
+  if (keyinfo->hash[1].bucket)
+  {
+    if (table->entries + table->deleted + keyinfo->hash[1].entries >= slots)
+      return hp_ohash_rebuild(share, keyinfo);
+    hp_ohash_move(share, keyinfo, keyinfo->hash[1].size);
+  }
+  return hp_ohash_resize(share, keyinfo, hp_ohash_size(table->entries + 1));
+}
+
+
+/*
+  Add a key to an open hash index
+
+  SYNOPSIS
+    hp_ohash_write_key()
+    info		Heap handler
+    keyinfo		Key definition
+    record		Row with the key
+    recpos		Position of the row in the record block
+
+  RETURN
+    0				ok
+    HA_ERR_FOUND_DUPP_KEY	The key of a unique index exists
+    HA_ERR_OUT_OF_MEM		Could not resize the index
+*/
+
+int hp_ohash_write_key(HP_INFO *info, HP_KEYDEF *keyinfo,
+                       const uchar *record, uchar *recpos)
+{
+  HP_SHARE *share= info->s;
+  uint32 hash= hp_ohash_value(hp_rec_hashnr(keyinfo, record));
+  my_bool check_dupp= ((keyinfo->flag & HA_NOSAME) &&
+                       (!(keyinfo->flag & HA_NULL_PART_KEY) ||
+                        !hp_if_null_in_key(keyinfo, record)));
+  my_bool same_key= 0;
+  HP_HASH_POS pos;
+  uchar *found;
+  DBUG_ENTER("hp_ohash_write_key");
+
+  hp_ohash_start(keyinfo, hash, &pos);
+  while ((found= hp_ohash_next(keyinfo, hash, &pos)))
+  {
+    if (check_dupp && !hp_rec_key_cmp(keyinfo, record, found, 1))
+      DBUG_RETURN(my_errno= HA_ERR_FOUND_DUPP_KEY);
+    if (!same_key && !hp_rec_key_cmp(keyinfo, record, found, 0))
+    {
+      same_key= 1;
+      if (!check_dupp)
+        break;
+    }
+  }
+  if (hp_ohash_reserve(share, keyinfo))
+    DBUG_RETURN(my_errno);
+  hp_ohash_insert(keyinfo->hash, hash, recpos);
+  if (!same_key)
+    keyinfo->hash_buckets++;
+  DBUG_RETURN(0);
+}
+
+
+/*
+  Remove a key from an open hash index
+
+  SYNOPSIS
+    hp_ohash_delete_key()
+    info		Heap handler
+    keyinfo		Key definition
+    record		Row with the key
+    recpos		Position of the row in the record block
+    flag		Set if info->current_ptr should be moved to the
+			previous row with the key, for heap_rnext()
+
+  NOTES
+    The keys are not moved when flag is set, heap_rnext() continues
+    from the position of the previous row.
+*/
+
+int hp_ohash_delete_key(HP_INFO *info, HP_KEYDEF *keyinfo,
+                        const uchar *record, uchar *recpos, int flag)
+{
+  HP_SHARE *share= info->s;
+  uint32 hash= hp_ohash_value(hp_rec_hashnr(keyinfo, record));
+  HP_HASH_POS pos, prev_pos;
+  HP_HASH_TABLE *table;
+  HP_HASH_BUCKET *bucket;
+  uchar *found, *prev= 0;
+  DBUG_ENTER("hp_ohash_delete_key");
+
+  hp_ohash_start(keyinfo, hash, &pos);
+  prev_pos= pos;
+  while ((found= hp_ohash_next(keyinfo, hash, &pos)) != recpos)
+  {
+    if (!found)
+      DBUG_RETURN(my_errno= HA_ERR_CRASHED);	/* This shouldn't happend */
+    if (!hp_rec_key_cmp(keyinfo, record, found, 0))
+    {
+      prev= found;
+      prev_pos= pos;
+    }
+  }
+
+  table= keyinfo->hash + pos.table;
+  bucket= hp_ohash_bucket(table, &pos);
+  if (hp_ohash_has_empty(bucket))
+    bucket->hash_of_key[pos.slot]= HP_HASH_EMPTY;
+  else
+  {
+    bucket->hash_of_key[pos.slot]= HP_HASH_DELETED;
+    table->deleted++;
+  }
+  bucket->ptr_to_rec[pos.slot]= 0;
+  table->entries--;
+
+  if (!prev)
+  {
+    /* Was it the last row with the key? */
+    while ((found= hp_ohash_next(keyinfo, hash, &pos)) &&
+           hp_rec_key_cmp(keyinfo, record, found, 0))
+    {}
+    if (!found)
+      keyinfo->hash_buckets--;
+  }
+
+  if (flag)
+  {
+    /* Save for heap_rnext/heap_rprev */
+    info->current_ptr= prev;
+    info->hash_keydef= keyinfo;
+    info->hash_pos= prev_pos;
+    info->hash_version= keyinfo->hash_version;
+    DBUG_RETURN(0);
+  }
+  if (keyinfo->hash[1].bucket)
+    hp_ohash_move(share, keyinfo, hp_ohash_move_step(keyinfo));
+  else if (keyinfo->hash[0].size > HP_HASH_MIN_BUCKETS &&
+           keyinfo->hash[0].entries * 16 <
+           keyinfo->hash[0].size * HP_HASH_SLOTS)
+    (void) hp_ohash_resize(share, keyinfo,
+                           hp_ohash_size(keyinfo->hash[0].entries));
+  DBUG_RETURN(0);
+}
+
+
+/* Check if info->hash_pos is still the position of info->current_ptr */
+
+static my_bool hp_ohash_at_current(HP_INFO *info, HP_KEYDEF *keyinfo)
+{
+  HP_HASH_TABLE *table= keyinfo->hash + info->hash_pos.table;
+  return (info->hash_keydef == keyinfo &&
+          info->hash_version == keyinfo->hash_version &&
+          info->current_ptr && table->bucket &&
+          hp_ohash_bucket(table, &info->hash_pos)->
+            ptr_to_rec[info->hash_pos.slot] == info->current_ptr);
+}
+
+
+/*
+  Search in an open hash index, like hp_search()
+
+  SYNOPSIS
+    hp_ohash_search()
+    info		Heap handler
+    keyinfo		Key definition
+    key			Key to search for
+    nextflag		Search=0, next=1, prev=2, same=3 from current_ptr
+
+  NOTES
+    Sets info->current_ptr to the found row. Its position is remembered,
+    so that reading the next row does not need to find current_ptr again
+    unless keys were moved since.
+*/
+
+uchar *hp_ohash_search(HP_INFO *info, HP_KEYDEF *keyinfo, const uchar *key,
+                       uint nextflag)
+{
+  uint32 hash;
+  HP_HASH_POS pos, prev_pos;
+  uchar *found, *prev= 0;
+  DBUG_ENTER("hp_ohash_search");
+
+  info->current_hash_ptr= 0;
+  if (nextflag == 1 && hp_ohash_at_current(info, keyinfo))
+  {
+    pos= info->hash_pos;
+    hash= hp_ohash_bucket(keyinfo->hash + pos.table, &pos)->
+            hash_of_key[pos.slot];
+  }
+  else
+  {
+    hash= hp_ohash_value(hp_hashnr(keyinfo, key));
+    hp_ohash_start(keyinfo, hash, &pos);
+    prev_pos= pos;
+    if (nextflag)
+    {
+      while ((found= hp_ohash_next(keyinfo, hash, &pos)))
+      {
+        if (hp_key_cmp(keyinfo, found, key))
+          continue;
+        if (found == info->current_ptr)
+          break;
+        prev= found;
+        prev_pos= pos;
+      }
+      if (nextflag == 2 && (found || !info->current_ptr))
+      {
+        /* Previous row, or the last one if there is no current row */
+        if (!prev)
+        {
+          my_errno= HA_ERR_KEY_NOT_FOUND;
+          info->hash_keydef= 0;
+          DBUG_RETURN(info->current_ptr= 0);
+        }
+        found= prev;
+        pos= prev_pos;
+      }
+      else if (!found)
+      {
+        my_errno= HA_ERR_RECORD_CHANGED;	/* Didn't find old record */
+        info->hash_keydef= 0;
+        DBUG_RETURN(info->current_ptr= 0);
+      }
+      if (nextflag != 1)
+        goto end;
+    }
+  }
+  while ((found= hp_ohash_next(keyinfo, hash, &pos)))
+  {
+    if (!hp_key_cmp(keyinfo, found, key))
+      goto end;
+  }
+  my_errno= HA_ERR_KEY_NOT_FOUND;
+  info->hash_keydef= 0;
+  DBUG_RETURN(info->current_ptr= 0);
+
+end:
+  info->hash_keydef= keyinfo;
+  info->hash_pos= pos;
+  info->hash_version= keyinfo->hash_version;
+  DBUG_RETURN(info->current_ptr= found);
+}
+
+
+/*
+  Check an open hash index, for heap_check_heap()
+
+  Every key must have the hash value of its row and be found from its home
+  bucket. hash_buckets must be the number of different keys.
+*/
+
+int hp_ohash_check(HP_KEYDEF *keyinfo, uint keynr, ulong records,
+                   my_bool print_status)
+{
+  int error= 0;
+  uint t, i;
+  ulong found= 0, distinct= 0, probes= 0, max_probe= 0, b;
+
+  for (t= 0; t < 2; t++)
+  {
+    HP_HASH_TABLE *table= keyinfo->hash + t;
+    ulong entries= 0, deleted= 0;
+    for (b= 0; b < table->size; b++)
+    {
+      HP_HASH_BUCKET *bucket= table->bucket + b;
+      for (i= 0; i < HP_HASH_SLOTS; i++)
+      {
+        uint32 hash= bucket->hash_of_key[i];
+        uchar *rec= bucket->ptr_to_rec[i], *other;
+        my_bool first= 1;
+        HP_HASH_POS pos;
+
+        if (hash == HP_HASH_DELETED)
+          deleted++;
+        if (hash <= HP_HASH_DELETED)
+          continue;
+        entries++;
+        if (hash != hp_ohash_value(hp_rec_hashnr(keyinfo, rec)))
+        {
+          DBUG_PRINT("error", ("Found key with wrong hash in bucket %lu", b));
+          error= 1;
+          continue;
+        }
+        hp_ohash_start(keyinfo, hash, &pos);
+        while ((other= hp_ohash_next(keyinfo, hash, &pos)) != rec)
+        {
+          if (!other)
+          {
+            DBUG_PRINT("error", ("Key in bucket %lu can't be found", b));
+            error= 1;
+            break;
+          }
+          if (!hp_rec_key_cmp(keyinfo, rec, other, 0))
+            first= 0;
+        }
+        if (other && first)
+          distinct++;
+        probes+= pos.probe + 1;
+        set_if_bigger(max_probe, pos.probe);
+      }
+    }
+    if (entries != table->entries || deleted != table->deleted)
+    {
+      DBUG_PRINT("error", ("Table %u has %lu keys (%lu) %lu deleted (%lu)",
+                           t, entries, table->entries,
+                           deleted, table->deleted));
+      error= 1;
+    }
+    found+= entries;
+  }
+  if (found != records)
+  {
+    DBUG_PRINT("error",("Found %ld of %ld records", found, records));
+    error= 1;
+  }
+  if (keyinfo->hash_buckets != distinct)
+  {
+    DBUG_PRINT("error",("Found %lu keys, stats shows %lu keys",
+                        distinct, (ulong) keyinfo->hash_buckets));
+    error= 1;
+  }
+  DBUG_PRINT("info",
+             ("key: %u  records: %lu  buckets: %lu  probes: %lu  "
+              "max probe: %lu  keys: %lu",
+              keynr, records, keyinfo->hash[0].size, probes, max_probe,
+              distinct));
+  if (print_status)
+    printf("Key: %u  records: %lu  buckets: %lu  probes: %lu  "
+           "max probe: %lu  keys: %lu\n",
+           keynr, records, keyinfo->hash[0].size, probes, max_probe,
+           distinct);
+  return error;
+}
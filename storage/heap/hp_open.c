@@ -39,6 +39,8 @@ HP_INFO *heap_open_from_share(HP_SHARE *share, int mode)
     DBUG_RETURN(0);
   }
   share->open_count++; 
+  if (share->lock_stripes)
+    info->lock_stripe= share->open_count % share->read_stripes;
   thr_lock_data_init(&share->lock,&info->lock,NULL);
   info->s= share;
   info->lastkey= (uchar*) (info + 1);
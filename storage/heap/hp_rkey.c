@@ -16,6 +16,38 @@
 
 #include "heapdef.h"
 
+/*
+  Remember all rows with the key for heap_rnext(). Used for tables with
+  LOCK_STRIPES > 0 as other handlers may relink the hash chains between
+  the calls.
+*/
+
+static int hp_save_found(HP_INFO *info, HP_KEYDEF *keyinfo, const uchar *key,
+                         uchar *pos)
+{
+  info->found_count= 0;
+  do
+  {
+    if (info->found_count == info->found_alloc)
+    {
+      uint alloc= MY_MAX(16, info->found_alloc * 2);
+      uchar **found;
+      if (!(found= (uchar**) my_realloc(info->found, alloc * sizeof(uchar*),
+                                        MYF(MY_ALLOW_ZERO_PTR))))
+        return my_errno= HA_ERR_OUT_OF_MEM;
+      info->found= found;
+      info->found_alloc= alloc;
+    }
+    info->found[info->found_count++]= pos;
+  } while ((keyinfo->flag & (HA_NOSAME | HA_NULL_PART_KEY)) != HA_NOSAME &&
+           (pos= hp_search_next(info, keyinfo, key, info->current_hash_ptr)));
+  info->found_next= 1;
+  info->current_hash_ptr= 0;
+  info->current_ptr= info->found[0];
+  return 0;
+}
+
+
 int heap_rkey(HP_INFO *info, uchar *record, int inx, const uchar *key, 
               key_part_map keypart_map, enum ha_rkey_function find_flag)
 {
@@ -65,10 +97,17 @@ int heap_rkey(HP_INFO *info, uchar *record, int inx, const uchar *key,
       info->update= HA_STATE_NO_KEY;
       DBUG_RETURN(my_errno);
     }
-    if ((keyinfo->flag & (HA_NOSAME | HA_NULL_PART_KEY)) != HA_NOSAME)
+    if (share->lock_stripes)
+    {
+      memcpy(info->lastkey, key, (size_t) keyinfo->length);
+      if (hp_save_found(info, keyinfo, key, pos))
+        DBUG_RETURN(my_errno);
+    }
+    else if ((keyinfo->flag & (HA_NOSAME | HA_NULL_PART_KEY)) != HA_NOSAME)
       memcpy(info->lastkey, key, (size_t) keyinfo->length);
   }
-  memcpy(record, pos, (size_t) share->reclength);
+  if (hp_extract_record(info, record, pos))
+    DBUG_RETURN(my_errno);
   info->update= HA_STATE_AKTIV;
   DBUG_RETURN(0);
 }
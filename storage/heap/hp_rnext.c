@@ -99,6 +99,21 @@ int heap_rnext(HP_INFO *info, uchar *record)
       my_errno = HA_ERR_KEY_NOT_FOUND;
     }
   }
+  else if (share->lock_stripes)
+  {
+    /* Rows saved by heap_rkey() that still have the key */
+    for (pos= 0; info->found_next < info->found_count; )
+    {
+      uchar *found= info->found[info->found_next++];
+      if (found[share->visible] && !hp_key_cmp(keyinfo, found, info->lastkey))
+      {
+        pos= found;
+        break;
+      }
+    }
+    if (!(info->current_ptr= pos))
+      my_errno= HA_ERR_KEY_NOT_FOUND;
+  }
   else
   {
     if (info->current_hash_ptr)
@@ -124,7 +139,8 @@ int heap_rnext(HP_INFO *info, uchar *record)
       my_errno=HA_ERR_END_OF_FILE;
     DBUG_RETURN(my_errno);
   }
-  memcpy(record,pos,(size_t) share->reclength);
+  if (hp_extract_record(info, record, pos))
+    DBUG_RETURN(my_errno);
   info->update=HA_STATE_AKTIV | HA_STATE_NEXT_FOUND;
   DBUG_RETURN(0);
 }
@@ -26,16 +26,24 @@ LIST *heap_open_list=0,*heap_share_list=0;
 
 #ifdef HAVE_PSI_INTERFACE
 PSI_mutex_key hp_key_mutex_HP_SHARE_intern_lock;
+PSI_mutex_key hp_key_mutex_HP_SHARE_row_lock;
+PSI_rwlock_key hp_key_rwlock_HP_SHARE_stripe_lock;
 
 static PSI_mutex_info all_heap_mutexes[]=
 {
-  { & hp_key_mutex_HP_SHARE_intern_lock, "HP_SHARE::intern_lock", 0}
+  { & hp_key_mutex_HP_SHARE_intern_lock, "HP_SHARE::intern_lock", 0},
+  { & hp_key_mutex_HP_SHARE_row_lock, "HP_SHARE::row_lock", 0}
   /*
     Note:
     THR_LOCK_heap is part of mysys, not storage/heap.
   */
 };
 
+static PSI_rwlock_info all_heap_rwlocks[]=
+{
+  { & hp_key_rwlock_HP_SHARE_stripe_lock, "HP_SHARE::stripe_lock", 0}
+};
+
 void init_heap_psi_keys()
 {
   const char* category= "memory";
@@ -46,6 +54,9 @@ void init_heap_psi_keys()
 
   count= array_elements(all_heap_mutexes);
   PSI_server->register_mutex(category, all_heap_mutexes, count);
+
+  count= array_elements(all_heap_rwlocks);
+  PSI_server->register_rwlock(category, all_heap_rwlocks, count);
 }
 #endif /* HAVE_PSI_INTERFACE */
 
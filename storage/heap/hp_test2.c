@@ -25,8 +25,11 @@
 static int get_options(int argc, char *argv[]);
 static int rnd(int max_value);
 static sig_handler endprog(int sig_number);
+static int benchmark(ulong records);
 
 static uint flag=0,verbose=0,testflag=0,recant=10000,silent=0;
+static uint8 hash_layout= HP_HASH_CHAINED;
+static ulong bench_records= 0;
 static uint keys=MAX_KEYS;
 static uint16 key1[1001];
 static my_bool key3[MAX_RECORDS];
@@ -63,6 +66,8 @@ int main(int argc, char *argv[])
   filename2= "test2_2";
   file=file2=0;
   get_options(argc,argv);
+  if (bench_records)
+    return benchmark(bench_records);
 
   bzero(&hp_create_info, sizeof(hp_create_info));
   hp_create_info.max_table_size= 2*1024L*1024L;
@@ -117,6 +122,8 @@ int main(int argc, char *argv[])
   keyinfo[3].seg[0].null_bit=1;
   keyinfo[3].seg[0].null_pos=38;
   keyinfo[3].seg[0].charset=cs;
+  for (i=0 ; i < MAX_KEYS ; i++)
+    keyinfo[i].hash_layout= hash_layout;
 
   bzero((char*) key1,sizeof(key1));
   bzero((char*) key3,sizeof(key3));
@@ -379,7 +386,7 @@ int main(int argc, char *argv[])
 
   puts("- Test if: Read rrnd - same - rkey - same");
   DBUG_PRINT("progpos",("Read rrnd - same"));
-  pos=rnd(write_count-opt_delete-5)+5;
+  pos=rnd(write_count-opt_delete-6)+6;
   heap_scan_init(file);
   i=5;
   while ((error=heap_scan(file,record)) == HA_ERR_RECORD_DELETED ||
@@ -387,7 +394,7 @@ int main(int argc, char *argv[])
   {
     if (!error)
       pos--;
-    if (i-- == 0)
+    if (!error && i-- == 0)			/* Position of a live row */
     {
       bmove(record3,record,reclength);
       position=heap_position(file);
@@ -580,6 +587,12 @@ static int get_options(int argc,char *argv[])
     case 'B':				/* Big file */
       flag=1;
       break;
+    case 'O':				/* Open hash indexes */
+      hash_layout= HP_HASH_OPEN;
+      break;
+    case 'b':				/* Benchmark of # keys */
+      bench_records= (ulong) atol(++pos);
+      break;
     case 'v':				/* verbose */
       verbose=1;
       break;
@@ -597,7 +610,9 @@ static int get_options(int argc,char *argv[])
     case '?':
       printf("%s  Ver 1.2 for %s at %s\n",progname,SYSTEM_TYPE,MACHINE_TYPE);
       puts("TCX Datakonsult AB, by Monty, for your professional use\n");
-      printf("Usage: %s [-?ABIKLsWv] [-m#] [-t#]\n",progname);
+      printf("Usage: %s [-?ABIKLOsWv] [-m#] [-t#] [-b#]\n",progname);
+      puts("-O uses HASH_LAYOUT=OPEN for all keys, -b# compares the key");
+      puts("lookups per second of both hash layouts in a table of # rows");
       exit(0);
     case '#':
       DBUG_PUSH (++pos);
@@ -624,6 +639,83 @@ static sig_handler endprog(int sig_number __attribute__((unused)))
   }
 }
 
+/*
+  Insert records with a unique 8 byte key and read them back in a random
+  order, with the chained and the open hash layout
+*/
+
+static int benchmark(ulong records)
+{
+  static const char *names[]= { "chained", "open" };
+  uint layout;
+
+  for (layout= HP_HASH_CHAINED; layout <= HP_HASH_OPEN; layout++)
+  {
+    HP_CREATE_INFO create_info;
+    HP_KEYDEF keydef;
+    HA_KEYSEG keyseg;
+    HP_SHARE *share;
+    HP_INFO *info;
+    my_bool created;
+    uchar record[16], key[8];
+    ulonglong start, insert_time, lookup_time;
+    ulong i;
+
+    bzero(&keyseg, sizeof(keyseg));
+    keyseg.type= HA_KEYTYPE_BINARY;
+    keyseg.length= 8;
+    keyseg.charset= &my_charset_bin;
+    bzero(&keydef, sizeof(keydef));
+    keydef.keysegs= 1;
+    keydef.seg= &keyseg;
+    keydef.flag= HA_NOSAME;
+    keydef.algorithm= HA_KEY_ALG_HASH;
+    keydef.hash_layout= (uint8) layout;
+    bzero(&create_info, sizeof(create_info));
+    create_info.keys= 1;
+    create_info.keydef= &keydef;
+    create_info.reclength= sizeof(record);
+    create_info.max_table_size= ~(ulonglong) 0;
+    create_info.max_records= records;
+
+    if (heap_create("bench", &create_info, &share, &created) ||
+        !(info= heap_open("bench", 2)))
+      return 1;
+    bzero(record, sizeof(record));
+    start= my_interval_timer();
+    for (i= 0; i < records; i++)
+    {
+      int8store(record, (ulonglong) i * 2654435761UL);
+      if (heap_write(info, record))
+        return 1;
+    }
+    insert_time= my_interval_timer() - start;
+
+    start= my_interval_timer();
+    for (i= 0; i < records; i++)
+    {
+      /* Read the keys in an order unrelated to their positions */
+      ulong n= (ulong) (((ulonglong) i * 7919 + 13) % records);
+      int8store(key, (ulonglong) n * 2654435761UL);
+      if (heap_rkey(info, record, 0, key, 1, HA_READ_KEY_EXACT))
+        return 1;
+    }
+    lookup_time= my_interval_timer() - start;
+
+    printf("%-8s %lu rows  inserts/s: %.0f  lookups/s: %.0f  "
+           "index: %llu bytes\n",
+           names[layout], records,
+           records * 1e9 / (insert_time ? insert_time : 1),
+           records * 1e9 / (lookup_time ? lookup_time : 1),
+           share->index_length);
+    if (heap_close(info) || heap_delete_table("bench"))
+      return 1;
+  }
+  my_end(0);
+  return 0;
+}
+
+
 static int calc_check(uchar *buf, uint length)
 {
   int check=0;
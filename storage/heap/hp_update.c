@@ -21,7 +21,7 @@
 int heap_update(HP_INFO *info, const uchar *old, const uchar *heap_new)
 {
   HP_KEYDEF *keydef, *end, *p_lastinx;
-  uchar *pos;
+  uchar *pos, new_ref[HP_VARLEN_REF_LENGTH];
   my_bool auto_key_changed= 0, key_changed= 0;
   HP_SHARE *share= info->s;
   DBUG_ENTER("heap_update");
@@ -31,6 +31,9 @@ int heap_update(HP_INFO *info, const uchar *old, const uchar *heap_new)
 
   if (info->opt_flag & READ_CHECK_USED && hp_rectest(info,old))
     DBUG_RETURN(my_errno);				/* Record changed */
+  /* The new chunks are allocated before anything is changed */
+  if (share->columns && hp_store_varlen(share, heap_new, new_ref))
+    DBUG_RETURN(my_errno);
   if (--(share->records) < share->blength >> 1) share->blength>>= 1;
   share->changed=1;
 
@@ -47,7 +50,12 @@ int heap_update(HP_INFO *info, const uchar *old, const uchar *heap_new)
     }
   }
 
-  memcpy(pos,heap_new,(size_t) share->reclength);
+  memcpy(pos,heap_new,(size_t) share->head_length);
+  if (share->columns)
+  {
+    hp_free_varlen(share, pos + share->head_length);
+    memcpy(pos + share->head_length, new_ref, HP_VARLEN_REF_LENGTH);
+  }
   if (++(share->records) == share->blength) share->blength+= share->blength;
 
 #if !defined(DBUG_OFF) && defined(EXTRA_HEAP_DEBUG)
@@ -63,11 +71,14 @@ int heap_update(HP_INFO *info, const uchar *old, const uchar *heap_new)
   if (my_errno == HA_ERR_FOUND_DUPP_KEY)
   {
     info->errkey = (int) (keydef - share->keydef);
-    if (keydef->algorithm == HA_KEY_ALG_BTREE)
+    if (keydef->algorithm == HA_KEY_ALG_BTREE ||
+        keydef->hash_layout == HP_HASH_OPEN)
     {
       /* we don't need to delete non-inserted key from rb-tree */
       if ((*keydef->write_key)(info, keydef, old, pos))
       {
+        if (share->columns)
+          hp_free_varlen(share, new_ref);
         if (++(share->records) == share->blength)
 	  share->blength+= share->blength;
         DBUG_RETURN(my_errno);
@@ -85,6 +96,8 @@ int heap_update(HP_INFO *info, const uchar *old, const uchar *heap_new)
       keydef--;
     }
   }
+  if (share->columns)
+    hp_free_varlen(share, new_ref);
   if (++(share->records) == share->blength)
     share->blength+= share->blength;
   DBUG_RETURN(my_errno);
@@ -44,6 +44,14 @@ int heap_write(HP_INFO *info, const uchar *record)
 #endif
   if (!(pos=next_free_record_pos(share)))
     DBUG_RETURN(my_errno);
+  if (share->columns && hp_store_varlen(share, record, pos + share->head_length))
+  {
+    share->deleted++;
+    *((uchar**) pos)=share->del_link;
+    share->del_link=pos;
+    pos[share->visible]=0;			/* Record deleted */
+    DBUG_RETURN(my_errno);
+  }
   share->changed=1;
 
   for (keydef = share->keydef, end = keydef + share->keys; keydef < end;
@@ -53,8 +61,8 @@ int heap_write(HP_INFO *info, const uchar *record)
       goto err;
   }
 
-  memcpy(pos,record,(size_t) share->reclength);
-  pos[share->reclength]=1;		/* Mark record as not deleted */
+  memcpy(pos,record,(size_t) share->head_length);
+  pos[share->visible]=1;		/* Mark record as not deleted */
   if (++share->records == share->blength)
     share->blength+= share->blength;
   info->s->key_version++;
@@ -76,9 +84,11 @@ int heap_write(HP_INFO *info, const uchar *record)
     We don't need to delete non-inserted key from rb-tree.  Also, if
     we got ENOMEM, the key wasn't inserted, so don't try to delete it
     either.  Otherwise for HASH index on HA_ERR_FOUND_DUPP_KEY the key
-    was inserted and we have to delete it.
+    was inserted and we have to delete it, unless the index has
+    HASH_LAYOUT=OPEN, which checks for duplicates before inserting.
   */
-  if (keydef->algorithm == HA_KEY_ALG_BTREE || my_errno == ENOMEM)
+  if (keydef->algorithm == HA_KEY_ALG_BTREE ||
+      keydef->hash_layout == HP_HASH_OPEN || my_errno == ENOMEM)
   {
     keydef--;
   }
@@ -89,10 +99,12 @@ int heap_write(HP_INFO *info, const uchar *record)
     keydef--;
   } 
 
+  if (share->columns)
+    hp_free_varlen(share, pos + share->head_length);
   share->deleted++;
   *((uchar**) pos)=share->del_link;
   share->del_link=pos;
-  pos[share->reclength]=0;			/* Record deleted */
+  pos[share->visible]=0;			/* Record deleted */
 
   DBUG_RETURN(my_errno);
 } /* heap_write */
@@ -0,0 +1,198 @@
+#!/usr/bin/perl -w
+use strict;
+
+# Copyright (c) 2017, MariaDB Corporation.
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; version 2 of the License.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+
+#
+# Benchmark of hash joins with the join buffer (BNLH, join_cache_level=4)
+# on a TPC-H like schema without indexes on the join columns. Each query
+# is run with every join_cache_level given with --levels, so that the
+# hash join can be compared with the block nested loop join (level 2) and
+# the same binary can be compared with an older one.
+#
+# Queries:
+#   q3   customer, orders and lineitem of one market segment
+#   q5   revenue per nation from lineitem, orders, customer and supplier
+#   q10  returned items per customer
+#   fk   lineitem joined to orders on its foreign key only
+#
+# Example:
+#   perl bnlh_join_bench.pl --scale=0.1 --join-buffer-size=67108864
+#
+
+##################### Standard benchmark inits ##############################
+
+use DBI;
+use Getopt::Long;
+use Benchmark;
+
+package main;
+
+our ($opt_skip_create,$opt_skip_delete,$opt_scale,$opt_loops,$opt_levels);
+our ($opt_host,$opt_user,$opt_password,$opt_db,$opt_join_buffer_size);
+our ($opt_tests);
+my ($dbh, $test, $level, %queries);
+
+$opt_skip_create=$opt_skip_delete=0;
+$opt_scale=0.1;
+$opt_loops=1;
+$opt_levels="2,4";
+$opt_join_buffer_size=64*1024*1024;
+$opt_tests="q3,q5,q10,fk";
+$opt_host=$opt_user=$opt_password=""; $opt_db="test";
+
+GetOptions("host=s","db=s","user=s","password=s","scale=f","loops=i",
+           "levels=s","join-buffer-size=i","tests=s","skip-create",
+           "skip-delete") || die "Aborted";
+
+%queries=
+(
+ "q3" =>  "select l_orderkey, sum(l_extendedprice * (1 - l_discount)) " .
+          "as revenue, o_orderdate, o_shippriority " .
+          "from customer, orders, lineitem " .
+          "where c_mktsegment = 'BUILDING' and c_custkey = o_custkey " .
+          "and l_orderkey = o_orderkey and o_orderdate < '1995-03-15' " .
+          "and l_shipdate > '1995-03-15' " .
+          "group by l_orderkey, o_orderdate, o_shippriority " .
+          "order by revenue desc, o_orderdate limit 10",
+ "q5" =>  "select n_name, sum(l_extendedprice * (1 - l_discount)) " .
+          "as revenue from customer, orders, lineitem, supplier, nation " .
+          "where c_custkey = o_custkey and l_orderkey = o_orderkey " .
+          "and l_suppkey = s_suppkey and c_nationkey = s_nationkey " .
+          "and s_nationkey = n_nationkey and o_orderdate >= '1994-01-01' " .
+          "and o_orderdate < '1995-01-01' " .
+          "group by n_name order by revenue desc",
+ "q10" => "select c_custkey, c_name, " .
+          "sum(l_extendedprice * (1 - l_discount)) as revenue, n_name " .
+          "from customer, orders, lineitem, nation " .
+          "where c_custkey = o_custkey and l_orderkey = o_orderkey " .
+          "and o_orderdate >= '1993-10-01' and o_orderdate < '1994-01-01' " .
+          "and l_returnflag = 'R' and c_nationkey = n_nationkey " .
+          "group by c_custkey, c_name, n_name " .
+          "order by revenue desc limit 20",
+ "fk" =>  "select count(*), sum(o_totalprice) from orders straight_join " .
+          "lineitem where l_orderkey = o_orderkey"
+);
+
+print "Test of hash joins with scale factor $opt_scale\n";
+
+$dbh = DBI->connect("DBI:mysql:$opt_db:$opt_host",
+                    $opt_user, $opt_password,
+                  { PrintError => 0}) || die $DBI::errstr;
+
+create_tables() if (!$opt_skip_create);
+
+$dbh->do("set join_buffer_size=$opt_join_buffer_size, " .
+         "join_buffer_space_limit=" . 4 * $opt_join_buffer_size)
+  or die $DBI::errstr;
+$dbh->do("set optimizer_switch='join_cache_hashed=on'") or die $DBI::errstr;
+
+foreach $test (split(/,/, $opt_tests))
+{
+  die "Unknown test '$test'" if (!defined($queries{$test}));
+  foreach $level (split(/,/, $opt_levels))
+  {
+    my ($start, $end, $rows, $i);
+    $dbh->do("set join_cache_level=$level") or die $DBI::errstr;
+    $start= new Benchmark;
+    for ($i= 0 ; $i < $opt_loops ; $i++)
+    {
+      my $sth= $dbh->prepare($queries{$test}) or die $DBI::errstr;
+      $sth->execute or die $DBI::errstr;
+      $rows= 0;
+      while ($sth->fetchrow_arrayref) { $rows++; }
+      die "Got error on fetch: $DBI::errstr\n" if ($sth->err);
+      $sth->finish;
+    }
+    $end= new Benchmark;
+    printf("%-4s join_cache_level=%d  rows: %d  time: %s\n", $test, $level,
+           $rows, timestr(timediff($end, $start)));
+  }
+}
+
+$dbh->do("set join_cache_level=DEFAULT");
+if (!$opt_skip_delete)
+{
+  $dbh->do("drop table customer, orders, lineitem, supplier, nation");
+}
+$dbh->disconnect;
+exit(0);
+
+
+# Fill the tables with rows derived from sequence numbers, roughly with
+# the sizes and value distributions of TPC-H
+
+sub create_tables
+{
+  my $customers= int(150000 * $opt_scale) || 1;
+  my $orders= $customers * 10;
+  my $suppliers= int(10000 * $opt_scale) || 1;
+
+  print "Creating tables with $customers customers and $orders orders\n";
+  $dbh->do("drop table if exists customer, orders, lineitem, supplier, " .
+           "nation, bench_seq");
+  $dbh->do("create table nation (n_nationkey int not null, " .
+           "n_name char(25) not null) engine=myisam") or die $DBI::errstr;
+  $dbh->do("create table supplier (s_suppkey int not null, " .
+           "s_name char(25) not null, s_nationkey int not null) " .
+           "engine=myisam") or die $DBI::errstr;
+  $dbh->do("create table customer (c_custkey int not null, " .
+           "c_name varchar(25) not null, c_nationkey int not null, " .
+           "c_mktsegment char(10) not null) engine=myisam")
+    or die $DBI::errstr;
+  $dbh->do("create table orders (o_orderkey int not null, " .
+           "o_custkey int not null, o_totalprice decimal(15,2) not null, " .
+           "o_orderdate date not null, o_shippriority int not null) " .
+           "engine=myisam") or die $DBI::errstr;
+  $dbh->do("create table lineitem (l_orderkey int not null, " .
+           "l_suppkey int not null, l_extendedprice decimal(15,2) not null, " .
+           "l_discount decimal(15,2) not null, l_returnflag char(1) not null, " .
+           "l_shipdate date not null) engine=myisam") or die $DBI::errstr;
+
+  $dbh->do("create table bench_seq (n int not null) engine=myisam")
+    or die $DBI::errstr;
+  $dbh->do("insert into bench_seq values (0)") or die $DBI::errstr;
+  for (my $rows= 1 ; $rows < $orders ; $rows*= 2)
+  {
+    $dbh->do("insert into bench_seq select n + $rows from bench_seq " .
+             "where n + $rows < $orders") or die $DBI::errstr;
+  }
+
+  $dbh->do("insert into nation select n, concat('NATION ', n) " .
+           "from bench_seq where n < 25") or die $DBI::errstr;
+  $dbh->do("insert into supplier select n, concat('Supplier#', n), n % 25 " .
+           "from bench_seq where n < $suppliers") or die $DBI::errstr;
+  $dbh->do("insert into customer select n, concat('Customer#', n), " .
+           "(n * 7) % 25, elt(1 + n % 5, 'AUTOMOBILE', 'BUILDING', " .
+           "'FURNITURE', 'HOUSEHOLD', 'MACHINERY') from bench_seq " .
+           "where n < $customers") or die $DBI::errstr;
+  $dbh->do("insert into orders select n, (n * 7919) % $customers, " .
+           "1000 + (n * 31) % 100000, '1992-01-01' + interval n % 2400 day, " .
+           "0 from bench_seq") or die $DBI::errstr;
+  # One to seven line items per order, four on average
+  for (my $line= 0 ; $line < 7 ; $line++)
+  {
+    $dbh->do("insert into lineitem select o_orderkey, " .
+             "(o_orderkey + $line * 997) % $suppliers, " .
+             "100 + (o_orderkey * 13 + $line) % 10000, " .
+             "((o_orderkey + $line) % 11) / 100, " .
+             "elt(1 + (o_orderkey + $line) % 3, 'A', 'N', 'R'), " .
+             "o_orderdate + interval (1 + $line * 17) day from orders " .
+             "where o_orderkey % 7 >= $line - 1 or $line < 2")
+      or die $DBI::errstr;
+  }
+  $dbh->do("drop table bench_seq");
+}
@@ -0,0 +1,217 @@
+#!/usr/bin/perl -w
+use strict;
+
+# Copyright (c) 2017, MariaDB Corporation.
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; version 2 of the License.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+
+#
+# Benchmark of the compressed protocol: the same workloads are run with
+# each packet compressed on its own and with the compression context kept
+# for the whole connection (net_compress_stream). For each run the time,
+# the bytes sent on the wire and the CPU time of the client and, if
+# --server-pid is given, of the server are printed.
+#
+# Workloads:
+#   rows     Stream a result set with narrow rows
+#   wide     Stream a result set with 1K text columns
+#   points   Many single row primary key lookups
+#   insert   Many single row inserts (client to server direction)
+#
+# Example:
+#   perl compress_bench.pl --rows=1000000 --server-pid=`cat data/host.pid`
+#
+# The user needs the SUPER privilege to switch net_compress_stream.
+#
+
+##################### Standard benchmark inits ##############################
+
+use DBI;
+use Getopt::Long;
+use Benchmark;
+
+package main;
+
+our ($opt_skip_create,$opt_skip_delete,$opt_rows,$opt_lookups,$opt_loops);
+our ($opt_host,$opt_user,$opt_password,$opt_db,$opt_server_pid,$opt_tests);
+my ($dbh, $test, $mode, %result);
+
+$opt_skip_create=$opt_skip_delete=0;
+$opt_rows=1000000;
+$opt_lookups=100000;
+$opt_loops=1;
+$opt_server_pid=0;
+$opt_tests="rows,wide,points,insert";
+$opt_host=$opt_user=$opt_password=""; $opt_db="test";
+
+GetOptions("host=s","db=s","user=s","password=s","rows=i","lookups=i",
+           "loops=i","server-pid=i","tests=s","skip-create","skip-delete") ||
+  die "Aborted";
+
+print "Test of the compressed protocol with $opt_rows rows and " .
+  "$opt_lookups lookups\n";
+
+$dbh= connect_server(0);
+
+if (!$opt_skip_create)
+{
+  my $rows;
+  print "Creating table bench_compress with $opt_rows rows\n";
+  $dbh->do("drop table if exists bench_compress, bench_compress_ins");
+  $dbh->do("create table bench_compress (id int not null primary key, " .
+           "name varchar(32), city varchar(32), amount decimal(10,2), " .
+           "created datetime, note text) engine=myisam")
+    or die $DBI::errstr;
+  $dbh->do("insert into bench_compress values (1, 'customer 1', " .
+           "'Helsinki', 10.5, '2017-01-01 10:00:00', repeat('note ', 200))")
+    or die $DBI::errstr;
+  # Double the table until it is big enough
+  for ($rows= 1 ; $rows < $opt_rows ; $rows*= 2)
+  {
+    my $limit= ($opt_rows - $rows < $rows) ? $opt_rows - $rows : $rows;
+    $dbh->do("insert into bench_compress select id+$rows, " .
+             "concat('customer ', id+$rows), " .
+             "elt(1 + (id+$rows) % 4, 'Helsinki', 'Espoo', 'Tampere', " .
+             "'Turku'), amount + (id % 100), created + interval id minute, " .
+             "concat(note, id) from bench_compress limit $limit")
+      or die $DBI::errstr;
+  }
+  $dbh->do("create table bench_compress_ins like bench_compress")
+    or die $DBI::errstr;
+}
+
+foreach $test (split(/,/, $opt_tests))
+{
+  foreach $mode ("packet", "stream")
+  {
+    my ($con, $start, $end, $server_start, $sent, $received);
+    $dbh->do("set global net_compress_stream=" .
+             ($mode eq "stream" ? "ON" : "OFF")) or die $DBI::errstr;
+    $dbh->do("truncate table bench_compress_ins") or die $DBI::errstr;
+    $con= connect_server(1);
+    $server_start= server_cpu();
+    $start= new Benchmark;
+    run_test($con, $test);
+    $end= new Benchmark;
+    ($sent, $received)= wire_bytes($con);
+    $con->disconnect;
+    printf("%-7s %-7s time: %s  server cpu: %s  sent: %.1fM  " .
+           "received: %.1fM\n", $test, $mode,
+           timestr(timediff($end, $start)),
+           $opt_server_pid ?
+           sprintf("%.2f", server_cpu() - $server_start) : "n/a",
+           $sent / 1048576, $received / 1048576);
+  }
+}
+
+$dbh->do("set global net_compress_stream=DEFAULT");
+if (!$opt_skip_delete)
+{
+  $dbh->do("drop table bench_compress, bench_compress_ins");
+}
+$dbh->disconnect;
+exit(0);
+
+
+sub connect_server
+{
+  my ($compress)= @_;
+  return DBI->connect("DBI:mysql:$opt_db:$opt_host" .
+                      ($compress ? ";mysql_compression=1" : ""),
+                      $opt_user, $opt_password,
+                      { PrintError => 0}) || die $DBI::errstr;
+}
+
+
+sub run_test
+{
+  my ($con, $test)= @_;
+  my ($sth, $row, $i, $loop);
+
+  for ($loop= 0 ; $loop < $opt_loops ; $loop++)
+  {
+    if ($test eq "rows" || $test eq "wide")
+    {
+      my $columns= ($test eq "rows") ? "id, name, city, amount, created" :
+                                       "*";
+      $sth= $con->prepare("select $columns from bench_compress",
+                          { mysql_use_result => 1 }) or die $DBI::errstr;
+      $sth->execute or die $DBI::errstr;
+      while (($row= $sth->fetchrow_arrayref)) {}
+      die "Got error on fetch: $DBI::errstr\n" if ($sth->err);
+      $sth->finish;
+    }
+    elsif ($test eq "points")
+    {
+      $sth= $con->prepare("select id, name, city, amount, created " .
+                          "from bench_compress where id=?")
+        or die $DBI::errstr;
+      for ($i= 0 ; $i < $opt_lookups ; $i++)
+      {
+        $sth->execute(1 + ($i * 7919) % $opt_rows) or die $DBI::errstr;
+        while (($row= $sth->fetchrow_arrayref)) {}
+      }
+      $sth->finish;
+    }
+    elsif ($test eq "insert")
+    {
+      for ($i= 0 ; $i < $opt_lookups ; $i++)
+      {
+        $con->do("insert into bench_compress_ins values " .
+                 "($loop * $opt_lookups + $i, 'customer $i', 'Helsinki', " .
+                 "10.5, '2017-01-01 10:00:00', 'note $i')")
+          or die $DBI::errstr;
+      }
+    }
+    else
+    {
+      die "Unknown test '$test'";
+    }
+  }
+}
+
+
+# Bytes sent and received by the server on this connection
+
+sub wire_bytes
+{
+  my ($con)= @_;
+  my ($sent, $received);
+  my $sth= $con->prepare("show session status where variable_name in " .
+                         "('Bytes_sent', 'Bytes_received')")
+    or die $DBI::errstr;
+  $sth->execute or die $DBI::errstr;
+  while (my ($name, $value)= $sth->fetchrow_array)
+  {
+    $sent= $value if ($name eq "Bytes_sent");
+    $received= $value if ($name eq "Bytes_received");
+  }
+  $sth->finish;
+  return ($sent, $received);
+}
+
+
+# User and system CPU seconds used by the server process so far
+
+sub server_cpu
+{
+  my (@stat, $ticks);
+  return 0 if (!$opt_server_pid);
+  open(STAT, "/proc/$opt_server_pid/stat") or
+    die "Can't read CPU time of process $opt_server_pid: $!";
+  @stat= split(/ /, <STAT>);
+  close(STAT);
+  $ticks= `getconf CLK_TCK` || 100;
+  return ($stat[13] + $stat[14]) / $ticks;
+}
@@ -0,0 +1,138 @@
+#!/usr/bin/perl -w
+use strict;
+
+# Copyright (c) 2017, MariaDB Corporation.
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; version 2 of the License.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+
+#
+# Benchmark of IN lists of integer and DATETIME constants. A table
+# without indexes is scanned with a WHERE col IN (...) condition for
+# every list length given with --lengths and the number of rows
+# evaluated per second is printed. Lists shorter than 16 values are
+# searched with the binary search of in_longlong, longer lists with its
+# hash set; run the same test against an older binary to compare the
+# binary search with the hash set for the long lists.
+#
+# Example:
+#   perl in_list_bench.pl --rows=1000000 --lengths=8,64,1000,5000
+#
+
+##################### Standard benchmark inits ##############################
+
+use DBI;
+use Getopt::Long;
+use Benchmark;
+
+package main;
+
+our ($opt_skip_create,$opt_skip_delete,$opt_rows,$opt_loops,$opt_lengths);
+our ($opt_host,$opt_user,$opt_password,$opt_db,$opt_columns);
+my ($dbh, $column, $length);
+
+$opt_skip_create=$opt_skip_delete=0;
+$opt_rows=1000000;
+$opt_loops=3;
+$opt_lengths="8,64,1000,5000";
+$opt_columns="i,u,dt";
+$opt_host=$opt_user=$opt_password=""; $opt_db="test";
+
+GetOptions("host=s","db=s","user=s","password=s","rows=i","loops=i",
+           "lengths=s","columns=s","skip-create","skip-delete")
+  || die "Aborted";
+
+print "Test of IN lists with $opt_rows rows\n";
+
+$dbh = DBI->connect("DBI:mysql:$opt_db:$opt_host",
+                    $opt_user, $opt_password,
+                  { PrintError => 0}) || die $DBI::errstr;
+
+create_tables() if (!$opt_skip_create);
+
+foreach $column (split(/,/, $opt_columns))
+{
+  foreach $length (split(/,/, $opt_lengths))
+  {
+    my ($start, $end, $count, $i, $query, $secs);
+    $query= "select count(*) from bench_in where $column in (" .
+            in_list($column, $length) . ")";
+    $start= new Benchmark;
+    for ($i= 0 ; $i < $opt_loops ; $i++)
+    {
+      ($count)= $dbh->selectrow_array($query);
+      die "Got error on select: $DBI::errstr\n" if (!defined($count));
+    }
+    $end= new Benchmark;
+    $secs= timediff($end, $start)->[0] || 0.001;
+    printf("%-2s length: %5d  matches: %7d  rows/sec: %10.0f  time: %s\n",
+           $column, $length, $count, $opt_rows * $opt_loops / $secs,
+           timestr(timediff($end, $start)));
+  }
+}
+
+if (!$opt_skip_delete)
+{
+  $dbh->do("drop table bench_in");
+}
+$dbh->disconnect;
+exit(0);
+
+
+# The list of $length constants for $column, every second one matches
+# a row of the table
+
+sub in_list
+{
+  my ($column, $length)= @_;
+  my (@values, $i);
+  for ($i= 0 ; $i < $length ; $i++)
+  {
+    my $n= ($i * 7919 * 2 + ($i & 1)) % (2 * $opt_rows);
+    if ($column eq "dt")
+    {
+      push(@values, "'2000-01-01 00:00:00' + interval $n second");
+    }
+    elsif ($column eq "u")
+    {
+      push(@values, "18446744073709551615 - $n");
+    }
+    else
+    {
+      push(@values, $n - $opt_rows);
+    }
+  }
+  return join(",", @values);
+}
+
+
+# Rows with the even numbers of the value ranges used by in_list()
+
+sub create_tables
+{
+  print "Creating table with $opt_rows rows\n";
+  $dbh->do("drop table if exists bench_in");
+  $dbh->do("create table bench_in (i bigint not null, " .
+           "u bigint unsigned not null, dt datetime not null) engine=myisam")
+    or die $DBI::errstr;
+  $dbh->do("insert into bench_in values (0, 0, 0)") or die $DBI::errstr;
+  for (my $rows= 1 ; $rows < $opt_rows ; $rows*= 2)
+  {
+    $dbh->do("insert into bench_in select i + $rows, 0, 0 from bench_in " .
+             "where i + $rows < $opt_rows") or die $DBI::errstr;
+  }
+  $dbh->do("update bench_in set i= i * 2 - $opt_rows, " .
+           "u= 18446744073709551615 - (i + $opt_rows), " .
+           "dt= '2000-01-01 00:00:00' + interval (i + $opt_rows) second")
+    or die $DBI::errstr;
+}
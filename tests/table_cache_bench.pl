@@ -0,0 +1,144 @@
+#!/usr/bin/perl -w
+use strict;
+
+# Copyright (c) 2017, MariaDB Corporation.
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; version 2 of the License.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+
+#
+# Benchmark of the table definition cache: many connections open and
+# close random tables out of a large set, so that most time is spent in
+# tdc_acquire_share() / tdc_release_share().
+#
+# Run the server with a table_open_cache smaller than --tables to force
+# TABLE objects out of the cache, e.g.:
+#   mysqld --table-open-cache=400 --table-definition-cache=20000
+#   perl table_cache_bench.pl --threads=256 --tables=10000
+#
+
+my $opt_loop_count=10000; # Change this to make test harder/easier
+
+##################### Standard benchmark inits ##############################
+
+use DBI;
+use Getopt::Long;
+use Benchmark;
+
+package main;
+
+our ($opt_skip_create,$opt_skip_delete,$opt_threads,$opt_tables);
+our ($opt_host,$opt_user,$opt_password,$opt_db);
+my ($dbh, $start_time, $end_time);
+
+$opt_skip_create=$opt_skip_delete=0;
+$opt_threads=256;
+$opt_tables=1000;
+$opt_host=$opt_user=$opt_password=""; $opt_db="test";
+
+GetOptions("host=s","db=s","user=s","password=s","loop-count=i",
+           "skip-create","skip-delete","threads=i","tables=i") ||
+  die "Aborted";
+
+print "Test of $opt_threads connections opening and closing random tables\n";
+print "out of $opt_tables tables, $opt_loop_count opens per connection\n";
+
+####
+####  Start timeing and start test
+####
+
+$dbh = DBI->connect("DBI:mysql:$opt_db:$opt_host",
+		    $opt_user, $opt_password,
+		  { PrintError => 0}) || die $DBI::errstr;
+if (!$opt_skip_create)
+{
+  my $i;
+  print "Creating $opt_tables tables in database $opt_db\n";
+  for ($i=0 ; $i < $opt_tables ; $i++)
+  {
+    $dbh->do("drop table if exists bench_tc$i");
+    $dbh->do("create table bench_tc$i (id int not null primary key) ".
+             "engine=myisam") or die $DBI::errstr;
+    $dbh->do("insert into bench_tc$i values ($i)") or die $DBI::errstr;
+  }
+}
+$dbh->do("flush tables") or die $DBI::errstr;
+$dbh->disconnect; $dbh=0;	# Close handler
+$|= 1;				# Autoflush
+
+####
+#### Start the tests
+####
+
+my ($i, $pid, %work, $errors);
+
+$start_time=new Benchmark;
+for ($i=0 ; $i < $opt_threads ; $i++)
+{
+  test_open($i) if (($pid=fork()) == 0); $work{$pid}="open$i";
+}
+
+$errors=0;
+while (($pid=wait()) != -1)
+{
+  my $ret=$?/256;
+  if ($ret != 0)
+  {
+    print "thread '" . $work{$pid} . "' finished with exit code $ret\n";
+    $errors++;
+  }
+}
+$end_time=new Benchmark;
+
+print ($errors ? "Test failed\n" :"Test ok\n");
+print "Total time: " .
+  timestr(timediff($end_time, $start_time),"noc") . "\n";
+printf("Opens per second: %.0f\n",
+       $opt_threads * $opt_loop_count /
+       (timediff($end_time, $start_time)->[0] || 1));
+
+if (!$opt_skip_delete && !$errors)
+{
+  $dbh = DBI->connect("DBI:mysql:$opt_db:$opt_host",
+		      $opt_user, $opt_password,
+		    { PrintError => 0}) || die $DBI::errstr;
+  for ($i=0 ; $i < $opt_tables ; $i++)
+  {
+    $dbh->do("drop table bench_tc$i");
+  }
+  $dbh->disconnect;
+}
+exit($errors ? 1 : 0);
+
+#
+# Open and close a random table per statement
+#
+
+sub test_open
+{
+  my ($id)= @_;
+  my ($dbh, $i, $table);
+
+  srand($id);
+  $dbh = DBI->connect("DBI:mysql:$opt_db:$opt_host",
+		      $opt_user, $opt_password,
+		    { PrintError => 0}) || die $DBI::errstr;
+  for ($i=0 ; $i < $opt_loop_count ; $i++)
+  {
+    $table= "bench_tc" . int(rand($opt_tables));
+    $dbh->selectrow_array("select count(*) from $table where id >= 0") ||
+      die "Got error on select from $table: $DBI::errstr\n";
+  }
+  $dbh->disconnect;
+  exit(0);
+}
@@ -0,0 +1,109 @@
+#!/usr/bin/perl -w
+use strict;
+
+# Copyright (c) 2017, MariaDB Corporation.
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; version 2 of the License.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+
+#
+# Benchmark of sending result sets with wide rows: a table with long
+# string and blob columns is streamed to the client with
+# mysql_use_result(), so that most time is spent in Protocol_text and
+# the network layer of the server.
+#
+# Example:
+#   perl wide_rows_bench.pl --rows=10000000 --width=1024
+#
+
+##################### Standard benchmark inits ##############################
+
+use DBI;
+use Getopt::Long;
+use Benchmark;
+
+package main;
+
+our ($opt_skip_create,$opt_skip_delete,$opt_rows,$opt_width,$opt_loops);
+our ($opt_host,$opt_user,$opt_password,$opt_db,$opt_compress);
+my ($dbh, $sth, $start_time, $end_time, $rows, $bytes, $row, $i);
+
+$opt_skip_create=$opt_skip_delete=$opt_compress=0;
+$opt_rows=10000000;
+$opt_width=1024;
+$opt_loops=1;
+$opt_host=$opt_user=$opt_password=""; $opt_db="test";
+
+GetOptions("host=s","db=s","user=s","password=s","rows=i","width=i",
+           "loops=i","skip-create","skip-delete","compress") ||
+  die "Aborted";
+
+print "Test of streaming $opt_rows rows with $opt_width byte columns\n";
+
+$dbh = DBI->connect("DBI:mysql:$opt_db:$opt_host" .
+                    ($opt_compress ? ";mysql_compression=1" : ""),
+		    $opt_user, $opt_password,
+		  { PrintError => 0}) || die $DBI::errstr;
+
+if (!$opt_skip_create)
+{
+  print "Creating table bench_wide with $opt_rows rows\n";
+  $dbh->do("drop table if exists bench_wide");
+  $dbh->do("create table bench_wide (id int not null, a varchar($opt_width), ".
+           "b varchar($opt_width), c blob, d int, e double) engine=myisam")
+    or die $DBI::errstr;
+  $dbh->do("insert into bench_wide values (1, repeat('a',$opt_width), ".
+           "repeat('b',$opt_width), repeat('c',$opt_width), 1, 1.5)")
+    or die $DBI::errstr;
+  # Double the table until it is big enough
+  for ($rows= 1 ; $rows < $opt_rows ; $rows*= 2)
+  {
+    my $limit= ($opt_rows - $rows < $rows) ? $opt_rows - $rows : $rows;
+    $dbh->do("insert into bench_wide select id+$rows, a, b, c, d, e ".
+             "from bench_wide limit $limit") or die $DBI::errstr;
+  }
+}
+
+####
+####  Start timeing and start test
+####
+
+$start_time=new Benchmark;
+$rows=$bytes=0;
+for ($i=0 ; $i < $opt_loops ; $i++)
+{
+  $sth= $dbh->prepare("select * from bench_wide", { mysql_use_result => 1 })
+    or die $DBI::errstr;
+  $sth->execute or die $DBI::errstr;
+  while (($row= $sth->fetchrow_arrayref))
+  {
+    $rows++;
+    $bytes+= length($row->[1]) + length($row->[2]) + length($row->[3]);
+  }
+  die "Got error on fetch: $DBI::errstr\n" if ($sth->err);
+  $sth->finish;
+}
+$end_time=new Benchmark;
+
+print "Rows: $rows  Bytes: $bytes\n";
+print "Total time: " .
+  timestr(timediff($end_time, $start_time),"noc") . "\n";
+printf("Rows per second: %.0f\n",
+       $rows / (timediff($end_time, $start_time)->[0] || 1));
+
+if (!$opt_skip_delete)
+{
+  $dbh->do("drop table bench_wide");
+}
+$dbh->disconnect;
+exit(0);
@@ -0,0 +1,175 @@
+/* Copyright (c) 2017, MariaDB Corporation.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+/**
+  Unit test and benchmark of the merge of class Unique, done by the
+  calling thread or by merge worker threads.
+
+  The keys do not fit in memory, so they are written to sorted runs that
+  are merged by walk() and get(). With an argument, the number of keys to
+  add, the rows per second of every merge are printed:
+
+    unittest/sql/unique-t 10000000
+*/
+
+#define MYSQL_SERVER 1
+#include <tap.h>
+#include <sql_class.h>
+
+static const uint thread_counts[]= { 0, 2, 4 };
+static const ulonglong memory= 64 * 1024;
+
+static ulonglong rows= 100000;
+static ulonglong distinct_keys;
+
+static int cmp_keys(void *arg, const void *a, const void *b)
+{
+  ulonglong x= *(ulonglong*) a, y= *(ulonglong*) b;
+  return x < y ? -1 : x > y ? 1 : 0;
+}
+
+static ulonglong key_of_row(ulonglong row)
+{
+  return (row * 7919) % distinct_keys;
+}
+
+struct Walk_result
+{
+  ulonglong keys, counts;
+  ulonglong last;
+  bool sorted;
+};
+
+static int walk_action(void *key, element_count count, void *arg)
+{
+  Walk_result *res= (Walk_result*) arg;
+  ulonglong val= *(ulonglong*) key;
+  if (res->keys && val <= res->last)
+    res->sorted= false;
+  res->last= val;
+  res->keys++;
+  res->counts+= count;
+  return 0;
+}
+
+static double rows_per_sec(ulonglong added, ulonglong start)
+{
+  ulonglong ns= my_interval_timer() - start;
+  return ns ? (double) added * 1e9 / ns : 0.0;
+}
+
+static void test_walk(TABLE *table, uint threads, bool with_counters)
+{
+  Unique unique(cmp_keys, NULL, sizeof(ulonglong), memory,
+                with_counters ? 1 : 0);
+  Walk_result res= { 0, 0, 0, true };
+  ulonglong start;
+  bool error= false;
+
+  unique.set_merge_threads(threads);
+  for (ulonglong row= 0; row < rows; row++)
+  {
+    ulonglong key= key_of_row(row);
+    error|= unique.unique_add(&key);
+  }
+  start= my_interval_timer();
+  error|= unique.walk(table, walk_action, &res);
+  ok(!error && res.sorted && res.keys == distinct_keys &&
+     res.counts == (with_counters ? rows : distinct_keys),
+     "walk%s with %u threads: %llu keys",
+     with_counters ? " with counters" : "", threads, res.keys);
+  diag("%.0f rows/sec", rows_per_sec(rows, start));
+}
+
+/* Intersect the multiples of 2 and 3 if intersect, else get all keys */
+
+static void test_get(TABLE *table, uint threads, bool intersect)
+{
+  Unique unique(cmp_keys, NULL, sizeof(ulonglong), memory,
+                intersect ? 2 : 0);
+  IO_CACHE *cache;
+  ulonglong start, key, last= 0, keys= 0, added= 0, expected;
+  bool error= false, sorted= true;
+
+  unique.set_merge_threads(threads);
+  if (intersect)
+  {
+    for (key= 0; key < distinct_keys; key+= 2, added++)
+      error|= unique.unique_add(&key);
+    for (key= 0; key < distinct_keys; key+= 3, added++)
+      error|= unique.unique_add(&key);
+    expected= (distinct_keys + 5) / 6;
+  }
+  else
+  {
+    for (; added < rows; added++)
+    {
+      key= key_of_row(added);
+      error|= unique.unique_add(&key);
+    }
+    expected= distinct_keys;
+  }
+  start= my_interval_timer();
+  error|= unique.get(table);
+  if (!error && (cache= table->sort.io_cache))
+  {
+    while (!my_b_read(cache, (uchar*) &key, sizeof(key)))
+    {
+      if (keys && key <= last)
+        sorted= false;
+      if (intersect && key % 6)
+        sorted= false;
+      last= key;
+      keys++;
+    }
+    close_cached_file(cache);
+    my_free(cache);
+    table->sort.io_cache= NULL;
+  }
+  else
+    error= true;
+  ok(!error && sorted && keys == expected, "get%s with %u threads: %llu keys",
+     intersect ? " of intersection" : "", threads, keys);
+  diag("%.0f rows/sec", rows_per_sec(added, start));
+}
+
+
+int main(int argc, char **argv)
+{
+  TABLE *table;
+  MY_INIT(argv[0]);
+
+  if (argc > 1)
+    rows= strtoull(argv[1], NULL, 10);
+  distinct_keys= rows / 3 + 1;
+  pthread_key_create(&THR_THD, NULL);
+  init_tmpdir(&mysql_tmpdir_list, NULL);
+  table= (TABLE*) my_malloc(sizeof(TABLE), MYF(MY_WME | MY_ZEROFILL));
+
+  plan(4 * array_elements(thread_counts));
+  for (uint i= 0; i < array_elements(thread_counts); i++)
+  {
+    test_walk(table, thread_counts[i], false);
+    test_walk(table, thread_counts[i], true);
+    test_get(table, thread_counts[i], false);
+    test_get(table, thread_counts[i], true);
+  }
+
+  my_free(table);
+  free_tmpdir(&mysql_tmpdir_list);
+  pthread_key_delete(THR_THD);
+  my_end(0);
+  return exit_status();
+}
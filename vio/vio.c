@@ -100,6 +100,7 @@ static void vio_init(Vio *vio, enum enum_vio_type type,
     vio->vioerrno	=vio_errno;
     vio->read           =vio_read_pipe;
     vio->write          =vio_write_pipe;
+    vio->writev         =vio_writev_single;
     vio->fastsend	=vio_fastsend;
     vio->viokeepalive	=vio_keepalive;
     vio->should_retry	=vio_should_retry;
@@ -122,6 +123,7 @@ static void vio_init(Vio *vio, enum enum_vio_type type,
     vio->vioerrno	=vio_errno;
     vio->read           =vio_read_shared_memory;
     vio->write          =vio_write_shared_memory;
+    vio->writev         =vio_writev_single;
     vio->fastsend	=vio_fastsend;
     vio->viokeepalive	=vio_keepalive;
     vio->should_retry	=vio_should_retry;
@@ -144,6 +146,7 @@ static void vio_init(Vio *vio, enum enum_vio_type type,
     vio->vioerrno	=vio_errno;
     vio->read		=vio_ssl_read;
     vio->write		=vio_ssl_write;
+    vio->writev		=vio_writev_single;
     vio->fastsend	=vio_fastsend;
     vio->viokeepalive	=vio_keepalive;
     vio->should_retry	=vio_should_retry;
@@ -164,6 +167,7 @@ static void vio_init(Vio *vio, enum enum_vio_type type,
   vio->vioerrno         =vio_errno;
   vio->read=            (flags & VIO_BUFFERED_READ) ? vio_read_buff : vio_read;
   vio->write            =vio_write;
+  vio->writev           =vio_writev;
   vio->fastsend         =vio_fastsend;
   vio->viokeepalive     =vio_keepalive;
   vio->should_retry     =vio_should_retry;
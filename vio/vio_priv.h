@@ -45,6 +45,7 @@ int vio_shutdown_shared_memory(Vio *vio, int how);
 #endif
 
 int	vio_socket_shutdown(Vio *vio, int how);
+size_t	vio_writev_single(Vio *vio, const struct iovec *iov, int iovcnt);
 my_bool	vio_buff_has_data(Vio *vio);
 int	vio_socket_io_wait(Vio *vio, enum enum_vio_io_event event);
 int	vio_socket_timeout(Vio *vio, uint which, my_bool old_mode);
@@ -305,6 +305,75 @@ size_t vio_write(Vio *vio, const uchar* buf, size_t size)
   DBUG_RETURN(ret);
 }
 
+
+/**
+  Write data from several buffers with a single system call.
+
+  @return Number of bytes written, which can be less than the total
+          length of the buffers, or -1 on error, as for vio_write().
+*/
+
+size_t vio_writev(Vio *vio, const struct iovec *iov, int iovcnt)
+{
+#ifndef _WIN32
+  ssize_t ret;
+  int flags= 0;
+  struct msghdr msg;
+  DBUG_ENTER("vio_writev");
+  DBUG_PRINT("enter", ("sd: %d  iovcnt: %d",
+                       mysql_socket_getfd(vio->mysql_socket), iovcnt));
+
+  /* The non-blocking client API has no vectored write. */
+  if (vio->async_context)
+    DBUG_RETURN(vio_writev_single(vio, iov, iovcnt));
+
+  /* If timeout is enabled, do not block. */
+  if (vio->write_timeout >= 0)
+    flags= VIO_DONTWAIT;
+
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov= (struct iovec *) iov;
+  msg.msg_iovlen= iovcnt;
+  while ((ret= mysql_socket_sendmsg(vio->mysql_socket, &msg, flags)) == -1)
+  {
+    int error= socket_errno;
+    /* The operation would block? */
+    if (error != SOCKET_EAGAIN && error != SOCKET_EWOULDBLOCK)
+      break;
+
+    /* Wait for the output buffer to become writable.*/
+    if ((ret= vio_socket_io_wait(vio, VIO_IO_EVENT_WRITE)))
+      break;
+  }
+#ifndef DBUG_OFF
+  if (ret == -1)
+  {
+    DBUG_PRINT("vio_error", ("Got error on write: %d",socket_errno));
+  }
+#endif /* DBUG_OFF */
+  DBUG_PRINT("exit", ("%d", (int) ret));
+  DBUG_RETURN(ret);
+#else
+  return vio_writev_single(vio, iov, iovcnt);
+#endif /* _WIN32 */
+}
+
+
+/**
+  vio_writev() for transports without vectored writes: only the first
+  non-empty buffer is written.
+*/
+
+size_t vio_writev_single(Vio *vio, const struct iovec *iov, int iovcnt)
+{
+  while (iovcnt > 1 && iov->iov_len == 0)
+  {
+    iov++;
+    iovcnt--;
+  }
+  return vio->write(vio, (const uchar *) iov->iov_base, iov->iov_len);
+}
+
 #ifdef _WIN32
 static void CALLBACK cancel_io_apc(ULONG_PTR data)
 {